@@ -0,0 +1,282 @@
+#include "bench_parser.h"
+#include "input_stream.h"
+#include "verilog_lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FORMAT_SNIFF_BYTES 4096
+
+// State of one .bench parse
+typedef struct {
+    const ParseSink* sink;
+    const char* cursor;
+    const char* end;
+    int line;
+    NameView* inputs;          // Input names of the gate being read
+    int input_capacity;
+    bool stopped;              // A callback failed or memory ran out
+} BenchParser;
+
+// --- Scanning ---
+
+// Names run up to whitespace or punctuation ("G10", "U1234", "STATO_REG_2_", "a[3]")
+static bool is_name_char(char c) {
+    return (unsigned char)c > ' ' && c != '(' && c != ')' && c != ',' && c != '=' && c != '#';
+}
+
+static void skip_blanks(BenchParser* parser) {
+    const char* p = parser->cursor;
+    while (p < parser->end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v')) p++;
+    parser->cursor = p;
+}
+
+static NameView read_name(BenchParser* parser) {
+    skip_blanks(parser);
+    NameView name = { parser->cursor, 0 };
+    while (parser->cursor < parser->end && is_name_char(*parser->cursor)) parser->cursor++;
+    name.length = (int)(parser->cursor - name.text);
+    return name;
+}
+
+// Consumes c if it is the next non-blank character
+static bool accept(BenchParser* parser, char c) {
+    skip_blanks(parser);
+    if (parser->cursor < parser->end && *parser->cursor == c) {
+        parser->cursor++;
+        return true;
+    }
+    return false;
+}
+
+static void skip_line(BenchParser* parser) {
+    const char* newline = memchr(parser->cursor, '\n', (size_t)(parser->end - parser->cursor));
+    parser->cursor = newline ? newline + 1 : parser->end;
+    parser->line++;
+}
+
+static bool name_equals_upper(NameView name, const char* upper) {
+    int i = 0;
+    for (; i < name.length && upper[i]; i++) {
+        char c = name.text[i];
+        if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        if (c != upper[i]) return false;
+    }
+    return i == name.length && upper[i] == '\0';
+}
+
+// Gate primitives share the Verilog keywords ("NAND" -> nand); DFF is handled by the caller
+static GateType bench_gate_type(NameView name) {
+    char lower[8];
+    if (name.length < 2 || name.length >= (int)sizeof(lower)) return GATE_UNKNOWN;
+    for (int i = 0; i < name.length; i++) {
+        char c = name.text[i];
+        lower[i] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    return keyword_gate_type(lookup_keyword(lower, name.length));
+}
+
+static bool append_input(BenchParser* parser, int count, NameView name) {
+    if (count == parser->input_capacity) {
+        int capacity = parser->input_capacity ? parser->input_capacity * 2 : 16;
+        NameView* inputs = (NameView*)realloc(parser->inputs, (size_t)capacity * sizeof(NameView));
+        if (!inputs) return false;
+        parser->inputs = inputs;
+        parser->input_capacity = capacity;
+    }
+    parser->inputs[count] = name;
+    return true;
+}
+
+static bool declare(BenchParser* parser, DeclarationKind kind, NameView name) {
+    const ParseSink* sink = parser->sink;
+    if (sink->declare && !sink->declare(sink->user, kind, name)) parser->stopped = true;
+    return !parser->stopped;
+}
+
+// --- Statements ---
+
+// Parses "( name )" after INPUT or OUTPUT
+static void parse_declaration(BenchParser* parser, DeclarationKind kind, NameView keyword) {
+    NameView name = read_name(parser);
+    if (name.length == 0 || !accept(parser, ')')) {
+        fprintf(stderr, "Error: Malformed %.*s declaration on line %d\n", keyword.length, keyword.text, parser->line);
+        return;
+    }
+    declare(parser, kind, name);
+}
+
+// Parses "TYPE ( in1, in2, ... )" after "<output> ="
+static void parse_gate(BenchParser* parser, NameView output) {
+    NameView type_name = read_name(parser);
+    if (!accept(parser, '(')) {
+        fprintf(stderr, "Error: Missing '(' after gate type for %.*s on line %d\n",
+                output.length, output.text, parser->line);
+        return;
+    }
+
+    int input_count = 0;
+    if (!accept(parser, ')')) {
+        do {
+            NameView input = read_name(parser);
+            if (input.length == 0) {
+                fprintf(stderr, "Error: Malformed input list for %.*s on line %d\n",
+                        output.length, output.text, parser->line);
+                return;
+            }
+            if (!append_input(parser, input_count, input)) {
+                fprintf(stderr, "Error: Out of memory reading gate %.*s\n", output.length, output.text);
+                parser->stopped = true;
+                return;
+            }
+            input_count++;
+        } while (accept(parser, ','));
+
+        if (!accept(parser, ')')) {
+            fprintf(stderr, "Error: Expected ',' or ')' in inputs of gate %.*s on line %d\n",
+                    output.length, output.text, parser->line);
+            return;
+        }
+    }
+
+    if (name_equals_upper(type_name, "DFF")) {
+        if (input_count != 1) {
+            fprintf(stderr, "Error: DFF %.*s needs exactly one input on line %d\n",
+                    output.length, output.text, parser->line);
+            return;
+        }
+        // Cut the flip-flop: its output is a pseudo input, its data input a pseudo output
+        if (declare(parser, DECLARE_INPUT, output)) declare(parser, DECLARE_OUTPUT, parser->inputs[0]);
+        return;
+    }
+
+    GateType type = bench_gate_type(type_name);
+    if (type == GATE_UNKNOWN) {
+        fprintf(stderr, "Error: Unknown gate type %.*s for %.*s on line %d\n",
+                type_name.length, type_name.text, output.length, output.text, parser->line);
+        return;
+    }
+    if (input_count == 0) {
+        fprintf(stderr, "Error: Gate %.*s has no inputs on line %d\n", output.length, output.text, parser->line);
+        return;
+    }
+
+    const ParseSink* sink = parser->sink;
+    if (sink->gate && !sink->gate(sink->user, type, output, output, parser->inputs, input_count)) {
+        parser->stopped = true;
+    }
+}
+
+// One statement per line; malformed lines are reported and skipped
+static void run_parser(BenchParser* parser) {
+    while (!parser->stopped && parser->cursor < parser->end) {
+        skip_blanks(parser);
+        if (parser->cursor >= parser->end) break;
+        if (*parser->cursor == '\n' || *parser->cursor == '#') {
+            skip_line(parser);
+            continue;
+        }
+
+        NameView first = read_name(parser);
+        if (first.length == 0) {
+            fprintf(stderr, "Error: Unexpected '%c' on line %d\n", *parser->cursor, parser->line);
+        } else if (accept(parser, '(')) {
+            if (name_equals_upper(first, "INPUT")) {
+                parse_declaration(parser, DECLARE_INPUT, first);
+            } else if (name_equals_upper(first, "OUTPUT")) {
+                parse_declaration(parser, DECLARE_OUTPUT, first);
+            } else {
+                fprintf(stderr, "Error: Unknown statement %.*s on line %d\n", first.length, first.text, parser->line);
+            }
+        } else if (accept(parser, '=')) {
+            parse_gate(parser, first);
+        } else {
+            fprintf(stderr, "Error: Expected '=' after %.*s on line %d\n", first.length, first.text, parser->line);
+        }
+        skip_line(parser);
+    }
+}
+
+// --- Public Function Implementations ---
+
+int parse_bench_buffer(const char* data, size_t size, const char* module_name, const ParseSink* sink) {
+    BenchParser parser = { sink, data, data + size, 1, NULL, 0, false };
+
+    NameView module = { module_name, (int)strlen(module_name) };
+    if (sink->module && !sink->module(sink->user, module)) return 1;
+    run_parser(&parser);
+
+    free(parser.inputs);
+    return parser.stopped ? 1 : 0;
+}
+
+int parse_bench_stream(const char* filename, const ParseSink* sink) {
+    VerilogLexer file;
+    if (lexer_open(&file, filename) != 0) {
+        perror("Error opening bench file");
+        return 1;
+    }
+
+    // Module name: the file name without directory and extension
+    const char* base = strrchr(filename, '/');
+    base = base ? base + 1 : filename;
+    char module_name[MAX_NAME_LENGTH];
+    size_t length = strcspn(base, ".");
+    if (length >= sizeof(module_name)) length = sizeof(module_name) - 1;
+    memcpy(module_name, base, length);
+    module_name[length] = '\0';
+
+    int status = parse_bench_buffer(file.data, file.size, module_name, sink);
+    lexer_close(&file);
+    return status;
+}
+
+// Extension of a file name, ignoring a trailing ".gz" or ".zst"
+static NameView format_extension(const char* filename) {
+    const char* base = strrchr(filename, '/');
+    base = base ? base + 1 : filename;
+    NameView extension = { NULL, 0 };
+    int length = (int)strlen(base);
+    for (int pass = 0; pass < 2; pass++) {
+        int dot = length - 1;
+        while (dot >= 0 && base[dot] != '.') dot--;
+        if (dot < 0) return (NameView){ NULL, 0 };
+        extension.text = base + dot + 1;
+        extension.length = length - dot - 1;
+        if (!name_equals_upper(extension, "GZ") && !name_equals_upper(extension, "ZST")) break;
+        length = dot;
+    }
+    return extension;
+}
+
+NetlistFormat detect_netlist_format(const char* filename) {
+    NameView extension = format_extension(filename);
+    if (extension.text) {
+        if (name_equals_upper(extension, "BENCH")) return NETLIST_BENCH;
+        if (name_equals_upper(extension, "V")) return NETLIST_VERILOG;
+    }
+
+    // Unknown extension: look at the first statement (a Verilog file starts with a
+    // comment or "module"; ".bench" with '#', "INPUT(" or "x = ...")
+    InputStream* stream = open_input_stream(filename);
+    if (!stream) return NETLIST_VERILOG;
+    char head[FORMAT_SNIFF_BYTES];
+    size_t size = read_input_stream(stream, head, sizeof(head));
+    close_input_stream(stream);
+
+    BenchParser parser = { NULL, head, head + size, 1, NULL, 0, false };
+    for (;;) {
+        skip_blanks(&parser);
+        if (parser.cursor >= parser.end) return NETLIST_VERILOG;
+        if (*parser.cursor == '#') return NETLIST_BENCH;   // Verilog has no '#' comments
+        if (*parser.cursor != '\n') break;
+        skip_line(&parser);
+    }
+    NameView first = read_name(&parser);
+    if (first.length == 0) return NETLIST_VERILOG;
+    if (accept(&parser, '=')) return NETLIST_BENCH;
+    if ((name_equals_upper(first, "INPUT") || name_equals_upper(first, "OUTPUT")) && accept(&parser, '(')) {
+        return NETLIST_BENCH;
+    }
+    return NETLIST_VERILOG;
+}
@@ -0,0 +1,55 @@
+#ifndef BENCH_PARSER_H
+#define BENCH_PARSER_H
+
+#include "verilog_parser.h"
+#include <stddef.h>
+
+// Reader for the ISCAS/ITC'99 .bench netlist format:
+//
+//   # comment
+//   INPUT(G1)
+//   OUTPUT(G22)
+//   G10 = NAND(G1, G3)
+//   G5 = DFF(G10)
+//
+// Statements are handed to the same ParseSink as the Verilog parser, so the
+// circuit builder does not care which format a netlist came in. The file is
+// scanned in place like verilog_lexer.h does; names are views into it.
+//
+// .bench has no module or instance names: the module is named after the file
+// and each gate instance after its output signal. The simulator is purely
+// combinational, so flip-flops are cut (full-scan view): "Q = DFF(D)" declares
+// Q as an input and D as an output.
+
+typedef enum {
+    NETLIST_VERILOG,
+    NETLIST_BENCH
+} NetlistFormat;
+
+/**
+ * @brief Guesses a netlist's format from its extension (a .gz or .zst suffix is
+ *        skipped), else from its first statement.
+ * @param filename Path of the netlist.
+ * @return NETLIST_BENCH for .bench files, NETLIST_VERILOG otherwise.
+ */
+NetlistFormat detect_netlist_format(const char* filename);
+
+/**
+ * @brief Parses a .bench file, handing each statement to a sink.
+ * @param filename The path to the .bench file.
+ * @param sink Receives the module name, declarations and gates in source order.
+ * @return 0 on success, 1 if the file cannot be read or a callback stopped the parse.
+ */
+int parse_bench_stream(const char* filename, const ParseSink* sink);
+
+/**
+ * @brief Parses .bench text held in memory.
+ * @param data Text to parse (need not be NUL-terminated).
+ * @param size Length of the text.
+ * @param module_name Name reported to sink->module.
+ * @param sink Receives the statements.
+ * @return 0 on success, 1 if a callback stopped the parse.
+ */
+int parse_bench_buffer(const char* data, size_t size, const char* module_name, const ParseSink* sink);
+
+#endif // BENCH_PARSER_H
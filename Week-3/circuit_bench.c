@@ -0,0 +1,536 @@
+// Performance benchmark for the parse, build and simulation phases.
+//
+// Usage: circuit_bench [options] <netlist>...
+//
+// Every netlist (flat Verilog or .bench, possibly compressed) is parsed,
+// built and levelized --repeat times; then each simulation engine, and the
+// batch pipeline, simulates random vectors --repeat times. Each repetition of
+// an engine runs as many vectors as fit in --sim-seconds (calibrated once),
+// so small and large circuits take comparable time.
+//
+// Metrics (the suffix gives the unit and direction):
+//   parse_ms          Parse only, statements handed to an empty sink
+//   build_ms          Parse and build, branch nodes included
+//   levelize_ms       levelize_circuit()
+//   circuit_bytes     Nodes, connections, PI/PO lists and name index
+//   peak_rss_kb       Peak resident size while benchmarking the netlist (Linux
+//                     resets the peak per netlist; elsewhere it is the process peak)
+//   <engine>_vps      Vectors per second (iterative, levelized, partitioned, scc, pipeline)
+//
+// Results go to stdout as a table and, with --json, to a file that holds one
+// result per line, so two runs diff cleanly. --baseline compares the medians
+// with an earlier --json file and exits with 1 if a metric got worse by more
+// than --tolerance percent.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "bench_parser.h"
+#include "circuit_builder.h"
+#include "circuit_node.h"
+#include "cone_partition.h"
+#include "engine_tuner.h"
+#include "levelizer.h"
+#include "scc.h"
+#include "sim_pipeline.h"
+#include "splitmix.h"
+#include "spsc_ring.h"
+#include "verilog_parser.h"
+
+#define BENCH_FORMAT_VERSION 1
+#define DEFAULT_REPEAT 5
+#define DEFAULT_SIM_SECONDS 0.1
+#define DEFAULT_TOLERANCE 15.0      // Percent; run-to-run noise is several percent
+#define SAMPLE_VECTORS 64
+#define MAX_PARTITIONS 8
+#define PIPELINE_BATCH 1024
+#define MAX_LOOP_VECTORS 1000000LL
+#define MIN_COMPARABLE_MS 0.05      // Smaller time differences are timer noise
+#define MAX_LINE 1024
+
+typedef struct {
+    char netlist[512];          // JSON-escaped
+    char metric[32];
+    double min;
+    double median;
+    double p90;
+    double max;
+    double mean;
+} BenchResult;
+
+typedef struct {
+    BenchResult* results;
+    int count;
+    int capacity;
+} ResultList;
+
+typedef struct {
+    int repeat;
+    double sim_seconds;
+} BenchOptions;
+
+// --- Statistics ---
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double* sorted, int count, double fraction) {
+    int rank = (int)(fraction * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+static void escape_json(const char* text, char* out, size_t size) {
+    size_t used = 0;
+    for (; *text && used + 7 < size; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (c == '"' || c == '\\') {
+            out[used++] = '\\';
+            out[used++] = (char)c;
+        } else if (c < 0x20) {
+            used += (size_t)snprintf(out + used, size - used, "\\u%04x", c);
+        } else {
+            out[used++] = (char)c;
+        }
+    }
+    out[used] = '\0';
+}
+
+static BenchResult* add_result(ResultList* list, const char* netlist, const char* metric,
+                               double* samples, int count) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        BenchResult* grown = (BenchResult*)realloc(list->results, (size_t)capacity * sizeof(BenchResult));
+        if (!grown) return NULL;
+        list->results = grown;
+        list->capacity = capacity;
+    }
+    BenchResult* result = &list->results[list->count++];
+    escape_json(netlist, result->netlist, sizeof(result->netlist));
+    snprintf(result->metric, sizeof(result->metric), "%s", metric);
+
+    qsort(samples, (size_t)count, sizeof(double), compare_doubles);
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += samples[i];
+    result->min = samples[0];
+    result->median = percentile(samples, count, 0.5);
+    result->p90 = percentile(samples, count, 0.9);
+    result->max = samples[count - 1];
+    result->mean = sum / count;
+    return result;
+}
+
+// --- Measurements ---
+
+static bool count_statement(void* user, DeclarationKind kind, NameView name) {
+    (void)kind; (void)name;
+    (*(long long*)user)++;
+    return true;
+}
+
+static bool count_gate(void* user, GateType type, NameView instance, NameView output,
+                       const NameView* inputs, int input_count) {
+    (void)type; (void)instance; (void)output; (void)inputs; (void)input_count;
+    (*(long long*)user)++;
+    return true;
+}
+
+static double time_parse(const char* path, NetlistFormat format) {
+    long long statements = 0;
+    ParseSink sink = { &statements, NULL, count_statement, count_gate, NULL };
+    double start = monotonic_seconds();
+    int status = (format == NETLIST_BENCH) ? parse_bench_stream(path, &sink) : parse_verilog_stream(path, &sink);
+    double elapsed = monotonic_seconds() - start;
+    return (status == 0 && statements > 0) ? elapsed : -1.0;
+}
+
+static Circuit* build_netlist(const char* path, NetlistFormat format, NetlistSummary* summary) {
+    if (format == NETLIST_BENCH) return build_circuit_from_bench_file(path, false, summary);
+    return build_circuit_from_file(path, false, summary);
+}
+
+static size_t circuit_footprint(const Circuit* circuit) {
+    size_t bytes = sizeof(Circuit) + (size_t)circuit->node_capacity * sizeof(CircuitNode) +
+                   (size_t)(circuit->pi_capacity + circuit->po_capacity) * sizeof(int) +
+                   ((size_t)circuit->name_index_mask + 1) * sizeof(int);
+    for (int i = 0; i < circuit->node_count; i++) {
+        bytes += (size_t)(circuit->nodes[i].fanin_count + circuit->nodes[i].fanout_count) * sizeof(ConnectionNode);
+    }
+    return bytes;
+}
+
+// Starts a new peak for peak_rss_kb() where the kernel supports it
+static void reset_peak_rss(void) {
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (!file) return;
+    fputs("5", file);
+    fclose(file);
+}
+
+static double peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return (double)usage.ru_maxrss;     // Kilobytes on Linux
+}
+
+typedef struct {
+    Circuit* circuit;
+    const Levelization* levels;
+    bool pipeline;              // The batch pipeline on every CPU instead of engine
+    SimEngine engine;
+    ConePartitioning* partitioning;
+    SccDecomposition* scc;
+    const SignalValue* sample;
+    FILE* sink;
+} EngineRun;
+
+// Simulates vectors with one engine; returns the elapsed seconds, or a negative value on failure
+static double run_engine(EngineRun* run, long long vectors) {
+    Circuit* circuit = run->circuit;
+    if (run->pipeline) {
+        PipelineOptions options;
+        init_pipeline_options(&options);
+        options.random_count = vectors;
+        options.output = run->sink;
+        options.worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (options.worker_count < 1) options.worker_count = 1;
+        options.batch_size = PIPELINE_BATCH;
+        PipelineStats stats;
+        if (run_simulation_pipeline(circuit, run->levels, &options, &stats) != 0) return -1.0;
+        return stats.wall_seconds;
+    }
+
+    double start = monotonic_seconds();
+    for (long long v = 0; v < vectors; v++) {
+        set_primary_inputs(circuit, run->sample + (v % SAMPLE_VECTORS) * circuit->pi_count);
+        switch (run->engine) {
+            case ENGINE_ITERATIVE:
+                simulate_circuit(circuit);
+                break;
+            case ENGINE_LEVELIZED:
+                simulate_levelized(circuit, run->levels);
+                break;
+            case ENGINE_PARTITIONED:
+                if (!simulate_partitions_parallel(circuit, run->partitioning)) return -1.0;
+                break;
+            case ENGINE_SCC:
+                simulate_scc(circuit, run->scc, NULL);
+                break;
+            default:
+                return -1.0;
+        }
+    }
+    return monotonic_seconds() - start;
+}
+
+// Vectors per second of one engine over options->repeat runs of about sim_seconds each
+static bool measure_engine(EngineRun* run, const BenchOptions* options, double* samples) {
+    // Calibrate by doubling the vector count until a run takes a quarter of the target
+    long long vectors = 1;
+    double seconds;
+    for (;;) {
+        seconds = run_engine(run, vectors);
+        if (seconds < 0.0) return false;
+        if (seconds >= options->sim_seconds / 4 || vectors >= MAX_LOOP_VECTORS) break;
+        vectors *= 2;
+    }
+    if (seconds > 0.0) vectors = (long long)(vectors * options->sim_seconds / seconds);
+    if (vectors < 1) vectors = 1;
+    if (vectors > MAX_LOOP_VECTORS) vectors = MAX_LOOP_VECTORS;
+
+    for (int r = 0; r < options->repeat; r++) {
+        seconds = run_engine(run, vectors);
+        if (seconds < 0.0) return false;
+        samples[r] = (double)vectors / (seconds > 1e-9 ? seconds : 1e-9);
+    }
+    return true;
+}
+
+static int bench_netlist(const char* path, const BenchOptions* options, ResultList* results,
+                         FILE* json, bool first_in_json) {
+    NetlistFormat format = detect_netlist_format(path);
+    reset_peak_rss();
+    double* samples = (double*)malloc((size_t)options->repeat * sizeof(double));
+    if (!samples) return 1;
+
+    for (int r = 0; r < options->repeat; r++) {
+        samples[r] = time_parse(path, format) * 1e3;
+        if (samples[r] < 0.0) {
+            fprintf(stderr, "Error: Failed to parse %s\n", path);
+            free(samples);
+            return 1;
+        }
+    }
+    add_result(results, path, "parse_ms", samples, options->repeat);
+
+    // Keep the last build for the simulation runs
+    Circuit* circuit = NULL;
+    NetlistSummary summary;
+    for (int r = 0; r < options->repeat; r++) {
+        destroy_circuit(circuit);
+        double start = monotonic_seconds();
+        circuit = build_netlist(path, format, &summary);
+        samples[r] = (monotonic_seconds() - start) * 1e3;
+        if (!circuit) {
+            fprintf(stderr, "Error: Failed to build %s%s\n", path,
+                    summary.hierarchical ? " (hierarchical netlists are not benchmarked)" : "");
+            free(samples);
+            return 1;
+        }
+    }
+    add_result(results, path, "build_ms", samples, options->repeat);
+
+    Levelization* levels = NULL;
+    for (int r = 0; r < options->repeat; r++) {
+        destroy_levelization(levels);
+        double start = monotonic_seconds();
+        levels = levelize_circuit(circuit);
+        samples[r] = (monotonic_seconds() - start) * 1e3;
+    }
+    add_result(results, path, "levelize_ms", samples, options->repeat);
+
+    double footprint = (double)circuit_footprint(circuit);
+    add_result(results, path, "circuit_bytes", &footprint, 1);
+
+    if (json) {
+        char escaped[512];
+        escape_json(path, escaped, sizeof(escaped));
+        fprintf(json, "%s    {\"netlist\": \"%s\", \"nodes\": %d, \"gates\": %d, \"pis\": %d, \"pos\": %d, "
+                "\"depth\": %d, \"acyclic\": %s}",
+                first_in_json ? "" : ",\n", escaped, circuit->node_count, summary.gate_count,
+                circuit->pi_count, circuit->po_count, levels ? levels->max_level : 0,
+                (levels && levels->is_acyclic) ? "true" : "false");
+    }
+
+    SignalValue* sample = (SignalValue*)malloc((size_t)SAMPLE_VECTORS * (size_t)circuit->pi_count * sizeof(SignalValue) + 1);
+    FILE* sink = fopen("/dev/null", "w");
+    if (levels && sample && sink && circuit->pi_count > 0) {
+        uint64_t state = 0x5EEDULL;
+        for (int i = 0; i < SAMPLE_VECTORS * circuit->pi_count; i++) {
+            sample[i] = (next_random(&state) & 1) ? LOGIC_1 : LOGIC_0;
+        }
+
+        EngineRun run = { circuit, levels, false, ENGINE_ITERATIVE, NULL, NULL, sample, sink };
+        int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        int partitions = cpus < circuit->po_count ? cpus : circuit->po_count;
+        if (partitions > MAX_PARTITIONS) partitions = MAX_PARTITIONS;
+        if (levels->is_acyclic && partitions > 1) run.partitioning = partition_output_cones(circuit, levels, partitions);
+        run.scc = compute_sccs(circuit);
+
+        // Every engine, then the pipeline (run.engine == ENGINE_COUNT)
+        for (int engine = ENGINE_ITERATIVE; engine <= ENGINE_COUNT; engine++) {
+            run.engine = (SimEngine)engine;
+            run.pipeline = (engine == ENGINE_COUNT);
+            const char* name = run.pipeline ? "pipeline" : engine_name(run.engine);
+            if (engine != ENGINE_ITERATIVE && engine != ENGINE_SCC && !levels->is_acyclic) continue;
+            if ((engine == ENGINE_PARTITIONED && !run.partitioning) || (engine == ENGINE_SCC && !run.scc)) continue;
+            if (!measure_engine(&run, options, samples)) {
+                fprintf(stderr, "Warning: %s engine failed on %s\n", name, path);
+                continue;
+            }
+            char metric[32];
+            snprintf(metric, sizeof(metric), "%s_vps", name);
+            add_result(results, path, metric, samples, options->repeat);
+        }
+        destroy_cone_partitioning(run.partitioning);
+        destroy_scc_decomposition(run.scc);
+    }
+    if (sink) fclose(sink);
+    free(sample);
+
+    double rss = peak_rss_kb();
+    add_result(results, path, "peak_rss_kb", &rss, 1);
+
+    destroy_levelization(levels);
+    destroy_circuit(circuit);
+    free(samples);
+    return 0;
+}
+
+// --- Reporting ---
+
+static void print_results(const ResultList* results, int first) {
+    for (int i = first; i < results->count; i++) {
+        const BenchResult* r = &results->results[i];
+        printf("%-28s %-16s %14.6g %14.6g %14.6g %14.6g\n",
+               i == first ? r->netlist : "", r->metric, r->median, r->min, r->p90, r->max);
+    }
+}
+
+static void write_json_results(FILE* json, const ResultList* results) {
+    fprintf(json, "\n  ],\n  \"results\": [\n");
+    for (int i = 0; i < results->count; i++) {
+        const BenchResult* r = &results->results[i];
+        fprintf(json, "    {\"netlist\": \"%s\", \"metric\": \"%s\", \"min\": %.6g, \"median\": %.6g, "
+                "\"p90\": %.6g, \"max\": %.6g, \"mean\": %.6g}%s\n",
+                r->netlist, r->metric, r->min, r->median, r->p90, r->max, r->mean,
+                i + 1 < results->count ? "," : "");
+    }
+    fprintf(json, "  ]\n}\n");
+}
+
+// Copies the string value of "key" on a JSON line
+static bool json_string_field(const char* line, const char* key, char* out, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+    const char* start = strstr(line, pattern);
+    if (!start) return false;
+    start += strlen(pattern);
+    size_t length = 0;
+    while (start[length] && start[length] != '"') {
+        if (start[length] == '\\' && start[length + 1]) length++;
+        length++;
+    }
+    if (length >= size) return false;
+    memcpy(out, start, length);
+    out[length] = '\0';
+    return true;
+}
+
+// Compares medians with a baseline written by --json; returns the number of regressions
+static int compare_baseline(const char* baseline_path, const ResultList* results, double tolerance) {
+    FILE* file = fopen(baseline_path, "r");
+    if (!file) {
+        perror("Error opening baseline");
+        return -1;
+    }
+
+    int regressions = 0;
+    int compared = 0;
+    char line[MAX_LINE];
+    printf("\n=== Comparison with %s (tolerance %.1f%%) ===\n", baseline_path, tolerance);
+    while (fgets(line, sizeof(line), file)) {
+        BenchResult base;
+        const char* median = strstr(line, "\"median\": ");
+        if (!median || !json_string_field(line, "netlist", base.netlist, sizeof(base.netlist)) ||
+            !json_string_field(line, "metric", base.metric, sizeof(base.metric))) {
+            continue;
+        }
+        base.median = strtod(median + strlen("\"median\": "), NULL);
+
+        for (int i = 0; i < results->count; i++) {
+            const BenchResult* current = &results->results[i];
+            if (strcmp(current->netlist, base.netlist) != 0 || strcmp(current->metric, base.metric) != 0) continue;
+            compared++;
+            if (base.median <= 0.0) break;
+
+            // Throughput is better higher; times and sizes lower
+            size_t metric_length = strlen(base.metric);
+            bool higher_is_better = metric_length > 4 && strcmp(base.metric + metric_length - 4, "_vps") == 0;
+            double change = (current->median - base.median) / base.median * 100.0;
+            double worse = higher_is_better ? -change : change;
+            bool noise = metric_length > 3 && strcmp(base.metric + metric_length - 3, "_ms") == 0 &&
+                         current->median - base.median < MIN_COMPARABLE_MS;
+            if (worse > tolerance && !noise) {
+                printf("REGRESSION  %-28s %-16s %14.6g -> %-14.6g (%+.1f%%)\n",
+                       current->netlist, current->metric, base.median, current->median, change);
+                regressions++;
+            } else if (-worse > tolerance) {
+                printf("improved    %-28s %-16s %14.6g -> %-14.6g (%+.1f%%)\n",
+                       current->netlist, current->metric, base.median, current->median, change);
+            }
+            break;
+        }
+    }
+    fclose(file);
+    printf("%d metrics compared, %d regression%s\n", compared, regressions, regressions == 1 ? "" : "s");
+    return regressions;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [options] <netlist>...\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --repeat N            Repetitions of every measurement (default %d)\n", DEFAULT_REPEAT);
+    fprintf(stderr, "  --sim-seconds S       Length of one simulation repetition (default %.1f)\n", DEFAULT_SIM_SECONDS);
+    fprintf(stderr, "  --json FILE           Also write the results as JSON\n");
+    fprintf(stderr, "  --baseline FILE       Compare medians with an earlier --json file\n");
+    fprintf(stderr, "  --tolerance PCT       Allowed slowdown against the baseline (default %.0f)\n", DEFAULT_TOLERANCE);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = { DEFAULT_REPEAT, DEFAULT_SIM_SECONDS };
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    const char** netlists = (const char**)malloc((size_t)argc * sizeof(const char*));
+    int netlist_count = 0;
+    if (!netlists) return 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sim-seconds") == 0 && i + 1 < argc) {
+            options.sim_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            free(netlists);
+            return 1;
+        } else {
+            netlists[netlist_count++] = argv[i];
+        }
+    }
+    if (netlist_count == 0 || options.repeat < 1 || options.sim_seconds <= 0.0) {
+        print_usage(argv[0]);
+        free(netlists);
+        return 1;
+    }
+
+    FILE* json = NULL;
+    if (json_path) {
+        json = fopen(json_path, "w");
+        if (!json) {
+            perror("Error opening JSON output file");
+            free(netlists);
+            return 1;
+        }
+        fprintf(json, "{\n  \"version\": %d,\n  \"repetitions\": %d,\n  \"sim_seconds\": %g,\n  \"cpus\": %ld,\n"
+                "  \"netlists\": [\n", BENCH_FORMAT_VERSION, options.repeat, options.sim_seconds,
+                sysconf(_SC_NPROCESSORS_ONLN));
+    }
+
+    printf("%-28s %-16s %14s %14s %14s %14s\n", "Netlist", "Metric", "Median", "Min", "P90", "Max");
+    ResultList results = { NULL, 0, 0 };
+    int failures = 0;
+    for (int i = 0; i < netlist_count; i++) {
+        int first = results.count;
+        if (bench_netlist(netlists[i], &options, &results, json, i == failures) != 0) {
+            results.count = first;
+            failures++;
+            continue;
+        }
+        print_results(&results, first);
+        fflush(stdout);
+    }
+
+    int status = failures > 0 ? 1 : 0;
+    if (json) {
+        write_json_results(json, &results);
+        if (fclose(json) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", json_path);
+            status = 1;
+        }
+    }
+    if (baseline_path) {
+        int regressions = compare_baseline(baseline_path, &results, tolerance);
+        if (regressions != 0) status = 1;
+    }
+
+    free(results.results);
+    free(netlists);
+    return status;
+}
@@ -0,0 +1,283 @@
+#include "circuit_builder.h"
+#include "parallel_parser.h"
+#include "bench_parser.h"
+#include "sim_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+// Adds a primary input or output node
+static void add_port_node(Circuit* circuit, const char* name, NodeType type, bool verbose) {
+    const char* label = (type == NODE_PI) ? "input" : "output";
+    int node_id = add_node(circuit, name, type);
+    if (node_id == -1) {
+        fprintf(stderr, "Error: Failed to add primary %s %s\n", label, name);
+    } else if (verbose) {
+        printf("Added %s: %s (ID: %d)\n", type == NODE_PI ? "PI" : "PO", name, node_id);
+    }
+}
+
+// Adds a gate's output node and sets its gate properties; returns its ID or -1
+static int add_gate_node(Circuit* circuit, GateType type, const char* instance_name,
+                         const char* output_name, bool verbose) {
+    int output_node_id = add_node(circuit, output_name, NODE_GATE);
+    if (output_node_id == -1) {
+        fprintf(stderr, "Error: Failed to add gate output node %s\n", output_name);
+        return -1;
+    }
+
+    // Set gate properties
+    circuit->nodes[output_node_id].gate_type = type;
+    strncpy(circuit->nodes[output_node_id].gate_instance, instance_name,
+            sizeof(circuit->nodes[output_node_id].gate_instance) - 1);
+
+    if (verbose) printf("Added Gate: %s -> %s (ID: %d, Type: %s)\n",
+           instance_name, output_name, output_node_id,
+           gate_type_to_string(type));
+    return output_node_id;
+}
+
+// Adds an input node if it does not exist and connects it to the gate output
+static void connect_gate_input(Circuit* circuit, const char* input_name, int output_node_id, bool verbose) {
+    const char* output_name = circuit->nodes[output_node_id].name;
+    int input_node_id = add_node(circuit, input_name, NODE_GATE);
+    if (input_node_id == -1) {
+        fprintf(stderr, "Error: Failed to add input node %s\n", input_name);
+        return;
+    }
+
+    // Add connection from input to gate output
+    if (!add_connection(circuit, input_node_id, output_node_id)) {
+        fprintf(stderr, "Error: Failed to connect %s -> %s\n",
+                input_name, output_name);
+    } else if (verbose) {
+        printf("  Connected: %s (ID:%d) -> %s (ID:%d)\n",
+               input_name, input_node_id,
+               output_name, output_node_id);
+    }
+}
+
+// Node names hold MAX_NAME_LENGTH - 1 characters; truncating a longer net
+// name could merge it with another net, so the build fails instead
+static bool net_name_fits(const char* name, int length) {
+    if (length < MAX_NAME_LENGTH) return true;
+    fprintf(stderr, "Error: Net name %.*s... is longer than %d characters\n",
+            MAX_NAME_LENGTH - 1, name, MAX_NAME_LENGTH - 1);
+    return false;
+}
+
+static bool parsed_names_fit(const ParseContext* ctx, const int* ids, int count) {
+    for (int i = 0; i < count; i++) {
+        const char* name = parsed_name(ctx, ids[i]);
+        if (!net_name_fits(name, (int)strlen(name))) return false;
+    }
+    return true;
+}
+
+// Function to build circuit from parsed data (progress is printed when verbose)
+Circuit* build_circuit_from_parsed_data(const ParseContext* ctx, bool verbose) {
+    if (!parsed_names_fit(ctx, ctx->inputs.ids, ctx->inputs.count) ||
+        !parsed_names_fit(ctx, ctx->outputs.ids, ctx->outputs.count)) {
+        return NULL;
+    }
+    for (int i = 0; i < ctx->gate_count; i++) {
+        const GateInstance* gate = &ctx->gates[i];
+        if (!parsed_names_fit(ctx, &gate->output_signal, 1) ||
+            !parsed_names_fit(ctx, parsed_gate_inputs(ctx, gate), gate->input_count)) {
+            return NULL;
+        }
+    }
+
+    Circuit* circuit = create_circuit();
+    if (!circuit) {
+        fprintf(stderr, "Error: Failed to create circuit\n");
+        return NULL;
+    }
+
+    if (verbose) printf("Building circuit from parsed data...\n");
+
+    // Step 1: Add all primary input nodes
+    for (int i = 0; i < ctx->inputs.count; i++) {
+        add_port_node(circuit, parsed_name(ctx, ctx->inputs.ids[i]), NODE_PI, verbose);
+    }
+
+    // Step 2: Add all primary output nodes
+    for (int i = 0; i < ctx->outputs.count; i++) {
+        add_port_node(circuit, parsed_name(ctx, ctx->outputs.ids[i]), NODE_PO, verbose);
+    }
+
+    // Step 3: Add wire nodes and gate nodes from parsed gates
+    for (int i = 0; i < ctx->gate_count; i++) {
+        const GateInstance* gate = &ctx->gates[i];
+        const char* instance_name = parsed_name(ctx, gate->instance_name);
+
+        int output_node_id = add_gate_node(circuit, gate->type, instance_name,
+                                           parsed_name(ctx, gate->output_signal), verbose);
+        if (output_node_id == -1) continue;
+
+        const int* inputs = parsed_gate_inputs(ctx, gate);
+        for (int j = 0; j < gate->input_count; j++) {
+            connect_gate_input(circuit, parsed_name(ctx, inputs[j]), output_node_id, verbose);
+        }
+    }
+
+    // Step 4: Add branch nodes for fanout points
+    if (verbose) printf("\nAdding branch nodes for fanout points...\n");
+    add_branch_nodes(circuit);
+
+    if (verbose) printf("Circuit construction completed.\n\n");
+    return circuit;
+}
+
+// --- Streaming construction ---
+
+typedef struct {
+    Circuit* circuit;
+    NetlistSummary* summary;
+    bool verbose;
+    bool module_seen;
+} CircuitSink;
+
+// Node names are stored NUL-terminated; module and instance names are only
+// labels and are truncated like add_node() does
+static const char* view_to_name(NameView view, char buffer[MAX_NAME_LENGTH]) {
+    int length = view.length < MAX_NAME_LENGTH - 1 ? view.length : MAX_NAME_LENGTH - 1;
+    memcpy(buffer, view.text, (size_t)length);
+    buffer[length] = '\0';
+    return buffer;
+}
+
+// Like view_to_name() for a net, or NULL if the name does not fit
+static const char* view_to_net_name(NameView view, char buffer[MAX_NAME_LENGTH]) {
+    if (!net_name_fits(view.text, view.length)) return NULL;
+    return view_to_name(view, buffer);
+}
+
+// A flat circuit has one module and no instances; anything else stops the build
+static bool sink_module(void* user, NameView name) {
+    CircuitSink* target = (CircuitSink*)user;
+    if (target->module_seen) {
+        target->summary->hierarchical = true;
+        return false;
+    }
+    target->module_seen = true;
+    view_to_name(name, target->summary->module_name);
+    return true;
+}
+
+static bool sink_instance(void* user, NameView module, NameView instance,
+                          const NameView* formals, const NameView* actuals, int count) {
+    (void)module; (void)instance; (void)formals; (void)actuals; (void)count;
+    ((CircuitSink*)user)->summary->hierarchical = true;
+    return false;
+}
+
+static bool sink_declare(void* user, DeclarationKind kind, NameView name) {
+    CircuitSink* target = (CircuitSink*)user;
+    char buffer[MAX_NAME_LENGTH];
+    switch (kind) {
+        case DECLARE_INPUT:
+            target->summary->input_count++;
+            if (!view_to_net_name(name, buffer)) return false;
+            add_port_node(target->circuit, buffer, NODE_PI, target->verbose);
+            break;
+        case DECLARE_OUTPUT:
+            target->summary->output_count++;
+            if (!view_to_net_name(name, buffer)) return false;
+            add_port_node(target->circuit, buffer, NODE_PO, target->verbose);
+            break;
+        case DECLARE_WIRE:
+            target->summary->wire_count++; // Wires become nodes when a gate uses them
+            break;
+        case DECLARE_PORT:
+            break;
+    }
+    return true;
+}
+
+static bool sink_gate(void* user, GateType type, NameView instance, NameView output,
+                      const NameView* inputs, int input_count) {
+    CircuitSink* target = (CircuitSink*)user;
+    char instance_name[MAX_NAME_LENGTH];
+    char name[MAX_NAME_LENGTH];
+    target->summary->gate_count++;
+
+    view_to_name(instance, instance_name);
+    if (!view_to_net_name(output, name)) return false;
+    int output_node_id = add_gate_node(target->circuit, type, instance_name, name, target->verbose);
+    if (output_node_id == -1) return true;
+
+    for (int j = 0; j < input_count; j++) {
+        if (!view_to_net_name(inputs[j], name)) return false;
+        connect_gate_input(target->circuit, name, output_node_id, target->verbose);
+    }
+    return true;
+}
+
+// Runs a streaming front-end (Verilog or .bench) into a new circuit
+static Circuit* build_streaming(const char* filename, int (*parse)(const char*, const ParseSink*),
+                                bool verbose, NetlistSummary* summary) {
+    NetlistSummary local_summary;
+    if (!summary) summary = &local_summary;
+    memset(summary, 0, sizeof(*summary));
+
+    Circuit* circuit = create_circuit();
+    if (!circuit) {
+        fprintf(stderr, "Error: Failed to create circuit\n");
+        return NULL;
+    }
+
+    if (verbose) printf("Building circuit while parsing...\n");
+
+    CircuitSink target = { circuit, summary, verbose, false };
+    ParseSink sink = { &target, sink_module, sink_declare, sink_gate, sink_instance };
+    double trace_begin = TRACE_BEGIN();
+    int status = parse(filename, &sink);
+    TRACE_END("parse netlist", trace_begin);
+    if (status != 0) {
+        destroy_circuit(circuit);
+        return NULL;
+    }
+
+    if (verbose) printf("\nAdding branch nodes for fanout points...\n");
+    add_branch_nodes(circuit);
+
+    if (verbose) printf("Circuit construction completed.\n\n");
+    return circuit;
+}
+
+Circuit* build_circuit_from_file(const char* filename, bool verbose, NetlistSummary* summary) {
+    return build_streaming(filename, parse_verilog_stream, verbose, summary);
+}
+
+Circuit* build_circuit_from_bench_file(const char* filename, bool verbose, NetlistSummary* summary) {
+    return build_streaming(filename, parse_bench_stream, verbose, summary);
+}
+
+Circuit* build_circuit_from_file_parallel(const char* filename, int threads, bool verbose, NetlistSummary* summary) {
+    NetlistSummary local_summary;
+    if (!summary) summary = &local_summary;
+    memset(summary, 0, sizeof(*summary));
+
+    ParseContext* ctx = create_parse_context();
+    if (!ctx) return NULL;
+    double trace_begin = TRACE_BEGIN();
+    int status = parse_verilog_parallel(ctx, filename, threads);
+    TRACE_END("parse netlist", trace_begin);
+    if (status != 0 || ctx->hierarchical) {
+        summary->hierarchical = ctx->hierarchical;
+        destroy_parse_context(ctx);
+        return NULL;
+    }
+
+    strncpy(summary->module_name, parsed_name(ctx, ctx->module_name), MAX_NAME_LENGTH - 1);
+    summary->input_count = ctx->inputs.count;
+    summary->output_count = ctx->outputs.count;
+    summary->wire_count = ctx->wires.count;
+    summary->gate_count = ctx->gate_count;
+
+    trace_begin = TRACE_BEGIN();
+    Circuit* circuit = build_circuit_from_parsed_data(ctx, verbose);
+    TRACE_END("build circuit", trace_begin);
+    destroy_parse_context(ctx);
+    return circuit;
+}
@@ -0,0 +1,73 @@
+#ifndef CIRCUIT_BUILDER_H
+#define CIRCUIT_BUILDER_H
+
+#include "circuit_node.h"
+#include "verilog_parser.h"
+#include <stdbool.h>
+
+// What a streaming build saw in the netlist
+typedef struct {
+    char module_name[MAX_NAME_LENGTH];
+    int input_count;
+    int output_count;
+    int wire_count;
+    int gate_count;
+    bool hierarchical;      // Several modules or module instances: load with load_design()
+} NetlistSummary;
+
+/**
+ * @brief Builds a circuit from a context filled by parse_verilog_module().
+ *
+ * Adds PI/PO nodes, one node per gate output with its fanin connections,
+ * and finally the branch nodes for fanout points. Net names longer than
+ * MAX_NAME_LENGTH - 1 characters are reported and fail the build.
+ * @param ctx Parsed netlist.
+ * @param verbose Print every node and connection as it is added.
+ * @return New circuit (caller destroys), or NULL on failure.
+ */
+Circuit* build_circuit_from_parsed_data(const ParseContext* ctx, bool verbose);
+
+/**
+ * @brief Parses a Verilog file straight into a new circuit.
+ *
+ * Nodes and connections are created as each declaration and gate is read, so
+ * no intermediate tables are kept and every name is resolved once. Nodes are
+ * numbered in source order (for ISCAS netlists, inputs then outputs then gates,
+ * as with build_circuit_from_parsed_data()).
+ *
+ * Only flat netlists are built: at a second module header or a module instance
+ * the build stops and returns NULL with summary->hierarchical set. As with
+ * build_circuit_from_parsed_data(), a net name too long for a node fails the build.
+ * @param filename Verilog netlist.
+ * @param verbose Print every node and connection as it is added.
+ * @param summary Receives the module name and statement counts (may be NULL).
+ * @return New circuit (caller destroys), or NULL on failure or for a hierarchical netlist.
+ */
+Circuit* build_circuit_from_file(const char* filename, bool verbose, NetlistSummary* summary);
+
+/**
+ * @brief Like build_circuit_from_file(), for an ISCAS/ITC'99 .bench netlist.
+ *
+ * Flip-flops are cut into a pseudo input and a pseudo output (see bench_parser.h).
+ * @param filename .bench netlist.
+ * @param verbose Print every node and connection as it is added.
+ * @param summary Receives the module name and statement counts (may be NULL).
+ * @return New circuit (caller destroys), or NULL on failure.
+ */
+Circuit* build_circuit_from_bench_file(const char* filename, bool verbose, NetlistSummary* summary);
+
+/**
+ * @brief Like build_circuit_from_file(), tokenizing the netlist on several threads.
+ *
+ * The file is parsed by parse_verilog_parallel() into tables, which are then
+ * built serially; worthwhile for netlists of many megabytes. Hierarchical
+ * netlists are reported as by build_circuit_from_file().
+ * @param filename Verilog netlist.
+ * @param threads Parser threads (<= 0: one per online CPU).
+ * @param verbose Print every node and connection as it is added.
+ * @param summary Receives the module name and statement counts (may be NULL).
+ * @return New circuit (caller destroys), or NULL on failure.
+ */
+Circuit* build_circuit_from_file_parallel(const char* filename, int threads, bool verbose, NetlistSummary* summary);
+
+#endif // CIRCUIT_BUILDER_H
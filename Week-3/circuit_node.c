@@ -1,32 +1,28 @@
 #include "circuit_node.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+
+#define INITIAL_NAME_INDEX_SLOTS 1024
 
 Circuit* create_circuit(void) {
-    Circuit* circuit = (Circuit*)malloc(sizeof(Circuit));
+    Circuit* circuit = (Circuit*)calloc(1, sizeof(Circuit));
     if (!circuit) return NULL;
     
-    circuit->node_count = 0;
-    circuit->pi_count = 0;
-    circuit->po_count = 0;
     circuit->simulation_stable = false;
     circuit->iteration_count = 0;
     
-    // Initialize all nodes
-    for (int i = 0; i < MAX_NODES; i++) {
-        circuit->nodes[i].name[0] = '\0';
-        circuit->nodes[i].id = -1;
-        circuit->nodes[i].type = NODE_GATE;
-        circuit->nodes[i].gate_type = GATE_UNKNOWN;
-        circuit->nodes[i].value = LOGIC_X;
-        circuit->nodes[i].fanin_list = NULL;
-        circuit->nodes[i].fanout_list = NULL;
-        circuit->nodes[i].fanin_count = 0;
-        circuit->nodes[i].fanout_count = 0;
-        circuit->nodes[i].gate_instance[0] = '\0';
-        circuit->nodes[i].is_evaluated = false;
+    // Nodes and PI/PO arrays are allocated as they are added
+    circuit->name_index = (int*)malloc(INITIAL_NAME_INDEX_SLOTS * sizeof(int));
+    if (!circuit->name_index) {
+        free(circuit);
+        return NULL;
     }
+    memset(circuit->name_index, -1, INITIAL_NAME_INDEX_SLOTS * sizeof(int));
+    circuit->name_index_mask = INITIAL_NAME_INDEX_SLOTS - 1;
     
     return circuit;
 }
@@ -34,6 +30,12 @@ Circuit* create_circuit(void) {
 void destroy_circuit(Circuit* circuit) {
     if (!circuit) return;
     
+    if (circuit->mapping) {
+        munmap(circuit->mapping, circuit->mapping_size);
+        free(circuit);
+        return;
+    }
+    
     // Free all connection lists
     for (int i = 0; i < circuit->node_count; i++) {
         ConnectionNode* current = circuit->nodes[i].fanin_list;
@@ -51,20 +53,76 @@ void destroy_circuit(Circuit* circuit) {
         }
     }
     
+    free(circuit->nodes);
+    free(circuit->primary_inputs);
+    free(circuit->primary_outputs);
+    free(circuit->name_index);
     free(circuit);
 }
 
+bool reserve_circuit_nodes(Circuit* circuit, int capacity) {
+    if (!circuit) return false;
+    if (capacity <= circuit->node_capacity) return true;
+    if (circuit->mapping) return false;
+    
+    int new_capacity = circuit->node_capacity ? circuit->node_capacity : 256;
+    while (new_capacity < capacity) new_capacity *= 2;
+    CircuitNode* nodes = (CircuitNode*)realloc(circuit->nodes, (size_t)new_capacity * sizeof(CircuitNode));
+    if (!nodes) return false;
+    circuit->nodes = nodes;
+    circuit->node_capacity = new_capacity;
+    return true;
+}
+
+// Appends a node ID to a growable PI/PO array
+static bool append_node_id(int** ids, int* count, int* capacity, int node_id) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        int* grown = (int*)realloc(*ids, (size_t)new_capacity * sizeof(int));
+        if (!grown) return false;
+        *ids = grown;
+        *capacity = new_capacity;
+    }
+    (*ids)[(*count)++] = node_id;
+    return true;
+}
+
+static unsigned name_slot(const Circuit* circuit, const char* name) {
+    return string_pool_hash(name, (int)strlen(name)) & (unsigned)circuit->name_index_mask;
+}
+
+// Keeps the name index at most half full
+static bool grow_name_index(Circuit* circuit) {
+    int slots = (circuit->name_index_mask + 1) * 2;
+    int* index = (int*)malloc((size_t)slots * sizeof(int));
+    if (!index) return false;
+    memset(index, -1, (size_t)slots * sizeof(int));
+    free(circuit->name_index);
+    circuit->name_index = index;
+    circuit->name_index_mask = slots - 1;
+    
+    for (int id = 0; id < circuit->node_count; id++) {
+        unsigned slot = name_slot(circuit, circuit->nodes[id].name);
+        while (index[slot] >= 0) slot = (slot + 1) & (unsigned)circuit->name_index_mask;
+        index[slot] = id;
+    }
+    return true;
+}
+
 int add_node(Circuit* circuit, const char* name, NodeType type) {
-    if (!circuit || !name || circuit->node_count >= MAX_NODES) {
+    if (!circuit || !name || circuit->mapping) {
         return -1;
     }
     
     // Check if node already exists
     int existing_id = find_node_by_name(circuit, name);
     if (existing_id != -1) {
-        // Update type if more specific (PI/PO take precedence over GATE)
+        // Update type if more specific (PI/PO take precedence over GATE, and a
+        // PI that is also a PO, such as a cut flip-flop feeding another, stays a PI)
         if (type == NODE_PI || type == NODE_PO) {
-            circuit->nodes[existing_id].type = type;
+            if (type == NODE_PI || circuit->nodes[existing_id].type != NODE_PI) {
+                circuit->nodes[existing_id].type = type;
+            }
             
             // Add to appropriate lists if not already there
             if (type == NODE_PI) {
@@ -75,8 +133,8 @@ int add_node(Circuit* circuit, const char* name, NodeType type) {
                         break;
                     }
                 }
-                if (!found && circuit->pi_count < MAX_SIGNALS) {
-                    circuit->primary_inputs[circuit->pi_count++] = existing_id;
+                if (!found && !append_node_id(&circuit->primary_inputs, &circuit->pi_count, &circuit->pi_capacity, existing_id)) {
+                    return -1;
                 }
             } else if (type == NODE_PO) {
                 bool found = false;
@@ -86,14 +144,17 @@ int add_node(Circuit* circuit, const char* name, NodeType type) {
                         break;
                     }
                 }
-                if (!found && circuit->po_count < MAX_SIGNALS) {
-                    circuit->primary_outputs[circuit->po_count++] = existing_id;
+                if (!found && !append_node_id(&circuit->primary_outputs, &circuit->po_count, &circuit->po_capacity, existing_id)) {
+                    return -1;
                 }
             }
         }
         return existing_id;
     }
     
+    if (!reserve_circuit_nodes(circuit, circuit->node_count + 1)) return -1;
+    if ((circuit->node_count + 1) * 2 > circuit->name_index_mask + 1 && !grow_name_index(circuit)) return -1;
+    
     // Create new node
     int node_id = circuit->node_count;
     CircuitNode* node = &circuit->nodes[node_id];
@@ -102,20 +163,26 @@ int add_node(Circuit* circuit, const char* name, NodeType type) {
     node->name[sizeof(node->name) - 1] = '\0';
     node->id = node_id;
     node->type = type;
+    node->gate_type = GATE_UNKNOWN;
     node->value = LOGIC_X;
     node->fanin_list = NULL;
     node->fanout_list = NULL;
     node->fanin_count = 0;
     node->fanout_count = 0;
+    node->gate_instance[0] = '\0';
     node->is_evaluated = false;
     
     // Add to primary input/output lists if applicable
-    if (type == NODE_PI && circuit->pi_count < MAX_SIGNALS) {
-        circuit->primary_inputs[circuit->pi_count++] = node_id;
-    } else if (type == NODE_PO && circuit->po_count < MAX_SIGNALS) {
-        circuit->primary_outputs[circuit->po_count++] = node_id;
+    if (type == NODE_PI) {
+        if (!append_node_id(&circuit->primary_inputs, &circuit->pi_count, &circuit->pi_capacity, node_id)) return -1;
+    } else if (type == NODE_PO) {
+        if (!append_node_id(&circuit->primary_outputs, &circuit->po_count, &circuit->po_capacity, node_id)) return -1;
     }
     
+    unsigned slot = name_slot(circuit, node->name);
+    while (circuit->name_index[slot] >= 0) slot = (slot + 1) & (unsigned)circuit->name_index_mask;
+    circuit->name_index[slot] = node_id;
+    
     circuit->node_count++;
     return node_id;
 }
@@ -123,10 +190,12 @@ int add_node(Circuit* circuit, const char* name, NodeType type) {
 int find_node_by_name(Circuit* circuit, const char* name) {
     if (!circuit || !name) return -1;
     
-    for (int i = 0; i < circuit->node_count; i++) {
-        if (strcmp(circuit->nodes[i].name, name) == 0) {
-            return i;
+    unsigned slot = name_slot(circuit, name);
+    for (int id = circuit->name_index[slot]; id >= 0; id = circuit->name_index[slot]) {
+        if (strcmp(circuit->nodes[id].name, name) == 0) {
+            return id;
         }
+        slot = (slot + 1) & (unsigned)circuit->name_index_mask;
     }
     return -1;
 }
@@ -139,7 +208,7 @@ int find_node_by_id(Circuit* circuit, int id) {
 }
 
 bool add_connection(Circuit* circuit, int from_node_id, int to_node_id) {
-    if (!circuit || from_node_id < 0 || to_node_id < 0 || 
+    if (!circuit || circuit->mapping || from_node_id < 0 || to_node_id < 0 || 
         from_node_id >= circuit->node_count || to_node_id >= circuit->node_count) {
         return false;
     }
@@ -165,15 +234,33 @@ bool add_connection(Circuit* circuit, int from_node_id, int to_node_id) {
     return true;
 }
 
+// A stem whose fanouts have not been split into branch nodes yet (branches
+// are prepended to the stem's fanout list, so a branched stem starts with one)
+static bool needs_branches(const Circuit* circuit, const CircuitNode* node) {
+    return node->fanout_count > 1 && node->type != NODE_BRNH &&
+           circuit->nodes[node->fanout_list->node_id].type != NODE_BRNH;
+}
+
 void add_branch_nodes(Circuit* circuit) {
     if (!circuit) return;
+    double trace_begin = TRACE_BEGIN();
+    
+    // Reserve every branch up front so node pointers stay valid below
+    int branch_total = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        if (needs_branches(circuit, &circuit->nodes[i])) {
+            branch_total += circuit->nodes[i].fanout_count - 1;
+        }
+    }
+    if (!reserve_circuit_nodes(circuit, circuit->node_count + branch_total)) return;
     
     // Find nodes with fanout > 1 and create branch nodes
     for (int i = 0; i < circuit->node_count; i++) {
         CircuitNode* node = &circuit->nodes[i];
         
-        if (node->fanout_count > 1 && node->type != NODE_BRNH) {
+        if (needs_branches(circuit, node)) {
             // This node needs branch nodes
+            int fanout_count = node->fanout_count;
             ConnectionNode* fanout = node->fanout_list;
             ConnectionNode* first_fanout = fanout;
             
@@ -183,12 +270,11 @@ void add_branch_nodes(Circuit* circuit) {
             
             while (fanout) {
                 // Create branch node name
-                char branch_name[64];
-                // snprintf(branch_name, sizeof(branch_name), "%s_b%d", node->name, branch_counter++);
+                char branch_name[MAX_NAME_LENGTH];
                 int written = snprintf(branch_name, sizeof(branch_name), "%s_b%d", node->name, branch_counter++);
-                if (written >= sizeof(branch_name)) {
-                    // Name was truncated, but continue anyway
-                    branch_name[sizeof(branch_name) - 1] = '\0';
+                if (written < 0 || written >= (int)sizeof(branch_name)) {
+                    // Truncated it could match another branch: a name no netlist net can have
+                    snprintf(branch_name, sizeof(branch_name), "~b%d", circuit->node_count);
                 }
                 
                 // Add branch node
@@ -201,21 +287,21 @@ void add_branch_nodes(Circuit* circuit) {
                 // Redirect original connection through branch node
                 int target_node = fanout->node_id;
                 
-                // Remove original connection from target's fanin
-                ConnectionNode** fanin_ptr = &circuit->nodes[target_node].fanin_list;
-                while (*fanin_ptr) {
-                    if ((*fanin_ptr)->node_id == i) {
-                        ConnectionNode* to_remove = *fanin_ptr;
-                        *fanin_ptr = (*fanin_ptr)->next;
-                        free(to_remove);
-                        circuit->nodes[target_node].fanin_count--;
+                // Point the target's fanin at the branch in place, keeping its pin order
+                for (ConnectionNode* fanin = circuit->nodes[target_node].fanin_list; fanin; fanin = fanin->next) {
+                    if (fanin->node_id == i) {
+                        fanin->node_id = branch_id;
                         break;
                     }
-                    fanin_ptr = &(*fanin_ptr)->next;
                 }
                 
-                // Add connection from branch node to target
-                add_connection(circuit, branch_id, target_node);
+                // Add the branch's fanout to the target
+                ConnectionNode* branch_fanout = (ConnectionNode*)malloc(sizeof(ConnectionNode));
+                if (!branch_fanout) break;
+                branch_fanout->node_id = target_node;
+                branch_fanout->next = NULL;
+                circuit->nodes[branch_id].fanout_list = branch_fanout;
+                circuit->nodes[branch_id].fanout_count = 1;
                 
                 fanout = fanout->next;
             }
@@ -228,9 +314,125 @@ void add_branch_nodes(Circuit* circuit) {
                 fanout = next;
             }
             first_fanout->next = NULL;
-            node->fanout_count = 1;
+            // The first fanout plus one branch per other fanout, as before
+            node->fanout_count = fanout_count;
+        }
+    }
+    TRACE_END("insert branches", trace_begin);
+}
+
+bool gate_arity_valid(GateType gate_type, int input_count) {
+    switch (gate_type) {
+        case GATE_AND:
+        case GATE_NAND:
+        case GATE_OR:
+        case GATE_NOR:  return input_count > 0;
+        case GATE_XOR:
+        case GATE_XNOR: return input_count == 2;
+        case GATE_NOT:
+        case GATE_BUFF: return input_count == 1;
+        default:        return false;
+    }
+}
+
+SignalValue evaluate_gate(GateType gate_type, const SignalValue inputs[], int input_count) {
+    SIM_STAT_ADD(gate_evals[(unsigned)gate_type < SIM_STATS_GATE_TYPES ? gate_type : GATE_UNKNOWN], 1);
+    switch (gate_type) {
+        case GATE_AND:  return evaluate_and(inputs, input_count);
+        case GATE_NAND: return evaluate_nand(inputs, input_count);
+        case GATE_OR:   return evaluate_or(inputs, input_count);
+        case GATE_NOR:  return evaluate_nor(inputs, input_count);
+        case GATE_XOR:
+            if (input_count == 2) return evaluate_xor2(inputs[0], inputs[1]);
+            return LOGIC_X;
+        case GATE_XNOR:
+            if (input_count == 2) return evaluate_xnor2(inputs[0], inputs[1]);
+            return LOGIC_X;
+        case GATE_NOT:
+            if (input_count == 1) return evaluate_not1(inputs[0]);
+            return LOGIC_X;
+        case GATE_BUFF:
+            if (input_count == 1) return evaluate_buff1(inputs[0]);
+            return LOGIC_X;
+        default:
+            return LOGIC_X;
+    }
+}
+
+uint64_t evaluate_gate_bits(GateType gate_type, const uint64_t inputs[], int input_count) {
+    if (!gate_arity_valid(gate_type, input_count)) return 0;
+    SIM_STAT_ADD(word_evals, 1);
+
+    uint64_t result = inputs[0];
+    switch (gate_type) {
+        case GATE_AND:
+        case GATE_NAND:
+            for (int i = 1; i < input_count; i++) result &= inputs[i];
+            return (gate_type == GATE_NAND) ? ~result : result;
+        case GATE_OR:
+        case GATE_NOR:
+            for (int i = 1; i < input_count; i++) result |= inputs[i];
+            return (gate_type == GATE_NOR) ? ~result : result;
+        case GATE_XOR:
+        case GATE_XNOR:
+            result ^= inputs[1];
+            return (gate_type == GATE_XNOR) ? ~result : result;
+        case GATE_NOT:  return ~result;
+        case GATE_BUFF: return result;
+        default:        return 0;
+    }
+}
+
+int max_fanin_count(const Circuit* circuit) {
+    int widest = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        if (circuit->nodes[i].fanin_count > widest) widest = circuit->nodes[i].fanin_count;
+    }
+    return widest;
+}
+
+// Evaluates a gate from its fanin values, read from values[] or, when values
+// is NULL, from the fanin nodes. Gates wider than MAX_GATE_INPUTS gather
+// their inputs in a heap buffer.
+static SignalValue evaluate_fanins(const Circuit* circuit, const CircuitNode* node, const SignalValue* values) {
+    SignalValue buffer[MAX_GATE_INPUTS];
+    SignalValue* inputs = buffer;
+    int capacity = MAX_GATE_INPUTS;
+    if (node->fanin_count > MAX_GATE_INPUTS) {
+        capacity = node->fanin_count;
+        inputs = (SignalValue*)malloc((size_t)capacity * sizeof(SignalValue));
+        if (!inputs) {
+            fprintf(stderr, "Error: Out of memory evaluating gate %s\n", node->name);
+            exit(EXIT_FAILURE);
         }
     }
+
+    int input_count = 0;
+    const ConnectionNode* fanin = node->fanin_list;
+    if (values) {
+        for (; fanin && input_count < capacity; fanin = fanin->next) inputs[input_count++] = values[fanin->node_id];
+    } else {
+        for (; fanin && input_count < capacity; fanin = fanin->next) inputs[input_count++] = circuit->nodes[fanin->node_id].value;
+    }
+    SignalValue result = evaluate_gate(node->gate_type, inputs, input_count);
+    if (inputs != buffer) free(inputs);
+    return result;
+}
+
+SignalValue evaluate_node_with_values(const Circuit* circuit, int node_id, const SignalValue* values) {
+    const CircuitNode* node = &circuit->nodes[node_id];
+
+    if (node->type == NODE_PI) {
+        return values[node_id];
+    }
+    if (node->type == NODE_BRNH) {
+        return node->fanin_list ? values[node->fanin_list->node_id] : values[node_id];
+    }
+    if (node->gate_type == GATE_UNKNOWN) {
+        return values[node_id];
+    }
+
+    return evaluate_fanins(circuit, node, values);
 }
 
 bool simulate_circuit(Circuit* circuit) {
@@ -249,6 +451,9 @@ bool simulate_circuit(Circuit* circuit) {
     while (changes_occurred && circuit->iteration_count < MAX_ITERATIONS) {
         changes_occurred = false;
         circuit->iteration_count++;
+        long long visited = 0;
+        long long changed = 0;
+        long long fanouts = 0;
         
         // Evaluate all nodes that have gate logic or are branch nodes
         for (int i = 0; i < circuit->node_count; i++) {
@@ -258,6 +463,7 @@ bool simulate_circuit(Circuit* circuit) {
             if (node->type == NODE_PI) {
                 continue;
             }
+            visited++;
             
             if (node->type == NODE_BRNH) {
                 // Branch nodes simply pass through the value
@@ -266,59 +472,67 @@ bool simulate_circuit(Circuit* circuit) {
                     if (node->value != input_value) {
                         node->value = input_value;
                         changes_occurred = true;
+                        changed++;
+                        fanouts += node->fanout_count;
                     }
                 }
             } else if (node->gate_type != GATE_UNKNOWN) {
                 // This is a gate node (could be GATE, PO, or any other type with gate logic)
-                // Collect input values
-                SignalValue inputs[MAX_GATE_INPUTS];
-                int input_count = 0;
-                
-                ConnectionNode* fanin = node->fanin_list;
-                while (fanin && input_count < MAX_GATE_INPUTS) {
-                    inputs[input_count++] = circuit->nodes[fanin->node_id].value;
-                    fanin = fanin->next;
-                }
-                
-                // Evaluate gate
-                SignalValue new_value = LOGIC_X;
-                switch (node->gate_type) {
-                    case GATE_AND:  new_value = evaluate_and(inputs, input_count); break;
-                    case GATE_NAND: new_value = evaluate_nand(inputs, input_count); break;
-                    case GATE_OR:   new_value = evaluate_or(inputs, input_count); break;
-                    case GATE_NOR:  new_value = evaluate_nor(inputs, input_count); break;
-                    case GATE_XOR:
-                        if (input_count == 2) new_value = evaluate_xor2(inputs[0], inputs[1]);
-                        break;
-                    case GATE_XNOR:
-                        if (input_count == 2) new_value = evaluate_xnor2(inputs[0], inputs[1]);
-                        break;
-                    case GATE_NOT:
-                        if (input_count == 1) new_value = evaluate_not1(inputs[0]);
-                        break;
-                    case GATE_BUFF:
-                        if (input_count == 1) new_value = evaluate_buff1(inputs[0]);
-                        break;
-                    default:
-                        new_value = LOGIC_X;
-                        break;
-                }
+                SignalValue new_value = evaluate_fanins(circuit, node, NULL);
                 
                 // Update value if changed
                 if (node->value != new_value) {
                     node->value = new_value;
                     changes_occurred = true;
+                    changed++;
+                    fanouts += node->fanout_count;
                 }
                 
                 node->is_evaluated = true;
             }
         }
+        SIM_STAT_ADD(nodes_visited, visited);
+        SIM_STAT_ADD(events_scheduled, changed);
+        SIM_STAT_ADD(events_processed, fanouts);
+        SIM_STAT_ADD(fixed_point_iterations, 1);
     }
     
     circuit->simulation_stable = !changes_occurred;
     return circuit->simulation_stable;
 }
 
+int simulate_circuit_values(const Circuit* circuit, SignalValue* values) {
+    const int MAX_ITERATIONS = 1000;
+    bool changes_occurred = true;
+    int iterations = 0;
+
+    while (changes_occurred && iterations < MAX_ITERATIONS) {
+        changes_occurred = false;
+        iterations++;
+
+        long long visited = 0;
+        long long changed = 0;
+        long long fanouts = 0;
+        for (int i = 0; i < circuit->node_count; i++) {
+            if (circuit->nodes[i].type == NODE_PI) continue;
+            visited++;
+
+            SignalValue new_value = evaluate_node_with_values(circuit, i, values);
+            if (values[i] != new_value) {
+                values[i] = new_value;
+                changes_occurred = true;
+                changed++;
+                fanouts += circuit->nodes[i].fanout_count;
+            }
+        }
+        SIM_STAT_ADD(nodes_visited, visited);
+        SIM_STAT_ADD(events_scheduled, changed);
+        SIM_STAT_ADD(events_processed, fanouts);
+        SIM_STAT_ADD(fixed_point_iterations, 1);
+    }
+    return changes_occurred ? -1 : iterations;
+}
+
 void set_primary_inputs(Circuit* circuit, const SignalValue* input_values) {
     if (!circuit || !input_values) return;
     
@@ -4,8 +4,9 @@
 #include "gate_logic.h"
 #include "verilog_parser.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-#define MAX_NODES 1000
 #define MAX_CONNECTIONS 50
 
 // Node types according to ISCAS format
@@ -27,7 +28,7 @@ struct ConnectionNode {
 
 // Main circuit node structure
 typedef struct {
-    char name[64];            // Node name (e.g., "N1", "N10", "N22")
+    char name[MAX_NAME_LENGTH]; // Node name (e.g., "N1", "N10", "N22")
     int id;                   // Unique integer ID
     NodeType type;            // Node type
     GateType gate_type;       // Gate type if this is a gate node
@@ -40,38 +41,70 @@ typedef struct {
     int fanout_count;
     
     // For gate nodes
-    char gate_instance[64];   // Gate instance name
+    char gate_instance[MAX_NAME_LENGTH]; // Gate instance name
     bool is_evaluated;        // Simulation flag
 } CircuitNode;
 
 // Main circuit structure
 typedef struct {
-    CircuitNode nodes[MAX_NODES];  // 1D array of nodes
+    CircuitNode* nodes;       // 1D array of nodes (grows; may move when nodes are added)
     int node_count;
+    int node_capacity;
     
     // Quick access arrays - store node IDs
-    int primary_inputs[MAX_SIGNALS];   // Indices into nodes array
-    int primary_outputs[MAX_SIGNALS];  // Indices into nodes array
+    int* primary_inputs;      // Indices into nodes array
+    int* primary_outputs;     // Indices into nodes array
     int pi_count;
     int po_count;
+    int pi_capacity;
+    int po_capacity;
+    
+    // Name lookup: open-addressing hash of node IDs (-1 = empty slot)
+    int* name_index;
+    int name_index_mask;
     
     // Simulation state
     bool simulation_stable;
     int iteration_count;
+    
+    // Set when the circuit was loaded from a compiled netlist (netlist_cache.h):
+    // the arrays above and all connections live in this private mapping, and
+    // the circuit is complete (no nodes or connections can be added)
+    void* mapping;
+    size_t mapping_size;
 } Circuit;
 
 // Function declarations
 Circuit* create_circuit(void);
 void destroy_circuit(Circuit* circuit);
 
+// Makes room for at least capacity nodes so later add_node() calls do not move them
+bool reserve_circuit_nodes(Circuit* circuit, int capacity);
 int add_node(Circuit* circuit, const char* name, NodeType type);
 int find_node_by_name(Circuit* circuit, const char* name);
 int find_node_by_id(Circuit* circuit, int id);
 
 bool add_connection(Circuit* circuit, int from_node_id, int to_node_id);
 void add_branch_nodes(Circuit* circuit);
+// Largest fanin count of any node, to size gate input buffers (0 for an empty circuit)
+int max_fanin_count(const Circuit* circuit);
+
+// Gate evaluation helpers (shared by all simulation engines)
+// Whether evaluate_gate() computes a value: XOR/XNOR take exactly 2 inputs, NOT/BUFF
+// exactly 1, the others at least 1; any other gate always evaluates to X
+bool gate_arity_valid(GateType gate_type, int input_count);
+SignalValue evaluate_gate(GateType gate_type, const SignalValue inputs[], int input_count);
+// Two-valued evaluation of 64 patterns at once (bit i of every word is pattern i).
+// X has no two-valued encoding, so gates failing gate_arity_valid() return 0;
+// callers model their X output themselves.
+uint64_t evaluate_gate_bits(GateType gate_type, const uint64_t inputs[], int input_count);
+// Evaluates a node reading its fanins from values[] (indexed by node ID) instead of node->value
+SignalValue evaluate_node_with_values(const Circuit* circuit, int node_id, const SignalValue* values);
 
 bool simulate_circuit(Circuit* circuit);
+// Same sweep as simulate_circuit() on a private values[] array (node->value untouched).
+// Returns the iteration count, or -1 if the values did not stabilize.
+int simulate_circuit_values(const Circuit* circuit, SignalValue* values);
 void set_primary_inputs(Circuit* circuit, const SignalValue* input_values);
 void reset_simulation(Circuit* circuit);
 
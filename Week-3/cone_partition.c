@@ -0,0 +1,325 @@
+#include "cone_partition.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int* compute_fanin_cone(const Circuit* circuit, const Levelization* levels, int node_id, int* out_count) {
+    if (out_count) *out_count = 0;
+    if (!circuit || !levels || !levels->is_acyclic || node_id < 0 || node_id >= circuit->node_count) {
+        return NULL;
+    }
+
+    int n = circuit->node_count;
+    unsigned char* visited = (unsigned char*)calloc(n, 1);
+    int* stack = (int*)malloc(n * sizeof(int));
+    int* cone = (int*)malloc(n * sizeof(int));
+    if (!visited || !stack || !cone) {
+        free(visited);
+        free(stack);
+        free(cone);
+        return NULL;
+    }
+
+    int count = 0;
+    int sp = 0;
+    stack[sp++] = node_id;
+    visited[node_id] = 1;
+    while (sp > 0) {
+        int id = stack[--sp];
+        // Collect level-order positions; mapped back to IDs after sorting
+        cone[count++] = levels->position[id];
+        if (circuit->nodes[id].type == NODE_PI) continue;
+        for (const ConnectionNode* fanin = circuit->nodes[id].fanin_list; fanin; fanin = fanin->next) {
+            if (!visited[fanin->node_id]) {
+                visited[fanin->node_id] = 1;
+                stack[sp++] = fanin->node_id;
+            }
+        }
+    }
+
+    qsort(cone, count, sizeof(int), compare_ints);
+    for (int i = 0; i < count; i++) {
+        cone[i] = levels->order[cone[i]];
+    }
+
+    free(visited);
+    free(stack);
+    *out_count = count;
+    return cone;
+}
+
+// PO cone used while assigning outputs to partitions
+typedef struct {
+    int po_index;
+    int* nodes;
+    int count;
+} OutputCone;
+
+static int compare_cones_by_size_desc(const void* a, const void* b) {
+    const OutputCone* x = (const OutputCone*)a;
+    const OutputCone* y = (const OutputCone*)b;
+    if (x->count != y->count) return (y->count > x->count) - (y->count < x->count);
+    return (x->po_index > y->po_index) - (x->po_index < y->po_index);
+}
+
+ConePartitioning* partition_output_cones(const Circuit* circuit, const Levelization* levels, int partition_count) {
+    if (!circuit || !levels || !levels->is_acyclic || circuit->po_count == 0) {
+        fprintf(stderr, "Error: Cone partitioning needs an acyclic circuit with outputs\n");
+        return NULL;
+    }
+
+    int n = circuit->node_count;
+    int po_count = circuit->po_count;
+    int k = partition_count;
+    if (k < 1) k = 1;
+    if (k > po_count) k = po_count;
+
+    // 1. Fanin cone of every PO
+    OutputCone* cones = (OutputCone*)calloc(po_count, sizeof(OutputCone));
+    unsigned char* member = (unsigned char*)calloc((size_t)k * n, 1);   // member[p * n + id]
+    int* sizes = (int*)calloc(k, sizeof(int));
+    int* assignment = (int*)malloc(po_count * sizeof(int));
+    ConePartitioning* result = (ConePartitioning*)calloc(1, sizeof(ConePartitioning));
+    if (!cones || !member || !sizes || !assignment || !result) goto fail;
+
+    for (int i = 0; i < po_count; i++) {
+        cones[i].po_index = i;
+        cones[i].nodes = compute_fanin_cone(circuit, levels, circuit->primary_outputs[i], &cones[i].count);
+        if (!cones[i].nodes) goto fail;
+    }
+
+    // 2. Greedy assignment, largest cones first
+    qsort(cones, po_count, sizeof(OutputCone), compare_cones_by_size_desc);
+    for (int i = 0; i < po_count; i++) {
+        int best = 0;
+        int best_cost = -1;
+        int best_added = 0;
+        for (int p = 0; p < k; p++) {
+            const unsigned char* in_partition = member + (size_t)p * n;
+            int added = 0;
+            for (int j = 0; j < cones[i].count; j++) {
+                if (!in_partition[cones[i].nodes[j]]) added++;
+            }
+            int cost = sizes[p] + added;
+            if (best_cost < 0 || cost < best_cost || (cost == best_cost && added < best_added)) {
+                best = p;
+                best_cost = cost;
+                best_added = added;
+            }
+        }
+
+        unsigned char* in_best = member + (size_t)best * n;
+        for (int j = 0; j < cones[i].count; j++) {
+            in_best[cones[i].nodes[j]] = 1;
+        }
+        sizes[best] = best_cost;
+        assignment[cones[i].po_index] = best;
+    }
+
+    // 3. Materialize non-empty partitions in level order and assign ownership
+    result->partitions = (ConePartition*)calloc(k, sizeof(ConePartition));
+    if (!result->partitions) goto fail;
+    result->circuit_node_count = n;
+
+    unsigned char* owned = (unsigned char*)calloc(n, 1);
+    if (!owned) goto fail;
+    result->covered = owned;
+
+    for (int p = 0; p < k; p++) {
+        if (sizes[p] == 0) continue;
+
+        const unsigned char* in_partition = member + (size_t)p * n;
+        ConePartition* part = &result->partitions[result->partition_count++];
+        part->nodes = (int*)malloc(sizes[p] * sizeof(int));
+        part->owned = (int*)malloc(sizes[p] * sizeof(int));
+        part->outputs = (int*)malloc(po_count * sizeof(int));
+        part->values = (SignalValue*)malloc(n * sizeof(SignalValue));
+        if (!part->nodes || !part->owned || !part->outputs || !part->values) goto fail;
+
+        for (int i = 0; i < levels->order_count; i++) {
+            int id = levels->order[i];
+            if (!in_partition[id]) continue;
+            part->nodes[part->node_count++] = id;
+            bool seed = (levels->level[id] == 0);
+            if (seed) part->seed_count++;
+            if (!owned[id]) {
+                owned[id] = 1;
+                result->covered_nodes++;
+                // Seeds are copied from the circuit, never written back
+                if (!seed) part->owned[part->owned_count++] = id;
+            }
+        }
+        for (int i = 0; i < po_count; i++) {
+            if (assignment[i] == p) part->outputs[part->output_count++] = i;
+        }
+
+        result->cone_node_total += part->node_count;
+    }
+
+    for (int i = 0; i < po_count; i++) free(cones[i].nodes);
+    free(cones);
+    free(member);
+    free(sizes);
+    free(assignment);
+    return result;
+
+fail:
+    fprintf(stderr, "Error: Failed to partition output cones\n");
+    if (cones) {
+        for (int i = 0; i < po_count; i++) free(cones[i].nodes);
+    }
+    free(cones);
+    free(member);
+    free(sizes);
+    free(assignment);
+    destroy_cone_partitioning(result);
+    return NULL;
+}
+
+void destroy_cone_partitioning(ConePartitioning* partitioning) {
+    if (!partitioning) return;
+    if (partitioning->partitions) {
+        for (int p = 0; p < partitioning->partition_count; p++) {
+            ConePartition* part = &partitioning->partitions[p];
+            free(part->nodes);
+            free(part->outputs);
+            free(part->owned);
+            free(part->values);
+        }
+        free(partitioning->partitions);
+    }
+    free(partitioning->covered);
+    free(partitioning);
+}
+
+// Evaluates a partition into its private buffer. Only reads the shared circuit.
+static void evaluate_partition(const Circuit* circuit, ConePartition* part) {
+    SignalValue* values = part->values;
+    int i = 0;
+    for (; i < part->seed_count; i++) {
+        int id = part->nodes[i];
+        values[id] = circuit->nodes[id].value;
+    }
+    for (; i < part->node_count; i++) {
+        int id = part->nodes[i];
+        values[id] = evaluate_node_with_values(circuit, id, values);
+    }
+    SIM_STAT_ADD(nodes_visited, part->node_count - part->seed_count);
+}
+
+// Copies evaluated gate values into the circuit; seeds are never passed in
+static void write_back(Circuit* circuit, const ConePartition* part, const int* ids, int count) {
+    for (int i = 0; i < count; i++) {
+        CircuitNode* node = &circuit->nodes[ids[i]];
+        node->value = part->values[ids[i]];
+        node->is_evaluated = (node->type != NODE_BRNH && node->gate_type != GATE_UNKNOWN);
+    }
+}
+
+void simulate_partition(Circuit* circuit, ConePartitioning* partitioning, int index) {
+    if (!circuit || !partitioning || index < 0 || index >= partitioning->partition_count) return;
+
+    ConePartition* part = &partitioning->partitions[index];
+    evaluate_partition(circuit, part);
+    write_back(circuit, part, part->nodes + part->seed_count, part->node_count - part->seed_count);
+}
+
+void evaluate_partition_values(const Circuit* circuit, const ConePartitioning* partitioning,
+                               int index, SignalValue* values) {
+    const ConePartition* part = &partitioning->partitions[index];
+    for (int i = part->seed_count; i < part->node_count; i++) {
+        int id = part->nodes[i];
+        values[id] = evaluate_node_with_values(circuit, id, values);
+    }
+    SIM_STAT_ADD(nodes_visited, part->node_count - part->seed_count);
+}
+
+typedef struct {
+    const Circuit* circuit;
+    ConePartition* part;
+} PartitionJob;
+
+// Only evaluates: the circuit is written after every worker has been joined
+static void* partition_worker(void* arg) {
+    PartitionJob* job = (PartitionJob*)arg;
+    trace_name_thread("partition", -1);
+    double trace_begin = TRACE_BEGIN();
+    evaluate_partition(job->circuit, job->part);
+    TRACE_END("simulate partition", trace_begin);
+    return NULL;
+}
+
+bool simulate_partitions_parallel(Circuit* circuit, ConePartitioning* partitioning) {
+    if (!circuit || !partitioning || partitioning->circuit_node_count != circuit->node_count) return false;
+
+    int k = partitioning->partition_count;
+    pthread_t* threads = (pthread_t*)malloc(k * sizeof(pthread_t));
+    PartitionJob* jobs = (PartitionJob*)malloc(k * sizeof(PartitionJob));
+    bool* started = (bool*)calloc(k, sizeof(bool));
+    bool all_started = (threads && jobs && started);
+
+    if (all_started) {
+        // Partition 0 runs on the calling thread
+        for (int p = 1; p < k; p++) {
+            jobs[p].circuit = circuit;
+            jobs[p].part = &partitioning->partitions[p];
+            started[p] = (pthread_create(&threads[p], NULL, partition_worker, &jobs[p]) == 0);
+            if (!started[p]) all_started = false;
+        }
+        jobs[0].circuit = circuit;
+        jobs[0].part = &partitioning->partitions[0];
+        partition_worker(&jobs[0]);
+
+        for (int p = 1; p < k; p++) {
+            if (started[p]) {
+                pthread_join(threads[p], NULL);
+            } else {
+                partition_worker(&jobs[p]);
+            }
+        }
+    } else {
+        for (int p = 0; p < k; p++) {
+            evaluate_partition(circuit, &partitioning->partitions[p]);
+        }
+    }
+
+    for (int p = 0; p < k; p++) {
+        const ConePartition* part = &partitioning->partitions[p];
+        write_back(circuit, part, part->owned, part->owned_count);
+    }
+
+    free(threads);
+    free(jobs);
+    free(started);
+
+    circuit->iteration_count = 1;
+    circuit->simulation_stable = true;
+    return all_started;
+}
+
+void print_cone_partitioning(const Circuit* circuit, const ConePartitioning* partitioning) {
+    if (!circuit || !partitioning) return;
+
+    printf("=== Output Cone Partitions ===\n");
+    for (int p = 0; p < partitioning->partition_count; p++) {
+        const ConePartition* part = &partitioning->partitions[p];
+        printf("Partition %d: %d nodes, %d outputs:", p, part->node_count, part->output_count);
+        for (int i = 0; i < part->output_count; i++) {
+            printf(" %s", circuit->nodes[circuit->primary_outputs[part->outputs[i]]].name);
+        }
+        printf("\n");
+    }
+    double duplication = partitioning->covered_nodes > 0
+        ? (double)partitioning->cone_node_total / (double)partitioning->covered_nodes : 0.0;
+    printf("Cone nodes: %d total, %d distinct (duplication %.2fx)\n\n",
+           partitioning->cone_node_total, partitioning->covered_nodes, duplication);
+}
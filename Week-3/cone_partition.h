@@ -0,0 +1,107 @@
+#ifndef CONE_PARTITION_H
+#define CONE_PARTITION_H
+
+#include "circuit_node.h"
+#include "levelizer.h"
+#include <stdbool.h>
+
+// Per-output fanin cone partitioning.
+//
+// Every primary output depends only on its transitive fanin cone. POs are
+// grouped into partitions so that overlapping cones share a partition (fewer
+// gates evaluated twice), and each partition is simulated independently from
+// its own level-ordered node list. Partitions never write shared state while
+// running: each evaluates into a private value buffer, and once every
+// partition has finished, the nodes each one owns (every gate is owned by
+// exactly one partition) are copied back.
+
+typedef struct {
+    int* nodes;              // Union of the member cones, in level order
+    int node_count;
+    int seed_count;          // Leading level-0 nodes (PIs, undriven) copied, not evaluated
+    int* outputs;            // Indices into circuit->primary_outputs
+    int output_count;
+    int* owned;              // Gates whose values this partition writes back (no seeds)
+    int owned_count;
+    SignalValue* values;     // Private evaluation buffer (node_count of the circuit)
+} ConePartition;
+
+typedef struct {
+    ConePartition* partitions;
+    int partition_count;
+    int circuit_node_count;
+    int cone_node_total;     // Sum of partition sizes (shared gates counted per partition)
+    int covered_nodes;       // Distinct nodes in any PO cone
+    unsigned char* covered;  // 1 for each node in some PO cone; the others are never evaluated
+} ConePartitioning;
+
+/**
+ * @brief Computes the transitive fanin cone of one node.
+ * @param circuit The circuit.
+ * @param levels Levelization of the circuit (must be acyclic).
+ * @param node_id Apex of the cone.
+ * @param out_count Receives the number of nodes in the cone.
+ * @return malloc'd array of node IDs in level order (caller frees), or NULL.
+ */
+int* compute_fanin_cone(const Circuit* circuit, const Levelization* levels, int node_id, int* out_count);
+
+/**
+ * @brief Groups primary outputs into partitions with minimal duplicated gates.
+ *
+ * Greedy assignment: POs are taken largest cone first, and each goes to the
+ * partition whose size grows the least once the cone is merged in. This both
+ * favours overlapping cones and keeps partition sizes balanced.
+ * @param circuit The circuit.
+ * @param levels Levelization of the circuit (must be acyclic).
+ * @param partition_count Requested number of partitions (capped at po_count).
+ * @return New partitioning, or NULL on error.
+ */
+ConePartitioning* partition_output_cones(const Circuit* circuit, const Levelization* levels, int partition_count);
+
+/**
+ * @brief Frees a partitioning.
+ */
+void destroy_cone_partitioning(ConePartitioning* partitioning);
+
+/**
+ * @brief Simulates a single partition in the calling thread.
+ *
+ * Only the nodes in the partition's cones are evaluated; use this when just
+ * the partition's outputs matter. Every gate in the partition's cones is
+ * written back to the circuit.
+ * @param circuit The circuit (PI values already set).
+ * @param partitioning The partitioning.
+ * @param index Partition to simulate.
+ */
+void simulate_partition(Circuit* circuit, ConePartitioning* partitioning, int index);
+
+/**
+ * @brief Evaluates one partition into a caller-owned value array.
+ *
+ * Reads the circuit and partitioning only, so several threads may evaluate
+ * the same partitioning concurrently with their own arrays.
+ * @param circuit The circuit.
+ * @param partitioning The partitioning.
+ * @param index Partition to evaluate.
+ * @param values One value per node; PI and undriven entries must be preset.
+ */
+void evaluate_partition_values(const Circuit* circuit, const ConePartitioning* partitioning,
+                               int index, SignalValue* values);
+
+/**
+ * @brief Simulates all partitions concurrently, one thread per partition.
+ *
+ * The threads only read the circuit; the owned values are copied back once
+ * they have all been joined.
+ * @param circuit The circuit (PI values already set).
+ * @param partitioning The partitioning.
+ * @return false if threads could not be started (falls back to sequential).
+ */
+bool simulate_partitions_parallel(Circuit* circuit, ConePartitioning* partitioning);
+
+/**
+ * @brief Prints partition sizes, outputs and the duplication factor.
+ */
+void print_cone_partitioning(const Circuit* circuit, const ConePartitioning* partitioning);
+
+#endif // CONE_PARTITION_H
@@ -0,0 +1,147 @@
+#include "cross_check.h"
+#include "splitmix.h"
+#include <stdlib.h>
+#include <string.h>
+
+void init_cross_check_stats(CrossCheckStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->first_mismatch_vector = -1;
+    stats->first_divergent_node = -1;
+    stats->engine_value = LOGIC_X;
+    stats->reference_value = LOGIC_X;
+}
+
+CrossChecker* create_cross_checker(const Circuit* circuit, const Levelization* levels,
+                                   double sample_rate, uint64_t seed) {
+    CrossChecker* checker = (CrossChecker*)calloc(1, sizeof(CrossChecker));
+    if (!checker) return NULL;
+
+    checker->reference = (SignalValue*)malloc((circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(SignalValue));
+    if (!checker->reference) {
+        free(checker);
+        return NULL;
+    }
+    checker->circuit = circuit;
+    checker->levels = levels;
+    checker->sample_rate = sample_rate;
+    checker->rng_state = seed;
+    init_cross_check_stats(&checker->stats);
+    return checker;
+}
+
+void destroy_cross_checker(CrossChecker* checker) {
+    if (!checker) return;
+    free(checker->reference);
+    free(checker);
+}
+
+static bool should_sample(CrossChecker* checker) {
+    if (checker->sample_rate >= 1.0) return true;
+    if (checker->sample_rate <= 0.0) return false;
+    double u = (double)(next_random(&checker->rng_state) >> 11) * (1.0 / 9007199254740992.0);
+    return u < checker->sample_rate;
+}
+
+static void record_mismatch(CrossChecker* checker, long long vector_index, int node_id, SignalValue engine_value) {
+    CrossCheckStats* stats = &checker->stats;
+    stats->mismatched_vectors++;
+    if (stats->first_mismatch_vector < 0 || vector_index < stats->first_mismatch_vector) {
+        stats->first_mismatch_vector = vector_index;
+        stats->first_divergent_node = node_id;
+        stats->engine_value = engine_value;
+        stats->reference_value = checker->reference[node_id];
+    }
+}
+
+// Whether the engine's value of a node differs from the reference (nodes out of scope never do)
+static bool node_diverges(const CrossChecker* checker, const SignalValue* engine_values, int id) {
+    if (checker->scope && !checker->scope[id]) return false;
+    return engine_values[id] != checker->reference[id];
+}
+
+// First node (in level order, then loop nodes by ID) where the engine differs
+static int first_divergent_node(const CrossChecker* checker, const SignalValue* engine_values) {
+    const Circuit* circuit = checker->circuit;
+    const Levelization* levels = checker->levels;
+
+    if (levels) {
+        for (int i = 0; i < levels->order_count; i++) {
+            int id = levels->order[i];
+            if (node_diverges(checker, engine_values, id)) return id;
+        }
+    }
+    for (int id = 0; id < circuit->node_count; id++) {
+        if (levels && levels->position[id] >= 0) continue;
+        if (node_diverges(checker, engine_values, id)) return id;
+    }
+    return -1;
+}
+
+bool cross_check_vector(CrossChecker* checker, long long vector_index, const SignalValue* inputs,
+                        const SignalValue* engine_values, const SignalValue* engine_outputs) {
+    const Circuit* circuit = checker->circuit;
+    checker->stats.vectors_seen++;
+    if (!should_sample(checker)) return true;
+    checker->stats.vectors_checked++;
+
+    for (int i = 0; i < circuit->node_count; i++) checker->reference[i] = LOGIC_X;
+    for (int i = 0; i < circuit->pi_count; i++) checker->reference[circuit->primary_inputs[i]] = inputs[i];
+    if (simulate_circuit_values(circuit, checker->reference) < 0) {
+        checker->stats.unstable_vectors++;
+        return true;
+    }
+
+    if (engine_values) {
+        int node_id = first_divergent_node(checker, engine_values);
+        if (node_id < 0) return true;
+        record_mismatch(checker, vector_index, node_id, engine_values[node_id]);
+        return false;
+    }
+
+    // Outputs only (e.g. a cache hit): report the earliest-levelled divergent PO
+    int divergent = -1;
+    int divergent_index = -1;
+    for (int i = 0; i < circuit->po_count; i++) {
+        int id = circuit->primary_outputs[i];
+        if (engine_outputs[i] == checker->reference[id]) continue;
+        if (divergent < 0 || (checker->levels && checker->levels->position[id] >= 0 &&
+                              checker->levels->position[id] < checker->levels->position[divergent])) {
+            divergent = id;
+            divergent_index = i;
+        }
+    }
+    if (divergent < 0) return true;
+    record_mismatch(checker, vector_index, divergent, engine_outputs[divergent_index]);
+    return false;
+}
+
+void merge_cross_check_stats(CrossCheckStats* into, const CrossCheckStats* from) {
+    into->vectors_seen += from->vectors_seen;
+    into->vectors_checked += from->vectors_checked;
+    into->mismatched_vectors += from->mismatched_vectors;
+    into->unstable_vectors += from->unstable_vectors;
+    if (from->first_mismatch_vector >= 0 &&
+        (into->first_mismatch_vector < 0 || from->first_mismatch_vector < into->first_mismatch_vector)) {
+        into->first_mismatch_vector = from->first_mismatch_vector;
+        into->first_divergent_node = from->first_divergent_node;
+        into->engine_value = from->engine_value;
+        into->reference_value = from->reference_value;
+    }
+}
+
+void print_cross_check_stats(FILE* stream, const Circuit* circuit, const CrossCheckStats* stats) {
+    fprintf(stream, "## Cross-Check Against Reference\n");
+    fprintf(stream, "Checked %lld of %lld vectors", stats->vectors_checked, stats->vectors_seen);
+    if (stats->unstable_vectors > 0) {
+        fprintf(stream, " (%lld skipped: reference did not stabilize)", stats->unstable_vectors);
+    }
+    fprintf(stream, ", %lld mismatched.\n", stats->mismatched_vectors);
+
+    if (stats->first_mismatch_vector >= 0) {
+        int id = stats->first_divergent_node;
+        fprintf(stream, "First divergence: vector %lld, node %s (ID %d): engine %c, reference %c\n",
+                stats->first_mismatch_vector + 1, circuit->nodes[id].name, id,
+                signal_value_to_char(stats->engine_value), signal_value_to_char(stats->reference_value));
+    }
+    fprintf(stream, "\n");
+}
@@ -0,0 +1,84 @@
+#ifndef CROSS_CHECK_H
+#define CROSS_CHECK_H
+
+#include "circuit_node.h"
+#include "levelizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Engine cross-checking.
+//
+// A sampled fraction of the vectors simulated by a fast engine is re-simulated
+// with the reference sweep of simulate_circuit() and compared node for node.
+// The first divergent node is reported in level order, so the earliest point
+// where the engine went wrong is named rather than a downstream symptom.
+//
+// A checker keeps private buffers and is not thread-safe: give each thread its
+// own and combine the results with merge_cross_check_stats().
+
+typedef struct {
+    long long vectors_seen;          // Vectors offered to the checker
+    long long vectors_checked;       // Vectors actually re-simulated
+    long long mismatched_vectors;
+    long long unstable_vectors;      // Reference did not settle (loops); not compared
+    long long first_mismatch_vector; // Index of the earliest mismatching vector, -1 if none
+    int first_divergent_node;        // Node ID in that vector, -1 if none
+    SignalValue engine_value;        // Values of first_divergent_node
+    SignalValue reference_value;
+} CrossCheckStats;
+
+typedef struct {
+    const Circuit* circuit;
+    const Levelization* levels;      // Defines the level order of the report
+    double sample_rate;              // 0..1
+    const unsigned char* scope;      // Nodes compared (nonzero entries), or NULL for all; set after creation
+    uint64_t rng_state;
+    SignalValue* reference;          // node_count reference values
+    CrossCheckStats stats;
+} CrossChecker;
+
+/**
+ * @brief Creates a checker.
+ * @param circuit The circuit (read only).
+ * @param levels Its levelization (nodes on loops are reported after the ordered ones).
+ * @param sample_rate Fraction of vectors to check (>= 1 checks all of them).
+ * @param seed Seed of the sampling decisions.
+ * @return New checker, or NULL on allocation failure.
+ */
+CrossChecker* create_cross_checker(const Circuit* circuit, const Levelization* levels,
+                                   double sample_rate, uint64_t seed);
+
+/**
+ * @brief Frees a checker.
+ */
+void destroy_cross_checker(CrossChecker* checker);
+
+/**
+ * @brief Offers one simulated vector to the checker.
+ * @param checker The checker.
+ * @param vector_index Index of the vector in the run (for the report).
+ * @param inputs PI values in circuit->primary_inputs order.
+ * @param engine_values All node values from the engine, or NULL if only outputs are known.
+ * @param engine_outputs PO values in circuit->primary_outputs order (used when engine_values is NULL).
+ * @return false if the vector was checked and diverged, true otherwise.
+ */
+bool cross_check_vector(CrossChecker* checker, long long vector_index, const SignalValue* inputs,
+                        const SignalValue* engine_values, const SignalValue* engine_outputs);
+
+/**
+ * @brief Adds the counters of one checker to another, keeping the earliest mismatch.
+ */
+void merge_cross_check_stats(CrossCheckStats* into, const CrossCheckStats* from);
+
+/**
+ * @brief Resets counters to "nothing seen".
+ */
+void init_cross_check_stats(CrossCheckStats* stats);
+
+/**
+ * @brief Prints a one-paragraph summary.
+ */
+void print_cross_check_stats(FILE* stream, const Circuit* circuit, const CrossCheckStats* stats);
+
+#endif // CROSS_CHECK_H
@@ -0,0 +1,252 @@
+#include "demand_eval.h"
+#include "sim_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// One pending node on the explicit DFS stack
+struct DemandFrame {
+    int node_id;
+    ConnectionNode* next_fanin;   // Next fanin to pull
+    int inputs_left;              // Fanins not read yet
+    bool has_x;                   // AND/OR family: an X input has been seen
+    bool have_first;              // XOR/XNOR: first operand already read
+    SignalValue first;            // XOR/XNOR: first operand
+};
+
+DemandEvaluator* create_demand_evaluator(Circuit* circuit) {
+    if (!circuit) return NULL;
+
+    DemandEvaluator* evaluator = (DemandEvaluator*)malloc(sizeof(DemandEvaluator));
+    if (!evaluator) return NULL;
+
+    int n = circuit->node_count > 0 ? circuit->node_count : 1;
+    evaluator->circuit = circuit;
+    evaluator->epoch = 0;
+    evaluator->done_epoch = (unsigned int*)calloc(n, sizeof(unsigned int));
+    evaluator->active_epoch = (unsigned int*)calloc(n, sizeof(unsigned int));
+    // A node is pushed at most once per evaluation, so node_count frames suffice
+    evaluator->stack = (struct DemandFrame*)malloc(n * sizeof(struct DemandFrame));
+    evaluator->stack_capacity = n;
+    evaluator->nodes_evaluated = 0;
+    evaluator->inputs_skipped = 0;
+
+    if (!evaluator->done_epoch || !evaluator->active_epoch || !evaluator->stack) {
+        destroy_demand_evaluator(evaluator);
+        return NULL;
+    }
+
+    demand_begin_vector(evaluator);
+    return evaluator;
+}
+
+void destroy_demand_evaluator(DemandEvaluator* evaluator) {
+    if (!evaluator) return;
+    free(evaluator->done_epoch);
+    free(evaluator->active_epoch);
+    free(evaluator->stack);
+    free(evaluator);
+}
+
+void demand_begin_vector(DemandEvaluator* evaluator) {
+    if (!evaluator) return;
+
+    evaluator->epoch++;
+    if (evaluator->epoch == 0) {
+        // Counter wrapped: clear the stamps so stale entries cannot match
+        for (int i = 0; i < evaluator->stack_capacity; i++) {
+            evaluator->done_epoch[i] = 0;
+            evaluator->active_epoch[i] = 0;
+        }
+        evaluator->epoch = 1;
+    }
+    evaluator->nodes_evaluated = 0;
+    evaluator->inputs_skipped = 0;
+}
+
+// Stores the final value of a node for the current vector
+static void resolve_node(DemandEvaluator* evaluator, int node_id, SignalValue value, bool computed) {
+    CircuitNode* node = &evaluator->circuit->nodes[node_id];
+    node->value = value;
+    if (computed) {
+        node->is_evaluated = (node->type != NODE_BRNH);
+        evaluator->nodes_evaluated++;
+        SIM_STAT_ADD(nodes_visited, 1);
+    }
+    evaluator->done_epoch[node_id] = evaluator->epoch;
+}
+
+// Starts evaluating a node. Returns true if the node could be resolved without
+// looking at any fanin; otherwise pushes a frame and returns false.
+static bool begin_node(DemandEvaluator* evaluator, int* sp, int node_id) {
+    CircuitNode* node = &evaluator->circuit->nodes[node_id];
+
+    // Primary inputs and undriven nodes keep their current value, as in simulate_circuit()
+    if (node->type == NODE_PI) {
+        resolve_node(evaluator, node_id, node->value, false);
+        return true;
+    }
+    if (node->type == NODE_BRNH) {
+        if (!node->fanin_list) {
+            resolve_node(evaluator, node_id, node->value, false);
+            return true;
+        }
+    } else if (node->gate_type == GATE_UNKNOWN) {
+        resolve_node(evaluator, node_id, node->value, false);
+        return true;
+    }
+
+    int input_count = node->fanin_count;
+    if (node->type != NODE_BRNH) {
+        // Arity mismatches evaluate to X without reading any input
+        if (!gate_arity_valid(node->gate_type, input_count)) {
+            evaluator->inputs_skipped += input_count;
+            resolve_node(evaluator, node_id, LOGIC_X, true);
+            return true;
+        }
+    }
+
+    struct DemandFrame* frame = &evaluator->stack[(*sp)++];
+    frame->node_id = node_id;
+    frame->next_fanin = node->fanin_list;
+    frame->inputs_left = (node->type == NODE_BRNH) ? 1 : input_count;
+    frame->has_x = false;
+    frame->have_first = false;
+    frame->first = LOGIC_X;
+    evaluator->active_epoch[node_id] = evaluator->epoch;
+    return false;
+}
+
+// Feeds one input value to a pending gate. Returns true once the output is
+// known, storing it in *result.
+static bool consume_input(const CircuitNode* node, struct DemandFrame* frame,
+                          SignalValue value, SignalValue* result) {
+    if (node->type == NODE_BRNH) {
+        *result = value;
+        return true;
+    }
+
+    switch (node->gate_type) {
+        case GATE_AND:
+        case GATE_NAND:
+            if (value == LOGIC_0) {
+                *result = (node->gate_type == GATE_AND) ? LOGIC_0 : LOGIC_1;
+                return true;
+            }
+            if (value == LOGIC_X) frame->has_x = true;
+            return false;
+        case GATE_OR:
+        case GATE_NOR:
+            if (value == LOGIC_1) {
+                *result = (node->gate_type == GATE_OR) ? LOGIC_1 : LOGIC_0;
+                return true;
+            }
+            if (value == LOGIC_X) frame->has_x = true;
+            return false;
+        case GATE_XOR:
+        case GATE_XNOR:
+            if (!frame->have_first) {
+                // An X operand already decides the output
+                if (value == LOGIC_X) {
+                    *result = LOGIC_X;
+                    return true;
+                }
+                frame->first = value;
+                frame->have_first = true;
+                return false;
+            }
+            *result = (node->gate_type == GATE_XOR) ? evaluate_xor2(frame->first, value)
+                                                    : evaluate_xnor2(frame->first, value);
+            return true;
+        case GATE_NOT:
+            *result = evaluate_not1(value);
+            return true;
+        case GATE_BUFF:
+            *result = evaluate_buff1(value);
+            return true;
+        default:
+            *result = LOGIC_X;
+            return true;
+    }
+}
+
+// Output of an AND/OR-family gate once every input was read without a controlling value
+static SignalValue finish_gate(const CircuitNode* node, const struct DemandFrame* frame) {
+    if (frame->has_x) return LOGIC_X;
+    switch (node->gate_type) {
+        case GATE_AND: return LOGIC_1;
+        case GATE_NAND: return LOGIC_0;
+        case GATE_OR:  return LOGIC_0;
+        case GATE_NOR: return LOGIC_1;
+        default:       return LOGIC_X;
+    }
+}
+
+SignalValue demand_evaluate(DemandEvaluator* evaluator, int node_id) {
+    if (!evaluator || node_id < 0 || node_id >= evaluator->circuit->node_count) {
+        return LOGIC_X;
+    }
+
+    CircuitNode* nodes = evaluator->circuit->nodes;
+    unsigned int epoch = evaluator->epoch;
+
+    if (evaluator->done_epoch[node_id] == epoch) {
+        return nodes[node_id].value;
+    }
+
+    int sp = 0;
+    if (begin_node(evaluator, &sp, node_id)) {
+        return nodes[node_id].value;
+    }
+
+    while (sp > 0) {
+        struct DemandFrame* frame = &evaluator->stack[sp - 1];
+        const CircuitNode* node = &nodes[frame->node_id];
+        bool descended = false;
+        bool finished = false;
+        SignalValue result = LOGIC_X;
+
+        while (frame->next_fanin && frame->inputs_left > 0) {
+            int input_id = frame->next_fanin->node_id;
+
+            if (evaluator->done_epoch[input_id] != epoch &&
+                evaluator->active_epoch[input_id] != epoch) {
+                if (!begin_node(evaluator, &sp, input_id)) {
+                    descended = true;
+                    break;
+                }
+            }
+
+            // Resolved for this vector, or part of a loop (read current value)
+            frame->next_fanin = frame->next_fanin->next;
+            frame->inputs_left--;
+            if (consume_input(node, frame, nodes[input_id].value, &result)) {
+                finished = true;
+                break;
+            }
+        }
+
+        if (descended) continue;
+
+        if (!finished) {
+            result = finish_gate(node, frame);
+        }
+
+        // Count the fanins a controlling value made unnecessary
+        evaluator->inputs_skipped += frame->inputs_left;
+
+        resolve_node(evaluator, frame->node_id, result, true);
+        sp--;
+    }
+
+    return nodes[node_id].value;
+}
+
+void demand_evaluate_targets(DemandEvaluator* evaluator, const int* node_ids, int count,
+                             SignalValue* out_values) {
+    if (!evaluator || !node_ids) return;
+
+    for (int i = 0; i < count; i++) {
+        SignalValue value = demand_evaluate(evaluator, node_ids[i]);
+        if (out_values) out_values[i] = value;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef DEMAND_EVAL_H
+#define DEMAND_EVAL_H
+
+#include "circuit_node.h"
+#include <stdbool.h>
+
+// Demand-driven (lazy) evaluation of selected nodes.
+//
+// Instead of sweeping the whole node array like simulate_circuit(), only the
+// transitive fanin cones of the requested nodes are visited. Results are
+// memoized per input vector, and AND/NAND/OR/NOR gates stop pulling inputs as
+// soon as a controlling value (0 for AND/NAND, 1 for OR/NOR) is seen.
+//
+// The circuit is assumed to be combinational. A fanin that is already on the
+// evaluation stack (combinational loop) is read with its current value.
+
+// Per-circuit lazy evaluator state
+typedef struct {
+    Circuit* circuit;
+    unsigned int epoch;           // Current vector generation
+    unsigned int* done_epoch;     // Epoch in which each node was resolved
+    unsigned int* active_epoch;   // Epoch in which each node is on the stack
+
+    // Explicit DFS stack (avoids recursion depth limits on deep circuits)
+    struct DemandFrame* stack;
+    int stack_capacity;
+
+    // Work counters for the current vector
+    long nodes_evaluated;         // Gate/branch nodes actually computed
+    long inputs_skipped;          // Fanins never read due to controlling values
+} DemandEvaluator;
+
+/**
+ * @brief Creates a lazy evaluator for a fully built circuit.
+ * @param circuit The circuit (branch nodes already inserted).
+ * @return New evaluator, or NULL on allocation failure.
+ */
+DemandEvaluator* create_demand_evaluator(Circuit* circuit);
+
+/**
+ * @brief Frees the evaluator (the circuit itself is not touched).
+ */
+void destroy_demand_evaluator(DemandEvaluator* evaluator);
+
+/**
+ * @brief Starts a new input vector: drops all memoized results.
+ *
+ * Call after set_primary_inputs(). This is O(1); memoization uses epochs.
+ */
+void demand_begin_vector(DemandEvaluator* evaluator);
+
+/**
+ * @brief Evaluates one node, pulling only the values it depends on.
+ *
+ * The result is also written to circuit->nodes[node_id].value, as are the
+ * values of every node evaluated along the way. Nodes outside the visited
+ * cones keep whatever value they had before.
+ * @param evaluator The evaluator.
+ * @param node_id Node to evaluate.
+ * @return The node's logic value (LOGIC_X for an invalid ID).
+ */
+SignalValue demand_evaluate(DemandEvaluator* evaluator, int node_id);
+
+/**
+ * @brief Evaluates a list of target nodes for the current vector.
+ * @param evaluator The evaluator.
+ * @param node_ids Target node IDs.
+ * @param count Number of targets.
+ * @param out_values Optional array receiving each target's value.
+ */
+void demand_evaluate_targets(DemandEvaluator* evaluator, const int* node_ids, int count,
+                             SignalValue* out_values);
+
+#endif // DEMAND_EVAL_H
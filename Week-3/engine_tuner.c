@@ -0,0 +1,377 @@
+#include "engine_tuner.h"
+#include "cone_partition.h"
+#include "sim_pipeline.h"
+#include "sim_checkpoint.h"
+#include "splitmix.h"
+#include "spsc_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RECONVERGENCE_VISIT_BUDGET 2000000LL
+#define BENCH_MIN_SECONDS 0.005
+#define BENCH_MAX_SECONDS 0.2
+#define BENCH_SAMPLE_VECTORS 64
+#define BATCH_TUNE_SECONDS 0.02     // Target length of one pipeline trial
+#define MAX_TUNE_THREADS 8
+#define TUNE_FILE_VERSION 2      // 2: netlist hash from hash_netlist_source()
+
+static const char* engine_names[ENGINE_COUNT] = { "auto", "iterative", "levelized", "partitioned", "scc" };
+
+static int online_cpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+const char* engine_name(SimEngine engine) {
+    return (engine >= 0 && engine < ENGINE_COUNT) ? engine_names[engine] : "unknown";
+}
+
+int parse_engine_name(const char* name) {
+    for (int i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(name, engine_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// --- Structural profile ---
+
+// Counts stems whose fanout branches meet again. For each stem, a forward DFS
+// from each branch tags nodes with the branch index; reaching a node already
+// tagged by another branch of the same stem proves reconvergence. Nodes are
+// tagged when pushed, so each is pushed at most once per stem and the stack
+// never needs more than node_count entries.
+static void count_reconvergent_stems(const Circuit* circuit, CircuitProfile* profile) {
+    int n = circuit->node_count;
+    int* stamp = (int*)malloc(n * sizeof(int));
+    int* branch = (int*)malloc(n * sizeof(int));
+    int* stack = (int*)malloc(n * sizeof(int));
+    if (!stamp || !branch || !stack) {
+        profile->reconvergence_truncated = true;
+        free(stamp);
+        free(branch);
+        free(stack);
+        return;
+    }
+    for (int i = 0; i < n; i++) stamp[i] = -1;
+
+    long long visits = 0;
+    for (int stem = 0; stem < n; stem++) {
+        if (!circuit->nodes[stem].fanout_list || !circuit->nodes[stem].fanout_list->next) continue;
+        if (visits > RECONVERGENCE_VISIT_BUDGET) {
+            profile->reconvergence_truncated = true;
+            break;
+        }
+
+        bool reconverges = false;
+        int b = 0;
+        for (ConnectionNode* out = circuit->nodes[stem].fanout_list; out && !reconverges; out = out->next, b++) {
+            int top = 0;
+            if (stamp[out->node_id] == stem) {
+                reconverges = true;   // Reached from an earlier branch
+                continue;
+            }
+            stamp[out->node_id] = stem;
+            branch[out->node_id] = b;
+            stack[top++] = out->node_id;
+            while (top > 0 && !reconverges) {
+                int id = stack[--top];
+                visits++;
+                for (ConnectionNode* next = circuit->nodes[id].fanout_list; next; next = next->next) {
+                    int to = next->node_id;
+                    if (stamp[to] == stem) {
+                        if (branch[to] != b) {
+                            reconverges = true;
+                            break;
+                        }
+                        continue;
+                    }
+                    stamp[to] = stem;
+                    branch[to] = b;
+                    stack[top++] = to;
+                }
+            }
+        }
+        if (reconverges) profile->reconvergent_stems++;
+    }
+
+    free(stamp);
+    free(branch);
+    free(stack);
+}
+
+void profile_circuit(const Circuit* circuit, const Levelization* levels, bool count_reconvergence,
+                     CircuitProfile* profile) {
+    memset(profile, 0, sizeof(*profile));
+    profile->node_count = circuit->node_count;
+    profile->pi_count = circuit->pi_count;
+    profile->po_count = circuit->po_count;
+    profile->is_acyclic = levels ? levels->is_acyclic : false;
+    profile->depth = (levels && levels->is_acyclic) ? levels->max_level : 0;
+
+    long long fanin_total = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        const CircuitNode* node = &circuit->nodes[i];
+        if (node->type == NODE_BRNH) profile->branch_count++;
+        if (node->type != NODE_PI && node->type != NODE_BRNH && node->gate_type != GATE_UNKNOWN) {
+            profile->gate_count++;
+            fanin_total += node->fanin_count;
+        }
+
+        int fanout = node->fanout_count;
+        int bucket = fanout <= 2 ? fanout : fanout <= 4 ? 3 : fanout <= 8 ? 4 : 5;
+        profile->fanout_histogram[bucket]++;
+        if (fanout > profile->max_fanout) profile->max_fanout = fanout;
+        if (fanout > 1) profile->fanout_stems++;
+    }
+    profile->average_fanin = profile->gate_count > 0 ? (double)fanin_total / profile->gate_count : 0.0;
+
+    if (count_reconvergence) {
+        profile->reconvergence_counted = true;
+        count_reconvergent_stems(circuit, profile);
+    }
+}
+
+// --- Selection ---
+void select_engine_heuristic(const CircuitProfile* profile, EngineConfig* config) {
+    int cpus = online_cpus();
+    memset(config, 0, sizeof(*config));
+
+    // Filled in whatever the engine, so --engine partitioned has a count to use
+    config->partitions = cpus < profile->po_count ? cpus : profile->po_count;
+    if (config->partitions > MAX_TUNE_THREADS) config->partitions = MAX_TUNE_THREADS;
+    if (config->partitions < 1) config->partitions = 1;
+
+    // Loops need fixed-point iteration; the SCC engine confines it to the loops
+    if (!profile->is_acyclic) {
+        config->engine = ENGINE_SCC;
+    } else if (profile->gate_count >= 5000 && cpus > 1 && profile->po_count > 1) {
+        // Thread start-up per vector only pays off on large circuits
+        config->engine = ENGINE_PARTITIONED;
+    } else {
+        config->engine = ENGINE_LEVELIZED;
+    }
+
+    // Tiny circuits are dominated by hand-off cost; keep them on one worker
+    config->threads = profile->gate_count < 64 ? 1 : (cpus < MAX_TUNE_THREADS ? cpus : MAX_TUNE_THREADS);
+    config->batch_size = profile->gate_count < 500 ? 1024 : 256;
+}
+
+// --- Micro-benchmarks ---
+// Seconds per vector for one engine, or a negative value if it cannot run
+static double time_engine(Circuit* circuit, const Levelization* levels, SimEngine engine,
+                          ConePartitioning* partitioning, const SignalValue* sample) {
+    long long vectors = 0;
+    double start = monotonic_seconds();
+    double elapsed = 0.0;
+
+    while (elapsed < BENCH_MIN_SECONDS || vectors < BENCH_SAMPLE_VECTORS) {
+        const SignalValue* inputs = sample + (vectors % BENCH_SAMPLE_VECTORS) * circuit->pi_count;
+        set_primary_inputs(circuit, inputs);
+
+        switch (engine) {
+            case ENGINE_ITERATIVE:
+                simulate_circuit(circuit);
+                break;
+            case ENGINE_LEVELIZED:
+                simulate_levelized(circuit, levels);
+                break;
+            case ENGINE_PARTITIONED:
+                if (!partitioning || !simulate_partitions_parallel(circuit, partitioning)) return -1.0;
+                break;
+            default:
+                return -1.0;
+        }
+
+        vectors++;
+        elapsed = monotonic_seconds() - start;
+        if (elapsed > BENCH_MAX_SECONDS) break;
+    }
+    return elapsed / (double)vectors;
+}
+
+// Wall seconds of one pipeline trial with the chosen engine, or a negative value on failure
+static double time_pipeline(const Circuit* circuit, const Levelization* levels, const EngineConfig* config,
+                            FILE* sink, long long vectors, int threads, int batch_size) {
+    PipelineOptions options;
+    init_pipeline_options(&options);
+    options.engine = config;
+    options.random_count = vectors;
+    options.output = sink;
+    options.worker_count = threads;
+    options.batch_size = batch_size;
+
+    PipelineStats stats;
+    if (run_simulation_pipeline(circuit, levels, &options, &stats) != 0) return -1.0;
+    return stats.wall_seconds;
+}
+
+static void tune_batch_settings(const Circuit* circuit, const Levelization* levels, EngineConfig* config) {
+    FILE* sink = fopen("/dev/null", "w");
+    if (!sink) return;
+
+    // Size the trial so each configuration runs for roughly BATCH_TUNE_SECONDS
+    double per_vector = config->vector_seconds > 0.0 ? config->vector_seconds : 1e-6;
+    long long vectors = (long long)(BATCH_TUNE_SECONDS / per_vector);
+    if (vectors < 2048) vectors = 2048;
+    if (vectors > 65536) vectors = 65536;
+
+    static const int batch_sizes[] = { 64, 256, 1024 };
+    int cpus = online_cpus();
+    double best = -1.0;
+
+    for (int threads = 1; threads <= cpus && threads <= MAX_TUNE_THREADS; threads *= 2) {
+        for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+            double seconds = time_pipeline(circuit, levels, config, sink, vectors, threads, batch_sizes[b]);
+            if (seconds > 0.0 && (best < 0.0 || seconds < best)) {
+                best = seconds;
+                config->threads = threads;
+                config->batch_size = batch_sizes[b];
+            }
+        }
+    }
+    fclose(sink);
+}
+
+void tune_engine(Circuit* circuit, const Levelization* levels, const CircuitProfile* profile,
+                 bool tune_batch, EngineConfig* config) {
+    select_engine_heuristic(profile, config);
+    if (!levels || !levels->is_acyclic || circuit->pi_count == 0) return;
+
+    SignalValue* sample = (SignalValue*)malloc((size_t)BENCH_SAMPLE_VECTORS * circuit->pi_count * sizeof(SignalValue));
+    if (!sample) return;
+    SimCheckpoint* saved_state = create_checkpoint(circuit);
+    uint64_t state = 0x5EEDULL;
+    for (int i = 0; i < BENCH_SAMPLE_VECTORS * circuit->pi_count; i++) {
+        sample[i] = (next_random(&state) & 1) ? LOGIC_1 : LOGIC_0;
+    }
+
+    int cpus = online_cpus();
+    ConePartitioning* partitioning = NULL;
+    int partitions = cpus < circuit->po_count ? cpus : circuit->po_count;
+    if (partitions > MAX_TUNE_THREADS) partitions = MAX_TUNE_THREADS;
+    if (partitions > 1) partitioning = partition_output_cones(circuit, levels, partitions);
+
+    double best = -1.0;
+    for (int engine = ENGINE_ITERATIVE; engine < ENGINE_COUNT; engine++) {
+        double seconds = time_engine(circuit, levels, (SimEngine)engine, partitioning, sample);
+        if (seconds > 0.0 && (best < 0.0 || seconds < best)) {
+            best = seconds;
+            config->engine = (SimEngine)engine;
+            if (engine == ENGINE_PARTITIONED) config->partitions = partitioning->partition_count;
+        }
+    }
+    config->vector_seconds = best > 0.0 ? best : 0.0;
+    config->measured = true;
+
+    destroy_cone_partitioning(partitioning);
+    free(sample);
+
+    if (saved_state) {
+        restore_checkpoint(saved_state, circuit);
+        destroy_checkpoint(saved_state);
+    } else {
+        reset_simulation(circuit);
+    }
+
+    if (tune_batch) tune_batch_settings(circuit, levels, config);
+}
+
+// --- Persistence ---
+
+static void tune_file_path(const char* netlist_path, char* path, size_t size) {
+    snprintf(path, size, "%s.tune", netlist_path);
+}
+
+bool load_engine_config(const char* netlist_path, uint64_t netlist_hash, EngineConfig* config) {
+    char path[1024];
+    tune_file_path(netlist_path, path, sizeof(path));
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    EngineConfig loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    unsigned long long hash = 0;
+    int version = 0;
+    int cpus = 0;
+    int fields = 0;
+    char line[256];
+    char name[64];
+
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "version %d", &version) == 1) fields |= 1;
+        else if (sscanf(line, "netlist_hash %llx", &hash) == 1) fields |= 2;
+        else if (sscanf(line, "cpus %d", &cpus) == 1) fields |= 4;
+        else if (sscanf(line, "engine %63s", name) == 1) {
+            int engine = parse_engine_name(name);
+            if (engine > ENGINE_AUTO) {
+                loaded.engine = (SimEngine)engine;
+                fields |= 8;
+            }
+        }
+        else if (sscanf(line, "partitions %d", &loaded.partitions) == 1) fields |= 16;
+        else if (sscanf(line, "threads %d", &loaded.threads) == 1) fields |= 32;
+        else if (sscanf(line, "batch_size %d", &loaded.batch_size) == 1) fields |= 64;
+        else if (sscanf(line, "vector_seconds %lf", &loaded.vector_seconds) == 1) fields |= 128;
+    }
+    fclose(file);
+
+    // Stale if anything is missing, the netlist changed or the machine differs
+    if (fields != 255 || version != TUNE_FILE_VERSION || cpus != online_cpus() ||
+        hash != netlist_hash || netlist_hash == 0 || loaded.threads < 1 || loaded.batch_size < 1) {
+        return false;
+    }
+
+    loaded.measured = true;
+    loaded.from_file = true;
+    *config = loaded;
+    return true;
+}
+
+int save_engine_config(const char* netlist_path, uint64_t netlist_hash, const EngineConfig* config) {
+    char path[1024];
+    tune_file_path(netlist_path, path, sizeof(path));
+    FILE* file = fopen(path, "w");
+    if (!file) return 1;
+
+    fprintf(file, "# Engine tuning for %s (delete to re-tune)\n", netlist_path);
+    fprintf(file, "version %d\n", TUNE_FILE_VERSION);
+    fprintf(file, "netlist_hash %016llx\n", (unsigned long long)netlist_hash);
+    fprintf(file, "cpus %d\n", online_cpus());
+    fprintf(file, "engine %s\n", engine_name(config->engine));
+    fprintf(file, "partitions %d\n", config->partitions);
+    fprintf(file, "threads %d\n", config->threads);
+    fprintf(file, "batch_size %d\n", config->batch_size);
+    fprintf(file, "vector_seconds %.9f\n", config->vector_seconds);
+    return fclose(file) == 0 ? 0 : 1;
+}
+
+void print_engine_selection(FILE* stream, const CircuitProfile* profile, const EngineConfig* config) {
+    static const char* bucket_names[FANOUT_BUCKETS] = { "0", "1", "2", "3-4", "5-8", "9+" };
+
+    fprintf(stream, "## Engine Selection\n");
+    fprintf(stream, "Gates: %d, Branches: %d, PIs: %d, POs: %d, Depth: %d%s\n",
+            profile->gate_count, profile->branch_count, profile->pi_count, profile->po_count,
+            profile->depth, profile->is_acyclic ? "" : " (combinational loops)");
+    fprintf(stream, "Average fanin: %.2f, Max fanout: %d, Fanout histogram:",
+            profile->average_fanin, profile->max_fanout);
+    for (int i = 0; i < FANOUT_BUCKETS; i++) {
+        fprintf(stream, " %s:%d", bucket_names[i], profile->fanout_histogram[i]);
+    }
+    fprintf(stream, "\nFanout stems: %d", profile->fanout_stems);
+    if (profile->reconvergence_counted) {
+        fprintf(stream, ", Reconvergent stems: %d%s", profile->reconvergent_stems,
+                profile->reconvergence_truncated ? " (search truncated)" : "");
+    }
+    fprintf(stream, "\n");
+
+    fprintf(stream, "Engine: %s", engine_name(config->engine));
+    if (config->engine == ENGINE_PARTITIONED) fprintf(stream, " (%d partitions)", config->partitions);
+    fprintf(stream, ", Batch: %d threads x %d vectors", config->threads, config->batch_size);
+    fprintf(stream, " [%s]\n", config->from_file ? "saved tuning" : config->measured ? "benchmarked" : "heuristic");
+    if (config->vector_seconds > 0.0) {
+        fprintf(stream, "Measured: %.2f us per vector\n", config->vector_seconds * 1e6);
+    }
+    fprintf(stream, "\n");
+}
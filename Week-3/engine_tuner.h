@@ -0,0 +1,124 @@
+#ifndef ENGINE_TUNER_H
+#define ENGINE_TUNER_H
+
+#include "circuit_node.h"
+#include "levelizer.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Load-time engine selection.
+//
+// A structural profile of the circuit drives a heuristic choice of simulation
+// engine and batch settings. Optionally the candidates are micro-benchmarked on
+// a short random sample and the fastest wins. Tuned results are persisted next
+// to the netlist ("<netlist>.tune") together with a hash of the netlist text and
+// the CPU count, so later runs reuse them until either changes.
+
+typedef enum {
+    ENGINE_AUTO,          // Let the tuner decide
+    ENGINE_ITERATIVE,     // Reference sweep-until-stable (handles loops)
+    ENGINE_LEVELIZED,     // One pass in level order
+    ENGINE_PARTITIONED,   // Output-cone partitions on parallel threads
+    ENGINE_SCC,           // SCC order, iterating only inside combinational loops
+    ENGINE_COUNT
+} SimEngine;
+
+#define FANOUT_BUCKETS 6  // Fanout 0, 1, 2, 3-4, 5-8, 9+
+
+typedef struct {
+    int node_count;
+    int gate_count;
+    int branch_count;
+    int pi_count;
+    int po_count;
+    int depth;                      // Highest level (0 when the circuit has loops)
+    bool is_acyclic;
+    double average_fanin;           // Over gates
+    int max_fanout;
+    int fanout_histogram[FANOUT_BUCKETS];
+    int fanout_stems;               // Nodes with fanout > 1
+    bool reconvergence_counted;     // reconvergent_stems was searched for
+    int reconvergent_stems;         // Stems whose branches meet again downstream
+    bool reconvergence_truncated;   // Search budget ran out; count is a lower bound
+} CircuitProfile;
+
+typedef struct {
+    SimEngine engine;       // Engine for single-vector simulation
+    int partitions;         // Partition count for ENGINE_PARTITIONED
+    int threads;            // Batch pipeline workers
+    int batch_size;         // Batch pipeline vectors per batch
+    bool measured;          // Chosen by benchmark (now or in a saved .tune file)
+    bool from_file;         // Loaded from a .tune file
+    double vector_seconds;  // Measured time per vector of the chosen engine (0 if unknown)
+} EngineConfig;
+
+/**
+ * @brief Returns the command-line name of an engine ("auto", "levelized", ...).
+ */
+const char* engine_name(SimEngine engine);
+
+/**
+ * @brief Parses an engine name.
+ * @return The engine, or -1 if the name is unknown.
+ */
+int parse_engine_name(const char* name);
+
+/**
+ * @brief Computes structural statistics of a circuit.
+ *
+ * Everything but the reconvergence count is one pass over the nodes. The
+ * engine choice does not depend on reconvergence, so the search (a DFS per
+ * fanout stem, up to a visit budget) is only worth it for reports.
+ * @param circuit The circuit.
+ * @param levels Its levelization.
+ * @param count_reconvergence Also search for reconvergent stems.
+ * @param profile Receives the statistics.
+ */
+void profile_circuit(const Circuit* circuit, const Levelization* levels, bool count_reconvergence,
+                     CircuitProfile* profile);
+
+/**
+ * @brief Picks engine and batch settings from the profile alone.
+ * @param profile Structural statistics.
+ * @param config Receives the choice.
+ */
+void select_engine_heuristic(const CircuitProfile* profile, EngineConfig* config);
+
+/**
+ * @brief Benchmarks the candidate engines and batch settings on random vectors.
+ *
+ * Node values are checkpointed and restored afterwards.
+ * @param circuit The circuit.
+ * @param levels Its levelization (must be acyclic; otherwise only the heuristic applies).
+ * @param profile Structural statistics.
+ * @param tune_batch Also search pipeline thread counts and batch sizes.
+ * @param config Receives the fastest configuration.
+ */
+void tune_engine(Circuit* circuit, const Levelization* levels, const CircuitProfile* profile,
+                 bool tune_batch, EngineConfig* config);
+
+/**
+ * @brief Loads a saved configuration for a netlist.
+ * @param netlist_path Netlist file; the configuration lives in "<netlist_path>.tune".
+ * @param netlist_hash hash_netlist_source() of the netlist (netlist_cache.h).
+ * @param config Receives the configuration.
+ * @return true if a file exists and still matches the netlist and CPU count.
+ */
+bool load_engine_config(const char* netlist_path, uint64_t netlist_hash, EngineConfig* config);
+
+/**
+ * @brief Saves a configuration next to the netlist.
+ * @param netlist_path Netlist file.
+ * @param netlist_hash hash_netlist_source() of the netlist, checked on load.
+ * @param config The configuration.
+ * @return 0 on success, 1 if the file could not be written.
+ */
+int save_engine_config(const char* netlist_path, uint64_t netlist_hash, const EngineConfig* config);
+
+/**
+ * @brief Prints the profile and the chosen configuration.
+ */
+void print_engine_selection(FILE* stream, const CircuitProfile* profile, const EngineConfig* config);
+
+#endif // ENGINE_TUNER_H
@@ -103,3 +103,32 @@ SignalValue evaluate_not1(SignalValue input1) {
 SignalValue evaluate_buff1(SignalValue input1) {
     return input1; // Buffer output is the same as input, including X
 }
+
+// --- Packed signal vectors ---
+void pack_signal_values(const SignalValue values[], int count, uint64_t packed[]) {
+    int words = PACKED_WORDS(count);
+    uint64_t* value_plane = packed;
+    uint64_t* x_plane = packed + words;
+
+    for (int w = 0; w < words; w++) {
+        value_plane[w] = 0;
+        x_plane[w] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        uint64_t bit = (uint64_t)1 << (i & 63);
+        if (values[i] == LOGIC_1) value_plane[i >> 6] |= bit;
+        else if (values[i] == LOGIC_X) x_plane[i >> 6] |= bit;
+    }
+}
+
+void unpack_signal_values(const uint64_t packed[], int count, SignalValue values[]) {
+    int words = PACKED_WORDS(count);
+    const uint64_t* value_plane = packed;
+    const uint64_t* x_plane = packed + words;
+
+    for (int i = 0; i < count; i++) {
+        uint64_t bit = (uint64_t)1 << (i & 63);
+        if (x_plane[i >> 6] & bit) values[i] = LOGIC_X;
+        else values[i] = (value_plane[i >> 6] & bit) ? LOGIC_1 : LOGIC_0;
+    }
+}
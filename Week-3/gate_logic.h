@@ -1,6 +1,8 @@
 #ifndef GATE_LOGIC_H
 #define GATE_LOGIC_H
 
+#include <stdint.h>
+
 // Represents the possible logic values of a signal
 typedef enum
 {
@@ -80,4 +82,27 @@ SignalValue evaluate_not1(SignalValue input1);
  */
 SignalValue evaluate_buff1(SignalValue input1);
 
+// --- Packed Signal Vectors ---
+// A packed vector stores n signals in two bit planes of PACKED_WORDS(n) words
+// each: plane 0 holds the value bits, plane 1 marks LOGIC_X positions.
+// Signal i lives in bit (i % 64) of word (i / 64) of each plane.
+
+#define PACKED_WORDS(n) (((n) + 63) / 64)
+
+/**
+ * @brief Packs an array of signal values into the two-plane bit format.
+ * @param values Signal values to pack.
+ * @param count Number of signals.
+ * @param packed Output buffer of 2 * PACKED_WORDS(count) words.
+ */
+void pack_signal_values(const SignalValue values[], int count, uint64_t packed[]);
+
+/**
+ * @brief Expands a packed vector back to one SignalValue per signal.
+ * @param packed Packed buffer of 2 * PACKED_WORDS(count) words.
+ * @param count Number of signals.
+ * @param values Output array of count signal values.
+ */
+void unpack_signal_values(const uint64_t packed[], int count, SignalValue values[]);
+
 #endif // GATE_LOGIC_H
@@ -0,0 +1,724 @@
+#include "hierarchy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- Loading ---
+//
+// While parsing, an instance op stores its connections as (formal, actual)
+// pairs: formal is an ID in DesignSink.formal_names (-1 when positional) and
+// actual a net of the parent (-1 when unconnected); child is an ID in
+// DesignSink.references. link_design() rewrites both once every module is known.
+
+typedef struct {
+    Design* design;
+    const char* filename;
+    ModuleTemplate* current;     // Module whose header was read last
+    StringPool* references;      // Names of instantiated modules
+    StringPool* formal_names;    // Port names of named connections
+    bool failed;
+} DesignSink;
+
+static bool append_int(int** items, int* count, int* capacity, int value) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        int* grown = (int*)realloc(*items, (size_t)new_capacity * sizeof(int));
+        if (!grown) return false;
+        *items = grown;
+        *capacity = new_capacity;
+    }
+    (*items)[(*count)++] = value;
+    return true;
+}
+
+static TemplateOp* append_op(ModuleTemplate* module) {
+    if (module->op_count == module->op_capacity) {
+        int capacity = module->op_capacity ? module->op_capacity * 2 : 64;
+        TemplateOp* ops = (TemplateOp*)realloc(module->ops, (size_t)capacity * sizeof(TemplateOp));
+        if (!ops) return NULL;
+        module->ops = ops;
+        module->op_capacity = capacity;
+    }
+    TemplateOp* op = &module->ops[module->op_count++];
+    memset(op, 0, sizeof(*op));
+    op->first_net = module->op_net_count;
+    return op;
+}
+
+static bool sink_failed(DesignSink* target, const char* what) {
+    fprintf(stderr, "Error: %s while loading %s\n", what, target->filename);
+    target->failed = true;
+    return false;
+}
+
+// Net ID of a name in the current module
+static int intern_net(DesignSink* target, NameView name) {
+    int id = string_pool_intern(target->current->nets, name.text, name.length);
+    if (id < 0) sink_failed(target, "Out of memory");
+    return id;
+}
+
+static bool design_module(void* user, NameView name) {
+    DesignSink* target = (DesignSink*)user;
+    Design* design = target->design;
+
+    if (string_pool_find(design->module_names, name.text, name.length) >= 0) {
+        fprintf(stderr, "Error: Module %.*s is defined twice\n", name.length, name.text);
+        target->failed = true;
+        return false;
+    }
+    if (design->module_count == design->module_capacity) {
+        int capacity = design->module_capacity ? design->module_capacity * 2 : 16;
+        ModuleTemplate* modules = (ModuleTemplate*)realloc(design->modules, (size_t)capacity * sizeof(ModuleTemplate));
+        if (!modules) return sink_failed(target, "Out of memory");
+        design->modules = modules;
+        design->module_capacity = capacity;
+    }
+
+    ModuleTemplate* module = &design->modules[design->module_count];
+    memset(module, 0, sizeof(*module));
+    module->nets = create_string_pool();
+    module->instance_names = create_string_pool();
+    design->module_count++;
+    if (!module->nets || !module->instance_names ||
+        string_pool_intern(design->module_names, name.text, name.length) != design->module_count - 1) {
+        return sink_failed(target, "Out of memory");
+    }
+    int length = name.length < MAX_NAME_LENGTH - 1 ? name.length : MAX_NAME_LENGTH - 1;
+    memcpy(module->name, name.text, (size_t)length);
+    module->name[length] = '\0';
+    module->acyclic = true;
+    target->current = module;
+    return true;
+}
+
+static bool design_declare(void* user, DeclarationKind kind, NameView name) {
+    DesignSink* target = (DesignSink*)user;
+    ModuleTemplate* module = target->current;
+    if (!module) return true; // Declarations outside a module are ignored, as in a flat parse
+
+    int net = intern_net(target, name);
+    if (net < 0) return false;
+    bool stored = true;
+    switch (kind) {
+        case DECLARE_PORT:   stored = append_parsed_name(&module->ports, net); break;
+        case DECLARE_INPUT:  stored = append_parsed_name(&module->inputs, net); break;
+        case DECLARE_OUTPUT: stored = append_parsed_name(&module->outputs, net); break;
+        case DECLARE_WIRE:   module->wire_count++; break;
+    }
+    return stored || sink_failed(target, "Out of memory");
+}
+
+static bool design_gate(void* user, GateType type, NameView instance, NameView output,
+                        const NameView* inputs, int input_count) {
+    DesignSink* target = (DesignSink*)user;
+    ModuleTemplate* module = target->current;
+    if (!module) return true;
+
+    TemplateOp* op = append_op(module);
+    if (!op) return sink_failed(target, "Out of memory");
+    op->kind = OP_GATE;
+    op->gate_type = type;
+    op->name = string_pool_intern(module->instance_names, instance.text, instance.length);
+    op->net_count = 1 + input_count;
+    if (op->name < 0) return sink_failed(target, "Out of memory");
+
+    int net = intern_net(target, output);
+    if (net < 0 || !append_int(&module->op_nets, &module->op_net_count, &module->op_net_capacity, net)) {
+        return sink_failed(target, "Out of memory");
+    }
+    for (int i = 0; i < input_count; i++) {
+        net = intern_net(target, inputs[i]);
+        if (net < 0 || !append_int(&module->op_nets, &module->op_net_count, &module->op_net_capacity, net)) {
+            return sink_failed(target, "Out of memory");
+        }
+    }
+    module->gate_count++;
+    if (input_count > target->design->max_gate_inputs) target->design->max_gate_inputs = input_count;
+    return true;
+}
+
+static bool design_instance(void* user, NameView child, NameView instance,
+                            const NameView* formals, const NameView* actuals, int count) {
+    DesignSink* target = (DesignSink*)user;
+    ModuleTemplate* module = target->current;
+    if (!module) return true;
+
+    TemplateOp* op = append_op(module);
+    if (!op) return sink_failed(target, "Out of memory");
+    op->kind = OP_INSTANCE;
+    op->gate_type = GATE_UNKNOWN;
+    op->child = string_pool_intern(target->references, child.text, child.length);
+    op->name = string_pool_intern(module->instance_names, instance.text, instance.length);
+    op->net_count = 2 * count;
+    if (op->child < 0 || op->name < 0) return sink_failed(target, "Out of memory");
+
+    for (int i = 0; i < count; i++) {
+        int formal = formals ? string_pool_intern(target->formal_names, formals[i].text, formals[i].length) : -1;
+        int actual = actuals[i].text ? intern_net(target, actuals[i]) : -1;
+        if ((formals && formal < 0) || (actuals[i].text && actual < 0) ||
+            !append_int(&module->op_nets, &module->op_net_count, &module->op_net_capacity, formal) ||
+            !append_int(&module->op_nets, &module->op_net_count, &module->op_net_capacity, actual)) {
+            return sink_failed(target, "Out of memory");
+        }
+    }
+    module->instance_count++;
+    return true;
+}
+
+// --- Linking ---
+
+// Position of each port net in the [inputs..., outputs...] order, -1 for other nets
+static int* build_port_slots(const ModuleTemplate* module) {
+    int* slots = (int*)malloc((size_t)(module->nets->count > 0 ? module->nets->count : 1) * sizeof(int));
+    if (!slots) return NULL;
+    for (int i = 0; i < module->nets->count; i++) slots[i] = -1;
+    for (int i = 0; i < module->inputs.count; i++) slots[module->inputs.ids[i]] = i;
+    for (int i = 0; i < module->outputs.count; i++) slots[module->outputs.ids[i]] = module->inputs.count + i;
+    return slots;
+}
+
+// Rewrites one module's instance ops from (formal, actual) pairs to child port order
+static bool link_module(DesignSink* target, ModuleTemplate* module, int* const* port_slots) {
+    Design* design = target->design;
+    int* nets = NULL;
+    int net_count = 0;
+    int net_capacity = 0;
+
+    for (int o = 0; o < module->op_count; o++) {
+        TemplateOp* op = &module->ops[o];
+        const int* old_nets = module->op_nets + op->first_net;
+        int first_net = net_count;
+
+        if (op->kind == OP_GATE) {
+            for (int i = 0; i < op->net_count; i++) {
+                if (!append_int(&nets, &net_count, &net_capacity, old_nets[i])) goto out_of_memory;
+            }
+            op->first_net = first_net;
+            continue;
+        }
+
+        const char* child_name = string_pool_get(target->references, op->child);
+        const char* instance_name = string_pool_get(module->instance_names, op->name);
+        int child_index = string_pool_find(design->module_names, child_name, (int)strlen(child_name));
+        if (child_index < 0) {
+            fprintf(stderr, "Error: Unknown module %s instantiated as %s in module %s\n",
+                    child_name, instance_name, module->name);
+            free(nets);
+            return false;
+        }
+        const ModuleTemplate* child = &design->modules[child_index];
+        int port_count = child->inputs.count + child->outputs.count;
+        for (int i = 0; i < port_count; i++) {
+            if (!append_int(&nets, &net_count, &net_capacity, -1)) goto out_of_memory;
+        }
+
+        int connections = op->net_count / 2;
+        for (int k = 0; k < connections; k++) {
+            int formal = old_nets[2 * k];
+            int actual = old_nets[2 * k + 1];
+            int slot = -1;
+            if (formal >= 0) {
+                const char* port = string_pool_get(target->formal_names, formal);
+                int port_net = string_pool_find(child->nets, port, (int)strlen(port));
+                if (port_net >= 0) slot = port_slots[child_index][port_net];
+                if (slot < 0) {
+                    fprintf(stderr, "Error: Module %s has no port %s (instance %s in module %s)\n",
+                            child->name, port, instance_name, module->name);
+                    free(nets);
+                    return false;
+                }
+            } else if (k < child->ports.count) {
+                slot = port_slots[child_index][child->ports.ids[k]];
+            }
+            if (slot < 0) {
+                fprintf(stderr, "Error: Too many connections to %s (instance %s in module %s)\n",
+                        child->name, instance_name, module->name);
+                free(nets);
+                return false;
+            }
+            nets[first_net + slot] = actual;
+        }
+
+        op->child = child_index;
+        op->first_net = first_net;
+        op->net_count = port_count;
+    }
+
+    free(module->op_nets);
+    module->op_nets = nets;
+    module->op_net_count = net_count;
+    module->op_net_capacity = net_capacity;
+    return true;
+
+out_of_memory:
+    free(nets);
+    sink_failed(target, "Out of memory");
+    return false;
+}
+
+// The nets an op reads are [op_input_begin, op_input_end) of its op_nets:
+// a gate's inputs, or an instance's child-input slots
+static int op_input_begin(const TemplateOp* op) {
+    return op->kind == OP_GATE ? 1 : 0;
+}
+
+static int op_input_end(const Design* design, const TemplateOp* op) {
+    return op->kind == OP_GATE ? op->net_count : design->modules[op->child].inputs.count;
+}
+
+// Orders a module's ops so every net is computed before it is read (Kahn's
+// algorithm over op -> op edges). A combinational loop leaves the remaining ops
+// in source order and clears module->acyclic.
+static bool schedule_module(ModuleTemplate* module, const Design* design) {
+    int net_count = module->nets->count;
+    int op_count = module->op_count;
+    int* driver = (int*)malloc((size_t)(net_count > 0 ? net_count : 1) * sizeof(int));
+    int* pending = (int*)calloc((size_t)(op_count > 0 ? op_count : 1), sizeof(int));
+    int* edge_start = (int*)calloc((size_t)op_count + 1, sizeof(int));
+    int* order = (int*)malloc((size_t)(op_count > 0 ? op_count : 1) * sizeof(int));
+    int* edges = NULL;
+    TemplateOp* ops = NULL;
+    bool ok = false;
+    if (!driver || !pending || !edge_start || !order) goto done;
+
+    for (int i = 0; i < net_count; i++) driver[i] = -1;
+    for (int o = 0; o < op_count; o++) {
+        const TemplateOp* op = &module->ops[o];
+        const int* nets = module->op_nets + op->first_net;
+        int input_end = op_input_end(design, op);
+        int output_begin = (op->kind == OP_GATE) ? 0 : input_end;
+        int output_end = (op->kind == OP_GATE) ? 1 : op->net_count;
+        for (int i = output_begin; i < output_end; i++) {
+            if (nets[i] >= 0 && driver[nets[i]] < 0) driver[nets[i]] = o;
+        }
+    }
+
+    // Edges driver -> reader, bucketed by driver
+    int edge_count = 0;
+    for (int o = 0; o < op_count; o++) {
+        const TemplateOp* op = &module->ops[o];
+        const int* nets = module->op_nets + op->first_net;
+        for (int i = op_input_begin(op); i < op_input_end(design, op); i++) {
+            if (nets[i] >= 0 && driver[nets[i]] >= 0) {
+                edge_start[driver[nets[i]] + 1]++;
+                pending[o]++;
+                edge_count++;
+            }
+        }
+    }
+    for (int o = 0; o < op_count; o++) edge_start[o + 1] += edge_start[o];
+    edges = (int*)malloc((size_t)(edge_count > 0 ? edge_count : 1) * sizeof(int));
+    if (!edges) goto done;
+    int* fill = order; // Reused as a cursor array before the ordering starts
+    for (int o = 0; o < op_count; o++) fill[o] = edge_start[o];
+    for (int o = 0; o < op_count; o++) {
+        const TemplateOp* op = &module->ops[o];
+        const int* nets = module->op_nets + op->first_net;
+        for (int i = op_input_begin(op); i < op_input_end(design, op); i++) {
+            if (nets[i] >= 0 && driver[nets[i]] >= 0) edges[fill[driver[nets[i]]]++] = o;
+        }
+    }
+
+    int head = 0;
+    int tail = 0;
+    for (int o = 0; o < op_count; o++) {
+        if (pending[o] == 0) order[tail++] = o;
+    }
+    while (head < tail) {
+        int o = order[head++];
+        for (int e = edge_start[o]; e < edge_start[o + 1]; e++) {
+            if (--pending[edges[e]] == 0) order[tail++] = edges[e];
+        }
+    }
+    if (tail < op_count) {
+        module->acyclic = false;
+        for (int o = 0; o < op_count; o++) {
+            if (pending[o] > 0) order[tail++] = o;
+        }
+    }
+
+    ops = (TemplateOp*)malloc((size_t)(op_count > 0 ? op_count : 1) * sizeof(TemplateOp));
+    if (!ops) goto done;
+    for (int i = 0; i < op_count; i++) ops[i] = module->ops[order[i]];
+    free(module->ops);
+    module->ops = ops;
+    module->op_capacity = op_count;
+    ok = true;
+
+done:
+    free(driver);
+    free(pending);
+    free(edge_start);
+    free(order);
+    free(edges);
+    return ok;
+}
+
+// Depth-first over the instance graph: children are finished before their
+// parents, which gives frame sizes and flattened sizes bottom-up
+static bool finish_module(Design* design, int index, char* state) {
+    if (state[index] == 2) return true;
+    ModuleTemplate* module = &design->modules[index];
+    if (state[index] == 1) {
+        fprintf(stderr, "Error: Module %s is instantiated recursively\n", module->name);
+        return false;
+    }
+    state[index] = 1;
+
+    int deepest_child = 0;
+    module->flat_gate_count = module->gate_count;
+    for (int o = 0; o < module->op_count; o++) {
+        const TemplateOp* op = &module->ops[o];
+        if (op->kind != OP_INSTANCE) continue;
+        if (!finish_module(design, op->child, state)) return false;
+        const ModuleTemplate* child = &design->modules[op->child];
+        if (child->frame_size > deepest_child) deepest_child = child->frame_size;
+        module->flat_gate_count += child->flat_gate_count;
+    }
+    module->frame_size = module->nets->count + deepest_child;
+    state[index] = 2;
+    return true;
+}
+
+static bool link_design(DesignSink* target) {
+    Design* design = target->design;
+    int module_count = design->module_count;
+    int** port_slots = (int**)calloc((size_t)module_count, sizeof(int*));
+    bool* instantiated = (bool*)calloc((size_t)module_count, sizeof(bool));
+    char* state = (char*)calloc((size_t)module_count, 1);
+    long long* uses = (long long*)calloc((size_t)module_count, sizeof(long long));
+    int* order = (int*)malloc((size_t)module_count * sizeof(int));
+    bool ok = false;
+    if (!port_slots || !instantiated || !state || !uses || !order) {
+        sink_failed(target, "Out of memory");
+        goto done;
+    }
+
+    for (int m = 0; m < module_count; m++) {
+        port_slots[m] = build_port_slots(&design->modules[m]);
+        if (!port_slots[m]) {
+            sink_failed(target, "Out of memory");
+            goto done;
+        }
+    }
+    for (int m = 0; m < module_count; m++) {
+        if (!link_module(target, &design->modules[m], port_slots)) goto done;
+    }
+
+    for (int m = 0; m < module_count; m++) {
+        const ModuleTemplate* module = &design->modules[m];
+        for (int o = 0; o < module->op_count; o++) {
+            if (module->ops[o].kind == OP_INSTANCE) instantiated[module->ops[o].child] = true;
+        }
+    }
+    design->top = -1;
+    for (int m = 0; m < module_count; m++) {
+        if (instantiated[m]) continue;
+        if (design->top >= 0) {
+            fprintf(stderr, "Warning: Modules %s and %s are both uninstantiated, using %s as top\n",
+                    design->modules[design->top].name, design->modules[m].name, design->modules[m].name);
+        }
+        design->top = m;
+    }
+    if (design->top < 0) {
+        fprintf(stderr, "Error: Every module is instantiated by another, no top module\n");
+        goto done;
+    }
+
+    design->acyclic = true;
+    for (int m = 0; m < module_count; m++) {
+        if (!schedule_module(&design->modules[m], design)) {
+            sink_failed(target, "Out of memory");
+            goto done;
+        }
+        if (!design->modules[m].acyclic) design->acyclic = false;
+    }
+    for (int m = 0; m < module_count; m++) {
+        if (!finish_module(design, m, state)) goto done;
+    }
+
+    // Use counts top-down: a module is taken once all its parents are counted
+    // (finish_module() has rejected recursion, so this reaches every module)
+    int count = 0;
+    int* parents_left = (int*)calloc((size_t)module_count, sizeof(int));
+    if (!parents_left) {
+        sink_failed(target, "Out of memory");
+        goto done;
+    }
+    for (int m = 0; m < module_count; m++) {
+        const ModuleTemplate* module = &design->modules[m];
+        for (int o = 0; o < module->op_count; o++) {
+            if (module->ops[o].kind == OP_INSTANCE) parents_left[module->ops[o].child]++;
+        }
+    }
+    for (int m = 0; m < module_count; m++) {
+        if (parents_left[m] == 0) order[count++] = m;
+    }
+    uses[design->top] = 1;
+    for (int head = 0; head < count; head++) {
+        const ModuleTemplate* module = &design->modules[order[head]];
+        for (int o = 0; o < module->op_count; o++) {
+            if (module->ops[o].kind != OP_INSTANCE) continue;
+            int child = module->ops[o].child;
+            uses[child] += uses[order[head]];
+            if (--parents_left[child] == 0) order[count++] = child;
+        }
+    }
+    free(parents_left);
+    design->flat_instance_count = 0;
+    for (int m = 0; m < module_count; m++) {
+        if (m != design->top) design->flat_instance_count += uses[m];
+    }
+
+    design->scratch = (SignalValue*)malloc((size_t)(design->modules[design->top].frame_size + 1) * sizeof(SignalValue));
+    design->gate_inputs = (SignalValue*)malloc((size_t)(design->max_gate_inputs + 1) * sizeof(SignalValue));
+    if (!design->scratch || !design->gate_inputs) {
+        sink_failed(target, "Out of memory");
+        goto done;
+    }
+    ok = true;
+
+done:
+    if (port_slots) {
+        for (int m = 0; m < module_count; m++) free(port_slots[m]);
+    }
+    free(port_slots);
+    free(instantiated);
+    free(state);
+    free(uses);
+    free(order);
+    return ok;
+}
+
+// --- Public Function Implementations ---
+
+Design* load_design(const char* filename) {
+    Design* design = (Design*)calloc(1, sizeof(Design));
+    DesignSink target = { design, filename, NULL, create_string_pool(), create_string_pool(), false };
+    if (!design || !target.references || !target.formal_names ||
+        !(design->module_names = create_string_pool())) {
+        fprintf(stderr, "Error: Out of memory while loading %s\n", filename);
+        destroy_string_pool(target.references);
+        destroy_string_pool(target.formal_names);
+        destroy_design(design);
+        return NULL;
+    }
+
+    ParseSink sink = { &target, design_module, design_declare, design_gate, design_instance };
+    bool ok = (parse_verilog_stream(filename, &sink) == 0 && !target.failed);
+    if (ok && design->module_count == 0) {
+        fprintf(stderr, "Error: No module found in %s\n", filename);
+        ok = false;
+    }
+    if (ok) ok = link_design(&target);
+
+    destroy_string_pool(target.references);
+    destroy_string_pool(target.formal_names);
+    if (!ok) {
+        destroy_design(design);
+        return NULL;
+    }
+    return design;
+}
+
+void destroy_design(Design* design) {
+    if (!design) return;
+    for (int m = 0; m < design->module_count; m++) {
+        ModuleTemplate* module = &design->modules[m];
+        destroy_string_pool(module->nets);
+        destroy_string_pool(module->instance_names);
+        free(module->ports.ids);
+        free(module->inputs.ids);
+        free(module->outputs.ids);
+        free(module->ops);
+        free(module->op_nets);
+    }
+    free(design->modules);
+    destroy_string_pool(design->module_names);
+    free(design->scratch);
+    free(design->gate_inputs);
+    free(design);
+}
+
+// --- Evaluation ---
+
+static void clear_frame(SignalValue* frame, int count) {
+    for (int i = 0; i < count; i++) frame[i] = LOGIC_X;
+}
+
+// Evaluates one instance whose input nets are already set in frame; child
+// instances use the stack space after this module's nets
+static void evaluate_template(const Design* design, const ModuleTemplate* module, SignalValue* frame) {
+    SignalValue* child_frame = frame + module->nets->count;
+    SignalValue* inputs = design->gate_inputs;
+
+    for (int o = 0; o < module->op_count; o++) {
+        const TemplateOp* op = &module->ops[o];
+        const int* nets = module->op_nets + op->first_net;
+
+        if (op->kind == OP_GATE) {
+            int input_count = op->net_count - 1;
+            for (int i = 0; i < input_count; i++) inputs[i] = frame[nets[1 + i]];
+            frame[nets[0]] = evaluate_gate(op->gate_type, inputs, input_count);
+            continue;
+        }
+
+        const ModuleTemplate* child = &design->modules[op->child];
+        clear_frame(child_frame, child->nets->count);
+        for (int i = 0; i < child->inputs.count; i++) {
+            if (nets[i] >= 0) child_frame[child->inputs.ids[i]] = frame[nets[i]];
+        }
+        evaluate_template(design, child, child_frame);
+        for (int i = 0; i < child->outputs.count; i++) {
+            int net = nets[child->inputs.count + i];
+            if (net >= 0) frame[net] = child_frame[child->outputs.ids[i]];
+        }
+    }
+}
+
+bool evaluate_design(Design* design, const SignalValue* inputs, SignalValue* outputs) {
+    if (!design || !design->acyclic) return false;
+    const ModuleTemplate* top = &design->modules[design->top];
+
+    clear_frame(design->scratch, top->nets->count);
+    for (int i = 0; i < top->inputs.count; i++) design->scratch[top->inputs.ids[i]] = inputs[i];
+    evaluate_template(design, top, design->scratch);
+    for (int i = 0; i < top->outputs.count; i++) outputs[i] = design->scratch[top->outputs.ids[i]];
+    return true;
+}
+
+// --- Flattening ---
+
+typedef struct {
+    const Design* design;
+    Circuit* circuit;
+    bool failed;
+} Flattener;
+
+// Node of a net, created on first use and named by its instance path
+static int net_node(Flattener* flattener, const ModuleTemplate* module, int* net_nodes, int net, const char* prefix) {
+    if (net_nodes[net] >= 0) return net_nodes[net];
+
+    char name[MAX_NAME_LENGTH];
+    int length = snprintf(name, sizeof(name), "%s%s", prefix, string_pool_get(module->nets, net));
+    if (length < 0 || length >= (int)sizeof(name)) {
+        // Too deep to spell out: a name no netlist net can have
+        snprintf(name, sizeof(name), "~n%d", flattener->circuit->node_count);
+    }
+    net_nodes[net] = add_node(flattener->circuit, name, NODE_GATE);
+    if (net_nodes[net] < 0) flattener->failed = true;
+    return net_nodes[net];
+}
+
+static void flatten_module(Flattener* flattener, const ModuleTemplate* module, int* net_nodes, const char* prefix) {
+    const Design* design = flattener->design;
+    Circuit* circuit = flattener->circuit;
+
+    for (int o = 0; o < module->op_count && !flattener->failed; o++) {
+        const TemplateOp* op = &module->ops[o];
+        const int* nets = module->op_nets + op->first_net;
+        const char* instance_name = string_pool_get(module->instance_names, op->name);
+
+        if (op->kind == OP_GATE) {
+            int output = net_node(flattener, module, net_nodes, nets[0], prefix);
+            if (output < 0) return;
+            circuit->nodes[output].gate_type = op->gate_type;
+            snprintf(circuit->nodes[output].gate_instance, sizeof(circuit->nodes[output].gate_instance),
+                     "%s%s", prefix, instance_name);
+            for (int i = 1; i < op->net_count; i++) {
+                int input = net_node(flattener, module, net_nodes, nets[i], prefix);
+                if (input < 0 || !add_connection(circuit, input, output)) {
+                    flattener->failed = true;
+                    return;
+                }
+            }
+            continue;
+        }
+
+        // Child ports alias the parent's nets; the child's other nets get fresh nodes
+        const ModuleTemplate* child = &design->modules[op->child];
+        int* child_nodes = (int*)malloc((size_t)(child->nets->count > 0 ? child->nets->count : 1) * sizeof(int));
+        if (!child_nodes) {
+            flattener->failed = true;
+            return;
+        }
+        for (int i = 0; i < child->nets->count; i++) child_nodes[i] = -1;
+        for (int i = 0; i < child->inputs.count; i++) {
+            if (nets[i] >= 0) child_nodes[child->inputs.ids[i]] = net_node(flattener, module, net_nodes, nets[i], prefix);
+        }
+        for (int i = 0; i < child->outputs.count; i++) {
+            int net = nets[child->inputs.count + i];
+            if (net >= 0) child_nodes[child->outputs.ids[i]] = net_node(flattener, module, net_nodes, net, prefix);
+        }
+
+        char child_prefix[MAX_NAME_LENGTH];
+        int length = snprintf(child_prefix, sizeof(child_prefix), "%s%s/", prefix, instance_name);
+        if (length < 0 || length >= (int)sizeof(child_prefix)) child_prefix[0] = '~'; // Forces fallback names
+        if (!flattener->failed) flatten_module(flattener, child, child_nodes, child_prefix);
+        free(child_nodes);
+    }
+}
+
+Circuit* flatten_design(const Design* design) {
+    if (!design) return NULL;
+    const ModuleTemplate* top = &design->modules[design->top];
+    Flattener flattener = { design, create_circuit(), false };
+    int* net_nodes = (int*)malloc((size_t)(top->nets->count > 0 ? top->nets->count : 1) * sizeof(int));
+    if (!flattener.circuit || !net_nodes) {
+        fprintf(stderr, "Error: Out of memory flattening %s\n", top->name);
+        destroy_circuit(flattener.circuit);
+        free(net_nodes);
+        return NULL;
+    }
+
+    // Ports first, in declaration order, as a flat netlist would number them
+    for (int i = 0; i < top->nets->count; i++) net_nodes[i] = -1;
+    for (int i = 0; i < top->inputs.count; i++) {
+        int net = top->inputs.ids[i];
+        net_nodes[net] = add_node(flattener.circuit, string_pool_get(top->nets, net), NODE_PI);
+    }
+    for (int i = 0; i < top->outputs.count; i++) {
+        int net = top->outputs.ids[i];
+        net_nodes[net] = add_node(flattener.circuit, string_pool_get(top->nets, net), NODE_PO);
+    }
+    flatten_module(&flattener, top, net_nodes, "");
+    free(net_nodes);
+
+    if (flattener.failed) {
+        fprintf(stderr, "Error: Out of memory flattening %s\n", top->name);
+        destroy_circuit(flattener.circuit);
+        return NULL;
+    }
+    add_branch_nodes(flattener.circuit);
+    return flattener.circuit;
+}
+
+void summarize_design(const Design* design, NetlistSummary* summary) {
+    const ModuleTemplate* top = &design->modules[design->top];
+    memset(summary, 0, sizeof(*summary));
+    snprintf(summary->module_name, sizeof(summary->module_name), "%s", top->name);
+    summary->input_count = top->inputs.count;
+    summary->output_count = top->outputs.count;
+    summary->wire_count = top->wire_count;
+    summary->gate_count = (int)top->flat_gate_count;
+    summary->hierarchical = true;
+}
+
+void print_design_hierarchy(const Design* design) {
+    if (!design) return;
+
+    printf("=== Module Templates ===\n");
+    long long unique_gates = 0;
+    for (int m = 0; m < design->module_count; m++) {
+        const ModuleTemplate* module = &design->modules[m];
+        unique_gates += module->gate_count;
+        printf("%-15s %s%d gates, %d instances, %d nets, %lld gates flattened%s\n",
+               module->name, m == design->top ? "(top) " : "", module->gate_count, module->instance_count,
+               module->nets->count, module->flat_gate_count, module->acyclic ? "" : " [loop]");
+    }
+    const ModuleTemplate* top = &design->modules[design->top];
+    printf("Templates: %d, Instances flattened: %lld, Gates: %lld unique / %lld flattened\n",
+           design->module_count, design->flat_instance_count, unique_gates, top->flat_gate_count);
+    printf("Evaluation stack: %d values\n\n", top->frame_size);
+}
@@ -0,0 +1,126 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "circuit_builder.h"
+#include "circuit_node.h"
+#include "gate_logic.h"
+#include "string_pool.h"
+#include "verilog_parser.h"
+#include <stdbool.h>
+
+// Hierarchical (multi-module) Verilog netlists.
+//
+// Every module is compiled once into a template: its own gates and submodule
+// instances as a list of operations in evaluation (topological) order, over
+// nets numbered locally within the module. An instance only names its
+// template, so memory grows with the unique logic rather than the instance
+// count. A design is evaluated straight from the templates, each instance in
+// its own frame of one scratch stack, or flattened on demand into an ordinary
+// Circuit for the other engines.
+
+typedef enum {
+    OP_GATE,
+    OP_INSTANCE
+} TemplateOpKind;
+
+// A gate or submodule instance. Its nets are net_count consecutive entries of
+// ModuleTemplate.op_nets: a gate's output, then its inputs; an instance's
+// connections in the child's port order, inputs then outputs (-1: unconnected).
+typedef struct {
+    TemplateOpKind kind;
+    GateType gate_type;         // OP_GATE
+    int child;                  // OP_INSTANCE: template index
+    int name;                   // Instance name (ID in ModuleTemplate.instance_names)
+    int first_net;
+    int net_count;
+} TemplateOp;
+
+typedef struct {
+    char name[MAX_NAME_LENGTH];
+    StringPool* nets;           // Net names; a net's ID is its slot in an evaluation frame
+    StringPool* instance_names;
+    NameList ports;             // Header order, for positional connections
+    NameList inputs;
+    NameList outputs;
+    int wire_count;
+
+    TemplateOp* ops;            // In evaluation order once the design is loaded
+    int op_count;
+    int op_capacity;
+    int* op_nets;
+    int op_net_count;
+    int op_net_capacity;
+
+    int gate_count;             // Own gates
+    int instance_count;         // Own submodule instances
+    long long flat_gate_count;  // Gates in one flattened instance of this module
+    int frame_size;             // Scratch values to evaluate one instance (own nets + deepest child)
+    bool acyclic;               // The ops have an evaluation order
+} ModuleTemplate;
+
+typedef struct {
+    ModuleTemplate* modules;
+    int module_count;
+    int module_capacity;
+    StringPool* module_names;   // ID == template index
+    int top;                    // Template index of the top module
+    long long flat_instance_count;  // Module instances below the top, counted per use
+    bool acyclic;               // Every template is acyclic, so evaluate_design() can run
+    SignalValue* scratch;       // frame_size values of the top template
+    int max_gate_inputs;        // Widest gate of any template
+    SignalValue* gate_inputs;   // max_gate_inputs values gathered for one gate
+} Design;
+
+/**
+ * @brief Parses a multi-module Verilog file into one template per module.
+ *
+ * Instances may reference modules defined later in the file. The top module is
+ * the one no other module instantiates (the last such module if there are
+ * several).
+ * @param filename Verilog netlist.
+ * @return New design (caller destroys), or NULL if the file cannot be read,
+ *         references an unknown module or port, or instantiates recursively.
+ */
+Design* load_design(const char* filename);
+
+/**
+ * @brief Frees a design.
+ * @param design The design (may be NULL).
+ */
+void destroy_design(Design* design);
+
+/**
+ * @brief Evaluates the top module from the templates, without flattening.
+ * @param design The design.
+ * @param inputs One value per top-module input, in declaration order.
+ * @param outputs Receives one value per top-module output.
+ * @return false if some template has a combinational loop (flatten and use the
+ *         SCC engine instead).
+ */
+bool evaluate_design(Design* design, const SignalValue* inputs, SignalValue* outputs);
+
+/**
+ * @brief Expands the design into a flat circuit.
+ *
+ * Top-level nets keep their names; nets inside instances are named by their
+ * instance path ("u_alu/u_add3/n5"). Primary inputs and outputs are the top
+ * module's ports in declaration order, as for a flat netlist.
+ * @param design The design.
+ * @return New circuit (caller destroys), or NULL on allocation failure.
+ */
+Circuit* flatten_design(const Design* design);
+
+/**
+ * @brief Describes the top module in the terms of a flat build (gates counted flattened).
+ * @param design The design.
+ * @param summary Receives the summary.
+ */
+void summarize_design(const Design* design, NetlistSummary* summary);
+
+/**
+ * @brief Prints each template with its size and use count.
+ * @param design The design.
+ */
+void print_design_hierarchy(const Design* design);
+
+#endif // HIERARCHY_H
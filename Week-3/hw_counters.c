@@ -0,0 +1,117 @@
+#define _DEFAULT_SOURCE   // syscall()
+#include "hw_counters.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+static int counter_fds[HW_COUNTER_COUNT] = { -1, -1, -1, -1, -1 };
+static char open_error[160] = "";
+
+static const char* const counter_names[HW_COUNTER_COUNT] = {
+    "cycles", "instructions", "cache_misses", "l1d_misses", "branch_misses"
+};
+
+const char* hw_counter_name(HwCounter counter) {
+    return counter_names[counter];
+}
+
+const char* hw_counters_error(void) {
+    return open_error;
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.inherit = 1;          // Threads created later count into this counter
+    attr.exclude_kernel = 1;   // User space only: allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool open_hw_counters(void) {
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[HW_COUNTER_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    int opened = 0;
+    int first_errno = 0;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        if (counter_fds[c] >= 0) {
+            opened++;
+            continue;
+        }
+        counter_fds[c] = open_counter(events[c].type, events[c].config);
+        if (counter_fds[c] >= 0) {
+            opened++;
+        } else if (!first_errno) {
+            first_errno = errno;
+        }
+    }
+    if (opened > 0) {
+        open_error[0] = '\0';
+        return true;
+    }
+
+    // Explain the usual causes rather than only the errno
+    int paranoid = -1;
+    FILE* file = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (file) {
+        if (fscanf(file, "%d", &paranoid) != 1) paranoid = -1;
+        fclose(file);
+    }
+    const char* hint = "";
+    if (first_errno == ENOENT || first_errno == EOPNOTSUPP) hint = " (no hardware PMU exposed, e.g. a VM)";
+    else if (first_errno == ENOSYS) hint = " (blocked by the container's seccomp filter)";
+    else if ((first_errno == EACCES || first_errno == EPERM) && paranoid > 2) hint = " (perf_event_paranoid is above 2)";
+    snprintf(open_error, sizeof(open_error), "perf_event_open: %s%s", strerror(first_errno), hint);
+    return false;
+}
+
+void read_hw_counters(HwCounts* counts) {
+    memset(counts, 0, sizeof(*counts));
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        if (counter_fds[c] < 0) continue;
+
+        uint64_t data[3];   // value, time enabled, time running
+        if (read(counter_fds[c], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+        // Multiplexed with other events: extrapolate to the full enabled time
+        uint64_t value = data[0];
+        if (data[2] > 0 && data[2] < data[1]) {
+            value = (uint64_t)((double)value * (double)data[1] / (double)data[2]);
+        } else if (data[2] == 0 && data[1] > 0) {
+            continue;   // Never got onto the PMU
+        }
+        counts->value[c] = value;
+        counts->valid[c] = true;
+    }
+}
+#else
+bool open_hw_counters(void) {
+    snprintf(open_error, sizeof(open_error), "perf_event_open is only available on Linux");
+    return false;
+}
+
+void read_hw_counters(HwCounts* counts) {
+    memset(counts, 0, sizeof(*counts));
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef HW_COUNTERS_H
+#define HW_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hardware performance counters through Linux perf_event_open().
+//
+// The counters count user-space events of the whole process: they are
+// opened with inherit set, so threads started afterwards count too, and a
+// thread's events are added to the totals when it exits (the engines join
+// their threads before a phase ends). Each counter is opened on its own, so
+// a PMU that lacks one event (common in VMs) still provides the others. If
+// none can be opened (no PMU, a container seccomp filter, a restrictive
+// perf_event_paranoid, or not Linux), reads report nothing and
+// hw_counters_error() says why.
+
+typedef enum {
+    HW_CYCLES,
+    HW_INSTRUCTIONS,
+    HW_CACHE_MISSES,      // Last-level cache misses
+    HW_L1D_MISSES,        // L1 data cache read misses
+    HW_BRANCH_MISSES,
+    HW_COUNTER_COUNT
+} HwCounter;
+
+typedef struct {
+    uint64_t value[HW_COUNTER_COUNT];
+    bool valid[HW_COUNTER_COUNT];   // Counter opened and read
+} HwCounts;
+
+/**
+ * @brief Opens and starts the counters (call once, before starting threads).
+ * @return true if at least one counter is counting.
+ */
+bool open_hw_counters(void);
+
+/**
+ * @brief Reads the totals since open_hw_counters(), scaled up if the kernel
+ *        multiplexed the counters.
+ * @param counts Receives the totals; valid[] is all false if none are open.
+ */
+void read_hw_counters(HwCounts* counts);
+
+/**
+ * @brief Why no counter could be opened (empty while counting or never opened).
+ */
+const char* hw_counters_error(void);
+
+/**
+ * @brief Short name of a counter ("cycles", "instructions", ...).
+ */
+const char* hw_counter_name(HwCounter counter);
+
+#endif // HW_COUNTERS_H
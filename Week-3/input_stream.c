@@ -0,0 +1,391 @@
+#include "input_stream.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "spsc_ring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define MAGIC_BYTES 4
+#define COMPRESSED_BLOCK_BYTES (1 << 20)    // read() size of the reader thread
+#define COMPRESSED_BLOCK_COUNT 2            // One block is read while the other is decoded
+#define DECODE_STEP_BYTES (1u << 30)        // Largest output handed to one zlib call (avail_out is 32-bit)
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+} CompressedBlock;
+
+struct InputStream {
+    CompressionKind compression;
+    int fd;
+    char* name;
+    bool failed;
+    bool at_end;
+
+    // Bytes read to recognise the format, handed out before the rest of the file
+    unsigned char head[MAGIC_BYTES];
+    size_t head_length;
+    size_t head_position;
+
+    // Compressed input: blocks circulate between the reader thread and the decoder
+    pthread_t reader;
+    bool reader_running;
+    SpscRing filled;                // reader -> decoder; NULL marks the end of the file
+    SpscRing empty;                 // decoder -> reader; NULL stops the reader
+    CompressedBlock blocks[COMPRESSED_BLOCK_COUNT];
+    CompressedBlock* current;       // Block being decoded
+    const unsigned char* in_next;   // Undecoded part of current
+    size_t in_left;
+    bool input_done;                // The reader has delivered everything
+    int read_errno;                 // Set by the reader before it signals the end
+    bool frame_open;                // Inside a compressed member/frame
+
+#ifdef HAVE_ZLIB
+    z_stream gzip;
+    bool gzip_ready;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream* zstd;
+#endif
+};
+
+CompressionKind detect_compression(const unsigned char* head, size_t length) {
+    if (length >= 2 && head[0] == 0x1F && head[1] == 0x8B) return COMPRESSION_GZIP;
+    if (length >= 4 && head[0] == 0x28 && head[1] == 0xB5 && head[2] == 0x2F && head[3] == 0xFD) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+static const char* compression_name(CompressionKind kind) {
+    return kind == COMPRESSION_GZIP ? "gzip" : kind == COMPRESSION_ZSTD ? "zstd" : "plain";
+}
+
+static bool compression_supported(CompressionKind kind) {
+    switch (kind) {
+        case COMPRESSION_NONE: return true;
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP: return true;
+#endif
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD: return true;
+#endif
+        default:               return false;
+    }
+}
+
+// read() that retries short reads; returns bytes read (short at end of file) or -1
+static ssize_t read_fully(int fd, unsigned char* buffer, size_t size) {
+    size_t used = 0;
+    while (used < size) {
+        ssize_t got = read(fd, buffer + used, size - used);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) break;
+        used += (size_t)got;
+    }
+    return (ssize_t)used;
+}
+
+static void stream_error(InputStream* stream, const char* detail) {
+    if (!stream->failed) {
+        fprintf(stderr, "Error: %s: %s\n", stream->name, detail);
+    }
+    stream->failed = true;
+    stream->at_end = true;
+}
+
+// --- Reader thread ---
+
+static void* reader_thread(void* arg) {
+    InputStream* stream = (InputStream*)arg;
+    trace_name_thread("reader", -1);
+    for (;;) {
+        void* item;
+        spsc_ring_pop(&stream->empty, &item);
+        if (!item) break;
+
+        CompressedBlock* block = (CompressedBlock*)item;
+        double trace_begin = TRACE_BEGIN();
+        ssize_t got = read_fully(stream->fd, block->data, COMPRESSED_BLOCK_BYTES);
+        TRACE_END("read block", trace_begin);
+        if (got <= 0) {
+            if (got < 0) stream->read_errno = errno;
+            spsc_ring_push(&stream->filled, NULL);
+            break;
+        }
+        block->length = (size_t)got;
+        spsc_ring_push(&stream->filled, block);
+    }
+    return NULL;
+}
+
+// Moves to the next compressed block; false at the end of the file
+static bool next_block(InputStream* stream) {
+    if (stream->input_done) return false;
+    if (stream->current) spsc_ring_push(&stream->empty, stream->current);
+
+    void* item;
+    spsc_ring_pop(&stream->filled, &item);
+    stream->current = (CompressedBlock*)item;
+    if (!item) {
+        stream->input_done = true;
+        if (stream->read_errno) stream_error(stream, strerror(stream->read_errno));
+        return false;
+    }
+    stream->in_next = stream->current->data;
+    stream->in_left = stream->current->length;
+    return true;
+}
+
+// Makes sure there is compressed input to decode; false at the end of the file
+static bool have_input(InputStream* stream) {
+    if (stream->in_left > 0) return true;
+    if (stream->head_position < stream->head_length) {
+        stream->in_next = stream->head + stream->head_position;
+        stream->in_left = stream->head_length - stream->head_position;
+        stream->head_position = stream->head_length;
+        return true;
+    }
+    while (next_block(stream)) {
+        if (stream->in_left > 0) return true;
+    }
+    if (stream->frame_open && !stream->failed) stream_error(stream, "compressed data ends unexpectedly");
+    return false;
+}
+
+// --- Decoders ---
+
+static size_t read_plain(InputStream* stream, unsigned char* buffer, size_t size) {
+    size_t used = 0;
+    if (stream->head_position < stream->head_length) {
+        used = stream->head_length - stream->head_position;
+        if (used > size) used = size;
+        memcpy(buffer, stream->head + stream->head_position, used);
+        stream->head_position += used;
+    }
+
+    ssize_t got = read_fully(stream->fd, buffer + used, size - used);
+    if (got < 0) {
+        stream_error(stream, strerror(errno));
+        return used;
+    }
+    used += (size_t)got;
+    if (used < size) stream->at_end = true;
+    return used;
+}
+
+#ifdef HAVE_ZLIB
+// Concatenated members (pigz, "cat a.gz b.gz") decode as one file, like gzip -d
+static size_t read_gzip(InputStream* stream, unsigned char* buffer, size_t size) {
+    z_stream* z = &stream->gzip;
+    size_t used = 0;
+    while (used < size && have_input(stream)) {
+        size_t step = size - used;
+        if (step > DECODE_STEP_BYTES) step = DECODE_STEP_BYTES;
+        size_t in_step = stream->in_left > DECODE_STEP_BYTES ? DECODE_STEP_BYTES : stream->in_left;
+
+        z->next_in = (unsigned char*)stream->in_next;
+        z->avail_in = (uInt)in_step;
+        z->next_out = buffer + used;
+        z->avail_out = (uInt)step;
+        int status = inflate(z, Z_NO_FLUSH);
+        stream->in_next += in_step - z->avail_in;
+        stream->in_left -= in_step - z->avail_in;
+        used += step - z->avail_out;
+
+        if (status == Z_STREAM_END) {
+            stream->frame_open = false;
+            inflateReset(z);
+        } else if (status == Z_OK || status == Z_BUF_ERROR) {
+            stream->frame_open = true;
+        } else {
+            stream_error(stream, z->msg ? z->msg : "corrupt gzip data");
+            return used;
+        }
+    }
+    if (used < size) stream->at_end = true;
+    return used;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static size_t read_zstd(InputStream* stream, unsigned char* buffer, size_t size) {
+    size_t used = 0;
+    while (used < size && have_input(stream)) {
+        ZSTD_inBuffer in = { stream->in_next, stream->in_left, 0 };
+        ZSTD_outBuffer out = { buffer + used, size - used, 0 };
+        size_t status = ZSTD_decompressStream(stream->zstd, &out, &in);
+        if (ZSTD_isError(status)) {
+            stream_error(stream, ZSTD_getErrorName(status));
+            return used + out.pos;
+        }
+        stream->in_next += in.pos;
+        stream->in_left -= in.pos;
+        used += out.pos;
+        stream->frame_open = (status != 0);
+    }
+    if (used < size) stream->at_end = true;
+    return used;
+}
+#endif
+
+// --- Public Function Implementations ---
+
+static bool start_decoder(InputStream* stream) {
+#ifdef HAVE_ZLIB
+    if (stream->compression == COMPRESSION_GZIP) {
+        memset(&stream->gzip, 0, sizeof(stream->gzip));
+        if (inflateInit2(&stream->gzip, 15 + 16) != Z_OK) return false;
+        stream->gzip_ready = true;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (stream->compression == COMPRESSION_ZSTD) {
+        stream->zstd = ZSTD_createDStream();
+        if (!stream->zstd) return false;
+        ZSTD_initDStream(stream->zstd);
+    }
+#endif
+
+    if (!spsc_ring_init(&stream->filled, COMPRESSED_BLOCK_COUNT + 1) ||
+        !spsc_ring_init(&stream->empty, COMPRESSED_BLOCK_COUNT + 1)) {
+        return false;
+    }
+    for (int i = 0; i < COMPRESSED_BLOCK_COUNT; i++) {
+        stream->blocks[i].data = (unsigned char*)malloc(COMPRESSED_BLOCK_BYTES);
+        if (!stream->blocks[i].data) return false;
+        spsc_ring_push(&stream->empty, &stream->blocks[i]);
+    }
+    if (pthread_create(&stream->reader, NULL, reader_thread, stream) != 0) return false;
+    stream->reader_running = true;
+    return true;
+}
+
+InputStream* open_input_descriptor(int fd, const char* name) {
+    InputStream* stream = (InputStream*)calloc(1, sizeof(InputStream));
+    if (!stream || !(stream->name = (char*)malloc(strlen(name) + 1))) {
+        free(stream);
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+    strcpy(stream->name, name);
+    stream->fd = fd;
+
+    ssize_t got = read_fully(fd, stream->head, MAGIC_BYTES);
+    if (got < 0) {
+        int saved_errno = errno;
+        close_input_stream(stream);
+        errno = saved_errno;
+        return NULL;
+    }
+    stream->head_length = (size_t)got;
+    stream->compression = detect_compression(stream->head, stream->head_length);
+    if (stream->compression == COMPRESSION_NONE) return stream;
+
+    if (!compression_supported(stream->compression)) {
+        fprintf(stderr, "Error: %s is %s-compressed, but this build cannot read %s files\n",
+                name, compression_name(stream->compression), compression_name(stream->compression));
+        close_input_stream(stream);
+        errno = ENOTSUP;
+        return NULL;
+    }
+    if (!start_decoder(stream)) {
+        close_input_stream(stream);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return stream;
+}
+
+InputStream* open_input_stream(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return open_input_descriptor(fd, filename);
+}
+
+size_t read_input_stream(InputStream* stream, void* buffer, size_t size) {
+    if (stream->at_end || size == 0) return 0;
+    size_t got;
+    switch (stream->compression) {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP: got = read_gzip(stream, (unsigned char*)buffer, size); break;
+#endif
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD: got = read_zstd(stream, (unsigned char*)buffer, size); break;
+#endif
+        default:               got = read_plain(stream, (unsigned char*)buffer, size); break;
+    }
+    SIM_STAT_ADD(bytes_read, (long long)got);
+    return got;
+}
+
+char* read_entire_stream(InputStream* stream, size_t* size) {
+    size_t capacity = 1 << 16;
+    size_t used = 0;
+    char* data = (char*)malloc(capacity + 1);
+    while (data) {
+        used += read_input_stream(stream, data + used, capacity - used);
+        if (used < capacity) break;
+        capacity *= 2;
+        char* grown = (char*)realloc(data, capacity + 1);
+        if (!grown) {
+            free(data);
+            data = NULL;
+        } else {
+            data = grown;
+        }
+    }
+    if (!data) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (stream->failed) {
+        free(data);
+        errno = EIO;
+        return NULL;
+    }
+    data[used] = '\0';
+    *size = used;
+    return data;
+}
+
+bool input_stream_failed(const InputStream* stream) {
+    return stream->failed;
+}
+
+void close_input_stream(InputStream* stream) {
+    if (!stream) return;
+    if (stream->reader_running) {
+        // The reader either waits for an empty block or has already signalled the end
+        spsc_ring_push(&stream->empty, NULL);
+        pthread_join(stream->reader, NULL);
+    }
+    spsc_ring_destroy(&stream->filled);
+    spsc_ring_destroy(&stream->empty);
+    for (int i = 0; i < COMPRESSED_BLOCK_COUNT; i++) free(stream->blocks[i].data);
+#ifdef HAVE_ZLIB
+    if (stream->gzip_ready) inflateEnd(&stream->gzip);
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(stream->zstd);
+#endif
+    close(stream->fd);
+    free(stream->name);
+    free(stream);
+}
@@ -0,0 +1,79 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sequential reader that decompresses on the fly.
+//
+// Netlists and vector files may be stored gzip- or zstd-compressed; the
+// format is recognised from the first bytes, not the file name. Plain files
+// are read as they are. For compressed files a reader thread fills two
+// compressed blocks in turn (double buffering) while the caller's thread
+// decodes the other one, so disk reads overlap decompression and no
+// intermediate file is written.
+//
+// gzip needs zlib (HAVE_ZLIB) and zstd needs libzstd (HAVE_ZSTD); the Makefile
+// enables each one when its header is installed.
+
+typedef enum {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD
+} CompressionKind;
+
+typedef struct InputStream InputStream;
+
+/**
+ * @brief Recognises a compressed file from its first bytes.
+ * @param head Start of the file.
+ * @param length Bytes available in head (4 are enough).
+ * @return The compression format, COMPRESSION_NONE for anything else.
+ */
+CompressionKind detect_compression(const unsigned char* head, size_t length);
+
+/**
+ * @brief Opens a file for reading, decompressing it if needed.
+ * @param filename Path of the file.
+ * @return New stream (close with close_input_stream()), or NULL with errno set
+ *         if the file cannot be opened or uses a format this build cannot read.
+ */
+InputStream* open_input_stream(const char* filename);
+
+/**
+ * @brief Like open_input_stream(), for an already open descriptor (pipes too).
+ * @param fd Descriptor positioned at the start of the data; the stream takes ownership.
+ * @param name Name used in error messages.
+ * @return New stream, or NULL with errno set (fd is closed).
+ */
+InputStream* open_input_descriptor(int fd, const char* name);
+
+/**
+ * @brief Reads decompressed data, like fread().
+ * @param stream The stream.
+ * @param buffer Receives the data.
+ * @param size Bytes wanted.
+ * @return Bytes read; fewer than size only at the end of the data or on an error.
+ */
+size_t read_input_stream(InputStream* stream, void* buffer, size_t size);
+
+/**
+ * @brief Reads the rest of the stream into one heap buffer.
+ * @param stream The stream.
+ * @param size Receives the number of bytes read.
+ * @return NUL-terminated buffer (caller frees), or NULL on a read error or out of memory.
+ */
+char* read_entire_stream(InputStream* stream, size_t* size);
+
+/**
+ * @brief Tells whether reading stopped on an I/O error or corrupt compressed data.
+ */
+bool input_stream_failed(const InputStream* stream);
+
+/**
+ * @brief Stops the reader thread, closes the file and frees the stream.
+ * @param stream The stream (may be NULL).
+ */
+void close_input_stream(InputStream* stream);
+
+#endif // INPUT_STREAM_H
@@ -0,0 +1,58 @@
+#ifndef LEVELIZER_H
+#define LEVELIZER_H
+
+#include "circuit_node.h"
+#include <stdbool.h>
+
+// Topological levelization of a circuit.
+//
+// Primary inputs and undriven nodes are level 0; every other node sits one
+// level above its deepest fanin. order[] lists node IDs sorted by level, so a
+// single pass over it evaluates an acyclic circuit completely.
+
+typedef struct {
+    int* level;          // Level of each node (-1 if it lies on a combinational loop)
+    int* order;          // Node IDs in level order
+    int* position;       // Index of each node in order[] (-1 if not ordered)
+    int order_count;     // Nodes in order[] (== node_count when acyclic)
+    int node_count;
+    int max_level;
+    bool is_acyclic;
+} Levelization;
+
+/**
+ * @brief Computes levels and a level-ordered node list (Kahn's algorithm).
+ * @param circuit A fully built circuit.
+ * @return New levelization, or NULL on allocation failure. Nodes on
+ *         combinational loops are left out of order[] and is_acyclic is false.
+ */
+Levelization* levelize_circuit(const Circuit* circuit);
+
+/**
+ * @brief Frees a levelization.
+ */
+void destroy_levelization(Levelization* levels);
+
+/**
+ * @brief Simulates an acyclic circuit with one pass in level order.
+ *
+ * Produces the same node values as simulate_circuit() on acyclic circuits,
+ * without repeated sweeps.
+ * @param circuit The circuit (PI values already set).
+ * @param levels Levelization of the circuit.
+ * @return false if the circuit is cyclic and was not simulated.
+ */
+bool simulate_levelized(Circuit* circuit, const Levelization* levels);
+
+/**
+ * @brief Level-order evaluation into a caller-owned value array.
+ *
+ * Reads the circuit structure only, so several threads may evaluate the same
+ * circuit concurrently with their own arrays.
+ * @param circuit The circuit.
+ * @param levels Levelization of the circuit (must be acyclic).
+ * @param values One value per node; PI and undriven entries must be preset.
+ */
+void evaluate_levelized_values(const Circuit* circuit, const Levelization* levels, SignalValue* values);
+
+#endif // LEVELIZER_H
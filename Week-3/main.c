@@ -2,87 +2,65 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/stat.h>
 
 #include "verilog_parser.h"
 #include "gate_logic.h"
 #include "circuit_node.h"
+#include "circuit_builder.h"
+#include "parallel_parser.h"
+#include "bench_parser.h"
+#include "hierarchy.h"
+#include "netlist_cache.h"
+#include "netlist_writer.h"
+#include "demand_eval.h"
+#include "levelizer.h"
+#include "cone_partition.h"
+#include "signal_probability.h"
+#include "sim_pipeline.h"
+#include "engine_tuner.h"
+#include "cross_check.h"
+#include "scc.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
 
-// Function to build circuit from parsed data
-Circuit* build_circuit_from_parsed_data(void) {
-    Circuit* circuit = create_circuit();
-    if (!circuit) {
-        fprintf(stderr, "Error: Failed to create circuit\n");
-        return NULL;
-    }
-    
-    printf("Building circuit from parsed data...\n");
-    
-    // Step 1: Add all primary input nodes
-    for (int i = 0; i < input_count; i++) {
-        int node_id = add_node(circuit, input_signals[i].name, NODE_PI);
-        if (node_id == -1) {
-            fprintf(stderr, "Error: Failed to add primary input %s\n", input_signals[i].name);
-        } else {
-            printf("Added PI: %s (ID: %d)\n", input_signals[i].name, node_id);
-        }
-    }
-    
-    // Step 2: Add all primary output nodes
-    for (int i = 0; i < output_count; i++) {
-        int node_id = add_node(circuit, output_signals[i].name, NODE_PO);
-        if (node_id == -1) {
-            fprintf(stderr, "Error: Failed to add primary output %s\n", output_signals[i].name);
-        } else {
-            printf("Added PO: %s (ID: %d)\n", output_signals[i].name, node_id);
-        }
-    }
-    
-    // Step 3: Add wire nodes and gate nodes from parsed gates
-    for (int i = 0; i < parsed_gate_count; i++) {
-        GateInstance* gate = &parsed_gates[i];
-        
-        // Add output node as gate node
-        int output_node_id = add_node(circuit, gate->output_signal, NODE_GATE);
-        if (output_node_id == -1) {
-            fprintf(stderr, "Error: Failed to add gate output node %s\n", gate->output_signal);
-            continue;
-        }
-        
-        // Set gate properties
-        circuit->nodes[output_node_id].gate_type = gate->type;
-        strncpy(circuit->nodes[output_node_id].gate_instance, gate->instance_name, 
-                sizeof(circuit->nodes[output_node_id].gate_instance) - 1);
-        
-        printf("Added Gate: %s -> %s (ID: %d, Type: %s)\n", 
-               gate->instance_name, gate->output_signal, output_node_id,
-               gate_type_to_string(gate->type));
-        
-        // Add input nodes if they don't exist
-        for (int j = 0; j < gate->input_signal_count; j++) {
-            int input_node_id = add_node(circuit, gate->input_signals[j].name, NODE_GATE);
-            if (input_node_id == -1) {
-                fprintf(stderr, "Error: Failed to add input node %s\n", gate->input_signals[j].name);
-                continue;
-            }
-            
-            // Add connection from input to gate output
-            if (!add_connection(circuit, input_node_id, output_node_id)) {
-                fprintf(stderr, "Error: Failed to connect %s -> %s\n", 
-                        gate->input_signals[j].name, gate->output_signal);
+
+// --stats / --stats-json / --trace: written from an atexit() handler, so every exit path reports
+static bool stats_report = false;
+static const char* stats_json_file = NULL;
+static const char* trace_file = NULL;
+
+static void report_stats(void) {
+    SimStatsReport report;
+    collect_sim_stats(&report);
+    fflush(stdout);
+    if (stats_report) print_sim_stats(stderr, &report);
+    if (stats_json_file) write_sim_stats_json(stats_json_file, &report);
+    if (trace_file) write_trace(trace_file);
+}
+
+// Prompts until the user enters 0 or 1 for one input
+SignalValue get_user_input(const char* name) {
+    char input_buffer[10];
+    int val = -1;
+
+    while (val != 0 && val != 1) {
+        printf("  %s: ", name);
+        if (fgets(input_buffer, sizeof(input_buffer), stdin) != NULL) {
+            input_buffer[strcspn(input_buffer, "\n")] = 0;
+            if (strcmp(input_buffer, "0") == 0) {
+                val = 0;
+            } else if (strcmp(input_buffer, "1") == 0) {
+                val = 1;
             } else {
-                printf("  Connected: %s (ID:%d) -> %s (ID:%d)\n", 
-                       gate->input_signals[j].name, input_node_id,
-                       gate->output_signal, output_node_id);
+                printf("    Invalid input. Please enter 0 or 1.\n");
             }
+        } else {
+            fprintf(stderr, "Error reading input.\n");
+            exit(EXIT_FAILURE);
         }
     }
-    
-    // Step 4: Add branch nodes for fanout points
-    printf("\nAdding branch nodes for fanout points...\n");
-    add_branch_nodes(circuit);
-    
-    printf("Circuit construction completed.\n\n");
-    return circuit;
+    return (val == 1) ? LOGIC_1 : LOGIC_0;
 }
 
 // Function to get user input for primary inputs
@@ -90,61 +68,439 @@ void get_user_inputs(Circuit* circuit, SignalValue* input_values) {
     printf("## Enter Primary Input Values (0 or 1):\n");
     for (int i = 0; i < circuit->pi_count; i++) {
         int node_id = circuit->primary_inputs[i];
-        CircuitNode* node = &circuit->nodes[node_id];
-        
-        char input_buffer[10];
-        int val = -1;
-        
-        while (val != 0 && val != 1) {
-            printf("  %s: ", node->name);
-            if (fgets(input_buffer, sizeof(input_buffer), stdin) != NULL) {
-                input_buffer[strcspn(input_buffer, "\n")] = 0;
-                if (strcmp(input_buffer, "0") == 0) {
-                    val = 0;
-                } else if (strcmp(input_buffer, "1") == 0) {
-                    val = 1;
-                } else {
-                    printf("    Invalid input. Please enter 0 or 1.\n");
-                }
-            } else {
-                fprintf(stderr, "Error reading input.\n");
-                exit(EXIT_FAILURE);
+        input_values[i] = get_user_input(circuit->nodes[node_id].name);
+    }
+    printf("\n");
+}
+
+void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s <netlist_file> [options]\n", program);
+    fprintf(stderr, "The netlist is gate-level Verilog or ISCAS .bench (detected from the file).\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --targets N1,N2,...   Evaluate only the listed nodes (demand-driven)\n");
+    fprintf(stderr, "  --partitions K        Simulate K output-cone partitions in parallel\n");
+    fprintf(stderr, "  --cop                 Print COP signal probabilities instead of simulating\n");
+    fprintf(stderr, "  --cop-samples WORDS   Like --cop, correcting reconvergent nodes with WORDS x 64 samples\n");
+    fprintf(stderr, "  --engine NAME         auto (default), iterative, levelized, partitioned or scc\n");
+    fprintf(stderr, "  --cross-check RATE    Re-simulate RATE (0-1) of the vectors with the reference and compare\n");
+    fprintf(stderr, "  --tune                Benchmark engines and batch settings, save to <netlist_file>.tune\n");
+    fprintf(stderr, "  --parse-threads N     Parse the netlist with N threads (default: all CPUs above 8 MB)\n");
+    fprintf(stderr, "  --hierarchical        Evaluate a multi-module design from its module templates\n");
+    fprintf(stderr, "                        instead of flattening it\n");
+    fprintf(stderr, "  --no-netlist-cache    Always parse the netlist; neither read nor write <netlist_file>.ckt\n");
+    fprintf(stderr, "  --write-netlist FILE  Save the (flattened) circuit as Verilog, or .bench if FILE ends\n");
+    fprintf(stderr, "                        in .bench, and exit\n");
+    fprintf(stderr, "  --stats               Print phase times, hardware and simulation counters to stderr at exit\n");
+    fprintf(stderr, "                        (simulation counters need a build with make STATS=yes)\n");
+    fprintf(stderr, "  --stats-json FILE     Write them as JSON to FILE (- for stdout) at exit\n");
+    fprintf(stderr, "  --trace FILE          Write a Chrome trace of the phases and threads to FILE at exit\n");
+    fprintf(stderr, "Batch options (pipelined, non-interactive):\n");
+    fprintf(stderr, "  --vectors FILE        Simulate every vector in FILE (one line of 0/1/X per vector)\n");
+    fprintf(stderr, "  --random N            Simulate N random vectors\n");
+    fprintf(stderr, "  --seed S              Seed for --random (default 1)\n");
+    fprintf(stderr, "  --threads W           Simulation worker threads (default: tuned)\n");
+    fprintf(stderr, "  --batch-size B        Vectors per pipeline batch (default: tuned)\n");
+    fprintf(stderr, "  --cache-mb MB         Result cache for repeated vectors (default off)\n");
+    fprintf(stderr, "  --output FILE         Write PO responses to FILE instead of stdout\n");
+}
+
+// Picks the engine: a valid saved tuning, a fresh benchmark (--tune) or the heuristic.
+// Reconvergence is only searched for when it is reported (verbose) or tuned for.
+// source_hash is the netlist's hash if it was already computed for the netlist cache, else 0.
+void choose_engine(Circuit* circuit, const Levelization* levels, const char* filename, uint64_t source_hash,
+                   bool tune, bool tune_batch, bool verbose, CircuitProfile* profile, EngineConfig* config) {
+    profile_circuit(circuit, levels, tune || verbose, profile);
+    if (!source_hash) source_hash = hash_netlist_source(filename);
+
+    if (!tune && load_engine_config(filename, source_hash, config)) {
+        // Saved tunings are only written for acyclic netlists, but stay safe
+        if (!profile->is_acyclic) config->engine = ENGINE_SCC;
+        return;
+    }
+
+    if (tune) {
+        tune_engine(circuit, levels, profile, tune_batch, config);
+        if (config->measured && save_engine_config(filename, source_hash, config) != 0) {
+            fprintf(stderr, "Warning: Could not save tuning to %s.tune\n", filename);
+        }
+    } else {
+        select_engine_heuristic(profile, config);
+    }
+}
+
+// Runs the pipelined batch flow; responses go to output_file or stdout
+int run_batch(Circuit* circuit, const Levelization* levels, PipelineOptions* options, const char* output_file) {
+    FILE* output = stdout;
+    if (output_file) {
+        output = fopen(output_file, "w");
+        if (!output) {
+            perror("Error opening output file");
+            return 1;
+        }
+    }
+    options->output = output;
+
+    PipelineStats stats;
+    int status = run_simulation_pipeline(circuit, levels, options, &stats);
+    if (status == 0) {
+        print_pipeline_stats(stderr, &stats);
+        if (stats.cross_check.vectors_seen > 0) {
+            print_cross_check_stats(stderr, circuit, &stats.cross_check);
+            if (stats.cross_check.mismatched_vectors > 0) {
+                fprintf(stderr, "Error: Engine diverged from the reference simulator\n");
+                status = 1;
             }
         }
-        input_values[i] = (val == 1) ? LOGIC_1 : LOGIC_0;
+    }
+
+    if (output != stdout) fclose(output);
+    return status;
+}
+
+// Compares the node values left by the selected engine with the reference sweep
+// (only the nodes in scope when it is not NULL, see CrossChecker)
+bool run_cross_check(Circuit* circuit, const Levelization* levels, const SignalValue* input_values,
+                     const unsigned char* scope) {
+    SignalValue* engine_values = (SignalValue*)malloc((circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(SignalValue));
+    CrossChecker* checker = create_cross_checker(circuit, levels, 1.0, 0);
+    if (!engine_values || !checker) {
+        fprintf(stderr, "Error: Out of memory cross-checking\n");
+        free(engine_values);
+        destroy_cross_checker(checker);
+        return false;
+    }
+    checker->scope = scope;
+
+    for (int i = 0; i < circuit->node_count; i++) engine_values[i] = circuit->nodes[i].value;
+    bool match = cross_check_vector(checker, 0, input_values, engine_values, NULL);
+    print_cross_check_stats(stdout, circuit, &checker->stats);
+
+    free(engine_values);
+    destroy_cross_checker(checker);
+    return match;
+}
+
+// Computes and prints COP signal probabilities (all PIs at 0.5)
+int run_signal_probability(Circuit* circuit, int sample_words) {
+    Levelization* levels = levelize_circuit(circuit);
+    double* probabilities = (double*)malloc((circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(double));
+    if (!levels || !probabilities) {
+        fprintf(stderr, "Error: Out of memory computing signal probabilities\n");
+        destroy_levelization(levels);
+        free(probabilities);
+        return 1;
+    }
+
+    compute_signal_probabilities(circuit, levels, NULL, probabilities);
+
+    if (sample_words > 0) {
+        CopCorrectionStats stats;
+        if (!levels->is_acyclic) {
+            fprintf(stderr, "Warning: Circuit has combinational loops, skipping Monte Carlo correction\n");
+        } else if (correct_reconvergent_probabilities(circuit, levels, NULL, probabilities,
+                                                      sample_words, 1, &stats) == 0) {
+            printf("## Reconvergence Correction\n");
+            printf("Fanout stems: %d, Reconvergent gates: %d\n", stats.fanout_stems, stats.reconvergent_gates);
+            printf("Corrected %d nodes by simulating %d nodes over %lld samples.\n\n",
+                   stats.corrected_nodes, stats.simulated_nodes, stats.samples);
+        }
+    }
+
+    print_signal_probabilities(circuit, probabilities);
+
+    destroy_levelization(levels);
+    free(probabilities);
+    return 0;
+}
+
+// Evaluates a hierarchical design from its module templates, without flattening
+int run_template_simulation(Design* design) {
+    const ModuleTemplate* top = &design->modules[design->top];
+    SignalValue* inputs = (SignalValue*)malloc((size_t)(top->inputs.count > 0 ? top->inputs.count : 1) * sizeof(SignalValue));
+    SignalValue* outputs = (SignalValue*)malloc((size_t)(top->outputs.count > 0 ? top->outputs.count : 1) * sizeof(SignalValue));
+    if (!inputs || !outputs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(inputs);
+        free(outputs);
+        return 1;
+    }
+
+    printf("## Enter Primary Input Values (0 or 1):\n");
+    for (int i = 0; i < top->inputs.count; i++) {
+        inputs[i] = get_user_input(string_pool_get(top->nets, top->inputs.ids[i]));
     }
     printf("\n");
+
+    int status = 0;
+    printf("## Simulating Design From Templates\n");
+    if (!evaluate_design(design, inputs, outputs)) {
+        fprintf(stderr, "Error: A module has a combinational loop; run without --hierarchical to simulate the flattened circuit\n");
+        status = 1;
+    } else {
+        printf("Evaluated %lld module instances from %d templates.\n\n",
+               design->flat_instance_count + 1, design->module_count);
+        printf("## Primary Output Values:\n");
+        for (int i = 0; i < top->outputs.count; i++) {
+            printf("  %s: %c\n", string_pool_get(top->nets, top->outputs.ids[i]), signal_value_to_char(outputs[i]));
+        }
+    }
+
+    free(inputs);
+    free(outputs);
+    return status;
+}
+
+// Resolves a comma-separated list of node names of any length; returns the
+// number found, or -1 if the list cannot be copied
+int parse_target_list(Circuit* circuit, const char* list, int* target_ids, int max_targets) {
+    size_t length = strlen(list);
+    char* buffer = (char*)malloc(length + 1);
+    if (!buffer) {
+        fprintf(stderr, "Error: Out of memory reading the target list\n");
+        return -1;
+    }
+    memcpy(buffer, list, length + 1);
+
+    int count = 0;
+    char *saveptr;
+    char *name = strtok_r(buffer, ", \t", &saveptr);
+    while (name && count < max_targets) {
+        int node_id = find_node_by_name(circuit, name);
+        if (node_id == -1) {
+            fprintf(stderr, "Warning: Target node %s not found, ignoring\n", name);
+        } else {
+            target_ids[count++] = node_id;
+        }
+        name = strtok_r(NULL, ", \t", &saveptr);
+    }
+    free(buffer);
+    return count;
 }
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <verilog_file>\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
     const char *filename = argv[1];
+    const char *target_list = NULL;
+    int partition_count = 0;
+    bool cop_mode = false;
+    int cop_sample_words = 0;
+    int requested_engine = ENGINE_AUTO;
+    bool tune = false;
+    int parse_threads = 0;      // 0: decide from the file size
+    bool evaluate_templates = false;
+    bool use_netlist_cache = true;
+    const char *write_file = NULL;
+    bool threads_set = false;
+    bool batch_size_set = false;
+    double cross_check_rate = 0.0;
+    const char *output_file = NULL;
+    PipelineOptions batch_options;
+    init_pipeline_options(&batch_options);
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--targets") == 0 && i + 1 < argc) {
+            target_list = argv[++i];
+        } else if (strcmp(argv[i], "--partitions") == 0 && i + 1 < argc) {
+            partition_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cop") == 0) {
+            cop_mode = true;
+        } else if (strcmp(argv[i], "--cop-samples") == 0 && i + 1 < argc) {
+            cop_mode = true;
+            cop_sample_words = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            requested_engine = parse_engine_name(argv[++i]);
+            if (requested_engine < 0) {
+                fprintf(stderr, "Error: Unknown engine %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cross-check") == 0 && i + 1 < argc) {
+            cross_check_rate = atof(argv[++i]);
+            batch_options.cross_check_rate = cross_check_rate;
+        } else if (strcmp(argv[i], "--tune") == 0) {
+            tune = true;
+        } else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) {
+            parse_threads = atoi(argv[++i]);
+            if (parse_threads < 1) parse_threads = 1;
+        } else if (strcmp(argv[i], "--hierarchical") == 0) {
+            evaluate_templates = true;
+        } else if (strcmp(argv[i], "--no-netlist-cache") == 0) {
+            use_netlist_cache = false;
+        } else if (strcmp(argv[i], "--write-netlist") == 0 && i + 1 < argc) {
+            write_file = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_report = true;
+        } else if (strcmp(argv[i], "--stats-json") == 0 && i + 1 < argc) {
+            stats_json_file = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (strcmp(argv[i], "--vectors") == 0 && i + 1 < argc) {
+            batch_options.vector_file = argv[++i];
+        } else if (strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            batch_options.random_count = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            batch_options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            batch_options.worker_count = atoi(argv[++i]);
+            threads_set = true;
+        } else if (strcmp(argv[i], "--batch-size") == 0 && i + 1 < argc) {
+            batch_options.batch_size = atoi(argv[++i]);
+            batch_size_set = true;
+        } else if (strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc) {
+            batch_options.cache_budget = (size_t)(atof(argv[++i]) * 1024.0 * 1024.0);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     
-    printf("=== ISCAS Circuit Simulator ===\n");
-    printf("Parsing Verilog file: %s\n\n", filename);
+    if (trace_file) start_trace("circuit_simulator");
+    if (stats_report || stats_json_file || trace_file) atexit(report_stats);
+    // Hardware counters must be open before any thread starts to count it
+    if (stats_report || stats_json_file) sim_stats_enable_hw_counters();
 
-    // 1. Parse the Verilog file
-    if (parse_verilog_module(filename) != 0) {
-        fprintf(stderr, "Error: Failed to parse Verilog file\n");
-        return 1;
+    // Batch runs keep stdout for the responses
+    bool batch_mode = (batch_options.vector_file != NULL || batch_options.random_count > 0);
+
+    NetlistFormat format = detect_netlist_format(filename);
+    const char* format_name = (format == NETLIST_BENCH) ? "bench" : "Verilog";
+    if (!batch_mode) {
+        printf("=== ISCAS Circuit Simulator ===\n");
+        printf("Parsing %s file: %s\n\n", format_name, filename);
     }
 
-    printf("## Parsed Verilog Structure\n");
-    printf("Module: %s\n", module_name);
-    printf("Inputs: %d, Outputs: %d, Wires: %d, Gates: %d\n\n",
-           input_count, output_count, wire_count, parsed_gate_count);
+    // 1-2. Parse the netlist straight into the circuit (large Verilog files on all CPUs)
+    sim_stats_phase_begin(PHASE_PARSE);
+    if (parse_threads == 0) {
+        struct stat info;
+        parse_threads = (stat(filename, &info) == 0 && info.st_size >= PARALLEL_PARSE_MIN_BYTES) ? -1 : 1;
+    }
+    // A compiled netlist saved by an earlier run skips parsing and levelizing
+    // (templates are not cached, so --hierarchical always parses)
+    uint64_t source_hash = (use_netlist_cache && !evaluate_templates) ? hash_netlist_source(filename) : 0;
+    NetlistSummary summary;
+    Levelization* levels = NULL;
+    Circuit* circuit = source_hash ? load_netlist_cache(filename, source_hash, &summary, &levels) : NULL;
+    if (circuit) {
+        if (!batch_mode) {
+            char cache_path[1024];
+            netlist_cache_path(filename, cache_path, sizeof(cache_path));
+            printf("Loaded compiled netlist %s (source unchanged)\n\n", cache_path);
+        }
+    } else if (format == NETLIST_BENCH) {
+        circuit = build_circuit_from_bench_file(filename, !batch_mode, &summary);
+    } else if (parse_threads == 1) {
+        circuit = build_circuit_from_file(filename, !batch_mode, &summary);
+    } else {
+        circuit = build_circuit_from_file_parallel(filename, parse_threads, !batch_mode, &summary);
+    }
 
-    // 2. Build circuit from parsed data
-    Circuit* circuit = build_circuit_from_parsed_data();
-    if (!circuit) {
-        fprintf(stderr, "Error: Failed to build circuit\n");
+    // Several modules or module instances: one template per module, flattened
+    // below unless the design is evaluated from the templates
+    Design* design = NULL;
+    if (!circuit && summary.hierarchical) {
+        if (!batch_mode) printf("Several modules or module instances found, loading the design hierarchically.\n\n");
+        design = load_design(filename);
+        if (design) summarize_design(design, &summary);
+    }
+    sim_stats_phase_end(PHASE_PARSE);
+    if (!circuit && !design) {
+        fprintf(stderr, "Error: Failed to build circuit from %s\n", filename);
         return 1;
     }
 
+    if (!batch_mode) {
+        printf("## Parsed %s Structure\n", format_name);
+        printf("Module: %s\n", summary.module_name);
+        printf("Inputs: %d, Outputs: %d, Wires: %d, Gates: %d\n\n",
+               summary.input_count, summary.output_count, summary.wire_count, summary.gate_count);
+        if (design) print_design_hierarchy(design);
+    }
+
+    if (evaluate_templates && (!design || batch_mode)) {
+        fprintf(stderr, "Warning: --hierarchical applies to interactive runs of multi-module designs, ignored\n");
+    }
+    if (design) {
+        if (evaluate_templates && !batch_mode) {
+            int status = run_template_simulation(design);
+            destroy_design(design);
+            return status;
+        }
+        sim_stats_phase_begin(PHASE_PARSE);
+        circuit = flatten_design(design);
+        destroy_design(design);
+        sim_stats_phase_end(PHASE_PARSE);
+        if (!circuit) return 1;
+    }
+
+    if (write_file) {
+        size_t length = strlen(write_file);
+        NetlistFormat write_format = (length > 6 && strcmp(write_file + length - 6, ".bench") == 0) ? NETLIST_BENCH : NETLIST_VERILOG;
+        sim_stats_phase_begin(PHASE_WRITE);
+        int status = write_netlist(circuit, summary.module_name, write_file, write_format);
+        sim_stats_phase_end(PHASE_WRITE);
+        if (status == 0 && !batch_mode) {
+            printf("Wrote %s netlist %s\n", write_format == NETLIST_BENCH ? "bench" : "Verilog", write_file);
+        }
+        destroy_levelization(levels);
+        destroy_circuit(circuit);
+        return status;
+    }
+
+    if (!levels) {
+        sim_stats_phase_begin(PHASE_LEVELIZE);
+        levels = levelize_circuit(circuit);
+        sim_stats_phase_end(PHASE_LEVELIZE);
+        if (!levels) {
+            fprintf(stderr, "Error: Out of memory levelizing circuit\n");
+            destroy_circuit(circuit);
+            return 1;
+        }
+        if (source_hash) {
+            sim_stats_phase_begin(PHASE_WRITE);
+            save_netlist_cache(filename, source_hash, circuit, &summary, levels);
+            sim_stats_phase_end(PHASE_WRITE);
+        }
+    }
+
+    CircuitProfile profile;
+    EngineConfig engine_config;
+    sim_stats_phase_begin(PHASE_ENGINE);
+    choose_engine(circuit, levels, filename, source_hash, tune, true, !batch_mode, &profile, &engine_config);
+    sim_stats_phase_end(PHASE_ENGINE);
+    if (requested_engine != ENGINE_AUTO) engine_config.engine = (SimEngine)requested_engine;
+    // --partitions K overrides the selected engine
+    if (partition_count > 0) {
+        engine_config.engine = ENGINE_PARTITIONED;
+        engine_config.partitions = partition_count;
+    }
+    // Decided here for both flows, so the reported engine is the one that runs
+    if (engine_config.engine != ENGINE_ITERATIVE && engine_config.engine != ENGINE_SCC && !levels->is_acyclic) {
+        fprintf(stderr, "Warning: Circuit has combinational loops, using the SCC engine\n");
+        engine_config.engine = ENGINE_SCC;
+    }
+
+    if (batch_mode) {
+        if (!threads_set) batch_options.worker_count = engine_config.threads;
+        if (!batch_size_set) batch_options.batch_size = engine_config.batch_size;
+        batch_options.engine = &engine_config;
+        print_engine_selection(stderr, &profile, &engine_config);
+
+        sim_stats_phase_begin(PHASE_SIMULATE);
+        int status = run_batch(circuit, levels, &batch_options, output_file);
+        sim_stats_phase_end(PHASE_SIMULATE);
+        destroy_levelization(levels);
+        destroy_circuit(circuit);
+        return status;
+    }
+
     // 3. Display circuit information
     print_circuit_info(circuit);
     
@@ -153,13 +509,110 @@ int main(int argc, char *argv[]) {
         print_connections(circuit);
     }
 
+    if (cop_mode) {
+        // Signal probabilities need no input vector
+        int status = run_signal_probability(circuit, cop_sample_words);
+        destroy_levelization(levels);
+        destroy_circuit(circuit);
+        return status;
+    }
+
+    print_engine_selection(stdout, &profile, &engine_config);
+
     // 5. Interactive simulation
-    SignalValue input_values[MAX_SIGNALS];
+    SignalValue* input_values = (SignalValue*)malloc((size_t)(circuit->pi_count > 0 ? circuit->pi_count : 1) * sizeof(SignalValue));
+    if (!input_values) {
+        fprintf(stderr, "Error: Out of memory\n");
+        destroy_levelization(levels);
+        destroy_circuit(circuit);
+        return 1;
+    }
+    int status = 0;
     get_user_inputs(circuit, input_values);
     
     // Set inputs and simulate
     set_primary_inputs(circuit, input_values);
     
+    if (target_list) {
+        // Demand-driven mode: evaluate only the fanin cones of the targets
+        int* target_ids = (int*)malloc((size_t)circuit->node_count * sizeof(int));
+        int target_count = target_ids ? parse_target_list(circuit, target_list, target_ids, circuit->node_count) : 0;
+
+        DemandEvaluator* evaluator = (target_ids && target_count >= 0) ? create_demand_evaluator(circuit) : NULL;
+        if (!evaluator) {
+            if (target_count >= 0) fprintf(stderr, "Error: Failed to create demand evaluator\n");
+            free(target_ids);
+            free(input_values);
+            destroy_levelization(levels);
+            destroy_circuit(circuit);
+            return 1;
+        }
+
+        printf("## Demand-Driven Evaluation\n");
+        sim_stats_phase_begin(PHASE_SIMULATE);
+        demand_begin_vector(evaluator);
+        for (int i = 0; i < target_count; i++) {
+            SignalValue value = demand_evaluate(evaluator, target_ids[i]);
+            printf("  %s: %c\n", circuit->nodes[target_ids[i]].name, signal_value_to_char(value));
+        }
+        sim_stats_phase_end(PHASE_SIMULATE);
+        printf("Evaluated %ld of %d nodes (%ld fanins skipped by controlling values).\n",
+               evaluator->nodes_evaluated, circuit->node_count, evaluator->inputs_skipped);
+
+        destroy_demand_evaluator(evaluator);
+        free(target_ids);
+        free(input_values);
+        destroy_levelization(levels);
+        destroy_circuit(circuit);
+        return 0;
+    }
+
+    ConePartitioning* partitioning = NULL;     // Kept for the cross-check
+    sim_stats_phase_begin(PHASE_SIMULATE);
+    if (engine_config.engine == ENGINE_SCC) {
+        SccDecomposition* scc = compute_sccs(circuit);
+        if (scc) {
+            print_scc_report(circuit, scc);
+            SccSimStats scc_stats;
+            printf("## Simulating Circuit\n");
+            if (simulate_scc(circuit, scc, &scc_stats)) {
+                printf("Circuit simulation completed successfully.\n");
+            } else {
+                printf("Warning: %d loop%s oscillated; %d toggling nodes set to X.\n",
+                       scc_stats.oscillating_components, scc_stats.oscillating_components == 1 ? "" : "s",
+                       scc_stats.oscillating_nodes);
+            }
+            printf("Evaluated %d components, %d sweeps inside loops.\n\n", scc->component_count, scc_stats.sweeps);
+            destroy_scc_decomposition(scc);
+            goto report;
+        }
+        engine_config.engine = ENGINE_ITERATIVE;
+    }
+
+    if (engine_config.engine == ENGINE_PARTITIONED) {
+        // Per-output cone partitions simulated on separate threads
+        int partitions = engine_config.partitions > 0 ? engine_config.partitions : 1;
+        partitioning = partition_output_cones(circuit, levels, partitions);
+        if (partitioning) {
+            print_cone_partitioning(circuit, partitioning);
+            printf("## Simulating %d Partitions in Parallel\n", partitioning->partition_count);
+            if (!simulate_partitions_parallel(circuit, partitioning)) {
+                printf("Warning: Could not start all partition threads, ran them sequentially.\n");
+            }
+            printf("Circuit simulation completed successfully.\n\n");
+            goto report;
+        }
+        engine_config.engine = ENGINE_LEVELIZED;
+    }
+
+    if (engine_config.engine == ENGINE_LEVELIZED) {
+        printf("## Simulating Circuit\n");
+        simulate_levelized(circuit, levels);
+        printf("Circuit simulation completed successfully.\n");
+        printf("Evaluated %d levels in a single pass.\n\n", levels->max_level + 1);
+        goto report;
+    }
+
     printf("## Simulating Circuit\n");
     if (simulate_circuit(circuit)) {
         printf("Circuit simulation completed successfully.\n");
@@ -168,6 +621,15 @@ int main(int argc, char *argv[]) {
         printf("Warning: Circuit did not stabilize within maximum iterations.\n\n");
     }
     
+report:
+    sim_stats_phase_end(PHASE_SIMULATE);
+    // Partitions skip logic that reaches no output, so only their cones are compared
+    if (cross_check_rate > 0.0 &&
+        !run_cross_check(circuit, levels, input_values, partitioning ? partitioning->covered : NULL)) {
+        status = 1;
+    }
+    destroy_cone_partitioning(partitioning);
+
     // 6. Display results
     print_node_values(circuit);
     
@@ -179,6 +641,8 @@ int main(int argc, char *argv[]) {
     }
 
     // Cleanup
+    free(input_values);
+    destroy_levelization(levels);
     destroy_circuit(circuit);
-    return 0;
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,822 @@
+// Synthetic netlist generator for scaling benchmarks.
+//
+// Usage: netgen <kind> <size> [options]
+//
+//   random      Layered random DAG with <size> gates
+//   multiplier  <size> x <size> carry-save array multiplier (c6288 style)
+//   adder       <size>-bit adder, ripple-carry or Kogge-Stone prefix
+//   parity      XOR tree over <size> inputs
+//   ecc         Hamming single-error corrector for <size> data bits (c499 style)
+//
+// The same arguments and seed always produce the same file, so benchmark
+// circuits from 10^3 to 10^7 gates can be regenerated rather than stored.
+// Gates are written in topological order as gate-level Verilog, or as .bench
+// when the output file ends in .bench, through the netlist writer's output
+// buffer (netlist_writer.h). XOR and XNOR gates have two inputs, the only
+// arity the simulator evaluates for them.
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "netlist_writer.h"
+#include "splitmix.h"
+
+#define MAX_PORT_GROUPS 4
+#define MAX_COMMAND_LINE 512
+#define PICK_ATTEMPTS 8                     // Random re-picks before settling for a worse input
+
+typedef enum {
+    KIND_AND, KIND_NAND, KIND_OR, KIND_NOR, KIND_XOR, KIND_XNOR, KIND_NOT, KIND_BUF,
+    KIND_COUNT
+} GateKind;
+
+static const char* const verilog_keywords[KIND_COUNT] = { "and", "nand", "or", "nor", "xor", "xnor", "not", "buf" };
+static const char* const bench_keywords[KIND_COUNT] = { "AND", "NAND", "OR", "NOR", "XOR", "XNOR", "NOT", "BUFF" };
+
+// Ports are named <prefix><index>, or just <prefix> in a group of one
+typedef struct {
+    const char* prefix;
+    int count;
+} PortGroup;
+
+// Signals 0..input_count-1 are the inputs; gate g drives signal input_count + g.
+// Gates only read signals that exist when they are added, so the gate order is
+// topological.
+typedef struct {
+    PortGroup input_groups[MAX_PORT_GROUPS];
+    int input_group_count;
+    int input_count;
+
+    uint8_t* kinds;             // GateKind of each gate
+    size_t* first_fanin;        // Gate g reads fanins[first_fanin[g] .. first_fanin[g + 1])
+    int gate_count;
+    size_t gate_capacity;
+    int* fanins;
+    size_t fanin_count;
+    size_t fanin_capacity;
+
+    PortGroup output_groups[MAX_PORT_GROUPS];
+    int output_group_count;
+    int* outputs;               // Output port i is driven by gate signal outputs[i]
+    int output_count;
+    size_t output_capacity;
+} Netlist;
+
+typedef struct {
+    const char* kind;
+    int size;
+    const char* output_path;    // NULL: stdout
+    const char* module_name;
+    bool bench;
+    uint64_t seed;
+
+    // random
+    int depth;
+    int input_count;            // 0: one level's worth of gates
+    int min_fanin;
+    int max_fanin;
+    double locality;            // Chance that an input comes from the level right below
+    double skew;                // Chance that an input copies an existing connection
+    int max_fanout;             // Soft cap on random picks, 0 = none
+    unsigned weights[KIND_COUNT];
+
+    // adder
+    bool prefix_adder;
+} Options;
+
+// --- Netlist construction ---
+
+static void* checked_realloc(void* pointer, size_t bytes) {
+    void* grown = realloc(pointer, bytes ? bytes : 1);
+    if (!grown) {
+        fprintf(stderr, "Error: Out of memory generating netlist\n");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+static double random_unit(uint64_t* state) {
+    return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void init_netlist(Netlist* net) {
+    memset(net, 0, sizeof(*net));
+    net->first_fanin = (size_t*)checked_realloc(NULL, sizeof(size_t));
+    net->first_fanin[0] = 0;
+}
+
+static void free_netlist(Netlist* net) {
+    free(net->kinds);
+    free(net->first_fanin);
+    free(net->fanins);
+    free(net->outputs);
+}
+
+// Adds a group of inputs; returns the signal of the first
+static int add_inputs(Netlist* net, const char* prefix, int count) {
+    int first = net->input_count;
+    net->input_groups[net->input_group_count++] = (PortGroup){ prefix, count };
+    net->input_count += count;
+    return first;
+}
+
+static int add_gate(Netlist* net, GateKind kind, const int* inputs, int count) {
+    if (net->gate_count >= INT_MAX - net->input_count) {
+        fprintf(stderr, "Error: Netlist exceeds %d signals\n", INT_MAX);
+        exit(EXIT_FAILURE);
+    }
+    if ((size_t)net->gate_count + 1 >= net->gate_capacity) {
+        net->gate_capacity = net->gate_capacity ? net->gate_capacity * 2 : 4096;
+        net->kinds = (uint8_t*)checked_realloc(net->kinds, net->gate_capacity);
+        net->first_fanin = (size_t*)checked_realloc(net->first_fanin, (net->gate_capacity + 1) * sizeof(size_t));
+    }
+    if (net->fanin_count + (size_t)count > net->fanin_capacity) {
+        net->fanin_capacity = net->fanin_capacity ? net->fanin_capacity * 2 : 16384;
+        net->fanins = (int*)checked_realloc(net->fanins, net->fanin_capacity * sizeof(int));
+    }
+    memcpy(net->fanins + net->fanin_count, inputs, (size_t)count * sizeof(int));
+    net->fanin_count += (size_t)count;
+    net->kinds[net->gate_count] = (uint8_t)kind;
+    net->first_fanin[++net->gate_count] = net->fanin_count;
+    return net->input_count + net->gate_count - 1;
+}
+
+static int add_gate2(Netlist* net, GateKind kind, int a, int b) {
+    int inputs[2] = { a, b };
+    return add_gate(net, kind, inputs, 2);
+}
+
+static void begin_outputs(Netlist* net, const char* prefix) {
+    net->output_groups[net->output_group_count++] = (PortGroup){ prefix, 0 };
+}
+
+// Outputs are named after their port, so each must be a gate driving no other port
+static void add_output(Netlist* net, int signal) {
+    if (signal < net->input_count) signal = add_gate(net, KIND_BUF, &signal, 1);
+    if ((size_t)net->output_count == net->output_capacity) {
+        net->output_capacity = net->output_capacity ? net->output_capacity * 2 : 256;
+        net->outputs = (int*)checked_realloc(net->outputs, net->output_capacity * sizeof(int));
+    }
+    net->outputs[net->output_count++] = signal;
+    net->output_groups[net->output_group_count - 1].count++;
+}
+
+// Sum of up to three bits of equal weight (-1 = absent). The carry (-1 if
+// none) is only built when carry is non-NULL.
+static int add_bits(Netlist* net, int x, int y, int z, int* carry) {
+    int bits[3];
+    int count = 0;
+    if (x >= 0) bits[count++] = x;
+    if (y >= 0) bits[count++] = y;
+    if (z >= 0) bits[count++] = z;
+    if (carry) *carry = -1;
+    if (count < 2) return count ? bits[0] : -1;
+
+    int half_sum = add_gate2(net, KIND_XOR, bits[0], bits[1]);
+    if (count == 2) {
+        if (carry) *carry = add_gate2(net, KIND_AND, bits[0], bits[1]);
+        return half_sum;
+    }
+    if (carry) {
+        int both = add_gate2(net, KIND_AND, bits[0], bits[1]);
+        *carry = add_gate2(net, KIND_OR, both, add_gate2(net, KIND_AND, half_sum, bits[2]));
+    }
+    return add_gate2(net, KIND_XOR, half_sum, bits[2]);
+}
+
+// Combines signals into one balanced tree of gates at most fanin wide (signals is overwritten)
+static int reduce_tree(Netlist* net, GateKind kind, int* signals, int count, int fanin) {
+    while (count > 1) {
+        int reduced = 0;
+        for (int i = 0; i < count; i += fanin) {
+            int width = (count - i < fanin) ? count - i : fanin;
+            signals[reduced++] = (width == 1) ? signals[i] : add_gate(net, kind, signals + i, width);
+        }
+        count = reduced;
+    }
+    return signals[0];
+}
+
+// --- Structured generators ---
+
+// Rows of AND partial products summed by a carry-save array of full adders,
+// then a ripple-carry adder for the upper half of the product
+static void generate_multiplier(Netlist* net, int n) {
+    int a = add_inputs(net, "a", n);
+    int b = add_inputs(net, "b", n);
+    int* sum = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));      // Weight row + j
+    int* carry = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));    // Weight row + j (from the row above)
+
+    begin_outputs(net, "p");
+    for (int j = 0; j < n; j++) {
+        sum[j] = add_gate2(net, KIND_AND, a + j, b);
+        carry[j] = -1;
+    }
+    add_output(net, sum[0]);
+    for (int row = 1; row < n; row++) {
+        for (int j = 0; j < n; j++) {
+            int product = add_gate2(net, KIND_AND, a + j, b + row);
+            sum[j] = add_bits(net, product, (j + 1 < n) ? sum[j + 1] : -1, carry[j], &carry[j]);
+        }
+        add_output(net, sum[0]);
+    }
+
+    int ripple = -1;
+    for (int k = 0; k < n; k++) {
+        // The top bit's carry is always 0
+        int bit = add_bits(net, (k + 1 < n) ? sum[k + 1] : -1, carry[k], ripple, (k + 1 < n) ? &ripple : NULL);
+        add_output(net, bit);
+    }
+    free(sum);
+    free(carry);
+}
+
+static void generate_ripple_adder(Netlist* net, int n) {
+    int a = add_inputs(net, "a", n);
+    int b = add_inputs(net, "b", n);
+    int carry = add_inputs(net, "cin", 1);
+
+    begin_outputs(net, "s");
+    for (int i = 0; i < n; i++) {
+        int carry_out;
+        add_output(net, add_bits(net, a + i, b + i, carry, &carry_out));
+        carry = carry_out;
+    }
+    begin_outputs(net, "cout");
+    add_output(net, carry);
+}
+
+// Kogge-Stone: log2(n) levels of (generate, propagate) prefix combining
+static void generate_prefix_adder(Netlist* net, int n) {
+    int a = add_inputs(net, "a", n);
+    int b = add_inputs(net, "b", n);
+    int carry_in = add_inputs(net, "cin", 1);
+    int* half_sum = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));
+    int* generate = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));     // Carry out of bit i
+    int* propagate = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));
+
+    for (int i = 0; i < n; i++) {
+        half_sum[i] = propagate[i] = add_gate2(net, KIND_XOR, a + i, b + i);
+        generate[i] = add_gate2(net, KIND_AND, a + i, b + i);
+    }
+    generate[0] = add_gate2(net, KIND_OR, generate[0], add_gate2(net, KIND_AND, propagate[0], carry_in));
+    for (int distance = 1; distance < n; distance *= 2) {
+        // Downwards, so generate[i - distance] still holds the previous level
+        for (int i = n - 1; i >= distance; i--) {
+            int carried = add_gate2(net, KIND_AND, propagate[i], generate[i - distance]);
+            generate[i] = add_gate2(net, KIND_OR, generate[i], carried);
+            // The next level only reads propagate[i] for i >= 2 * distance
+            if (i >= 2 * distance) propagate[i] = add_gate2(net, KIND_AND, propagate[i], propagate[i - distance]);
+        }
+    }
+
+    begin_outputs(net, "s");
+    for (int i = 0; i < n; i++) {
+        add_output(net, add_gate2(net, KIND_XOR, half_sum[i], (i == 0) ? carry_in : generate[i - 1]));
+    }
+    begin_outputs(net, "cout");
+    add_output(net, generate[n - 1]);
+    free(half_sum);
+    free(generate);
+    free(propagate);
+}
+
+static void generate_parity(Netlist* net, int n) {
+    int first = add_inputs(net, "d", n);
+    int* signals = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));
+    for (int i = 0; i < n; i++) signals[i] = first + i;
+    begin_outputs(net, "parity");
+    add_output(net, reduce_tree(net, KIND_XOR, signals, n, 2));
+    free(signals);
+}
+
+// Syndrome bit k is the XOR of check bit k and the data bits whose Hamming
+// position has bit k set; each data bit is flipped when the syndrome equals
+// its position.
+static void generate_ecc(Netlist* net, int n) {
+    int check_bits = 0;
+    while ((1LL << check_bits) < (long long)n + check_bits + 1) check_bits++;
+    int data = add_inputs(net, "d", n);
+    int check = add_inputs(net, "c", check_bits);
+
+    // Data bits take the positions that are not powers of two
+    int* position = (int*)checked_realloc(NULL, (size_t)n * sizeof(int));
+    for (int i = 0, p = 3; i < n; p++) {
+        if (p & (p - 1)) position[i++] = p;
+    }
+
+    int* members = (int*)checked_realloc(NULL, ((size_t)n + 1) * sizeof(int));
+    int syndrome[32];
+    int inverted[32];
+    for (int k = 0; k < check_bits; k++) {
+        int count = 0;
+        members[count++] = check + k;
+        for (int i = 0; i < n; i++) {
+            if ((position[i] >> k) & 1) members[count++] = data + i;
+        }
+        syndrome[k] = reduce_tree(net, KIND_XOR, members, count, 2);
+        inverted[k] = add_gate(net, KIND_NOT, &syndrome[k], 1);
+    }
+
+    begin_outputs(net, "o");
+    int terms[32];
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < check_bits; k++) terms[k] = ((position[i] >> k) & 1) ? syndrome[k] : inverted[k];
+        int flip = reduce_tree(net, KIND_AND, terms, check_bits, MAX_GATE_INPUTS);
+        add_output(net, add_gate2(net, KIND_XOR, data + i, flip));
+    }
+    free(position);
+    free(members);
+}
+
+// --- Random layered DAG ---
+
+static int greatest_common_divisor(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return (int)a;
+}
+
+typedef struct {
+    Netlist* net;
+    const Options* options;
+    uint64_t* rng;
+    int* level_start;           // First signal of each level; level 0 holds the inputs
+    uint32_t* fanout;
+} RandomBuilder;
+
+static int random_signal_in_level(RandomBuilder* builder, int level) {
+    int size = builder->level_start[level + 1] - builder->level_start[level];
+    return builder->level_start[level] + (int)(next_random(builder->rng) % (uint64_t)size);
+}
+
+// An extra gate input: an existing connection's driver (preferential
+// attachment, for heavy-tailed fanout) or a signal a geometric number of levels down
+static int pick_input(RandomBuilder* builder, int level) {
+    const Options* options = builder->options;
+    for (int attempt = 0;; attempt++) {
+        int signal;
+        if (builder->net->fanin_count > 0 && random_unit(builder->rng) < options->skew) {
+            signal = builder->net->fanins[next_random(builder->rng) % builder->net->fanin_count];
+        } else {
+            int source = level - 1;
+            while (source > 0 && random_unit(builder->rng) >= options->locality) source--;
+            signal = random_signal_in_level(builder, source);
+        }
+        if (options->max_fanout == 0 || builder->fanout[signal] < (uint32_t)options->max_fanout ||
+            attempt + 1 == PICK_ATTEMPTS) {
+            return signal;
+        }
+    }
+}
+
+static bool contains(const int* signals, int count, int signal) {
+    for (int i = 0; i < count; i++) {
+        if (signals[i] == signal) return true;
+    }
+    return false;
+}
+
+static GateKind pick_kind(const Options* options, uint64_t* rng) {
+    unsigned total = 0;
+    for (int k = 0; k < KIND_COUNT; k++) total += options->weights[k];
+    unsigned pick = (unsigned)(next_random(rng) % total);
+    int kind = 0;
+    while (pick >= options->weights[kind]) pick -= options->weights[kind++];
+    return (GateKind)kind;
+}
+
+// Gates are spread evenly over depth levels. Each gate's first input comes
+// from the level below, walked in a random stride so that every signal there
+// is used before any is used twice; this fixes the gate's level. Outputs are
+// the gates nothing reads.
+static void generate_random(Netlist* net, const Options* options, uint64_t* rng) {
+    int gate_count = options->size;
+    int depth = (options->depth < gate_count) ? options->depth : gate_count;
+    int input_count = options->input_count > 0 ? options->input_count : gate_count / depth;
+    if (input_count < 2) input_count = 2;
+    add_inputs(net, "x", input_count);
+
+    RandomBuilder builder = { net, options, rng, NULL, NULL };
+    builder.level_start = (int*)checked_realloc(NULL, ((size_t)depth + 2) * sizeof(int));
+    builder.level_start[0] = 0;
+    builder.level_start[1] = input_count;
+    for (int level = 1; level <= depth; level++) {
+        int width = gate_count / depth + ((level - 1) < gate_count % depth ? 1 : 0);
+        builder.level_start[level + 1] = builder.level_start[level] + width;
+    }
+    builder.fanout = (uint32_t*)checked_realloc(NULL, ((size_t)input_count + (size_t)gate_count) * sizeof(uint32_t));
+    memset(builder.fanout, 0, ((size_t)input_count + (size_t)gate_count) * sizeof(uint32_t));
+    int* inputs = (int*)checked_realloc(NULL, (size_t)options->max_fanin * sizeof(int));
+
+    for (int level = 1; level <= depth; level++) {
+        int below = builder.level_start[level - 1];
+        uint64_t below_size = (uint64_t)(builder.level_start[level] - below);
+        uint64_t stride;
+        do {
+            stride = 1 + next_random(rng) % below_size;
+        } while (greatest_common_divisor(stride, below_size) != 1);
+        uint64_t cursor = next_random(rng) % below_size;
+
+        for (int s = builder.level_start[level]; s < builder.level_start[level + 1]; s++) {
+            GateKind kind = pick_kind(options, rng);
+            int count = 2;
+            if (kind == KIND_NOT || kind == KIND_BUF) {
+                count = 1;
+            } else if (kind != KIND_XOR && kind != KIND_XNOR) {
+                count = options->min_fanin + (int)(next_random(rng) % (uint64_t)(options->max_fanin - options->min_fanin + 1));
+            }
+
+            inputs[0] = below + (int)cursor;
+            cursor = (cursor + stride) % below_size;
+            for (int k = 1; k < count; k++) {
+                int signal = pick_input(&builder, level);
+                for (int attempt = 1; contains(inputs, k, signal) && attempt < PICK_ATTEMPTS; attempt++) {
+                    signal = pick_input(&builder, level);
+                }
+                // Small or heavily reused levels: take the lowest signal not yet
+                // connected, or make do with fewer inputs
+                if (contains(inputs, k, signal)) {
+                    signal = 0;
+                    while (signal < s && contains(inputs, k, signal)) signal++;
+                    if (signal == s) {
+                        count = k;
+                        break;
+                    }
+                }
+                inputs[k] = signal;
+            }
+            for (int k = 0; k < count; k++) builder.fanout[inputs[k]]++;
+            add_gate(net, kind, inputs, count);
+        }
+    }
+
+    begin_outputs(net, "y");
+    for (int g = 0; g < gate_count; g++) {
+        if (builder.fanout[input_count + g] == 0) add_output(net, input_count + g);
+    }
+    free(inputs);
+    free(builder.level_start);
+    free(builder.fanout);
+}
+
+// --- Output ---
+
+static void emit_number(NetlistOutput* out, unsigned value) {
+    char digits[16];
+    int length = 0;
+    do {
+        digits[sizeof(digits) - 1 - length++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    emit(out, digits + sizeof(digits) - length, (size_t)length);
+}
+
+static void emit_port_name(NetlistOutput* out, const PortGroup* groups, int group_count, int index) {
+    for (int g = 0; g < group_count; g++) {
+        if (index < groups[g].count) {
+            emit_text(out, groups[g].prefix);
+            if (groups[g].count > 1) emit_number(out, (unsigned)index);
+            return;
+        }
+        index -= groups[g].count;
+    }
+}
+
+typedef struct {
+    const Netlist* net;
+    NetlistOutput* out;
+    int* port_of_gate;          // Output port a gate drives, -1 for internal gates
+} NetlistWriter;
+
+static void emit_signal_name(NetlistWriter* writer, int signal) {
+    const Netlist* net = writer->net;
+    if (signal < net->input_count) {
+        emit_port_name(writer->out, net->input_groups, net->input_group_count, signal);
+    } else if (writer->port_of_gate[signal - net->input_count] >= 0) {
+        emit_port_name(writer->out, net->output_groups, net->output_group_count,
+                       writer->port_of_gate[signal - net->input_count]);
+    } else {
+        emit_text(writer->out, "n");
+        emit_number(writer->out, (unsigned)(signal - net->input_count));
+    }
+}
+
+// Writes "<prefix>a, b, c,\n    d, e<suffix>" with NAMES_PER_LINE names per line
+static void emit_signal_list(NetlistWriter* writer, const char* prefix, int first, int count,
+                             const int* signals, const char* suffix) {
+    emit_text(writer->out, prefix);
+    for (int i = 0; i < count; i++) {
+        if (i > 0) emit_text(writer->out, (i % NAMES_PER_LINE) == 0 ? ",\n    " : ", ");
+        emit_signal_name(writer, signals ? signals[i] : first + i);
+    }
+    emit_text(writer->out, suffix);
+}
+
+static void write_verilog(NetlistWriter* writer, const char* module_name) {
+    const Netlist* net = writer->net;
+    NetlistOutput* out = writer->out;
+
+    emit_text(out, "module ");
+    emit_text(out, module_name);
+    emit_text(out, " (");
+    emit_signal_list(writer, "", 0, net->input_count, NULL, ",\n    ");
+    emit_signal_list(writer, "", 0, net->output_count, net->outputs, ");\n\n");
+    emit_signal_list(writer, "  input ", 0, net->input_count, NULL, ";\n");
+    emit_signal_list(writer, "  output ", 0, net->output_count, net->outputs, ";\n");
+
+    int wire_count = 0;
+    for (int g = 0; g < net->gate_count && !out->failed; g++) {
+        if (writer->port_of_gate[g] >= 0) continue;
+        emit_text(out, (wire_count % NAMES_PER_LINE) == 0 ? (wire_count == 0 ? "  wire " : ",\n    ") : ", ");
+        emit_signal_name(writer, net->input_count + g);
+        wire_count++;
+    }
+    emit_text(out, wire_count > 0 ? ";\n\n" : "\n");
+
+    for (int g = 0; g < net->gate_count && !out->failed; g++) {
+        emit_text(out, "  ");
+        emit_text(out, verilog_keywords[net->kinds[g]]);
+        emit_text(out, " g");
+        emit_number(out, (unsigned)g);
+        emit_text(out, " (");
+        emit_signal_name(writer, net->input_count + g);
+        for (size_t f = net->first_fanin[g]; f < net->first_fanin[g + 1]; f++) {
+            emit_text(out, ", ");
+            emit_signal_name(writer, net->fanins[f]);
+        }
+        emit_text(out, ");\n");
+    }
+    emit_text(out, "\nendmodule\n");
+}
+
+static void write_bench(NetlistWriter* writer) {
+    const Netlist* net = writer->net;
+    NetlistOutput* out = writer->out;
+
+    for (int i = 0; i < net->input_count; i++) {
+        emit_text(out, "INPUT(");
+        emit_signal_name(writer, i);
+        emit_text(out, ")\n");
+    }
+    for (int i = 0; i < net->output_count; i++) {
+        emit_text(out, "OUTPUT(");
+        emit_signal_name(writer, net->outputs[i]);
+        emit_text(out, ")\n");
+    }
+    emit_text(out, "\n");
+    for (int g = 0; g < net->gate_count && !out->failed; g++) {
+        emit_signal_name(writer, net->input_count + g);
+        emit_text(out, " = ");
+        emit_text(out, bench_keywords[net->kinds[g]]);
+        emit_text(out, "(");
+        for (size_t f = net->first_fanin[g]; f < net->first_fanin[g + 1]; f++) {
+            if (f > net->first_fanin[g]) emit_text(out, ", ");
+            emit_signal_name(writer, net->fanins[f]);
+        }
+        emit_text(out, ")\n");
+    }
+}
+
+// Longest input-to-output path in gates
+static int netlist_depth(const Netlist* net) {
+    int* level = (int*)checked_realloc(NULL, ((size_t)net->gate_count + 1) * sizeof(int));
+    int depth = 0;
+    for (int g = 0; g < net->gate_count; g++) {
+        level[g] = 1;
+        for (size_t f = net->first_fanin[g]; f < net->first_fanin[g + 1]; f++) {
+            int driver = net->fanins[f] - net->input_count;
+            if (driver >= 0 && level[driver] + 1 > level[g]) level[g] = level[driver] + 1;
+        }
+        if (level[g] > depth) depth = level[g];
+    }
+    free(level);
+    return depth;
+}
+
+static int write_generated_netlist(const Netlist* net, const Options* options, const char* command_line) {
+    FILE* file = options->output_path ? fopen(options->output_path, "w") : stdout;
+    if (!file) {
+        perror("Error opening netlist output file");
+        return 1;
+    }
+
+    NetlistOutput out = { file, (char*)checked_realloc(NULL, WRITE_BUFFER_BYTES), 0, false };
+    NetlistWriter writer = { net, &out, (int*)checked_realloc(NULL, ((size_t)net->gate_count + 1) * sizeof(int)) };
+    for (int g = 0; g < net->gate_count; g++) writer.port_of_gate[g] = -1;
+    for (int i = 0; i < net->output_count; i++) writer.port_of_gate[net->outputs[i] - net->input_count] = i;
+
+    char header[MAX_COMMAND_LINE + 160];
+    snprintf(header, sizeof(header), "%s %s: %d inputs, %d outputs, %d gates (generated by: %s)\n",
+             options->bench ? "#" : "//", options->module_name, net->input_count, net->output_count,
+             net->gate_count, command_line);
+    emit_text(&out, header);
+    if (options->bench) {
+        write_bench(&writer);
+    } else {
+        write_verilog(&writer, options->module_name);
+    }
+    flush_output(&out);
+    if (fflush(file) != 0) out.failed = true;
+    if (file != stdout && fclose(file) != 0) out.failed = true;
+
+    free(out.buffer);
+    free(writer.port_of_gate);
+    if (out.failed) {
+        fprintf(stderr, "Error: Failed to write netlist %s\n", options->output_path ? options->output_path : "(stdout)");
+        if (options->output_path) remove(options->output_path);
+        return 1;
+    }
+    return 0;
+}
+
+// --- Command line ---
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s <kind> <size> [options]\n", program);
+    fprintf(stderr, "Kinds:\n");
+    fprintf(stderr, "  random                Layered random DAG with <size> gates\n");
+    fprintf(stderr, "  multiplier            <size> x <size> array multiplier (c6288 style)\n");
+    fprintf(stderr, "  adder                 <size>-bit adder\n");
+    fprintf(stderr, "  parity                XOR tree over <size> inputs\n");
+    fprintf(stderr, "  ecc                   Single-error corrector for <size> data bits (c499 style)\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --output FILE         Write to FILE (.bench if it ends in .bench) instead of stdout\n");
+    fprintf(stderr, "  --bench               Write .bench instead of Verilog\n");
+    fprintf(stderr, "  --name NAME           Module name (default: kind and size)\n");
+    fprintf(stderr, "  --seed S              Seed for random (default 1)\n");
+    fprintf(stderr, "  --depth D             random: gate levels (default 32)\n");
+    fprintf(stderr, "  --inputs N            random: primary inputs (default: gates per level)\n");
+    fprintf(stderr, "  --fanin MIN:MAX       random: inputs per AND/NAND/OR/NOR gate (default 2:3)\n");
+    fprintf(stderr, "  --locality P          random: chance an input comes from the level below (default 0.7)\n");
+    fprintf(stderr, "  --skew P              random: chance an input reuses a driven signal (default 0.1)\n");
+    fprintf(stderr, "  --max-fanout F        random: avoid signals already driving F gates (default: no limit)\n");
+    fprintf(stderr, "  --mix KIND=W,...      random: gate-type weights, kinds and..buf\n");
+    fprintf(stderr, "                        (default and=2,nand=3,or=2,nor=2,xor=1,not=1)\n");
+    fprintf(stderr, "  --style S             adder: ripple (default) or prefix (Kogge-Stone)\n");
+}
+
+static bool parse_mix(const char* text, unsigned weights[KIND_COUNT]) {
+    unsigned total = 0;
+    memset(weights, 0, KIND_COUNT * sizeof(unsigned));
+    while (*text) {
+        size_t name_length = strcspn(text, "=");
+        int kind = 0;
+        while (kind < KIND_COUNT && (strlen(verilog_keywords[kind]) != name_length ||
+                                     strncmp(text, verilog_keywords[kind], name_length) != 0)) {
+            kind++;
+        }
+        if (kind == KIND_COUNT || text[name_length] != '=') return false;
+        char* end;
+        unsigned long weight = strtoul(text + name_length + 1, &end, 10);
+        if (end == text + name_length + 1 || (*end != ',' && *end != '\0') || weight > 1000000) return false;
+        weights[kind] = (unsigned)weight;
+        total += (unsigned)weight;
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return total > 0;
+}
+
+static bool ends_with(const char* text, const char* suffix) {
+    size_t length = strlen(text);
+    size_t suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(text + length - suffix_length, suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Options options;
+    memset(&options, 0, sizeof(options));
+    options.kind = argv[1];
+    options.seed = 1;
+    options.depth = 32;
+    options.min_fanin = 2;
+    options.max_fanin = 3;
+    options.locality = 0.7;
+    options.skew = 0.1;
+    parse_mix("and=2,nand=3,or=2,nor=2,xor=1,not=1", options.weights);
+
+    char* end;
+    long size = strtol(argv[2], &end, 10);
+    if (*end != '\0' || size < 1 || size > INT_MAX / 2) {
+        fprintf(stderr, "Error: Invalid size %s\n", argv[2]);
+        return 1;
+    }
+    options.size = (int)size;
+
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output_path = argv[++i];
+            if (ends_with(options.output_path, ".bench")) options.bench = true;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            options.bench = true;
+        } else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            options.module_name = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            options.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--inputs") == 0 && i + 1 < argc) {
+            options.input_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fanin") == 0 && i + 1 < argc) {
+            const char* range = argv[++i];
+            options.min_fanin = atoi(range);
+            options.max_fanin = strchr(range, ':') ? atoi(strchr(range, ':') + 1) : options.min_fanin;
+        } else if (strcmp(argv[i], "--locality") == 0 && i + 1 < argc) {
+            options.locality = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--skew") == 0 && i + 1 < argc) {
+            options.skew = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-fanout") == 0 && i + 1 < argc) {
+            options.max_fanout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            if (!parse_mix(argv[++i], options.weights)) {
+                fprintf(stderr, "Error: Invalid gate mix %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--style") == 0 && i + 1 < argc) {
+            const char* style = argv[++i];
+            if (strcmp(style, "prefix") != 0 && strcmp(style, "ripple") != 0) {
+                fprintf(stderr, "Error: Unknown adder style %s\n", style);
+                return 1;
+            }
+            options.prefix_adder = strcmp(style, "prefix") == 0;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.min_fanin < 2 || options.max_fanin < options.min_fanin) {
+        fprintf(stderr, "Error: Fanin must be MIN:MAX with 2 <= MIN <= MAX\n");
+        return 1;
+    }
+    if (options.depth < 1 || options.input_count < 0 || options.max_fanout < 0 ||
+        options.locality < 0.0 || options.locality > 1.0 || options.skew < 0.0 || options.skew > 1.0) {
+        fprintf(stderr, "Error: Invalid random netlist options\n");
+        return 1;
+    }
+
+    char default_name[64];
+    if (!options.module_name) {
+        snprintf(default_name, sizeof(default_name), "%s%d", options.kind, options.size);
+        options.module_name = default_name;
+    }
+    // Recorded in the file; the output name is left out so copies are identical
+    char command_line[MAX_COMMAND_LINE] = "netgen";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0) {
+            i++;
+            continue;
+        }
+        size_t used = strlen(command_line);
+        snprintf(command_line + used, sizeof(command_line) - used, " %s", argv[i]);
+    }
+
+    Netlist net;
+    init_netlist(&net);
+    uint64_t rng = options.seed;
+    if (strcmp(options.kind, "random") == 0) {
+        generate_random(&net, &options, &rng);
+    } else if (strcmp(options.kind, "multiplier") == 0) {
+        if (options.size < 2) {
+            fprintf(stderr, "Error: Multiplier size must be at least 2\n");
+            free_netlist(&net);
+            return 1;
+        }
+        generate_multiplier(&net, options.size);
+    } else if (strcmp(options.kind, "adder") == 0) {
+        if (options.prefix_adder) {
+            generate_prefix_adder(&net, options.size);
+        } else {
+            generate_ripple_adder(&net, options.size);
+        }
+    } else if (strcmp(options.kind, "parity") == 0) {
+        generate_parity(&net, options.size);
+    } else if (strcmp(options.kind, "ecc") == 0) {
+        generate_ecc(&net, options.size);
+    } else {
+        fprintf(stderr, "Error: Unknown netlist kind %s\n", options.kind);
+        free_netlist(&net);
+        return 1;
+    }
+
+    int result = write_generated_netlist(&net, &options, command_line);
+    if (result == 0) {
+        fprintf(options.output_path ? stdout : stderr, "Generated %s: %d inputs, %d outputs, %d gates, depth %d\n",
+                options.module_name, net.input_count, net.output_count, net.gate_count, netlist_depth(&net));
+    }
+    free_netlist(&net);
+    return result;
+}
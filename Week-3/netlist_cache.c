@@ -0,0 +1,434 @@
+#include "netlist_cache.h"
+#include "sim_stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "CKTCACHE"
+#define CACHE_VERSION 2
+#define CACHE_BYTE_ORDER 0x01020304u
+#define SECTION_ALIGNMENT 64
+#define HASH_READ_BYTES (1 << 20)
+#define WRITE_BATCH 256                 // Nodes or connections encoded per fwrite
+
+enum {
+    SECTION_NODES,
+    SECTION_CONNECTIONS,
+    SECTION_INPUTS,
+    SECTION_OUTPUTS,
+    SECTION_NAME_INDEX,
+    SECTION_LEVEL,
+    SECTION_ORDER,
+    SECTION_POSITION,
+    SECTION_COUNT
+};
+
+// File header; sections follow at 64-byte aligned offsets
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t node_size;                 // The sections hold raw structs of this build
+    uint32_t connection_size;
+    uint32_t summary_size;
+    uint32_t pointer_size;
+    uint64_t source_hash;
+    uint64_t file_size;
+    NetlistSummary summary;
+    int32_t node_count;
+    int32_t connection_count;
+    int32_t pi_count;
+    int32_t po_count;
+    int32_t name_index_slots;
+    int32_t order_count;
+    int32_t max_level;
+    int32_t is_acyclic;
+    uint64_t section[SECTION_COUNT];    // Byte offset of each section
+} CacheHeader;
+
+// --- Source hash ---
+
+static uint64_t mix_word(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+    return hash ^ (hash >> 31);
+}
+
+// Eight bytes per step: hashing must stay far cheaper than parsing
+uint64_t hash_netlist_source(const char* netlist_path) {
+    int fd = open(netlist_path, O_RDONLY);
+    if (fd < 0) return 0;
+    unsigned char* buffer = (unsigned char*)malloc(HASH_READ_BYTES);
+    if (!buffer) {
+        close(fd);
+        return 0;
+    }
+
+    uint64_t hash = 0x9E3779B97F4A7C15ULL;
+    uint64_t total = 0;
+    bool failed = false;
+    for (;;) {
+        // Fill the whole buffer so that only the last block has a partial word
+        size_t used = 0;
+        while (used < HASH_READ_BYTES) {
+            ssize_t got = read(fd, buffer + used, HASH_READ_BYTES - used);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) failed = true;
+            if (got <= 0) break;
+            used += (size_t)got;
+        }
+        if (failed || used == 0) break;
+
+        size_t i = 0;
+        for (; i + 8 <= used; i += 8) {
+            uint64_t word;
+            memcpy(&word, buffer + i, 8);
+            hash = mix_word(hash, word);
+        }
+        if (i < used) {
+            uint64_t word = 0;
+            memcpy(&word, buffer + i, used - i);
+            hash = mix_word(hash, word);
+        }
+        total += used;
+        if (used < HASH_READ_BYTES) break;
+    }
+    free(buffer);
+    close(fd);
+    if (failed) return 0;
+
+    hash = mix_word(hash, total);
+    return hash ? hash : 1;
+}
+
+void netlist_cache_path(const char* netlist_path, char* path, size_t size) {
+    snprintf(path, size, "%s.ckt", netlist_path);
+}
+
+// --- Layout ---
+
+static uint64_t section_bytes(const CacheHeader* header, int section) {
+    switch (section) {
+        case SECTION_NODES:       return (uint64_t)header->node_count * sizeof(CircuitNode);
+        case SECTION_CONNECTIONS: return (uint64_t)header->connection_count * sizeof(ConnectionNode);
+        case SECTION_INPUTS:      return (uint64_t)header->pi_count * sizeof(int);
+        case SECTION_OUTPUTS:     return (uint64_t)header->po_count * sizeof(int);
+        case SECTION_NAME_INDEX:  return (uint64_t)header->name_index_slots * sizeof(int);
+        case SECTION_LEVEL:       return (uint64_t)header->node_count * sizeof(int);
+        case SECTION_ORDER:       return (uint64_t)header->order_count * sizeof(int);
+        case SECTION_POSITION:    return (uint64_t)header->node_count * sizeof(int);
+        default:                  return 0;
+    }
+}
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(uint64_t)(SECTION_ALIGNMENT - 1);
+}
+
+// Fills in the section offsets and the file size from the counts
+static void lay_out_sections(CacheHeader* header) {
+    uint64_t offset = align_offset(sizeof(CacheHeader));
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        header->section[s] = offset;
+        offset = align_offset(offset + section_bytes(header, s));
+    }
+    header->file_size = offset;
+}
+
+// List pointers are stored as connection index + 1 (0 for NULL)
+static ConnectionNode* encode_connection(int index) {
+    return (ConnectionNode*)(uintptr_t)(index + 1);
+}
+
+// --- Saving ---
+
+static int list_length(const ConnectionNode* list) {
+    int length = 0;
+    for (; list; list = list->next) length++;
+    return length;
+}
+
+static bool write_padding(FILE* file, uint64_t* position, uint64_t offset) {
+    static const char zeros[SECTION_ALIGNMENT];
+    size_t length = (size_t)(offset - *position);
+    *position = offset;
+    return fwrite(zeros, 1, length, file) == length;
+}
+
+// Connections are numbered node by node, fanin list then fanout list, each in list order
+static bool write_nodes(FILE* file, const Circuit* circuit) {
+    CircuitNode batch[WRITE_BATCH];
+    int connection = 0;
+    for (int first = 0; first < circuit->node_count; first += WRITE_BATCH) {
+        int count = circuit->node_count - first < WRITE_BATCH ? circuit->node_count - first : WRITE_BATCH;
+        for (int i = 0; i < count; i++) {
+            CircuitNode* node = &batch[i];
+            *node = circuit->nodes[first + i];
+            int fanin_length = list_length(node->fanin_list);
+            int fanout_length = list_length(node->fanout_list);
+            node->fanin_list = fanin_length ? encode_connection(connection) : NULL;
+            node->fanout_list = fanout_length ? encode_connection(connection + fanin_length) : NULL;
+            node->value = LOGIC_X;
+            node->is_evaluated = false;
+            connection += fanin_length + fanout_length;
+        }
+        if (fwrite(batch, sizeof(CircuitNode), (size_t)count, file) != (size_t)count) return false;
+    }
+    return true;
+}
+
+static bool flush_connections(FILE* file, const ConnectionNode* batch, int* count) {
+    bool ok = fwrite(batch, sizeof(ConnectionNode), (size_t)*count, file) == (size_t)*count;
+    *count = 0;
+    return ok;
+}
+
+static bool write_connections(FILE* file, const Circuit* circuit) {
+    ConnectionNode batch[WRITE_BATCH];
+    memset(batch, 0, sizeof(batch));    // Padding too, so equal circuits give equal files
+    int count = 0;
+    int index = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        const ConnectionNode* lists[2] = { circuit->nodes[i].fanin_list, circuit->nodes[i].fanout_list };
+        for (int l = 0; l < 2; l++) {
+            for (const ConnectionNode* connection = lists[l]; connection; connection = connection->next) {
+                batch[count].node_id = connection->node_id;
+                batch[count].next = connection->next ? encode_connection(index + 1) : NULL;
+                index++;
+                if (++count == WRITE_BATCH && !flush_connections(file, batch, &count)) return false;
+            }
+        }
+    }
+    return flush_connections(file, batch, &count);
+}
+
+bool save_netlist_cache(const char* netlist_path, uint64_t source_hash, const Circuit* circuit,
+                        const NetlistSummary* summary, const Levelization* levels) {
+    if (!netlist_path || !source_hash || !circuit || !summary || !levels) return false;
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.node_size = sizeof(CircuitNode);
+    header.connection_size = sizeof(ConnectionNode);
+    header.summary_size = sizeof(NetlistSummary);
+    header.pointer_size = sizeof(void*);
+    header.source_hash = source_hash;
+    header.summary = *summary;
+    header.node_count = circuit->node_count;
+    header.pi_count = circuit->pi_count;
+    header.po_count = circuit->po_count;
+    header.name_index_slots = circuit->name_index_mask + 1;
+    header.order_count = levels->order_count;
+    header.max_level = levels->max_level;
+    header.is_acyclic = levels->is_acyclic;
+    long long connections = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        connections += list_length(circuit->nodes[i].fanin_list) + list_length(circuit->nodes[i].fanout_list);
+    }
+    if (connections >= INT32_MAX) return false;
+    header.connection_count = (int32_t)connections;
+    lay_out_sections(&header);
+
+    char path[1024];
+    char temp_path[1100];
+    netlist_cache_path(netlist_path, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.%ld.tmp", path, (long)getpid());
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) return false;
+
+    const void* arrays[SECTION_COUNT] = {
+        [SECTION_INPUTS] = circuit->primary_inputs,
+        [SECTION_OUTPUTS] = circuit->primary_outputs,
+        [SECTION_NAME_INDEX] = circuit->name_index,
+        [SECTION_LEVEL] = levels->level,
+        [SECTION_ORDER] = levels->order,
+        [SECTION_POSITION] = levels->position,
+    };
+    uint64_t position = sizeof(header);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int s = 0; ok && s < SECTION_COUNT; s++) {
+        uint64_t bytes = section_bytes(&header, s);
+        ok = write_padding(file, &position, header.section[s]);
+        if (!ok || bytes == 0) continue;
+        if (s == SECTION_NODES) ok = write_nodes(file, circuit);
+        else if (s == SECTION_CONNECTIONS) ok = write_connections(file, circuit);
+        else ok = fwrite(arrays[s], 1, (size_t)bytes, file) == (size_t)bytes;
+        position += bytes;
+    }
+    ok = ok && write_padding(file, &position, header.file_size);
+
+    if (fclose(file) != 0) ok = false;
+    if (ok && rename(temp_path, path) != 0) ok = false;
+    if (!ok) remove(temp_path);
+    return ok;
+}
+
+// --- Loading ---
+
+static bool header_usable(const CacheHeader* header, uint64_t source_hash, uint64_t file_size) {
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != CACHE_VERSION ||
+        header->byte_order != CACHE_BYTE_ORDER || header->node_size != sizeof(CircuitNode) ||
+        header->connection_size != sizeof(ConnectionNode) || header->summary_size != sizeof(NetlistSummary) ||
+        header->pointer_size != sizeof(void*) || header->source_hash != source_hash) {
+        return false;
+    }
+    if (header->node_count < 0 || header->connection_count < 0 || header->pi_count < 0 || header->po_count < 0 ||
+        header->order_count < 0 || header->order_count > header->node_count || header->name_index_slots <= header->node_count ||
+        (header->name_index_slots & (header->name_index_slots - 1)) != 0) {
+        return false;
+    }
+
+    CacheHeader expected = *header;
+    lay_out_sections(&expected);
+    return expected.file_size == file_size && header->file_size == file_size &&
+           memcmp(expected.section, header->section, sizeof(expected.section)) == 0;
+}
+
+static bool ids_in_range(const int* ids, int count, int low, int high) {
+    for (int i = 0; i < count; i++) {
+        if (ids[i] < low || ids[i] >= high) return false;
+    }
+    return true;
+}
+
+static bool decode_connection(ConnectionNode** pointer, ConnectionNode* connections, int count) {
+    uintptr_t stored = (uintptr_t)*pointer;
+    if (stored > (uintptr_t)count) return false;
+    *pointer = stored ? &connections[stored - 1] : NULL;
+    return true;
+}
+
+// Turns stored indices back into pointers, checking everything a simulator would follow
+static bool fix_up_circuit(CircuitNode* nodes, int node_count, ConnectionNode* connections, int connection_count) {
+    for (int i = 0; i < node_count; i++) {
+        CircuitNode* node = &nodes[i];
+        if (node->id != i || !memchr(node->name, '\0', sizeof(node->name)) ||
+            !memchr(node->gate_instance, '\0', sizeof(node->gate_instance)) ||
+            !decode_connection(&node->fanin_list, connections, connection_count) ||
+            !decode_connection(&node->fanout_list, connections, connection_count)) {
+            return false;
+        }
+    }
+    for (int c = 0; c < connection_count; c++) {
+        ConnectionNode* connection = &connections[c];
+        uintptr_t stored = (uintptr_t)connection->next;
+        // Each list is stored in consecutive entries, so lists cannot loop
+        if (connection->node_id < 0 || connection->node_id >= node_count ||
+            (stored != 0 && stored != (uintptr_t)c + 2) ||
+            !decode_connection(&connection->next, connections, connection_count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static Levelization* copy_levels(const CacheHeader* header, const char* base) {
+    int n = header->node_count;
+    const int* level = (const int*)(base + header->section[SECTION_LEVEL]);
+    const int* order = (const int*)(base + header->section[SECTION_ORDER]);
+    const int* position = (const int*)(base + header->section[SECTION_POSITION]);
+    if (!ids_in_range(order, header->order_count, 0, n) || !ids_in_range(position, n, -1, header->order_count)) {
+        return NULL;
+    }
+
+    Levelization* levels = (Levelization*)malloc(sizeof(Levelization));
+    if (!levels) return NULL;
+    levels->level = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    levels->order = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    levels->position = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (!levels->level || !levels->order || !levels->position) {
+        destroy_levelization(levels);
+        return NULL;
+    }
+    memcpy(levels->level, level, (size_t)n * sizeof(int));
+    memcpy(levels->order, order, (size_t)header->order_count * sizeof(int));
+    memcpy(levels->position, position, (size_t)n * sizeof(int));
+    levels->node_count = n;
+    levels->order_count = header->order_count;
+    levels->max_level = header->max_level;
+    levels->is_acyclic = header->is_acyclic != 0;
+    return levels;
+}
+
+static Circuit* map_netlist_cache(const char* netlist_path, uint64_t source_hash,
+                                  NetlistSummary* summary, Levelization** levels) {
+    char path[1024];
+    netlist_cache_path(netlist_path, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || (size_t)info.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+    posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+    char* base = (char*)mapping;
+    const CacheHeader* header = (const CacheHeader*)mapping;
+    Levelization* loaded_levels = NULL;
+    Circuit* circuit = NULL;
+    if (!header_usable(header, source_hash, size)) goto reject;
+
+    int n = header->node_count;
+    CircuitNode* nodes = (CircuitNode*)(base + header->section[SECTION_NODES]);
+    ConnectionNode* connections = (ConnectionNode*)(base + header->section[SECTION_CONNECTIONS]);
+    int* inputs = (int*)(base + header->section[SECTION_INPUTS]);
+    int* outputs = (int*)(base + header->section[SECTION_OUTPUTS]);
+    int* name_index = (int*)(base + header->section[SECTION_NAME_INDEX]);
+    if (!fix_up_circuit(nodes, n, connections, header->connection_count) ||
+        !ids_in_range(inputs, header->pi_count, 0, n) || !ids_in_range(outputs, header->po_count, 0, n) ||
+        !ids_in_range(name_index, header->name_index_slots, -1, n)) {
+        goto reject;
+    }
+
+    loaded_levels = copy_levels(header, base);
+    circuit = (Circuit*)calloc(1, sizeof(Circuit));
+    if (!loaded_levels || !circuit) goto reject;
+
+    circuit->nodes = nodes;
+    circuit->node_count = n;
+    circuit->node_capacity = n;
+    circuit->primary_inputs = inputs;
+    circuit->primary_outputs = outputs;
+    circuit->pi_count = circuit->pi_capacity = header->pi_count;
+    circuit->po_count = circuit->po_capacity = header->po_count;
+    circuit->name_index = name_index;
+    circuit->name_index_mask = header->name_index_slots - 1;
+    circuit->mapping = mapping;
+    circuit->mapping_size = size;
+
+    *summary = header->summary;
+    *levels = loaded_levels;
+    return circuit;
+
+reject:
+    // Stale or damaged: the caller parses the netlist and rewrites the file
+    free(circuit);
+    destroy_levelization(loaded_levels);
+    munmap(mapping, size);
+    return NULL;
+}
+
+Circuit* load_netlist_cache(const char* netlist_path, uint64_t source_hash,
+                            NetlistSummary* summary, Levelization** levels) {
+    Circuit* circuit = map_netlist_cache(netlist_path, source_hash, summary, levels);
+    if (circuit) {
+        SIM_STAT_ADD(netlist_cache_hits, 1);
+        SIM_STAT_ADD(bytes_read, (long long)circuit->mapping_size);
+    } else {
+        SIM_STAT_ADD(netlist_cache_misses, 1);
+    }
+    return circuit;
+}
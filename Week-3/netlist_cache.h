@@ -0,0 +1,62 @@
+#ifndef NETLIST_CACHE_H
+#define NETLIST_CACHE_H
+
+#include "circuit_builder.h"
+#include "circuit_node.h"
+#include "levelizer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compiled-netlist cache.
+//
+// After a netlist is built (branch nodes included) and levelized, the result
+// is saved next to it as <netlist>.ckt: the node and connection arrays as they
+// sit in memory, with list pointers stored as indices, plus the PI/PO lists,
+// the name index, the levelization and the netlist summary. The file records
+// a hash of the source text and is only used while that hash still matches.
+//
+// Loading maps the file copy-on-write and turns the stored indices back into
+// pointers, so the circuit is usable without parsing anything. The file is
+// tied to the build that wrote it (format version, struct sizes, byte order);
+// any mismatch just means the netlist is parsed again and the file rewritten.
+
+/**
+ * @brief Hashes the contents of a netlist file.
+ * @param netlist_path Path of the netlist.
+ * @return The hash, or 0 if the file cannot be read.
+ */
+uint64_t hash_netlist_source(const char* netlist_path);
+
+/**
+ * @brief Writes the cache file name for a netlist into path.
+ */
+void netlist_cache_path(const char* netlist_path, char* path, size_t size);
+
+/**
+ * @brief Loads the compiled form of a netlist if its cache file is current.
+ * @param netlist_path Path of the netlist.
+ * @param source_hash hash_netlist_source() of the netlist.
+ * @param summary Receives the summary saved with the circuit.
+ * @param levels Receives a new levelization (caller destroys).
+ * @return The circuit (caller destroys), or NULL if there is no usable cache file.
+ */
+Circuit* load_netlist_cache(const char* netlist_path, uint64_t source_hash,
+                            NetlistSummary* summary, Levelization** levels);
+
+/**
+ * @brief Saves a built circuit as the netlist's cache file.
+ *
+ * The file is written under a temporary name and renamed, so concurrent runs
+ * never see a partial file.
+ * @param netlist_path Path of the netlist.
+ * @param source_hash hash_netlist_source() of the netlist the circuit was built from.
+ * @param circuit The finished circuit.
+ * @param summary Summary of the netlist.
+ * @param levels Levelization of the circuit.
+ * @return false if the file could not be written (e.g. read-only directory).
+ */
+bool save_netlist_cache(const char* netlist_path, uint64_t source_hash, const Circuit* circuit,
+                        const NetlistSummary* summary, const Levelization* levels);
+
+#endif // NETLIST_CACHE_H
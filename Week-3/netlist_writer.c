@@ -0,0 +1,304 @@
+#include "netlist_writer.h"
+#include "levelizer.h"
+#include "verilog_lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const Circuit* circuit;
+    NetlistOutput* out;
+    int* inputs;                // Fanins of the gate being written, stems resolved
+    int* gates;                 // Gate node IDs in writing order
+    int gate_count;
+} NetlistWriter;
+
+// --- Circuit structure ---
+
+// Follows branch nodes back to the signal they copy
+static int stem_of(const Circuit* circuit, int id) {
+    while (circuit->nodes[id].type == NODE_BRNH && circuit->nodes[id].fanin_list) {
+        id = circuit->nodes[id].fanin_list->node_id;
+    }
+    return id;
+}
+
+static bool is_gate_node(const CircuitNode* node) {
+    return node->type != NODE_BRNH && node->gate_type != GATE_UNKNOWN && node->fanin_list != NULL;
+}
+
+// Collects a gate's fanin stems in source order (connections are prepended as they are added)
+static int gather_inputs(NetlistWriter* writer, const CircuitNode* node) {
+    int count = 0;
+    for (const ConnectionNode* fanin = node->fanin_list; fanin; fanin = fanin->next) count++;
+    int i = count;
+    for (const ConnectionNode* fanin = node->fanin_list; fanin; fanin = fanin->next) {
+        writer->inputs[--i] = stem_of(writer->circuit, fanin->node_id);
+    }
+    return count;
+}
+
+// Gates by depth (counting gates only, since branch placement depends on fanout
+// order), then node ID, with gates on loops last. Every gate follows the gates
+// driving it, so re-reading the file numbers the nodes in this order and
+// writing that circuit again reproduces the file.
+static int* order_gates(const Circuit* circuit, int gate_count) {
+    Levelization* levels = levelize_circuit(circuit);
+    if (!levels) return NULL;
+    int* depth = (int*)malloc((size_t)(circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(int));
+    int* gates = (int*)malloc((size_t)(gate_count > 0 ? gate_count : 1) * sizeof(int));
+    int* start = NULL;
+    int max_depth = 0;
+    if (depth && gates) {
+        for (int id = 0; id < circuit->node_count; id++) depth[id] = -1;
+        for (int i = 0; i < levels->order_count; i++) {
+            int id = levels->order[i];
+            const CircuitNode* node = &circuit->nodes[id];
+            if (!is_gate_node(node)) {
+                depth[id] = 0;
+                continue;
+            }
+            for (const ConnectionNode* fanin = node->fanin_list; fanin; fanin = fanin->next) {
+                int input_depth = depth[stem_of(circuit, fanin->node_id)] + 1;
+                if (input_depth > depth[id]) depth[id] = input_depth;
+            }
+            if (depth[id] > max_depth) max_depth = depth[id];
+        }
+        start = (int*)calloc((size_t)max_depth + 3, sizeof(int));
+    }
+    if (start) {
+        int loop_bucket = max_depth + 1;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int id = 0; id < circuit->node_count; id++) {
+                if (!is_gate_node(&circuit->nodes[id])) continue;
+                int bucket = depth[id] >= 0 ? depth[id] : loop_bucket;
+                if (pass == 0) start[bucket + 1]++;
+                else gates[start[bucket]++] = id;
+            }
+            for (int b = 0; pass == 0 && b < loop_bucket; b++) start[b + 1] += start[b];
+        }
+    } else {
+        free(gates);
+        gates = NULL;
+    }
+    free(start);
+    free(depth);
+    destroy_levelization(levels);
+    return gates;
+}
+
+// --- Verilog ---
+
+// True if the lexer reads the name back as exactly one plain identifier
+static bool is_plain_verilog_name(const char* name) {
+    const char* p = name;
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_')) return false;
+    while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_' || *p == '$') {
+        p++;
+    }
+    // Bit-selects stay attached to the name ("a[3]")
+    while (*p == '[') {
+        const char* close = p + 1;
+        while (*close >= '0' && *close <= '9') close++;
+        if (close == p + 1 || *close != ']') return false;
+        p = close + 1;
+    }
+    return *p == '\0' && lookup_keyword(name, (int)(p - name)) == KW_NONE;
+}
+
+static void emit_verilog_name(NetlistOutput* out, const char* name) {
+    if (is_plain_verilog_name(name)) {
+        emit_text(out, name);
+    } else {
+        // Escaped identifier: ends at the next whitespace
+        emit(out, "\\", 1);
+        emit_text(out, name);
+        emit(out, " ", 1);
+    }
+}
+
+static const char* verilog_gate_keyword(GateType type) {
+    switch (type) {
+        case GATE_AND:  return "and";
+        case GATE_NAND: return "nand";
+        case GATE_OR:   return "or";
+        case GATE_NOR:  return "nor";
+        case GATE_XOR:  return "xor";
+        case GATE_XNOR: return "xnor";
+        case GATE_NOT:  return "not";
+        default:        return "buf";
+    }
+}
+
+// Writes "<prefix>a, b, c,\n    d, e<suffix>" with NAMES_PER_LINE names per line
+static void emit_name_list(NetlistWriter* writer, const char* prefix, const int* ids, int count, const char* suffix) {
+    NetlistOutput* out = writer->out;
+    emit_text(out, prefix);
+    for (int i = 0; i < count; i++) {
+        if (i > 0) emit_text(out, (i % NAMES_PER_LINE) == 0 ? ",\n    " : ", ");
+        emit_verilog_name(out, writer->circuit->nodes[ids[i]].name);
+    }
+    emit_text(out, suffix);
+}
+
+static bool write_verilog(NetlistWriter* writer, const char* module_name) {
+    const Circuit* circuit = writer->circuit;
+    NetlistOutput* out = writer->out;
+
+    // Internal signals in writing order, then any that no gate drives
+    int wire_count = 0;
+    int* wires = (int*)malloc((size_t)(circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(int));
+    // A node that is both input and output (a cut flip-flop feeding another) is one port
+    int port_count = circuit->pi_count;
+    int* ports = (int*)malloc((size_t)(circuit->pi_count + circuit->po_count + 1) * sizeof(int));
+    if (!wires || !ports) {
+        free(wires);
+        free(ports);
+        return false;
+    }
+    for (int g = 0; g < writer->gate_count; g++) {
+        if (circuit->nodes[writer->gates[g]].type == NODE_GATE) wires[wire_count++] = writer->gates[g];
+    }
+    for (int id = 0; id < circuit->node_count; id++) {
+        if (circuit->nodes[id].type == NODE_GATE && !is_gate_node(&circuit->nodes[id])) wires[wire_count++] = id;
+    }
+    memcpy(ports, circuit->primary_inputs, (size_t)circuit->pi_count * sizeof(int));
+    for (int i = 0; i < circuit->po_count; i++) {
+        if (circuit->nodes[circuit->primary_outputs[i]].type == NODE_PO) ports[port_count++] = circuit->primary_outputs[i];
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "// %s: %d inputs, %d outputs, %d gates (written by circuit_simulator)\n",
+             module_name, circuit->pi_count, circuit->po_count, writer->gate_count);
+    emit_text(out, line);
+    emit_text(out, "module ");
+    emit_verilog_name(out, module_name);
+    emit_name_list(writer, " (", ports, port_count, ");\n\n");
+    if (circuit->pi_count > 0) emit_name_list(writer, "  input ", circuit->primary_inputs, circuit->pi_count, ";\n");
+    if (circuit->po_count > 0) emit_name_list(writer, "  output ", circuit->primary_outputs, circuit->po_count, ";\n");
+    if (wire_count > 0) emit_name_list(writer, "  wire ", wires, wire_count, ";\n");
+    emit_text(out, "\n");
+
+    for (int g = 0; g < writer->gate_count && !out->failed; g++) {
+        int id = writer->gates[g];
+        const CircuitNode* node = &circuit->nodes[id];
+        emit_text(out, "  ");
+        emit_text(out, verilog_gate_keyword(node->gate_type));
+        emit(out, " ", 1);
+        if (node->gate_instance[0]) {
+            emit_verilog_name(out, node->gate_instance);
+        } else {
+            snprintf(line, sizeof(line), "g%d", id);
+            emit_text(out, line);
+        }
+        emit_text(out, " (");
+        emit_verilog_name(out, node->name);
+        int input_count = gather_inputs(writer, node);
+        for (int i = 0; i < input_count; i++) {
+            emit_text(out, ", ");
+            emit_verilog_name(out, circuit->nodes[writer->inputs[i]].name);
+        }
+        emit_text(out, ");\n");
+    }
+    emit_text(out, "\nendmodule\n");
+
+    free(wires);
+    free(ports);
+    return true;
+}
+
+// --- .bench ---
+
+static bool is_bench_name(const char* name) {
+    if (!*name) return false;
+    for (const char* p = name; *p; p++) {
+        if ((unsigned char)*p <= ' ' || *p == '(' || *p == ')' || *p == ',' || *p == '=' || *p == '#') return false;
+    }
+    return true;
+}
+
+static void emit_bench_statement(NetlistOutput* out, const char* keyword, const char* name) {
+    emit_text(out, keyword);
+    emit(out, "(", 1);
+    emit_text(out, name);
+    emit(out, ")\n", 2);
+}
+
+static bool write_bench(NetlistWriter* writer, const char* module_name) {
+    const Circuit* circuit = writer->circuit;
+    NetlistOutput* out = writer->out;
+    for (int id = 0; id < circuit->node_count; id++) {
+        if (circuit->nodes[id].type != NODE_BRNH && !is_bench_name(circuit->nodes[id].name)) {
+            fprintf(stderr, "Error: Signal name '%s' cannot be written in .bench format\n", circuit->nodes[id].name);
+            return false;
+        }
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "# %s\n# %d inputs, %d outputs, %d gates (written by circuit_simulator)\n\n",
+             module_name, circuit->pi_count, circuit->po_count, writer->gate_count);
+    emit_text(out, line);
+    for (int i = 0; i < circuit->pi_count; i++) {
+        emit_bench_statement(out, "INPUT", circuit->nodes[circuit->primary_inputs[i]].name);
+    }
+    emit_text(out, "\n");
+    for (int i = 0; i < circuit->po_count; i++) {
+        emit_bench_statement(out, "OUTPUT", circuit->nodes[circuit->primary_outputs[i]].name);
+    }
+    emit_text(out, "\n");
+
+    for (int g = 0; g < writer->gate_count && !out->failed; g++) {
+        const CircuitNode* node = &circuit->nodes[writer->gates[g]];
+        emit_text(out, node->name);
+        emit_text(out, " = ");
+        emit_text(out, gate_type_to_string(node->gate_type));
+        emit(out, "(", 1);
+        int input_count = gather_inputs(writer, node);
+        for (int i = 0; i < input_count; i++) {
+            if (i > 0) emit(out, ", ", 2);
+            emit_text(out, circuit->nodes[writer->inputs[i]].name);
+        }
+        emit(out, ")\n", 2);
+    }
+    return true;
+}
+
+// --- Public Function Implementations ---
+
+int write_netlist(const Circuit* circuit, const char* module_name, const char* filename, NetlistFormat format) {
+    if (!circuit || !module_name || !filename) return 1;
+
+    int max_fanin = 1;
+    int gate_count = 0;
+    for (int id = 0; id < circuit->node_count; id++) {
+        if (!is_gate_node(&circuit->nodes[id])) continue;
+        gate_count++;
+        if (circuit->nodes[id].fanin_count > max_fanin) max_fanin = circuit->nodes[id].fanin_count;
+    }
+
+    NetlistOutput out = { fopen(filename, "w"), (char*)malloc(WRITE_BUFFER_BYTES), 0, false };
+    NetlistWriter writer = { circuit, &out, (int*)malloc((size_t)max_fanin * sizeof(int)),
+                             order_gates(circuit, gate_count), gate_count };
+    if (!out.file) {
+        perror("Error opening netlist output file");
+        free(out.buffer);
+        free(writer.inputs);
+        free(writer.gates);
+        return 1;
+    }
+
+    bool ok = out.buffer && writer.inputs && writer.gates &&
+              (format == NETLIST_BENCH ? write_bench(&writer, module_name) : write_verilog(&writer, module_name));
+    if (ok) flush_output(&out);
+    if (fclose(out.file) != 0) out.failed = true;
+    free(out.buffer);
+    free(writer.inputs);
+    free(writer.gates);
+
+    if (!ok || out.failed) {
+        fprintf(stderr, "Error: Failed to write netlist %s\n", filename);
+        remove(filename);
+        return 1;
+    }
+    return 0;
+}
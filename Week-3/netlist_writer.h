@@ -0,0 +1,64 @@
+#ifndef NETLIST_WRITER_H
+#define NETLIST_WRITER_H
+
+#include "bench_parser.h"
+#include "circuit_node.h"
+#include <stdio.h>
+#include <string.h>
+
+// Writes an in-memory circuit back out as a netlist, so a transformed or
+// flattened circuit can be saved and loaded later like any other netlist.
+//
+// Branch nodes are folded back into their stems: every fanout of a signal
+// reads the stem's name again, as in the source. Ports keep their order;
+// gates are written by level, so each follows its drivers and writing a
+// re-read file reproduces it. All signals keep their names; Verilog names
+// the lexer would not read back as one identifier
+// (hierarchical paths, leading digits, keywords) are written escaped. Gates
+// keep their instance names, or are named g<node ID> if they have none.
+//
+// Output goes through a large buffer flushed with single fwrite() calls, so
+// million-gate circuits are written at disk speed. The buffer is shared with
+// netgen, which writes the same formats without building a Circuit.
+
+#define WRITE_BUFFER_BYTES (1 << 20)        // Flushed with one fwrite
+#define NAMES_PER_LINE 10                   // Port and declaration lists
+
+// Buffered netlist text; failed is set once any write fails
+typedef struct {
+    FILE* file;
+    char* buffer;               // WRITE_BUFFER_BYTES
+    size_t used;
+    bool failed;
+} NetlistOutput;
+
+static inline void flush_output(NetlistOutput* out) {
+    if (out->used > 0 && fwrite(out->buffer, 1, out->used, out->file) != out->used) out->failed = true;
+    out->used = 0;
+}
+
+static inline void emit(NetlistOutput* out, const char* text, size_t length) {
+    if (out->used + length > WRITE_BUFFER_BYTES) flush_output(out);
+    if (length > WRITE_BUFFER_BYTES) {
+        if (fwrite(text, 1, length, out->file) != length) out->failed = true;
+        return;
+    }
+    memcpy(out->buffer + out->used, text, length);
+    out->used += length;
+}
+
+static inline void emit_text(NetlistOutput* out, const char* text) {
+    emit(out, text, strlen(text));
+}
+
+/**
+ * @brief Writes a circuit as structural Verilog or .bench.
+ * @param circuit The circuit.
+ * @param module_name Module name (Verilog) or header comment (.bench).
+ * @param filename Output path.
+ * @param format NETLIST_VERILOG (the dialect parse_verilog_module() reads) or NETLIST_BENCH.
+ * @return 0 on success, 1 if the file cannot be written.
+ */
+int write_netlist(const Circuit* circuit, const char* module_name, const char* filename, NetlistFormat format);
+
+#endif // NETLIST_WRITER_H
@@ -0,0 +1,284 @@
+#include "parallel_parser.h"
+#include "sim_trace.h"
+#include "verilog_lexer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// One serially parsed header or one gate-section chunk
+typedef struct {
+    const char* data;
+    size_t size;
+    int first_line;
+    int newline_count;
+    ShardedStringPool* names;
+    ParseContext* tables;      // Storage only: IDs are sharded-pool IDs, tables->names is NULL
+    bool failed;
+    pthread_t thread;
+    bool thread_started;
+} ParseChunk;
+
+// --- Chunk sink: interns through the shared pool into chunk-local tables ---
+
+static int intern_chunk_name(ParseChunk* chunk, NameView name) {
+    int id = sharded_pool_intern(chunk->names, name.text, name.length);
+    if (id < 0) chunk->failed = true;
+    return id;
+}
+
+static bool chunk_module(void* user, NameView name) {
+    ParseChunk* chunk = (ParseChunk*)user;
+    if (chunk->tables->module_name >= 0) chunk->tables->hierarchical = true;
+    chunk->tables->module_name = intern_chunk_name(chunk, name);
+    return !chunk->failed;
+}
+
+static bool chunk_declare(void* user, DeclarationKind kind, NameView name) {
+    ParseChunk* chunk = (ParseChunk*)user;
+    ParseContext* tables = chunk->tables;
+    NameList* list = (kind == DECLARE_PORT) ? &tables->module_ports :
+                     (kind == DECLARE_INPUT) ? &tables->inputs :
+                     (kind == DECLARE_OUTPUT) ? &tables->outputs : &tables->wires;
+    if (!append_parsed_name(list, intern_chunk_name(chunk, name))) chunk->failed = true;
+    return !chunk->failed;
+}
+
+static bool chunk_gate(void* user, GateType type, NameView instance, NameView output,
+                       const NameView* inputs, int input_count) {
+    ParseChunk* chunk = (ParseChunk*)user;
+    ParseContext* tables = chunk->tables;
+
+    GateInstance gate;
+    gate.type = type;
+    gate.instance_name = intern_chunk_name(chunk, instance);
+    gate.instance_number = instance_number_from_name(instance.text, instance.length);
+    gate.output_signal = intern_chunk_name(chunk, output);
+    gate.first_input = tables->gate_inputs.count;
+    gate.input_count = input_count;
+    for (int i = 0; i < input_count && !chunk->failed; i++) {
+        if (!append_parsed_name(&tables->gate_inputs, intern_chunk_name(chunk, inputs[i]))) chunk->failed = true;
+    }
+    if (!chunk->failed && !append_parsed_gate(tables, &gate)) chunk->failed = true;
+    return !chunk->failed;
+}
+
+static bool chunk_instance(void* user, NameView module, NameView instance,
+                           const NameView* formals, const NameView* actuals, int count) {
+    (void)module; (void)instance; (void)formals; (void)actuals; (void)count;
+    ((ParseChunk*)user)->tables->hierarchical = true;
+    return true;
+}
+
+static int parse_chunk(ParseChunk* chunk, size_t* header_end) {
+    ParseSink sink = { chunk, chunk_module, chunk_declare, chunk_gate, chunk_instance };
+    return parse_verilog_buffer(chunk->data, chunk->size, chunk->first_line, &sink, header_end);
+}
+
+// --- Splitting ---
+
+static int count_newlines(const char* data, size_t size) {
+    int count = 0;
+    const char* end = data + size;
+    for (const char* p = data; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) count++;
+    return count;
+}
+
+static bool contains_block_comment(const char* data, size_t size) {
+    const char* end = data + size;
+    for (const char* p = data; (p = memchr(p, '/', (size_t)(end - p))) != NULL; p++) {
+        if (p + 1 < end && p[1] == '*') return true;
+    }
+    return false;
+}
+
+// First statement end at or after from, skipping ';' that sit behind a line
+// comment or inside an escaped identifier on the same line
+static const char* next_statement_boundary(const char* from, const char* start, const char* end) {
+    const char* p = from;
+    while (p < end) {
+        const char* semicolon = memchr(p, ';', (size_t)(end - p));
+        if (!semicolon) return end;
+
+        const char* line = semicolon;
+        while (line > start && line[-1] != '\n') line--;
+        bool suspicious = false;
+        for (const char* c = line; c < semicolon; c++) {
+            if (*c == '\\' || (*c == '/' && c + 1 < semicolon && c[1] == '/')) {
+                suspicious = true;
+                break;
+            }
+        }
+        if (!suspicious) return semicolon + 1;
+
+        const char* newline = memchr(semicolon, '\n', (size_t)(end - semicolon));
+        p = newline ? newline + 1 : end;
+    }
+    return end;
+}
+
+// --- Threads ---
+
+static void* count_lines_thread(void* arg) {
+    ParseChunk* chunk = (ParseChunk*)arg;
+    trace_name_thread("parser", -1);
+    double trace_begin = TRACE_BEGIN();
+    chunk->newline_count = count_newlines(chunk->data, chunk->size);
+    TRACE_END("count lines", trace_begin);
+    return NULL;
+}
+
+static void* parse_chunk_thread(void* arg) {
+    ParseChunk* chunk = (ParseChunk*)arg;
+    trace_name_thread("parser", -1);
+    double trace_begin = TRACE_BEGIN();
+    if (parse_chunk(chunk, NULL) != 0) chunk->failed = true;
+    TRACE_END("parse chunk", trace_begin);
+    return NULL;
+}
+
+// Runs fn on every chunk, one thread each (inline if a thread cannot start)
+static void run_chunks(ParseChunk* chunks, int count, void* (*fn)(void*)) {
+    for (int i = 0; i < count; i++) {
+        chunks[i].thread_started = (pthread_create(&chunks[i].thread, NULL, fn, &chunks[i]) == 0);
+        if (!chunks[i].thread_started) fn(&chunks[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].thread_started) pthread_join(chunks[i].thread, NULL);
+    }
+}
+
+// --- Merge ---
+
+static bool append_remapped(NameList* destination, const NameList* source, const int* shard_base) {
+    for (int i = 0; i < source->count; i++) {
+        if (!append_parsed_name(destination, sharded_pool_dense_id(shard_base, source->ids[i]))) return false;
+    }
+    return true;
+}
+
+static bool merge_tables(ParseContext* ctx, const ParseContext* tables, const int* shard_base) {
+    // A module header in a later chunk is a second module
+    if (tables->hierarchical || (tables->module_name >= 0 && ctx->module_name >= 0)) ctx->hierarchical = true;
+    if (tables->module_name >= 0) ctx->module_name = sharded_pool_dense_id(shard_base, tables->module_name);
+    if (!append_remapped(&ctx->module_ports, &tables->module_ports, shard_base) ||
+        !append_remapped(&ctx->inputs, &tables->inputs, shard_base) ||
+        !append_remapped(&ctx->outputs, &tables->outputs, shard_base) ||
+        !append_remapped(&ctx->wires, &tables->wires, shard_base)) {
+        return false;
+    }
+
+    for (int g = 0; g < tables->gate_count; g++) {
+        GateInstance gate = tables->gates[g];
+        const int* inputs = tables->gate_inputs.ids + gate.first_input;
+        gate.instance_name = sharded_pool_dense_id(shard_base, gate.instance_name);
+        gate.output_signal = sharded_pool_dense_id(shard_base, gate.output_signal);
+        gate.first_input = ctx->gate_inputs.count;
+        for (int i = 0; i < gate.input_count; i++) {
+            if (!append_parsed_name(&ctx->gate_inputs, sharded_pool_dense_id(shard_base, inputs[i]))) return false;
+        }
+        if (!append_parsed_gate(ctx, &gate)) return false;
+    }
+    return true;
+}
+
+// --- Public Function Implementations ---
+
+int parse_verilog_parallel(ParseContext* ctx, const char* filename, int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads == 1) return parse_verilog_module(ctx, filename);
+
+    VerilogLexer file;
+    if (lexer_open(&file, filename) != 0) {
+        perror("Error opening Verilog file");
+        return 1;
+    }
+
+    reset_parsed_data(ctx);
+    ShardedStringPool* names = create_sharded_pool();
+    ParseChunk* chunks = (ParseChunk*)calloc((size_t)threads + 1, sizeof(ParseChunk));
+    int chunk_count = 0;
+    int status = 1;
+    if (!names || !chunks) goto out_of_memory;
+
+    // 1. Header, serially; chunks[0] stops at the first gate
+    ParseChunk* header = &chunks[0];
+    header->data = file.data;
+    header->size = file.size;
+    header->first_line = 1;
+    header->names = names;
+    header->tables = (ParseContext*)calloc(1, sizeof(ParseContext));
+    chunk_count = 1;
+    if (!header->tables) goto out_of_memory;
+    header->tables->module_name = -1;
+
+    size_t gate_start = 0;
+    if (parse_chunk(header, &gate_start) != 0 || header->failed) goto out_of_memory;
+    header->size = gate_start;
+
+    const char* start = file.data + gate_start;
+    const char* end = file.data + file.size;
+    size_t gate_bytes = (size_t)(end - start);
+    int pieces = threads;
+    if ((size_t)pieces > gate_bytes / PARALLEL_PARSE_MIN_CHUNK) pieces = (int)(gate_bytes / PARALLEL_PARSE_MIN_CHUNK);
+    if (pieces < 2 || contains_block_comment(start, gate_bytes)) {
+        // Not worth splitting, or not safely splittable
+        for (int i = 0; i < chunk_count; i++) destroy_parse_context(chunks[i].tables);
+        free(chunks);
+        destroy_sharded_pool(names);
+        lexer_close(&file);
+        return parse_verilog_module(ctx, filename);
+    }
+
+    // 2. Cut the gate section at statement boundaries
+    const char* chunk_start = start;
+    for (int k = 1; k <= pieces; k++) {
+        const char* chunk_end = (k == pieces) ? end : next_statement_boundary(start + gate_bytes / (size_t)pieces * (size_t)k, start, end);
+        if (chunk_end <= chunk_start) continue;
+
+        ParseChunk* chunk = &chunks[chunk_count++];
+        chunk->data = chunk_start;
+        chunk->size = (size_t)(chunk_end - chunk_start);
+        chunk->names = names;
+        chunk->tables = (ParseContext*)calloc(1, sizeof(ParseContext));
+        if (!chunk->tables) goto out_of_memory;
+        chunk->tables->module_name = -1;
+        chunk_start = chunk_end;
+    }
+
+    // 3. Line numbers for messages, then tokenize every chunk in parallel
+    run_chunks(chunks + 1, chunk_count - 1, count_lines_thread);
+    int line = 1 + count_newlines(header->data, header->size);
+    for (int i = 1; i < chunk_count; i++) {
+        chunks[i].first_line = line;
+        line += chunks[i].newline_count;
+    }
+    run_chunks(chunks + 1, chunk_count - 1, parse_chunk_thread);
+    for (int i = 1; i < chunk_count; i++) {
+        if (chunks[i].failed) goto out_of_memory;
+    }
+
+    // 4. Dense IDs, then concatenate the tables in file order
+    int shard_base[STRING_POOL_SHARDS];
+    if (sharded_pool_flatten(names, ctx->names, shard_base) != 0) goto out_of_memory;
+    for (int i = 0; i < chunk_count; i++) {
+        if (!merge_tables(ctx, chunks[i].tables, shard_base)) goto out_of_memory;
+    }
+    status = 0;
+    goto cleanup;
+
+out_of_memory:
+    fprintf(stderr, "Error: Out of memory while parsing %s\n", filename);
+    reset_parsed_data(ctx);
+
+cleanup:
+    for (int i = 0; i < chunk_count; i++) destroy_parse_context(chunks[i].tables);
+    free(chunks);
+    destroy_sharded_pool(names);
+    lexer_close(&file);
+    return status;
+}
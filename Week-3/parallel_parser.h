@@ -0,0 +1,32 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include "verilog_parser.h"
+
+// Multi-threaded loading of large flat netlists.
+//
+// The header (module, input, output and wire declarations up to the first gate)
+// is parsed serially. The rest of the mapped file is cut at statement (';')
+// boundaries into one chunk per thread; each thread tokenizes its chunk into
+// its own gate and name-ID tables, interning names through a sharded pool.
+// The tables are then concatenated in file order and the IDs renumbered
+// densely, so the context holds the same statements in the same order as a
+// serial parse_verilog_module().
+
+#define PARALLEL_PARSE_MIN_BYTES (8 * 1024 * 1024)   // Below this, one thread is faster
+#define PARALLEL_PARSE_MIN_CHUNK (256 * 1024)        // Smallest chunk worth a thread
+
+/**
+ * @brief Parses a Verilog file on several threads.
+ *
+ * Falls back to the serial parser for one thread, for gate sections too small
+ * to split, and when the gate section contains block comments (a ';' inside
+ * one could not be told apart from a statement end without a full scan).
+ * @param ctx The context to fill (previous contents are discarded).
+ * @param filename The path to the Verilog file.
+ * @param threads Worker threads (<= 0: one per online CPU).
+ * @return 0 on success, 1 if the file cannot be read or memory runs out.
+ */
+int parse_verilog_parallel(ParseContext* ctx, const char* filename, int threads);
+
+#endif // PARALLEL_PARSER_H
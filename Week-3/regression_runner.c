@@ -0,0 +1,588 @@
+// Multi-netlist regression runner.
+//
+// Usage: regression_runner <manifest> [--threads N] [--chunk VECTORS]
+//
+// Each manifest line names a job: "<netlist> <stimulus> [expected]", where the
+// netlist is Verilog or .bench (bench_parser.h).
+// Paths are relative to the manifest's directory; '#' starts a comment and
+// "-" (or a missing third column) skips the response comparison. Stimulus
+// and expected files use the vector/response format of the batch pipeline;
+// any of the files may be gzip- or zstd-compressed.
+//
+// All jobs share one work-stealing pool. Every distinct netlist is parsed
+// once and reused by all jobs that name it; each job's vectors are split into
+// chunks so that even a handful of jobs keeps every core busy.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "verilog_parser.h"
+#include "bench_parser.h"
+#include "circuit_node.h"
+#include "circuit_builder.h"
+#include "hierarchy.h"
+#include "input_stream.h"
+#include "netlist_cache.h"
+#include "sim_trace.h"
+#include "levelizer.h"
+#include "sim_pipeline.h"
+#include "spsc_ring.h"
+#include "thread_pool.h"
+
+#define MAX_MANIFEST_LINE 4096
+#define DEFAULT_CHUNK_VECTORS 2048
+
+typedef struct {
+    char* path;
+    Circuit* circuit;
+    Levelization* levels;
+    bool loaded;
+    double load_seconds;
+} SharedNetlist;
+
+typedef struct {
+    int line_number;
+    char* netlist_path;
+    char* stimulus_path;
+    char* expected_path;          // NULL when responses are not checked
+    SharedNetlist* netlist;
+
+    // Loaded by the job task
+    SignalValue* vectors;         // vector_count * pi_count
+    long long vector_count;
+    long long invalid_lines;
+    char* expected_text;
+    const char** expected_lines;
+    long long expected_count;
+
+    // Results (guarded by lock)
+    pthread_mutex_t lock;
+    long long mismatches;
+    long long first_mismatch;     // Vector index, -1 if none
+    int chunks_remaining;
+    double start_time;
+    double end_time;
+    bool failed;                  // Could not run (I/O or netlist error)
+    char error[160];
+} RegressionJob;
+
+typedef struct {
+    RegressionJob* job;
+    long long first;
+    long long count;
+} ChunkTask;
+
+typedef struct {
+    ThreadPool* pool;
+    RegressionJob* jobs;
+    int job_count;
+    SharedNetlist* netlists;
+    int netlist_count;
+    long long chunk_vectors;
+    bool locks_initialized;       // Job locks exist (set once the manifest is complete)
+} Regression;
+
+static Regression* current_regression = NULL;
+
+static char* duplicate_string(const char* text) {
+    size_t length = strlen(text);
+    char* copy = (char*)malloc(length + 1);
+    if (copy) memcpy(copy, text, length + 1);
+    return copy;
+}
+
+// Joins a manifest-relative path with the manifest's directory
+static char* resolve_path(const char* manifest_path, const char* path) {
+    const char* slash = strrchr(manifest_path, '/');
+    if (path[0] == '/' || !slash) return duplicate_string(path);
+
+    size_t dir_length = (size_t)(slash - manifest_path) + 1;
+    char* joined = (char*)malloc(dir_length + strlen(path) + 1);
+    if (!joined) return NULL;
+    memcpy(joined, manifest_path, dir_length);
+    strcpy(joined + dir_length, path);
+    return joined;
+}
+
+// Stimulus and expected files may be compressed
+static char* read_whole_file(const char* path, size_t* length) {
+    InputStream* stream = open_input_stream(path);
+    if (!stream) return NULL;
+    char* data = read_entire_stream(stream, length);
+    close_input_stream(stream);
+    return data;
+}
+
+static void job_fail(RegressionJob* job, const char* message, const char* detail) {
+    job->failed = true;
+    snprintf(job->error, sizeof(job->error), "%s%s%s", message, detail ? ": " : "", detail ? detail : "");
+}
+
+// --- Tasks ---
+static void load_netlist_task(void* arg, int worker_index) {
+    trace_name_thread("pool", worker_index);
+    SharedNetlist* netlist = (SharedNetlist*)arg;
+    double start = monotonic_seconds();
+    double trace_begin = TRACE_BEGIN();
+
+    // Builds share no parser state, so netlists load in parallel; a current
+    // compiled netlist (netlist_cache.h) skips the build altogether
+    NetlistSummary summary;
+    uint64_t source_hash = hash_netlist_source(netlist->path);
+    if (source_hash) {
+        netlist->circuit = load_netlist_cache(netlist->path, source_hash, &summary, &netlist->levels);
+    }
+    if (!netlist->circuit) {
+        if (detect_netlist_format(netlist->path) == NETLIST_BENCH) {
+            netlist->circuit = build_circuit_from_bench_file(netlist->path, false, &summary);
+        } else {
+            netlist->circuit = build_circuit_from_file(netlist->path, false, &summary);
+        }
+        if (!netlist->circuit && summary.hierarchical) {
+            // The pipeline simulates flat circuits
+            Design* design = load_design(netlist->path);
+            netlist->circuit = flatten_design(design);
+            if (design) summarize_design(design, &summary);
+            destroy_design(design);
+        }
+        if (netlist->circuit) {
+            double levelize_begin = TRACE_BEGIN();
+            netlist->levels = levelize_circuit(netlist->circuit);
+            TRACE_END("levelize", levelize_begin);
+            if (netlist->levels && source_hash) {
+                save_netlist_cache(netlist->path, source_hash, netlist->circuit, &summary, netlist->levels);
+            }
+        }
+    }
+    netlist->loaded = (netlist->circuit && netlist->levels && netlist->levels->is_acyclic);
+    netlist->load_seconds = monotonic_seconds() - start;
+    TRACE_END("load netlist", trace_begin);
+}
+
+static void finish_chunk(RegressionJob* job) {
+    pthread_mutex_lock(&job->lock);
+    if (--job->chunks_remaining == 0) job->end_time = monotonic_seconds();
+    pthread_mutex_unlock(&job->lock);
+}
+
+// Compares one response with its expected line (trailing whitespace ignored)
+static bool response_matches(const SignalValue* outputs, int po_count, const char* expected) {
+    int i = 0;
+    for (; i < po_count; i++) {
+        char c = expected[i];
+        if (c == 'x') c = 'X';
+        if (c != signal_value_to_char(outputs[i])) return false;
+    }
+    for (; expected[i] && expected[i] != '\n'; i++) {
+        if (expected[i] != ' ' && expected[i] != '\t' && expected[i] != '\r') return false;
+    }
+    return true;
+}
+
+static void simulate_chunk_task(void* arg, int worker_index) {
+    trace_name_thread("pool", worker_index);
+    ChunkTask* chunk = (ChunkTask*)arg;
+    RegressionJob* job = chunk->job;
+    const Circuit* circuit = job->netlist->circuit;
+    int pi_count = circuit->pi_count;
+    int po_count = circuit->po_count;
+
+    SignalValue* values = (SignalValue*)malloc((circuit->node_count + 1) * sizeof(SignalValue));
+    SignalValue* outputs = (SignalValue*)malloc((po_count + 1) * sizeof(SignalValue));
+    if (!values || !outputs) {
+        pthread_mutex_lock(&job->lock);
+        job_fail(job, "Out of memory simulating chunk", NULL);
+        pthread_mutex_unlock(&job->lock);
+        free(values);
+        free(outputs);
+        free(chunk);
+        finish_chunk(job);
+        return;
+    }
+    for (int i = 0; i < circuit->node_count; i++) values[i] = LOGIC_X;
+
+    long long mismatches = 0;
+    long long first_mismatch = -1;
+    double trace_begin = TRACE_BEGIN();
+    for (long long v = chunk->first; v < chunk->first + chunk->count; v++) {
+        const SignalValue* inputs = job->vectors + v * pi_count;
+        for (int i = 0; i < pi_count; i++) values[circuit->primary_inputs[i]] = inputs[i];
+        evaluate_levelized_values(circuit, job->netlist->levels, values);
+
+        if (job->expected_lines) {
+            for (int i = 0; i < po_count; i++) outputs[i] = values[circuit->primary_outputs[i]];
+            if (!response_matches(outputs, po_count, job->expected_lines[v])) {
+                if (first_mismatch < 0) first_mismatch = v;
+                mismatches++;
+            }
+        }
+    }
+    TRACE_END("simulate chunk", trace_begin);
+
+    pthread_mutex_lock(&job->lock);
+    job->mismatches += mismatches;
+    if (first_mismatch >= 0 && (job->first_mismatch < 0 || first_mismatch < job->first_mismatch)) {
+        job->first_mismatch = first_mismatch;
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    free(values);
+    free(outputs);
+    free(chunk);
+    finish_chunk(job);
+}
+
+// Splits the text into lines; keeps only lines that are not blank or comments
+static const char** split_expected_lines(char* text, long long* count) {
+    long long capacity = 1024;
+    long long used = 0;
+    const char** lines = (const char**)malloc(capacity * sizeof(char*));
+    char* line = text;
+    while (lines && *line) {
+        char* end = strchr(line, '\n');
+        char* next = end ? end + 1 : line + strlen(line);
+        char* first = line;
+        while (*first == ' ' || *first == '\t' || *first == '\r') first++;
+        bool skip = (first == next || *first == '\n' || *first == '\0' || *first == '#' ||
+                     (first[0] == '/' && first[1] == '/'));
+        if (!skip) {
+            if (used == capacity) {
+                capacity *= 2;
+                const char** grown = (const char**)realloc(lines, capacity * sizeof(char*));
+                if (!grown) {
+                    free(lines);
+                    return NULL;
+                }
+                lines = grown;
+            }
+            lines[used++] = first;
+        }
+        line = next;
+    }
+    *count = used;
+    return lines;
+}
+
+static void run_job_task(void* arg, int worker_index) {
+    trace_name_thread("pool", worker_index);
+    RegressionJob* job = (RegressionJob*)arg;
+    Regression* regression = current_regression;
+    job->start_time = monotonic_seconds();
+    job->end_time = job->start_time;
+
+    if (!job->netlist->loaded) {
+        job_fail(job, "Netlist failed to load or is cyclic", job->netlist_path);
+        return;
+    }
+    const Circuit* circuit = job->netlist->circuit;
+    int pi_count = circuit->pi_count;
+
+    // Stimulus
+    size_t length = 0;
+    double trace_begin = TRACE_BEGIN();
+    char* text = read_whole_file(job->stimulus_path, &length);
+    TRACE_END("read stimulus", trace_begin);
+    if (!text) {
+        job_fail(job, "Cannot read stimulus", job->stimulus_path);
+        return;
+    }
+    long long capacity = 1024;
+    job->vectors = (SignalValue*)malloc(capacity * (pi_count + 1) * sizeof(SignalValue));
+    for (char* line = text; job->vectors && line < text + length;) {
+        char* end = memchr(line, '\n', (size_t)(text + length - line));
+        if (!end) end = text + length;
+        if (job->vector_count == capacity) {
+            capacity *= 2;
+            SignalValue* grown = (SignalValue*)realloc(job->vectors, capacity * (pi_count + 1) * sizeof(SignalValue));
+            if (!grown) {
+                free(job->vectors);
+                job->vectors = NULL;
+                break;
+            }
+            job->vectors = grown;
+        }
+        int status = parse_vector_line(line, end, pi_count, job->vectors + job->vector_count * pi_count);
+        if (status > 0) job->vector_count++;
+        else if (status < 0) job->invalid_lines++;
+        line = end + 1;
+    }
+    free(text);
+    if (!job->vectors) {
+        job_fail(job, "Out of memory reading stimulus", job->stimulus_path);
+        return;
+    }
+
+    // Expected responses
+    if (job->expected_path) {
+        job->expected_text = read_whole_file(job->expected_path, &length);
+        if (!job->expected_text) {
+            job_fail(job, "Cannot read expected responses", job->expected_path);
+            return;
+        }
+        job->expected_lines = split_expected_lines(job->expected_text, &job->expected_count);
+        if (!job->expected_lines) {
+            job_fail(job, "Out of memory reading expected responses", job->expected_path);
+            return;
+        }
+        if (job->expected_count != job->vector_count) {
+            char detail[96];
+            snprintf(detail, sizeof(detail), "%lld expected lines for %lld vectors",
+                     job->expected_count, job->vector_count);
+            job_fail(job, "Response count mismatch", detail);
+            return;
+        }
+    }
+
+    if (job->vector_count == 0) return;
+
+    // Fan the vectors out as chunk tasks on this worker's deque
+    long long chunk_vectors = regression->chunk_vectors;
+    job->chunks_remaining = (int)((job->vector_count + chunk_vectors - 1) / chunk_vectors);
+    for (long long first = 0; first < job->vector_count; first += chunk_vectors) {
+        ChunkTask* chunk = (ChunkTask*)malloc(sizeof(ChunkTask));
+        if (chunk) {
+            chunk->job = job;
+            chunk->first = first;
+            chunk->count = (job->vector_count - first < chunk_vectors) ? job->vector_count - first : chunk_vectors;
+        }
+        if (!chunk || !thread_pool_submit(regression->pool, simulate_chunk_task, chunk)) {
+            free(chunk);
+            pthread_mutex_lock(&job->lock);
+            job_fail(job, "Failed to queue simulation chunk", NULL);
+            pthread_mutex_unlock(&job->lock);
+            finish_chunk(job);
+        }
+    }
+}
+
+// --- Manifest ---
+static SharedNetlist* find_or_add_netlist(Regression* regression, const char* path, int* capacity) {
+    for (int i = 0; i < regression->netlist_count; i++) {
+        if (strcmp(regression->netlists[i].path, path) == 0) return &regression->netlists[i];
+    }
+    if (regression->netlist_count == *capacity) {
+        *capacity *= 2;
+        SharedNetlist* grown = (SharedNetlist*)realloc(regression->netlists, *capacity * sizeof(SharedNetlist));
+        if (!grown) return NULL;
+        regression->netlists = grown;
+    }
+    SharedNetlist* netlist = &regression->netlists[regression->netlist_count];
+    memset(netlist, 0, sizeof(*netlist));
+    netlist->path = duplicate_string(path);
+    if (!netlist->path) return NULL;
+    regression->netlist_count++;
+    return netlist;
+}
+
+static int read_manifest(Regression* regression, const char* manifest_path) {
+    FILE* file = fopen(manifest_path, "r");
+    if (!file) {
+        perror("Error opening manifest");
+        return 1;
+    }
+
+    int job_capacity = 16;
+    int netlist_capacity = 16;
+    regression->jobs = (RegressionJob*)calloc(job_capacity, sizeof(RegressionJob));
+    regression->netlists = (SharedNetlist*)calloc(netlist_capacity, sizeof(SharedNetlist));
+
+    char line[MAX_MANIFEST_LINE];
+    int line_number = 0;
+    bool ok = (regression->jobs && regression->netlists);
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char* saveptr;
+        char* netlist = strtok_r(line, " \t\r\n", &saveptr);
+        if (!netlist) continue;
+        char* stimulus = strtok_r(NULL, " \t\r\n", &saveptr);
+        char* expected = strtok_r(NULL, " \t\r\n", &saveptr);
+        if (!stimulus) {
+            fprintf(stderr, "Warning: Manifest line %d has no stimulus, skipping\n", line_number);
+            continue;
+        }
+
+        if (regression->job_count == job_capacity) {
+            job_capacity *= 2;
+            RegressionJob* grown = (RegressionJob*)realloc(regression->jobs, job_capacity * sizeof(RegressionJob));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            regression->jobs = grown;
+        }
+
+        RegressionJob* job = &regression->jobs[regression->job_count];
+        memset(job, 0, sizeof(*job));
+        job->line_number = line_number;
+        job->netlist_path = resolve_path(manifest_path, netlist);
+        job->stimulus_path = resolve_path(manifest_path, stimulus);
+        job->expected_path = (expected && strcmp(expected, "-") != 0) ? resolve_path(manifest_path, expected) : NULL;
+        job->first_mismatch = -1;
+        job->netlist = job->netlist_path ? find_or_add_netlist(regression, job->netlist_path, &netlist_capacity) : NULL;
+        if (!job->netlist || !job->stimulus_path || (expected && strcmp(expected, "-") != 0 && !job->expected_path)) {
+            free(job->netlist_path);
+            free(job->stimulus_path);
+            free(job->expected_path);
+            ok = false;
+            break;
+        }
+        regression->job_count++;
+    }
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Error: Out of memory reading manifest %s (line %d)\n", manifest_path, line_number);
+        return 1;
+    }
+
+    // Netlists may have moved while growing; re-link by path
+    for (int i = 0; i < regression->job_count; i++) {
+        regression->jobs[i].netlist = find_or_add_netlist(regression, regression->jobs[i].netlist_path, &netlist_capacity);
+    }
+    // Only now that jobs[] no longer moves: a mutex must not be moved once initialized
+    for (int i = 0; i < regression->job_count; i++) pthread_mutex_init(&regression->jobs[i].lock, NULL);
+    regression->locks_initialized = true;
+    return 0;
+}
+
+static void print_summary(const Regression* regression, double wall_seconds) {
+    long long total_vectors = 0;
+    int failures = 0;
+
+    printf("=== Regression Summary ===\n");
+    printf("%-4s | %-24s | %-24s | %-9s | %-10s | %-6s | %-10s | %-12s\n",
+           "Job", "Netlist", "Stimulus", "Vectors", "Mismatches", "Result", "Wall (ms)", "Vectors/s");
+    printf("-----+--------------------------+--------------------------+-----------+------------+--------+------------+-------------\n");
+    for (int i = 0; i < regression->job_count; i++) {
+        const RegressionJob* job = &regression->jobs[i];
+        double wall = job->end_time - job->start_time;
+        double rate = wall > 0.0 ? (double)job->vector_count / wall : 0.0;
+        const char* result = job->failed ? "ERROR" :
+                             (job->mismatches > 0 || job->invalid_lines > 0) ? "FAIL" :
+                             job->expected_path ? "PASS" : "RAN";
+        if (job->failed || job->mismatches > 0 || job->invalid_lines > 0) failures++;
+
+        const char* netlist_name = strrchr(job->netlist_path, '/');
+        const char* stimulus_name = strrchr(job->stimulus_path, '/');
+        printf("%-4d | %-24.24s | %-24.24s | %-9lld | %-10lld | %-6s | %-10.2f | %-12.0f\n",
+               i + 1, netlist_name ? netlist_name + 1 : job->netlist_path,
+               stimulus_name ? stimulus_name + 1 : job->stimulus_path,
+               job->vector_count, job->mismatches, result, wall * 1000.0, rate);
+        if (job->failed) {
+            printf("       %s\n", job->error);
+        } else if (job->first_mismatch >= 0) {
+            printf("       first mismatch at vector %lld\n", job->first_mismatch + 1);
+        }
+        if (job->invalid_lines > 0) {
+            printf("       %lld malformed stimulus lines\n", job->invalid_lines);
+        }
+        total_vectors += job->vector_count;
+    }
+
+    double load_seconds = 0.0;
+    for (int i = 0; i < regression->netlist_count; i++) load_seconds += regression->netlists[i].load_seconds;
+
+    printf("\nJobs: %d (%d failed), Netlists parsed: %d (%.2f ms total)\n",
+           regression->job_count, failures, regression->netlist_count, load_seconds * 1000.0);
+    printf("Threads: %d, Steals: %lld\n", thread_pool_size(regression->pool), thread_pool_steal_count(regression->pool));
+    printf("Total: %lld vectors in %.3f s (%.0f vectors/s)\n", total_vectors, wall_seconds,
+           wall_seconds > 0.0 ? (double)total_vectors / wall_seconds : 0.0);
+}
+
+static void free_regression(Regression* regression) {
+    for (int i = 0; i < regression->job_count; i++) {
+        RegressionJob* job = &regression->jobs[i];
+        free(job->netlist_path);
+        free(job->stimulus_path);
+        free(job->expected_path);
+        free(job->vectors);
+        free(job->expected_text);
+        free((void*)job->expected_lines);
+        if (regression->locks_initialized) pthread_mutex_destroy(&job->lock);
+    }
+    for (int i = 0; i < regression->netlist_count; i++) {
+        free(regression->netlists[i].path);
+        destroy_levelization(regression->netlists[i].levels);
+        destroy_circuit(regression->netlists[i].circuit);
+    }
+    free(regression->jobs);
+    free(regression->netlists);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <manifest> [--threads N] [--chunk VECTORS] [--trace FILE]\n", argv[0]);
+        return 1;
+    }
+
+    int thread_count = 0;   // All online CPUs
+    long long chunk_vectors = DEFAULT_CHUNK_VECTORS;
+    const char* trace_file = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunk_vectors = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (chunk_vectors <= 0) chunk_vectors = DEFAULT_CHUNK_VECTORS;
+    if (trace_file) start_trace("regression_runner");
+
+    Regression regression;
+    memset(&regression, 0, sizeof(regression));
+    regression.chunk_vectors = chunk_vectors;
+    if (read_manifest(&regression, argv[1]) != 0) {
+        free_regression(&regression);
+        return 1;
+    }
+    if (regression.job_count == 0) {
+        fprintf(stderr, "Error: Manifest %s lists no jobs\n", argv[1]);
+        free_regression(&regression);
+        return 1;
+    }
+
+    regression.pool = thread_pool_create(thread_count);
+    if (!regression.pool) {
+        fprintf(stderr, "Error: Failed to start thread pool\n");
+        free_regression(&regression);
+        return 1;
+    }
+    current_regression = &regression;
+
+    double start = monotonic_seconds();
+
+    // 1. Parse every distinct netlist once
+    for (int i = 0; i < regression.netlist_count; i++) {
+        thread_pool_submit(regression.pool, load_netlist_task, &regression.netlists[i]);
+    }
+    thread_pool_wait(regression.pool);
+
+    // 2. Run all jobs; each fans out into chunk tasks
+    for (int i = 0; i < regression.job_count; i++) {
+        thread_pool_submit(regression.pool, run_job_task, &regression.jobs[i]);
+    }
+    thread_pool_wait(regression.pool);
+
+    double wall = monotonic_seconds() - start;
+    print_summary(&regression, wall);
+
+    int failures = 0;
+    for (int i = 0; i < regression.job_count; i++) {
+        const RegressionJob* job = &regression.jobs[i];
+        if (job->failed || job->mismatches > 0 || job->invalid_lines > 0) failures++;
+    }
+
+    thread_pool_destroy(regression.pool);
+    free_regression(&regression);
+    if (trace_file && write_trace(trace_file) != 0) return 1;
+    return failures > 0 ? 1 : 0;
+}
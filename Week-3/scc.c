@@ -0,0 +1,314 @@
+#include "scc.h"
+#include "sim_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SCC_SWEEPS 1024          // Sweeps remembered per component before giving up
+#define MAX_REPORTED_MEMBERS 16
+
+typedef struct {
+    int node;
+    const ConnectionNode* next_edge;
+} TarjanFrame;
+
+static bool feeds_itself(const Circuit* circuit, int node_id) {
+    for (const ConnectionNode* out = circuit->nodes[node_id].fanout_list; out; out = out->next) {
+        if (out->node_id == node_id) return true;
+    }
+    return false;
+}
+
+SccDecomposition* compute_sccs(const Circuit* circuit) {
+    if (!circuit) return NULL;
+    int n = circuit->node_count;
+    size_t slots = (size_t)(n > 0 ? n : 1);
+
+    SccDecomposition* scc = (SccDecomposition*)calloc(1, sizeof(SccDecomposition));
+    int* index = (int*)malloc(slots * sizeof(int));
+    int* lowlink = (int*)malloc(slots * sizeof(int));
+    bool* on_stack = (bool*)calloc(slots, sizeof(bool));
+    int* stack = (int*)malloc(slots * sizeof(int));
+    TarjanFrame* frames = (TarjanFrame*)malloc(slots * sizeof(TarjanFrame));
+    int* found = (int*)malloc(slots * sizeof(int));   // Component in discovery (reverse topological) order
+    if (scc) {
+        scc->component = (int*)malloc(slots * sizeof(int));
+        scc->members = (int*)malloc(slots * sizeof(int));
+        scc->start = (int*)calloc(slots + 1, sizeof(int));
+        scc->cyclic = (bool*)calloc(slots, sizeof(bool));
+    }
+    if (!scc || !index || !lowlink || !on_stack || !stack || !frames || !found ||
+        !scc->component || !scc->members || !scc->start || !scc->cyclic) {
+        destroy_scc_decomposition(scc);
+        scc = NULL;
+        goto cleanup;
+    }
+    scc->node_count = n;
+
+    for (int i = 0; i < n; i++) index[i] = -1;
+
+    int counter = 0;
+    int stack_top = 0;
+    int found_count = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1) continue;
+
+        int depth = 0;
+        frames[depth].node = root;
+        frames[depth].next_edge = circuit->nodes[root].fanout_list;
+        index[root] = lowlink[root] = counter++;
+        stack[stack_top++] = root;
+        on_stack[root] = true;
+
+        while (depth >= 0) {
+            TarjanFrame* frame = &frames[depth];
+            int v = frame->node;
+
+            if (frame->next_edge) {
+                int w = frame->next_edge->node_id;
+                frame->next_edge = frame->next_edge->next;
+                if (index[w] == -1) {
+                    index[w] = lowlink[w] = counter++;
+                    stack[stack_top++] = w;
+                    on_stack[w] = true;
+                    depth++;
+                    frames[depth].node = w;
+                    frames[depth].next_edge = circuit->nodes[w].fanout_list;
+                } else if (on_stack[w] && index[w] < lowlink[v]) {
+                    lowlink[v] = index[w];
+                }
+                continue;
+            }
+
+            // All successors done: v roots a component if nothing reached above it
+            if (lowlink[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--stack_top];
+                    on_stack[w] = false;
+                    found[w] = found_count;
+                } while (w != v);
+                found_count++;
+            }
+            depth--;
+            if (depth >= 0 && lowlink[v] < lowlink[frames[depth].node]) {
+                lowlink[frames[depth].node] = lowlink[v];
+            }
+        }
+    }
+
+    // Tarjan emits sinks first; reverse for topological order of the SCC DAG
+    scc->component_count = found_count;
+    for (int i = 0; i < n; i++) {
+        scc->component[i] = found_count - 1 - found[i];
+        scc->start[scc->component[i] + 1]++;
+    }
+    for (int c = 0; c < found_count; c++) scc->start[c + 1] += scc->start[c];
+
+    int* fill = found;   // Reuse as insertion cursor per component
+    for (int c = 0; c < found_count; c++) fill[c] = scc->start[c];
+    for (int i = 0; i < n; i++) scc->members[fill[scc->component[i]]++] = i;
+
+    for (int c = 0; c < found_count; c++) {
+        int size = scc->start[c + 1] - scc->start[c];
+        scc->cyclic[c] = size > 1 || feeds_itself(circuit, scc->members[scc->start[c]]);
+        if (scc->cyclic[c]) {
+            scc->cyclic_count++;
+            scc->cyclic_nodes += size;
+            if (size > scc->largest_component) scc->largest_component = size;
+        }
+    }
+
+cleanup:
+    free(index);
+    free(lowlink);
+    free(on_stack);
+    free(stack);
+    free(frames);
+    free(found);
+    return scc;
+}
+
+void destroy_scc_decomposition(SccDecomposition* scc) {
+    if (!scc) return;
+    free(scc->component);
+    free(scc->members);
+    free(scc->start);
+    free(scc->cyclic);
+    free(scc);
+}
+
+static uint64_t hash_component_state(const int* members, int size, const SignalValue* values) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < size; i++) {
+        hash ^= (uint64_t)values[members[i]];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// One Gauss-Seidel sweep over a component in ID order; returns whether anything changed
+static bool sweep_component(const Circuit* circuit, const int* members, int size, SignalValue* values) {
+    long long visited = 0;
+    long long changed = 0;
+    long long fanouts = 0;
+    for (int i = 0; i < size; i++) {
+        int id = members[i];
+        if (circuit->nodes[id].type == NODE_PI) continue;
+        visited++;
+        SignalValue value = evaluate_node_with_values(circuit, id, values);
+        if (values[id] != value) {
+            values[id] = value;
+            changed++;
+            fanouts += circuit->nodes[id].fanout_count;
+        }
+    }
+    SIM_STAT_ADD(nodes_visited, visited);
+    SIM_STAT_ADD(events_scheduled, changed);
+    SIM_STAT_ADD(events_processed, fanouts);
+    SIM_STAT_ADD(fixed_point_iterations, 1);
+    return changed > 0;
+}
+
+// Iterates one cyclic component to a fixed point. Returns false if it oscillated.
+static bool settle_component(const Circuit* circuit, const int* members, int size,
+                             SignalValue* values, uint64_t* history, SccSimStats* stats) {
+    int sweeps = 0;
+    int repeat_at = -1;
+
+    while (sweeps < MAX_SCC_SWEEPS) {
+        bool changed = sweep_component(circuit, members, size, values);
+        sweeps++;
+        if (!changed) {
+            if (stats) stats->sweeps += sweeps;
+            return true;
+        }
+
+        uint64_t state = hash_component_state(members, size, values);
+        for (int s = 0; s < sweeps - 1; s++) {
+            if (history[s] == state) {
+                repeat_at = s;
+                break;
+            }
+        }
+        if (repeat_at >= 0) break;
+        history[sweeps - 1] = state;
+    }
+
+    // Oscillation: one more period shows which nodes toggle
+    int period = repeat_at >= 0 ? sweeps - 1 - repeat_at : 1;
+    int toggling = 0;
+    SignalValue* before = (SignalValue*)malloc((size_t)size * sizeof(SignalValue));
+    if (before) {
+        for (int i = 0; i < size; i++) before[i] = values[members[i]];
+        bool* toggles = (bool*)calloc((size_t)size, sizeof(bool));
+        for (int p = 0; p < period && toggles; p++) {
+            sweep_component(circuit, members, size, values);
+            for (int i = 0; i < size; i++) {
+                if (values[members[i]] != before[i]) toggles[i] = true;
+            }
+        }
+        for (int i = 0; toggles && i < size; i++) {
+            if (toggles[i]) toggling++;
+        }
+        free(toggles);
+        free(before);
+    }
+
+    // Restart from all-X: ternary gates are monotone, so this settles in at
+    // most size + 1 sweeps and leaves exactly the undetermined nodes at X
+    for (int i = 0; i < size; i++) {
+        if (circuit->nodes[members[i]].type != NODE_PI) values[members[i]] = LOGIC_X;
+    }
+    int x_sweeps = 0;
+    while (sweep_component(circuit, members, size, values) && x_sweeps <= size) x_sweeps++;
+
+    if (stats) {
+        stats->sweeps += sweeps + period + x_sweeps + 1;
+        stats->oscillating_components++;
+        stats->oscillating_nodes += toggling;
+    }
+    return false;
+}
+
+bool evaluate_scc_values(const Circuit* circuit, const SccDecomposition* scc,
+                         SignalValue* values, SccSimStats* stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!circuit || !scc || scc->node_count != circuit->node_count) return false;
+
+    uint64_t* history = NULL;
+    if (scc->cyclic_count > 0) {
+        history = (uint64_t*)malloc(MAX_SCC_SWEEPS * sizeof(uint64_t));
+        if (!history) return false;
+    }
+
+    bool settled = true;
+    long long visited = 0;
+    long long changed = 0;
+    long long fanouts = 0;
+    for (int c = 0; c < scc->component_count; c++) {
+        const int* members = scc->members + scc->start[c];
+        int size = scc->start[c + 1] - scc->start[c];
+
+        if (!scc->cyclic[c]) {
+            int id = members[0];
+            if (circuit->nodes[id].type != NODE_PI) {
+                SignalValue value = evaluate_node_with_values(circuit, id, values);
+                if (values[id] != value) {
+                    changed++;
+                    fanouts += circuit->nodes[id].fanout_count;
+                }
+                values[id] = value;
+                visited++;
+            }
+            continue;
+        }
+        if (!settle_component(circuit, members, size, values, history, stats)) settled = false;
+    }
+    SIM_STAT_ADD(nodes_visited, visited);
+    SIM_STAT_ADD(events_scheduled, changed);
+    SIM_STAT_ADD(events_processed, fanouts);
+
+    free(history);
+    return settled;
+}
+
+bool simulate_scc(Circuit* circuit, const SccDecomposition* scc, SccSimStats* stats) {
+    if (!circuit || !scc) return false;
+
+    SignalValue* values = (SignalValue*)malloc((circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(SignalValue));
+    if (!values) return false;
+    for (int i = 0; i < circuit->node_count; i++) values[i] = circuit->nodes[i].value;
+
+    bool settled = evaluate_scc_values(circuit, scc, values, stats);
+
+    for (int i = 0; i < circuit->node_count; i++) {
+        CircuitNode* node = &circuit->nodes[i];
+        node->value = values[i];
+        node->is_evaluated = (node->type != NODE_PI && node->type != NODE_BRNH && node->gate_type != GATE_UNKNOWN);
+    }
+    circuit->iteration_count = 1;
+    circuit->simulation_stable = settled;
+    free(values);
+    return settled;
+}
+
+void print_scc_report(const Circuit* circuit, const SccDecomposition* scc) {
+    if (!circuit || !scc) return;
+
+    printf("## Combinational Loops\n");
+    printf("Components: %d, Cyclic: %d (%d nodes, largest %d)\n",
+           scc->component_count, scc->cyclic_count, scc->cyclic_nodes, scc->largest_component);
+
+    for (int c = 0; c < scc->component_count; c++) {
+        if (!scc->cyclic[c]) continue;
+        int size = scc->start[c + 1] - scc->start[c];
+        printf("  SCC %d (%d node%s):", c, size, size == 1 ? "" : "s");
+        for (int i = 0; i < size && i < MAX_REPORTED_MEMBERS; i++) {
+            printf(" %s", circuit->nodes[scc->members[scc->start[c] + i]].name);
+        }
+        if (size > MAX_REPORTED_MEMBERS) printf(" ... (+%d)", size - MAX_REPORTED_MEMBERS);
+        printf("\n");
+    }
+    printf("\n");
+}
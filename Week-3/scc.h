@@ -0,0 +1,68 @@
+#ifndef SCC_H
+#define SCC_H
+
+#include "circuit_node.h"
+#include <stdbool.h>
+
+// Strongly connected component analysis for circuits with combinational loops.
+//
+// Tarjan's algorithm (iterative, so deep netlists cannot overflow the C stack)
+// splits the circuit into SCCs. Components are stored in topological order of
+// the SCC DAG: every acyclic node is then evaluated exactly once, and
+// fixed-point iteration is confined to the cyclic components. Each cyclic
+// component detects oscillation by remembering the states it has already been
+// in; nodes that keep toggling are forced to X.
+
+typedef struct {
+    int component_count;
+    int* component;        // Component index of each node
+    int* members;          // Node IDs grouped by component (IDs ascending within a component)
+    int* start;            // Component c owns members[start[c] .. start[c+1]-1]
+    bool* cyclic;          // More than one node, or a node that feeds itself
+    int cyclic_count;      // Number of cyclic components
+    int cyclic_nodes;      // Nodes inside cyclic components
+    int largest_component; // Size of the largest cyclic component (0 if none)
+    int node_count;
+} SccDecomposition;
+
+typedef struct {
+    int sweeps;                 // Sweeps over cyclic components (summed)
+    int oscillating_components; // Components whose state repeated without settling
+    int oscillating_nodes;      // Nodes forced to X because they kept toggling
+} SccSimStats;
+
+/**
+ * @brief Computes the SCCs of a built circuit.
+ * @param circuit The circuit.
+ * @return New decomposition, or NULL on allocation failure.
+ */
+SccDecomposition* compute_sccs(const Circuit* circuit);
+
+/**
+ * @brief Frees a decomposition.
+ */
+void destroy_scc_decomposition(SccDecomposition* scc);
+
+/**
+ * @brief Evaluates all nodes in SCC order on a private array (thread-safe).
+ * @param circuit The circuit (read only).
+ * @param scc Its decomposition.
+ * @param values Node values indexed by ID; PIs must be set, others are updated.
+ * @param stats Receives sweep and oscillation counts (may be NULL).
+ * @return true if every cyclic component settled.
+ */
+bool evaluate_scc_values(const Circuit* circuit, const SccDecomposition* scc,
+                         SignalValue* values, SccSimStats* stats);
+
+/**
+ * @brief Simulates the circuit in SCC order, updating node->value.
+ * @return true if every cyclic component settled (as simulate_circuit()).
+ */
+bool simulate_scc(Circuit* circuit, const SccDecomposition* scc, SccSimStats* stats);
+
+/**
+ * @brief Prints the cyclic components and their member nodes.
+ */
+void print_scc_report(const Circuit* circuit, const SccDecomposition* scc);
+
+#endif // SCC_H
@@ -0,0 +1,302 @@
+#include "signal_probability.h"
+#include "splitmix.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Above this many bytes of stem sets every node is treated as reconvergent
+#define COP_MAX_STEM_SET_BYTES (256u * 1024u * 1024u)
+
+static double pi_probability(const double* pi_probabilities, int index) {
+    if (!pi_probabilities) return COP_DEFAULT_PI_PROBABILITY;
+    double p = pi_probabilities[index];
+    if (p < 0.0) return 0.0;
+    if (p > 1.0) return 1.0;
+    return p;
+}
+
+// Probability of a gate output being 1 from independent input probabilities.
+// Gates the simulator evaluates to X (gate_arity_valid()) count as unknown: 0.5.
+static double gate_probability(GateType gate_type, const double inputs[], int input_count) {
+    if (!gate_arity_valid(gate_type, input_count)) return COP_DEFAULT_PI_PROBABILITY;
+
+    double p = inputs[0];
+    switch (gate_type) {
+        case GATE_AND:
+        case GATE_NAND:
+            for (int i = 1; i < input_count; i++) p *= inputs[i];
+            return (gate_type == GATE_NAND) ? 1.0 - p : p;
+        case GATE_OR:
+        case GATE_NOR: {
+            double all_zero = 1.0 - p;
+            for (int i = 1; i < input_count; i++) all_zero *= 1.0 - inputs[i];
+            return (gate_type == GATE_NOR) ? all_zero : 1.0 - all_zero;
+        }
+        case GATE_XOR:
+        case GATE_XNOR:
+            p = p + inputs[1] - 2.0 * p * inputs[1];
+            return (gate_type == GATE_XNOR) ? 1.0 - p : p;
+        case GATE_NOT:  return 1.0 - p;
+        case GATE_BUFF: return p;
+        default:        return COP_DEFAULT_PI_PROBABILITY;
+    }
+}
+
+int compute_signal_probabilities(const Circuit* circuit, const Levelization* levels,
+                                 const double* pi_probabilities, double* probabilities) {
+    if (!circuit || !levels || !probabilities || levels->node_count != circuit->node_count) {
+        return -1;
+    }
+
+    for (int i = 0; i < circuit->node_count; i++) {
+        probabilities[i] = COP_DEFAULT_PI_PROBABILITY;
+    }
+    for (int i = 0; i < circuit->pi_count; i++) {
+        probabilities[circuit->primary_inputs[i]] = pi_probability(pi_probabilities, i);
+    }
+
+    int widest = max_fanin_count(circuit);
+    double* inputs = (double*)malloc((size_t)(widest > 0 ? widest : 1) * sizeof(double));
+    if (!inputs) return -1;
+    for (int i = 0; i < levels->order_count; i++) {
+        int id = levels->order[i];
+        const CircuitNode* node = &circuit->nodes[id];
+
+        if (node->type == NODE_PI || !node->fanin_list) continue;
+        if (node->type == NODE_BRNH) {
+            probabilities[id] = probabilities[node->fanin_list->node_id];
+            continue;
+        }
+
+        int input_count = 0;
+        for (const ConnectionNode* fanin = node->fanin_list; fanin && input_count < widest; fanin = fanin->next) {
+            inputs[input_count++] = probabilities[fanin->node_id];
+        }
+        probabilities[id] = gate_probability(node->gate_type, inputs, input_count);
+    }
+    free(inputs);
+    return 0;
+}
+
+// 64 independent bits, each 1 with probability q / 65536
+static uint64_t biased_random_word(uint64_t* state, unsigned int q) {
+    if (q == 0) return 0;
+    if (q >= 65536) return ~(uint64_t)0;
+
+    uint64_t word = 0;
+    for (int bit = 0; bit < 16; bit++) {
+        uint64_t r = next_random(state);
+        word = ((q >> bit) & 1) ? (word | r) : (word & r);
+    }
+    return word;
+}
+
+static bool is_fanout_stem(const Circuit* circuit, int id) {
+    for (const ConnectionNode* fanout = circuit->nodes[id].fanout_list; fanout; fanout = fanout->next) {
+        if (circuit->nodes[fanout->node_id].type == NODE_BRNH) return true;
+    }
+    return false;
+}
+
+// Marks gates whose fanins share a fanout stem (reconvergence points).
+// Returns the number of stems found, or -1 if the stem sets would not fit in
+// memory, in which case every driven node is marked.
+static int find_reconvergent_gates(const Circuit* circuit, const Levelization* levels, unsigned char* reconvergent) {
+    int n = circuit->node_count;
+    int* stem_index = (int*)malloc(n * sizeof(int));
+    if (!stem_index) return -1;
+
+    int stem_count = 0;
+    for (int i = 0; i < n; i++) {
+        stem_index[i] = is_fanout_stem(circuit, i) ? stem_count++ : -1;
+    }
+
+    size_t words = (size_t)(stem_count + 63) / 64;
+    if (words == 0) {
+        // No fanout stems: nothing can reconverge
+        free(stem_index);
+        return 0;
+    }
+
+    uint64_t* stem_sets = NULL;
+    if ((size_t)n * words * sizeof(uint64_t) <= COP_MAX_STEM_SET_BYTES) {
+        stem_sets = (uint64_t*)calloc((size_t)n * words, sizeof(uint64_t));
+    }
+    if (!stem_sets) {
+        for (int i = 0; i < n; i++) {
+            reconvergent[i] = (circuit->nodes[i].type != NODE_PI && circuit->nodes[i].fanin_list != NULL);
+        }
+        free(stem_index);
+        return -1;
+    }
+
+    uint64_t* seen = (uint64_t*)malloc(words * sizeof(uint64_t));
+    if (!seen) {
+        free(stem_sets);
+        free(stem_index);
+        return -1;
+    }
+
+    // Stem set of a node = stems in its fanin cone; a gate reconverges when
+    // two of its fanins' stem sets intersect
+    for (int i = 0; i < levels->order_count; i++) {
+        int id = levels->order[i];
+        const CircuitNode* node = &circuit->nodes[id];
+        uint64_t* own = stem_sets + (size_t)id * words;
+
+        memset(seen, 0, words * sizeof(uint64_t));
+        if (node->type != NODE_PI) {
+            for (const ConnectionNode* fanin = node->fanin_list; fanin; fanin = fanin->next) {
+                const uint64_t* in = stem_sets + (size_t)fanin->node_id * words;
+                for (size_t w = 0; w < words; w++) {
+                    if (seen[w] & in[w]) reconvergent[id] = 1;
+                    seen[w] |= in[w];
+                }
+            }
+        }
+        memcpy(own, seen, words * sizeof(uint64_t));
+        if (stem_index[id] >= 0) own[stem_index[id] / 64] |= (uint64_t)1 << (stem_index[id] % 64);
+    }
+
+    free(seen);
+    free(stem_sets);
+    free(stem_index);
+    return stem_count;
+}
+
+int correct_reconvergent_probabilities(const Circuit* circuit, const Levelization* levels,
+                                       const double* pi_probabilities, double* probabilities,
+                                       int sample_words, uint64_t seed, CopCorrectionStats* stats) {
+    if (!circuit || !levels || !levels->is_acyclic || !probabilities || sample_words <= 0 ||
+        levels->node_count != circuit->node_count) {
+        return -1;
+    }
+
+    int n = circuit->node_count;
+    unsigned char* reconvergent = (unsigned char*)calloc(n, 1);
+    unsigned char* affected = (unsigned char*)calloc(n, 1);
+    unsigned char* needed = (unsigned char*)calloc(n, 1);
+    int* sim_order = (int*)malloc(n * sizeof(int));
+    uint64_t* words = (uint64_t*)malloc(n * sizeof(uint64_t));
+    long long* ones = (long long*)calloc(n, sizeof(long long));
+    unsigned int* pi_threshold = (unsigned int*)malloc((circuit->pi_count > 0 ? circuit->pi_count : 1) * sizeof(unsigned int));
+    int* pi_slot = (int*)malloc(n * sizeof(int));
+    int widest = max_fanin_count(circuit);
+    uint64_t* inputs = (uint64_t*)malloc((size_t)(widest > 0 ? widest : 1) * sizeof(uint64_t));
+    int result = -1;
+
+    if (!reconvergent || !affected || !needed || !sim_order || !words || !ones || !pi_threshold || !pi_slot || !inputs) {
+        goto cleanup;
+    }
+
+    CopCorrectionStats local = {0, 0, 0, 0, 0};
+    local.fanout_stems = find_reconvergent_gates(circuit, levels, reconvergent);
+
+    // Everything downstream of a reconvergence point inherits the error
+    for (int i = 0; i < levels->order_count; i++) {
+        int id = levels->order[i];
+        const CircuitNode* node = &circuit->nodes[id];
+        if (reconvergent[id]) {
+            affected[id] = 1;
+            local.reconvergent_gates++;
+        } else if (node->type != NODE_PI) {
+            for (const ConnectionNode* fanin = node->fanin_list; fanin; fanin = fanin->next) {
+                if (affected[fanin->node_id]) {
+                    affected[id] = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Only the fanin cones of affected nodes need to be sampled
+    for (int i = levels->order_count - 1; i >= 0; i--) {
+        int id = levels->order[i];
+        if (!affected[id] && !needed[id]) continue;
+        needed[id] = 1;
+        if (circuit->nodes[id].type == NODE_PI) continue;
+        for (const ConnectionNode* fanin = circuit->nodes[id].fanin_list; fanin; fanin = fanin->next) {
+            needed[fanin->node_id] = 1;
+        }
+    }
+
+    int sim_count = 0;
+    for (int i = 0; i < levels->order_count; i++) {
+        if (needed[levels->order[i]]) sim_order[sim_count++] = levels->order[i];
+    }
+
+    for (int i = 0; i < n; i++) pi_slot[i] = -1;
+    for (int i = 0; i < circuit->pi_count; i++) {
+        double p = pi_probability(pi_probabilities, i);
+        pi_threshold[i] = (unsigned int)(p * 65536.0 + 0.5);
+        pi_slot[circuit->primary_inputs[i]] = i;
+    }
+
+    uint64_t state = seed;
+    for (int s = 0; s < sample_words; s++) {
+        for (int i = 0; i < sim_count; i++) {
+            int id = sim_order[i];
+            const CircuitNode* node = &circuit->nodes[id];
+            uint64_t word;
+
+            if (node->type == NODE_PI) {
+                word = biased_random_word(&state, pi_threshold[pi_slot[id]]);
+            } else if (!node->fanin_list) {
+                word = next_random(&state);   // Undriven: unknown, assume 0.5
+            } else if (node->type == NODE_BRNH) {
+                word = words[node->fanin_list->node_id];
+            } else {
+                int input_count = 0;
+                for (const ConnectionNode* fanin = node->fanin_list; fanin && input_count < widest; fanin = fanin->next) {
+                    inputs[input_count++] = words[fanin->node_id];
+                }
+                // An X output is sampled like an undriven node
+                word = gate_arity_valid(node->gate_type, input_count)
+                    ? evaluate_gate_bits(node->gate_type, inputs, input_count) : next_random(&state);
+            }
+
+            words[id] = word;
+            if (affected[id]) ones[id] += __builtin_popcountll(word);
+        }
+    }
+
+    double total = (double)sample_words * 64.0;
+    for (int i = 0; i < n; i++) {
+        if (affected[i]) {
+            probabilities[i] = (double)ones[i] / total;
+            local.corrected_nodes++;
+        }
+    }
+    local.simulated_nodes = sim_count;
+    local.samples = (long long)sample_words * 64;
+    if (stats) *stats = local;
+    result = 0;
+
+cleanup:
+    free(reconvergent);
+    free(affected);
+    free(needed);
+    free(sim_order);
+    free(words);
+    free(ones);
+    free(pi_threshold);
+    free(pi_slot);
+    free(inputs);
+    return result;
+}
+
+void print_signal_probabilities(const Circuit* circuit, const double* probabilities) {
+    if (!circuit || !probabilities) return;
+
+    printf("=== Signal Probabilities ===\n");
+    printf("%-15s | %-4s | %-8s | %-8s\n", "Name", "Type", "P(1)", "P(0)");
+    printf("----------------+------+----------+----------\n");
+    for (int i = 0; i < circuit->node_count; i++) {
+        const CircuitNode* node = &circuit->nodes[i];
+        const char* type_str = (node->type == NODE_PI) ? "PI" :
+                              (node->type == NODE_PO) ? "PO" :
+                              (node->type == NODE_BRNH) ? "BRNH" : "GATE";
+        printf("%-15s | %-4s | %-8.4f | %-8.4f\n", node->name, type_str, probabilities[i], 1.0 - probabilities[i]);
+    }
+    printf("\n");
+}
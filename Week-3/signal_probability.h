@@ -0,0 +1,63 @@
+#ifndef SIGNAL_PROBABILITY_H
+#define SIGNAL_PROBABILITY_H
+
+#include "circuit_node.h"
+#include "levelizer.h"
+#include <stdint.h>
+
+// Signal probability (COP) estimation.
+//
+// The analytic pass visits nodes once in level order and combines fanin
+// probabilities assuming independent inputs, so it is linear in the circuit
+// size. That assumption breaks where fanout stems reconverge; the optional
+// correction pass finds those reconvergent gates and replaces the estimates at
+// and below them with bit-parallel Monte Carlo measurements (64 patterns per
+// machine word). Gates the simulator evaluates to X whatever their inputs
+// (gate_arity_valid()) are unknown: 0.5 analytically, random bits when sampled.
+
+#define COP_DEFAULT_PI_PROBABILITY 0.5
+
+// Summary of a correction run
+typedef struct {
+    int fanout_stems;         // Nodes driving more than one branch (-1: too many, all nodes sampled)
+    int reconvergent_gates;   // Gates whose fanins share a stem
+    int corrected_nodes;      // Nodes whose estimate was replaced by sampling
+    int simulated_nodes;      // Nodes evaluated per sample word
+    long long samples;        // Patterns simulated
+} CopCorrectionStats;
+
+/**
+ * @brief Analytic COP pass: probability of every node being 1.
+ * @param circuit The circuit.
+ * @param levels Levelization of the circuit. Nodes on loops keep 0.5.
+ * @param pi_probabilities One probability per primary input, or NULL for 0.5 each.
+ * @param probabilities Output array of circuit->node_count entries.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int compute_signal_probabilities(const Circuit* circuit, const Levelization* levels,
+                                 const double* pi_probabilities, double* probabilities);
+
+/**
+ * @brief Monte Carlo correction of nodes affected by reconvergent fanout.
+ *
+ * Call after compute_signal_probabilities(). Only the fanin cones of the
+ * affected nodes are simulated.
+ * @param circuit The circuit.
+ * @param levels Levelization of the circuit (must be acyclic).
+ * @param pi_probabilities One probability per primary input, or NULL for 0.5 each.
+ * @param probabilities Analytic estimates, updated in place.
+ * @param sample_words Number of 64-pattern words to simulate.
+ * @param seed Random seed (same seed gives the same estimates).
+ * @param stats Optional summary of the run.
+ * @return 0 on success, -1 on error.
+ */
+int correct_reconvergent_probabilities(const Circuit* circuit, const Levelization* levels,
+                                       const double* pi_probabilities, double* probabilities,
+                                       int sample_words, uint64_t seed, CopCorrectionStats* stats);
+
+/**
+ * @brief Prints the probability of each node being 1 (and 0).
+ */
+void print_signal_probabilities(const Circuit* circuit, const double* probabilities);
+
+#endif // SIGNAL_PROBABILITY_H
@@ -0,0 +1,193 @@
+#include "sim_cache.h"
+#include "sim_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct SimCacheEntry {
+    uint64_t hash;
+    SimCacheEntry* chain_next;   // Next entry in the same bucket
+    SimCacheEntry* lru_prev;
+    SimCacheEntry* lru_next;
+    uint64_t data[];             // key_words key words, then value_words value words
+};
+
+// 64-bit multiply/xor-shift mix over the packed key words
+static uint64_t hash_packed(const uint64_t* words, int count) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t)count;
+    for (int i = 0; i < count; i++) {
+        uint64_t k = words[i];
+        k *= 0xBF58476D1CE4E5B9ULL;
+        k ^= k >> 31;
+        h = (h ^ k) * 0x94D049BB133111EBULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+static SimCacheEntry* entry_at(const SimCache* cache, size_t index) {
+    return (SimCacheEntry*)(cache->entry_pool + index * cache->entry_size);
+}
+
+static void lru_unlink(SimCache* cache, SimCacheEntry* entry) {
+    if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+    else cache->lru_head = entry->lru_next;
+    if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+    else cache->lru_tail = entry->lru_prev;
+}
+
+static void lru_push_front(SimCache* cache, SimCacheEntry* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->lru_prev = entry;
+    cache->lru_head = entry;
+    if (!cache->lru_tail) cache->lru_tail = entry;
+}
+
+static void chain_remove(SimCache* cache, SimCacheEntry* entry) {
+    SimCacheEntry** link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link) {
+        if (*link == entry) {
+            *link = entry->chain_next;
+            return;
+        }
+        link = &(*link)->chain_next;
+    }
+}
+
+SimCache* sim_cache_create(int pi_count, int po_count, size_t memory_budget) {
+    if (pi_count < 0 || po_count < 0) return NULL;
+
+    int key_words = 2 * PACKED_WORDS(pi_count);
+    int value_words = 2 * PACKED_WORDS(po_count);
+    size_t entry_size = sizeof(SimCacheEntry) + (size_t)(key_words + value_words) * sizeof(uint64_t);
+
+    // Each entry also needs roughly one bucket pointer (load factor <= 1)
+    size_t capacity = memory_budget / (entry_size + sizeof(SimCacheEntry*));
+    if (capacity == 0) {
+        fprintf(stderr, "Error: Cache budget of %zu bytes cannot hold one entry (%zu bytes)\n",
+                memory_budget, entry_size);
+        return NULL;
+    }
+
+    size_t bucket_count = 1;
+    while (bucket_count < capacity) bucket_count <<= 1;
+    // Keep buckets within budget when rounding up overshoots it
+    if (bucket_count > capacity && capacity * entry_size + bucket_count * sizeof(SimCacheEntry*) > memory_budget) {
+        bucket_count >>= 1;
+    }
+
+    SimCache* cache = (SimCache*)calloc(1, sizeof(SimCache));
+    if (!cache) return NULL;
+
+    cache->pi_count = pi_count;
+    cache->po_count = po_count;
+    cache->key_words = key_words;
+    cache->value_words = value_words;
+    cache->entry_size = entry_size;
+    cache->capacity = capacity;
+    cache->bucket_count = bucket_count;
+    cache->entry_pool = (unsigned char*)malloc(capacity * entry_size);
+    cache->buckets = (SimCacheEntry**)calloc(bucket_count, sizeof(SimCacheEntry*));
+
+    if (!cache->entry_pool || !cache->buckets) {
+        sim_cache_destroy(cache);
+        return NULL;
+    }
+
+    sim_cache_clear(cache);
+    return cache;
+}
+
+void sim_cache_destroy(SimCache* cache) {
+    if (!cache) return;
+    free(cache->entry_pool);
+    free(cache->buckets);
+    free(cache);
+}
+
+void sim_cache_clear(SimCache* cache) {
+    if (!cache) return;
+
+    memset(cache->buckets, 0, cache->bucket_count * sizeof(SimCacheEntry*));
+    cache->free_list = NULL;
+    for (size_t i = cache->capacity; i > 0; i--) {
+        SimCacheEntry* entry = entry_at(cache, i - 1);
+        entry->chain_next = cache->free_list;
+        cache->free_list = entry;
+    }
+    cache->lru_head = NULL;
+    cache->lru_tail = NULL;
+    cache->entry_count = 0;
+}
+
+static SimCacheEntry* find_entry(const SimCache* cache, const uint64_t* key, uint64_t hash) {
+    SimCacheEntry* entry = cache->buckets[hash & (cache->bucket_count - 1)];
+    size_t key_bytes = (size_t)cache->key_words * sizeof(uint64_t);
+    while (entry) {
+        if (entry->hash == hash && memcmp(entry->data, key, key_bytes) == 0) {
+            return entry;
+        }
+        entry = entry->chain_next;
+    }
+    return NULL;
+}
+
+bool sim_cache_lookup(SimCache* cache, const uint64_t* packed_inputs, uint64_t* packed_outputs) {
+    if (!cache || !packed_inputs) return false;
+
+    uint64_t hash = hash_packed(packed_inputs, cache->key_words);
+    SimCacheEntry* entry = find_entry(cache, packed_inputs, hash);
+    if (!entry) {
+        cache->misses++;
+        SIM_STAT_ADD(sim_cache_misses, 1);
+        return false;
+    }
+
+    cache->hits++;
+    SIM_STAT_ADD(sim_cache_hits, 1);
+    if (cache->lru_head != entry) {
+        lru_unlink(cache, entry);
+        lru_push_front(cache, entry);
+    }
+    if (packed_outputs) {
+        memcpy(packed_outputs, entry->data + cache->key_words,
+               (size_t)cache->value_words * sizeof(uint64_t));
+    }
+    return true;
+}
+
+void sim_cache_insert(SimCache* cache, const uint64_t* packed_inputs, const uint64_t* packed_outputs) {
+    if (!cache || !packed_inputs || !packed_outputs) return;
+
+    uint64_t hash = hash_packed(packed_inputs, cache->key_words);
+    SimCacheEntry* entry = find_entry(cache, packed_inputs, hash);
+
+    if (entry) {
+        // Refresh an existing entry in place
+        lru_unlink(cache, entry);
+    } else {
+        if (cache->free_list) {
+            entry = cache->free_list;
+            cache->free_list = entry->chain_next;
+            cache->entry_count++;
+        } else {
+            // Evict the least recently used entry and reuse its slot
+            entry = cache->lru_tail;
+            lru_unlink(cache, entry);
+            chain_remove(cache, entry);
+            cache->evictions++;
+        }
+
+        entry->hash = hash;
+        memcpy(entry->data, packed_inputs, (size_t)cache->key_words * sizeof(uint64_t));
+        SimCacheEntry** bucket = &cache->buckets[hash & (cache->bucket_count - 1)];
+        entry->chain_next = *bucket;
+        *bucket = entry;
+        cache->insertions++;
+    }
+
+    memcpy(entry->data + cache->key_words, packed_outputs,
+           (size_t)cache->value_words * sizeof(uint64_t));
+    lru_push_front(cache, entry);
+}
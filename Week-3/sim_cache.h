@@ -0,0 +1,80 @@
+#ifndef SIM_CACHE_H
+#define SIM_CACHE_H
+
+#include "circuit_node.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded LRU cache of simulation results.
+//
+// Keys are packed PI vectors and values are packed PO vectors (see
+// pack_signal_values()), so a lookup costs one hash over a few 64-bit words
+// plus a memcmp, independent of the circuit size. All entries are carved out
+// of a single allocation sized from the memory budget at creation time.
+
+typedef struct SimCacheEntry SimCacheEntry;
+
+typedef struct {
+    int pi_count;
+    int po_count;
+    int key_words;               // 2 * PACKED_WORDS(pi_count)
+    int value_words;             // 2 * PACKED_WORDS(po_count)
+    size_t entry_size;           // Bytes per entry including key/value payload
+
+    // Storage
+    unsigned char* entry_pool;   // capacity entries of entry_size bytes
+    SimCacheEntry** buckets;     // Hash chains
+    size_t bucket_count;         // Power of two
+    size_t capacity;             // Maximum number of entries
+    size_t entry_count;          // Entries currently in use
+    SimCacheEntry* free_list;
+
+    // LRU list: head is most recently used, tail is the eviction candidate
+    SimCacheEntry* lru_head;
+    SimCacheEntry* lru_tail;
+
+    // Statistics
+    long long hits;
+    long long misses;
+    long long insertions;
+    long long evictions;
+} SimCache;
+
+/**
+ * @brief Creates a result cache for a circuit shape.
+ * @param pi_count Number of primary inputs (key size).
+ * @param po_count Number of primary outputs (value size).
+ * @param memory_budget Maximum bytes used by entries and hash buckets.
+ * @return New cache, or NULL if the budget cannot hold a single entry.
+ */
+SimCache* sim_cache_create(int pi_count, int po_count, size_t memory_budget);
+
+/**
+ * @brief Frees the cache and all of its entries.
+ */
+void sim_cache_destroy(SimCache* cache);
+
+/**
+ * @brief Looks up a packed PI vector.
+ * @param cache The cache.
+ * @param packed_inputs Key of cache->key_words words.
+ * @param packed_outputs Receives cache->value_words words on a hit.
+ * @return true on a hit (the entry becomes most recently used).
+ */
+bool sim_cache_lookup(SimCache* cache, const uint64_t* packed_inputs, uint64_t* packed_outputs);
+
+/**
+ * @brief Stores the result for a packed PI vector, evicting the LRU entry if full.
+ * @param cache The cache.
+ * @param packed_inputs Key of cache->key_words words.
+ * @param packed_outputs Value of cache->value_words words.
+ */
+void sim_cache_insert(SimCache* cache, const uint64_t* packed_inputs, const uint64_t* packed_outputs);
+
+/**
+ * @brief Drops every entry but keeps the statistics.
+ */
+void sim_cache_clear(SimCache* cache);
+
+#endif // SIM_CACHE_H
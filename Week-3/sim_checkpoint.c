@@ -0,0 +1,160 @@
+#include "sim_checkpoint.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void pack_circuit_values(const Circuit* circuit, int words, uint64_t* packed) {
+    uint64_t* value_plane = packed;
+    uint64_t* x_plane = packed + words;
+    memset(packed, 0, 2 * (size_t)words * sizeof(uint64_t));
+
+    for (int i = 0; i < circuit->node_count; i++) {
+        uint64_t bit = (uint64_t)1 << (i & 63);
+        SignalValue value = circuit->nodes[i].value;
+        if (value == LOGIC_1) value_plane[i >> 6] |= bit;
+        else if (value == LOGIC_X) x_plane[i >> 6] |= bit;
+    }
+}
+
+static SignalValue packed_value(const uint64_t* packed, int words, int index) {
+    uint64_t bit = (uint64_t)1 << (index & 63);
+    if (packed[words + (index >> 6)] & bit) return LOGIC_X;
+    return (packed[index >> 6] & bit) ? LOGIC_1 : LOGIC_0;
+}
+
+SimCheckpoint* create_checkpoint(const Circuit* circuit) {
+    if (!circuit) return NULL;
+
+    SimCheckpoint* checkpoint = (SimCheckpoint*)malloc(sizeof(SimCheckpoint));
+    if (!checkpoint) return NULL;
+    checkpoint->node_count = circuit->node_count;
+    checkpoint->words = PACKED_WORDS(circuit->node_count);
+    checkpoint->packed = (uint64_t*)malloc(2 * (size_t)(checkpoint->words > 0 ? checkpoint->words : 1) * sizeof(uint64_t));
+    if (!checkpoint->packed) {
+        free(checkpoint);
+        return NULL;
+    }
+
+    capture_checkpoint(checkpoint, circuit);
+    return checkpoint;
+}
+
+void destroy_checkpoint(SimCheckpoint* checkpoint) {
+    if (!checkpoint) return;
+    free(checkpoint->packed);
+    free(checkpoint);
+}
+
+void capture_checkpoint(SimCheckpoint* checkpoint, const Circuit* circuit) {
+    if (!checkpoint || !circuit || circuit->node_count != checkpoint->node_count) return;
+    pack_circuit_values(circuit, checkpoint->words, checkpoint->packed);
+    checkpoint->simulation_stable = circuit->simulation_stable;
+    checkpoint->iteration_count = circuit->iteration_count;
+}
+
+void restore_checkpoint(const SimCheckpoint* checkpoint, Circuit* circuit) {
+    if (!checkpoint || !circuit || circuit->node_count != checkpoint->node_count) return;
+
+    const uint64_t* value_plane = checkpoint->packed;
+    const uint64_t* x_plane = checkpoint->packed + checkpoint->words;
+    for (int w = 0; w < checkpoint->words; w++) {
+        uint64_t ones = value_plane[w];
+        uint64_t xs = x_plane[w];
+        int base = w << 6;
+        int end = base + 64 < circuit->node_count ? base + 64 : circuit->node_count;
+        for (int i = base; i < end; i++) {
+            uint64_t bit = (uint64_t)1 << (i - base);
+            circuit->nodes[i].value = (xs & bit) ? LOGIC_X : (ones & bit) ? LOGIC_1 : LOGIC_0;
+        }
+    }
+    circuit->simulation_stable = checkpoint->simulation_stable;
+    circuit->iteration_count = checkpoint->iteration_count;
+}
+
+void capture_checkpoint_values(SimCheckpoint* checkpoint, const SignalValue* values) {
+    if (!checkpoint || !values) return;
+    pack_signal_values(values, checkpoint->node_count, checkpoint->packed);
+}
+
+void restore_checkpoint_values(const SimCheckpoint* checkpoint, SignalValue* values) {
+    if (!checkpoint || !values) return;
+    unpack_signal_values(checkpoint->packed, checkpoint->node_count, values);
+}
+
+bool copy_checkpoint(SimCheckpoint* destination, const SimCheckpoint* source) {
+    if (!destination || !source || destination->node_count != source->node_count) return false;
+    memcpy(destination->packed, source->packed, 2 * (size_t)source->words * sizeof(uint64_t));
+    destination->simulation_stable = source->simulation_stable;
+    destination->iteration_count = source->iteration_count;
+    return true;
+}
+
+SimDelta* create_delta(void) {
+    return (SimDelta*)calloc(1, sizeof(SimDelta));
+}
+
+void destroy_delta(SimDelta* delta) {
+    if (!delta) return;
+    free(delta->node_ids);
+    free(delta->values);
+    free(delta->scratch);
+    free(delta);
+}
+
+static bool reserve_delta(SimDelta* delta, int capacity) {
+    if (capacity <= delta->capacity) return true;
+
+    int new_capacity = delta->capacity ? delta->capacity : 64;
+    while (new_capacity < capacity) new_capacity *= 2;
+    int* node_ids = (int*)realloc(delta->node_ids, (size_t)new_capacity * sizeof(int));
+    if (!node_ids) return false;
+    delta->node_ids = node_ids;
+    uint8_t* values = (uint8_t*)realloc(delta->values, (size_t)new_capacity);
+    if (!values) return false;
+    delta->values = values;
+    delta->capacity = new_capacity;
+    return true;
+}
+
+int capture_delta(SimDelta* delta, const SimCheckpoint* base, const Circuit* circuit) {
+    if (!delta || !base || !circuit || circuit->node_count != base->node_count) return -1;
+
+    int words = base->words;
+    if (delta->scratch_words < words) {
+        uint64_t* scratch = (uint64_t*)realloc(delta->scratch, 2 * (size_t)words * sizeof(uint64_t));
+        if (!scratch) return -1;
+        delta->scratch = scratch;
+        delta->scratch_words = words;
+    }
+    pack_circuit_values(circuit, words, delta->scratch);
+
+    delta->count = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t changed = (delta->scratch[w] ^ base->packed[w]) | (delta->scratch[words + w] ^ base->packed[words + w]);
+        while (changed) {
+            int i = (w << 6) + __builtin_ctzll(changed);
+            changed &= changed - 1;
+            if (!reserve_delta(delta, delta->count + 1)) return -1;
+            delta->node_ids[delta->count] = i;
+            delta->values[delta->count] = (uint8_t)circuit->nodes[i].value;
+            delta->count++;
+        }
+    }
+    return delta->count;
+}
+
+void apply_delta(const SimDelta* delta, Circuit* circuit) {
+    if (!delta || !circuit) return;
+    for (int i = 0; i < delta->count; i++) {
+        circuit->nodes[delta->node_ids[i]].value = (SignalValue)delta->values[i];
+    }
+}
+
+void rollback_delta(const SimDelta* delta, const SimCheckpoint* base, Circuit* circuit) {
+    if (!delta || !base || !circuit) return;
+    for (int i = 0; i < delta->count; i++) {
+        int id = delta->node_ids[i];
+        circuit->nodes[id].value = packed_value(base->packed, base->words, id);
+    }
+    circuit->simulation_stable = base->simulation_stable;
+    circuit->iteration_count = base->iteration_count;
+}
@@ -0,0 +1,102 @@
+#ifndef SIM_CHECKPOINT_H
+#define SIM_CHECKPOINT_H
+
+#include "circuit_node.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Simulation state checkpoints.
+//
+// A checkpoint holds every node value in the two-plane packed layout of
+// pack_signal_values() (2 bits per node), plus the simulator's stability flags.
+// Copying a checkpoint is a single memcpy; restoring into a Circuit unpacks the
+// planes into the node structs.
+//
+// A delta records only the nodes that differ from a base checkpoint. Capturing
+// one compares 64 nodes per word, and rolling back touches only the recorded
+// nodes, so fault injection or what-if runs return to the good-machine state
+// in time proportional to what they changed.
+
+typedef struct {
+    int node_count;
+    int words;                 // PACKED_WORDS(node_count)
+    uint64_t* packed;          // Value plane followed by X plane (2 * words)
+    bool simulation_stable;
+    int iteration_count;
+} SimCheckpoint;
+
+typedef struct {
+    int count;
+    int capacity;
+    int* node_ids;             // Changed nodes in ascending ID order
+    uint8_t* values;           // Their SignalValue at capture time
+    uint64_t* scratch;         // Packed current state used for the comparison
+    int scratch_words;
+} SimDelta;
+
+/**
+ * @brief Allocates a checkpoint sized for a circuit and captures its state.
+ * @return New checkpoint, or NULL on allocation failure.
+ */
+SimCheckpoint* create_checkpoint(const Circuit* circuit);
+
+/**
+ * @brief Frees a checkpoint.
+ */
+void destroy_checkpoint(SimCheckpoint* checkpoint);
+
+/**
+ * @brief Overwrites a checkpoint with the circuit's current state.
+ */
+void capture_checkpoint(SimCheckpoint* checkpoint, const Circuit* circuit);
+
+/**
+ * @brief Restores node values and stability flags from a checkpoint.
+ */
+void restore_checkpoint(const SimCheckpoint* checkpoint, Circuit* circuit);
+
+/**
+ * @brief Captures a flat values[] array (as used by the value-array engines).
+ */
+void capture_checkpoint_values(SimCheckpoint* checkpoint, const SignalValue* values);
+
+/**
+ * @brief Restores a flat values[] array.
+ */
+void restore_checkpoint_values(const SimCheckpoint* checkpoint, SignalValue* values);
+
+/**
+ * @brief Copies one checkpoint into another of the same size (one memcpy).
+ * @return false if the sizes differ.
+ */
+bool copy_checkpoint(SimCheckpoint* destination, const SimCheckpoint* source);
+
+/**
+ * @brief Allocates an empty delta.
+ */
+SimDelta* create_delta(void);
+
+/**
+ * @brief Frees a delta.
+ */
+void destroy_delta(SimDelta* delta);
+
+/**
+ * @brief Records the nodes whose current value differs from the base checkpoint.
+ * @return Number of changed nodes, or -1 on allocation failure.
+ */
+int capture_delta(SimDelta* delta, const SimCheckpoint* base, const Circuit* circuit);
+
+/**
+ * @brief Re-applies the recorded values (base state + delta = captured state).
+ */
+void apply_delta(const SimDelta* delta, Circuit* circuit);
+
+/**
+ * @brief Returns the recorded nodes to their base values, touching nothing else.
+ *
+ * Valid when no other nodes changed since capture_delta().
+ */
+void rollback_delta(const SimDelta* delta, const SimCheckpoint* base, Circuit* circuit);
+
+#endif // SIM_CHECKPOINT_H
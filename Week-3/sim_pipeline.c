@@ -0,0 +1,655 @@
+#include "sim_pipeline.h"
+#include "cone_partition.h"
+#include "input_stream.h"
+#include "scc.h"
+#include "sim_cache.h"
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "splitmix.h"
+#include "spsc_ring.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOURCE_CHUNK_BYTES (1 << 20)        // Read size of the file reader
+#define GENERATOR_CHUNK_VECTORS 4096        // Vectors per generated text chunk
+#define RING_CAPACITY 64                    // Items per ring between stages
+#define OUTPUT_BUFFER_BYTES (1 << 20)       // Writer buffer flushed with one fwrite
+#define DEFAULT_BATCH_SIZE 256
+
+// Raw text handed from the source to the packer (always ends at a line break)
+typedef struct {
+    char* data;
+    size_t length;
+} TextChunk;
+
+// Parsed vectors handed from the packer to a worker, then on to the writer
+typedef struct {
+    int count;
+    long long first_index;      // Index of the first vector in the whole run
+    SignalValue* inputs;        // count * pi_count
+    SignalValue* outputs;       // count * po_count
+} VectorBatch;
+
+// A worker's result cache counters, saved before the cache is freed
+typedef struct {
+    long long hits;
+    long long misses;
+    long long insertions;
+    long long evictions;
+    long long entries;
+    long long capacity;
+} CacheCounters;
+
+typedef struct {
+    const Circuit* circuit;
+    const Levelization* levels;
+    const PipelineOptions* options;
+    SimEngine engine;           // Resolved worker engine (never ENGINE_AUTO)
+    ConePartitioning* partitioning;   // ENGINE_PARTITIONED only; shared read only
+    SccDecomposition* scc;      // ENGINE_SCC only; shared read only
+    InputStream* input;         // Vector file, decompressed on the fly
+    int worker_count;
+    int batch_size;
+
+    SpscRing text_ring;         // source -> packer
+    SpscRing* batch_rings;      // packer -> worker i
+    SpscRing* result_rings;     // worker i -> writer
+
+    // Written only by the owning thread, read after join
+    StageCounters source_counters;
+    StageCounters packer_counters;
+    StageCounters* worker_counters;
+    long long invalid_lines;
+    CacheCounters* cache_counters;
+    CrossCheckStats* cross_checks;
+} Pipeline;
+
+typedef struct {
+    Pipeline* pipeline;
+    int index;
+} WorkerArg;
+
+void init_pipeline_options(PipelineOptions* options) {
+    options->vector_file = NULL;
+    options->random_count = 0;
+    options->seed = 1;
+    options->output = stdout;
+    options->worker_count = 1;
+    options->batch_size = DEFAULT_BATCH_SIZE;
+    options->cache_budget = 0;
+    options->cross_check_rate = 0.0;
+    options->engine = NULL;
+}
+
+static void push_chunk(Pipeline* pipeline, char* data, size_t length) {
+    TextChunk* chunk = (TextChunk*)malloc(sizeof(TextChunk));
+    if (!chunk) {
+        fprintf(stderr, "Error: Out of memory in pattern source\n");
+        exit(EXIT_FAILURE);
+    }
+    chunk->data = data;
+    chunk->length = length;
+    pipeline->source_counters.wait_seconds += spsc_ring_push(&pipeline->text_ring, chunk);
+    pipeline->source_counters.items++;
+}
+
+// --- Stage 1: pattern source ---
+static void read_vector_file(Pipeline* pipeline) {
+    char* carry = NULL;
+    size_t carry_length = 0;
+
+    for (;;) {
+        char* buffer = (char*)malloc(carry_length + SOURCE_CHUNK_BYTES);
+        if (!buffer) {
+            fprintf(stderr, "Error: Out of memory reading vector file\n");
+            exit(EXIT_FAILURE);
+        }
+        if (carry) {
+            memcpy(buffer, carry, carry_length);
+            free(carry);
+            carry = NULL;
+        }
+
+        double trace_begin = TRACE_BEGIN();
+        size_t got = read_input_stream(pipeline->input, buffer + carry_length, SOURCE_CHUNK_BYTES);
+        TRACE_END("read vectors", trace_begin);
+        size_t length = carry_length + got;
+        bool at_end = (got < SOURCE_CHUNK_BYTES);
+
+        // Hand over complete lines only; the partial tail starts the next chunk
+        size_t cut = length;
+        if (!at_end) {
+            while (cut > 0 && buffer[cut - 1] != '\n') cut--;
+            if (cut == 0) {
+                // A single line longer than the chunk: keep reading
+                carry = buffer;
+                carry_length = length;
+                continue;
+            }
+        }
+
+        carry_length = length - cut;
+        if (carry_length > 0) {
+            carry = (char*)malloc(carry_length);
+            if (!carry) {
+                fprintf(stderr, "Error: Out of memory reading vector file\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(carry, buffer + cut, carry_length);
+        }
+
+        if (cut > 0) push_chunk(pipeline, buffer, cut);
+        else free(buffer);
+
+        if (at_end) break;
+    }
+    free(carry);
+}
+
+static void generate_vectors(Pipeline* pipeline) {
+    int pi_count = pipeline->circuit->pi_count;
+    long long remaining = pipeline->options->random_count;
+    uint64_t state = pipeline->options->seed;
+
+    while (remaining > 0) {
+        long long count = remaining < GENERATOR_CHUNK_VECTORS ? remaining : GENERATOR_CHUNK_VECTORS;
+        size_t length = (size_t)count * (size_t)(pi_count + 1);
+        char* buffer = (char*)malloc(length > 0 ? length : 1);
+        if (!buffer) {
+            fprintf(stderr, "Error: Out of memory generating vectors\n");
+            exit(EXIT_FAILURE);
+        }
+
+        double trace_begin = TRACE_BEGIN();
+        char* out = buffer;
+        for (long long v = 0; v < count; v++) {
+            uint64_t bits = 0;
+            for (int i = 0; i < pi_count; i++) {
+                if ((i & 63) == 0) bits = next_random(&state);
+                *out++ = (bits & 1) ? '1' : '0';
+                bits >>= 1;
+            }
+            *out++ = '\n';
+        }
+        TRACE_END("generate vectors", trace_begin);
+
+        push_chunk(pipeline, buffer, length);
+        remaining -= count;
+    }
+}
+
+static void* source_thread(void* arg) {
+    Pipeline* pipeline = (Pipeline*)arg;
+    double start = monotonic_seconds();
+    trace_name_thread("source", -1);
+
+    if (pipeline->input) read_vector_file(pipeline);
+    else generate_vectors(pipeline);
+
+    pipeline->source_counters.wait_seconds += spsc_ring_push(&pipeline->text_ring, NULL);
+    pipeline->source_counters.busy_seconds =
+        monotonic_seconds() - start - pipeline->source_counters.wait_seconds;
+    return NULL;
+}
+
+// --- Stage 2: packer ---
+static VectorBatch* create_batch(const Pipeline* pipeline) {
+    VectorBatch* batch = (VectorBatch*)malloc(sizeof(VectorBatch));
+    size_t pi_count = (size_t)pipeline->circuit->pi_count;
+    size_t po_count = (size_t)pipeline->circuit->po_count;
+    if (batch) {
+        batch->count = 0;
+        batch->first_index = 0;
+        batch->inputs = (SignalValue*)malloc((pi_count * pipeline->batch_size + 1) * sizeof(SignalValue));
+        batch->outputs = (SignalValue*)malloc((po_count * pipeline->batch_size + 1) * sizeof(SignalValue));
+    }
+    if (!batch || !batch->inputs || !batch->outputs) {
+        fprintf(stderr, "Error: Out of memory allocating vector batch\n");
+        exit(EXIT_FAILURE);
+    }
+    return batch;
+}
+
+static void destroy_batch(VectorBatch* batch) {
+    if (!batch) return;
+    free(batch->inputs);
+    free(batch->outputs);
+    free(batch);
+}
+
+int parse_vector_line(const char* line, const char* end, int pi_count, SignalValue* values) {
+    while (line < end && (*line == ' ' || *line == '\t' || *line == '\r')) line++;
+    if (line == end || *line == '#' || (end - line >= 2 && line[0] == '/' && line[1] == '/')) {
+        return 0;
+    }
+
+    int count = 0;
+    for (; line < end; line++) {
+        SignalValue value;
+        switch (*line) {
+            case '0': value = LOGIC_0; break;
+            case '1': value = LOGIC_1; break;
+            case 'x':
+            case 'X': value = LOGIC_X; break;
+            case ' ':
+            case '\t':
+            case '\r':
+            case ',': continue;
+            default:  return -1;
+        }
+        if (count == pi_count) return -1;
+        values[count++] = value;
+    }
+    return (count == pi_count) ? 1 : -1;
+}
+
+static void* packer_thread(void* arg) {
+    Pipeline* pipeline = (Pipeline*)arg;
+    StageCounters* counters = &pipeline->packer_counters;
+    int pi_count = pipeline->circuit->pi_count;
+    int next_worker = 0;
+    long long packed = 0;
+    double start = monotonic_seconds();
+    trace_name_thread("packer", -1);
+
+    VectorBatch* batch = create_batch(pipeline);
+    for (;;) {
+        void* item;
+        counters->wait_seconds += spsc_ring_pop(&pipeline->text_ring, &item);
+        if (!item) break;
+
+        TextChunk* chunk = (TextChunk*)item;
+        double trace_begin = TRACE_BEGIN();
+        const char* line = chunk->data;
+        const char* chunk_end = chunk->data + chunk->length;
+        while (line < chunk_end) {
+            const char* line_end = memchr(line, '\n', (size_t)(chunk_end - line));
+            if (!line_end) line_end = chunk_end;
+
+            SignalValue* values = batch->inputs + (size_t)batch->count * pi_count;
+            int status = parse_vector_line(line, line_end, pi_count, values);
+            if (status < 0) {
+                pipeline->invalid_lines++;
+            } else if (status > 0 && ++batch->count == pipeline->batch_size) {
+                counters->wait_seconds += spsc_ring_push(&pipeline->batch_rings[next_worker], batch);
+                counters->items++;
+                SIM_STAT_ADD(batches_queued, 1);
+                next_worker = (next_worker + 1) % pipeline->worker_count;
+                packed += batch->count;
+                batch = create_batch(pipeline);
+                batch->first_index = packed;
+            }
+            line = line_end + 1;
+        }
+        TRACE_END("pack vectors", trace_begin);
+        free(chunk->data);
+        free(chunk);
+    }
+
+    if (batch->count > 0) {
+        counters->wait_seconds += spsc_ring_push(&pipeline->batch_rings[next_worker], batch);
+        counters->items++;
+        SIM_STAT_ADD(batches_queued, 1);
+    } else {
+        destroy_batch(batch);
+    }
+    for (int w = 0; w < pipeline->worker_count; w++) {
+        counters->wait_seconds += spsc_ring_push(&pipeline->batch_rings[w], NULL);
+    }
+
+    counters->busy_seconds = monotonic_seconds() - start - counters->wait_seconds;
+    return NULL;
+}
+
+// --- Stage 3: simulation workers ---
+
+// Simulates one vector in values[] (PIs set, undriven nodes X) with the pipeline's engine
+static void simulate_vector(const Pipeline* pipeline, SignalValue* values) {
+    const Circuit* circuit = pipeline->circuit;
+    switch (pipeline->engine) {
+        case ENGINE_PARTITIONED:
+            for (int p = 0; p < pipeline->partitioning->partition_count; p++) {
+                evaluate_partition_values(circuit, pipeline->partitioning, p, values);
+            }
+            break;
+        case ENGINE_SCC:
+        case ENGINE_ITERATIVE:
+            // Start from X so loop states do not depend on the previous vector
+            for (int i = 0; i < circuit->node_count; i++) {
+                if (circuit->nodes[i].type != NODE_PI) values[i] = LOGIC_X;
+            }
+            if (pipeline->engine == ENGINE_SCC) evaluate_scc_values(circuit, pipeline->scc, values, NULL);
+            else simulate_circuit_values(circuit, values);
+            break;
+        default:
+            evaluate_levelized_values(circuit, pipeline->levels, values);
+            break;
+    }
+}
+
+static void* worker_thread(void* arg) {
+    WorkerArg* worker = (WorkerArg*)arg;
+    Pipeline* pipeline = worker->pipeline;
+    StageCounters* counters = &pipeline->worker_counters[worker->index];
+    const Circuit* circuit = pipeline->circuit;
+    int pi_count = circuit->pi_count;
+    int po_count = circuit->po_count;
+    double start = monotonic_seconds();
+    trace_name_thread("worker", worker->index);
+
+    // Private node values: undriven nodes stay X, everything else is overwritten
+    SignalValue* values = (SignalValue*)malloc((circuit->node_count > 0 ? circuit->node_count : 1) * sizeof(SignalValue));
+    SimCache* cache = NULL;
+    uint64_t* key = NULL;
+    uint64_t* packed_outputs = NULL;
+    if (pipeline->options->cache_budget > 0) {
+        cache = sim_cache_create(pi_count, po_count, pipeline->options->cache_budget / pipeline->worker_count);
+        key = (uint64_t*)malloc(2 * PACKED_WORDS(pi_count + 1) * sizeof(uint64_t));
+        packed_outputs = (uint64_t*)malloc(2 * PACKED_WORDS(po_count + 1) * sizeof(uint64_t));
+        if (!key || !packed_outputs) {
+            sim_cache_destroy(cache);
+            cache = NULL;
+        }
+    }
+    CrossChecker* checker = NULL;
+    if (pipeline->options->cross_check_rate > 0.0) {
+        checker = create_cross_checker(circuit, pipeline->levels, pipeline->options->cross_check_rate,
+                                       pipeline->options->seed + 0x632BE59BD9B4E019ULL * (uint64_t)(worker->index + 1));
+        // Partitions skip logic that reaches no output; compare only what they evaluate
+        if (checker && pipeline->partitioning) checker->scope = pipeline->partitioning->covered;
+    }
+    if (!values || (pipeline->options->cross_check_rate > 0.0 && !checker)) {
+        fprintf(stderr, "Error: Out of memory in simulation worker\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < circuit->node_count; i++) values[i] = LOGIC_X;
+
+    for (;;) {
+        void* item;
+        counters->wait_seconds += spsc_ring_pop(&pipeline->batch_rings[worker->index], &item);
+        if (!item) break;
+
+        VectorBatch* batch = (VectorBatch*)item;
+        double trace_begin = TRACE_BEGIN();
+        for (int v = 0; v < batch->count; v++) {
+            const SignalValue* inputs = batch->inputs + (size_t)v * pi_count;
+            SignalValue* outputs = batch->outputs + (size_t)v * po_count;
+
+            if (cache) {
+                pack_signal_values(inputs, pi_count, key);
+                if (sim_cache_lookup(cache, key, packed_outputs)) {
+                    unpack_signal_values(packed_outputs, po_count, outputs);
+                    if (checker) cross_check_vector(checker, batch->first_index + v, inputs, NULL, outputs);
+                    continue;
+                }
+            }
+
+            for (int i = 0; i < pi_count; i++) values[circuit->primary_inputs[i]] = inputs[i];
+            simulate_vector(pipeline, values);
+            for (int i = 0; i < po_count; i++) outputs[i] = values[circuit->primary_outputs[i]];
+            if (checker) cross_check_vector(checker, batch->first_index + v, inputs, values, outputs);
+
+            if (cache) {
+                pack_signal_values(outputs, po_count, packed_outputs);
+                sim_cache_insert(cache, key, packed_outputs);
+            }
+        }
+        TRACE_END("simulate batch", trace_begin);
+
+        counters->wait_seconds += spsc_ring_push(&pipeline->result_rings[worker->index], batch);
+        counters->items++;
+        SIM_STAT_ADD(batches_simulated, 1);
+    }
+    counters->wait_seconds += spsc_ring_push(&pipeline->result_rings[worker->index], NULL);
+
+    if (cache) {
+        CacheCounters* counts = &pipeline->cache_counters[worker->index];
+        counts->hits = cache->hits;
+        counts->misses = cache->misses;
+        counts->insertions = cache->insertions;
+        counts->evictions = cache->evictions;
+        counts->entries = (long long)cache->entry_count;
+        counts->capacity = (long long)cache->capacity;
+    }
+    if (checker) {
+        pipeline->cross_checks[worker->index] = checker->stats;
+        destroy_cross_checker(checker);
+    }
+    sim_cache_destroy(cache);
+    free(key);
+    free(packed_outputs);
+    free(values);
+
+    counters->busy_seconds = monotonic_seconds() - start - counters->wait_seconds;
+    return NULL;
+}
+
+// --- Stage 4: response writer (runs on the calling thread) ---
+static long long write_responses(Pipeline* pipeline, StageCounters* counters) {
+    int po_count = pipeline->circuit->po_count;
+    size_t capacity = OUTPUT_BUFFER_BYTES;
+    if (capacity < (size_t)po_count + 1) capacity = (size_t)po_count + 1;
+    char* buffer = (char*)malloc(capacity);
+    if (!buffer) {
+        fprintf(stderr, "Error: Out of memory in response writer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t used = 0;
+    long long vectors = 0;
+    double start = monotonic_seconds();
+
+    for (long long sequence = 0;; sequence++) {
+        void* item;
+        counters->wait_seconds += spsc_ring_pop(&pipeline->result_rings[sequence % pipeline->worker_count], &item);
+        if (!item) break;   // Batches are dealt round-robin, so the first end marker is the end
+
+        VectorBatch* batch = (VectorBatch*)item;
+        double trace_begin = TRACE_BEGIN();
+        for (int v = 0; v < batch->count; v++) {
+            if (used + (size_t)po_count + 1 > capacity) {
+                fwrite(buffer, 1, used, pipeline->options->output);
+                used = 0;
+            }
+            const SignalValue* outputs = batch->outputs + (size_t)v * po_count;
+            for (int i = 0; i < po_count; i++) buffer[used++] = signal_value_to_char(outputs[i]);
+            buffer[used++] = '\n';
+        }
+        TRACE_END("write responses", trace_begin);
+        vectors += batch->count;
+        counters->items++;
+        destroy_batch(batch);
+    }
+
+    if (used > 0) fwrite(buffer, 1, used, pipeline->options->output);
+    fflush(pipeline->options->output);
+    free(buffer);
+
+    counters->busy_seconds = monotonic_seconds() - start - counters->wait_seconds;
+    return vectors;
+}
+
+int run_simulation_pipeline(const Circuit* circuit, const Levelization* levels,
+                            const PipelineOptions* options, PipelineStats* stats) {
+    if (!circuit || !levels || !options || !options->output) return 1;
+
+    SimEngine engine = options->engine ? options->engine->engine : ENGINE_AUTO;
+    if (engine == ENGINE_AUTO) engine = levels->is_acyclic ? ENGINE_LEVELIZED : ENGINE_SCC;
+    if ((engine == ENGINE_LEVELIZED || engine == ENGINE_PARTITIONED) && !levels->is_acyclic) {
+        fprintf(stderr, "Error: The %s engine requires an acyclic circuit\n", engine_name(engine));
+        return 1;
+    }
+
+    Pipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.circuit = circuit;
+    pipeline.levels = levels;
+    pipeline.options = options;
+    pipeline.engine = engine;
+    if (engine == ENGINE_PARTITIONED) {
+        int partitions = options->engine->partitions > 0 ? options->engine->partitions : 1;
+        pipeline.partitioning = partition_output_cones(circuit, levels, partitions);
+        if (!pipeline.partitioning) return 1;
+    } else if (engine == ENGINE_SCC) {
+        pipeline.scc = compute_sccs(circuit);
+        if (!pipeline.scc) {
+            fprintf(stderr, "Error: Out of memory computing SCCs\n");
+            return 1;
+        }
+    }
+    pipeline.worker_count = options->worker_count > 0 ? options->worker_count : 1;
+    pipeline.batch_size = options->batch_size > 0 ? options->batch_size : DEFAULT_BATCH_SIZE;
+
+    if (options->vector_file) {
+        pipeline.input = open_input_stream(options->vector_file);
+        if (!pipeline.input) {
+            perror("Error opening vector file");
+            destroy_cone_partitioning(pipeline.partitioning);
+            destroy_scc_decomposition(pipeline.scc);
+            return 1;
+        }
+    }
+
+    int w_count = pipeline.worker_count;
+    pipeline.batch_rings = (SpscRing*)calloc(w_count, sizeof(SpscRing));
+    pipeline.result_rings = (SpscRing*)calloc(w_count, sizeof(SpscRing));
+    pipeline.worker_counters = (StageCounters*)calloc(w_count, sizeof(StageCounters));
+    pipeline.cache_counters = (CacheCounters*)calloc(w_count, sizeof(CacheCounters));
+    pipeline.cross_checks = (CrossCheckStats*)calloc(w_count, sizeof(CrossCheckStats));
+    pthread_t* workers = (pthread_t*)malloc(w_count * sizeof(pthread_t));
+    WorkerArg* worker_args = (WorkerArg*)malloc(w_count * sizeof(WorkerArg));
+
+    bool ok = pipeline.batch_rings && pipeline.result_rings && pipeline.worker_counters &&
+              pipeline.cache_counters && pipeline.cross_checks && workers && worker_args &&
+              spsc_ring_init(&pipeline.text_ring, RING_CAPACITY);
+    for (int w = 0; ok && w < w_count; w++) {
+        init_cross_check_stats(&pipeline.cross_checks[w]);
+        ok = spsc_ring_init(&pipeline.batch_rings[w], RING_CAPACITY) &&
+             spsc_ring_init(&pipeline.result_rings[w], RING_CAPACITY);
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Out of memory setting up simulation pipeline\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = monotonic_seconds();
+    pthread_t source, packer;
+    if (pthread_create(&source, NULL, source_thread, &pipeline) != 0 ||
+        pthread_create(&packer, NULL, packer_thread, &pipeline) != 0) {
+        fprintf(stderr, "Error: Failed to start pipeline threads\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int w = 0; w < w_count; w++) {
+        worker_args[w].pipeline = &pipeline;
+        worker_args[w].index = w;
+        if (pthread_create(&workers[w], NULL, worker_thread, &worker_args[w]) != 0) {
+            fprintf(stderr, "Error: Failed to start simulation worker %d\n", w);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    StageCounters writer_counters;
+    memset(&writer_counters, 0, sizeof(writer_counters));
+    long long vectors = write_responses(&pipeline, &writer_counters);
+
+    pthread_join(source, NULL);
+    pthread_join(packer, NULL);
+    for (int w = 0; w < w_count; w++) pthread_join(workers[w], NULL);
+    double wall = monotonic_seconds() - start;
+
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->engine = engine;
+        stats->vectors = vectors;
+        stats->invalid_lines = pipeline.invalid_lines;
+        stats->wall_seconds = wall;
+        init_cross_check_stats(&stats->cross_check);
+        for (int w = 0; w < w_count; w++) merge_cross_check_stats(&stats->cross_check, &pipeline.cross_checks[w]);
+
+        // Rings are only written by their two stages, which have all been joined
+        pipeline.source_counters.sleep_seconds = pipeline.text_ring.push_sleep_seconds;
+        pipeline.packer_counters.sleep_seconds = pipeline.text_ring.pop_sleep_seconds;
+        for (int w = 0; w < w_count; w++) {
+            pipeline.packer_counters.sleep_seconds += pipeline.batch_rings[w].push_sleep_seconds;
+            pipeline.worker_counters[w].sleep_seconds =
+                pipeline.batch_rings[w].pop_sleep_seconds + pipeline.result_rings[w].push_sleep_seconds;
+            writer_counters.sleep_seconds += pipeline.result_rings[w].pop_sleep_seconds;
+        }
+
+        stats->stages[STAGE_SOURCE] = pipeline.source_counters;
+        stats->stages[STAGE_SOURCE].name = options->vector_file ? "reader" : "generator";
+        stats->stages[STAGE_SOURCE].threads = 1;
+        stats->stages[STAGE_PACKER] = pipeline.packer_counters;
+        stats->stages[STAGE_PACKER].name = "packer";
+        stats->stages[STAGE_PACKER].threads = 1;
+        stats->stages[STAGE_WORKERS].name = "simulate";
+        stats->stages[STAGE_WORKERS].threads = w_count;
+        for (int w = 0; w < w_count; w++) {
+            stats->stages[STAGE_WORKERS].items += pipeline.worker_counters[w].items;
+            stats->stages[STAGE_WORKERS].busy_seconds += pipeline.worker_counters[w].busy_seconds;
+            stats->stages[STAGE_WORKERS].wait_seconds += pipeline.worker_counters[w].wait_seconds;
+            stats->stages[STAGE_WORKERS].sleep_seconds += pipeline.worker_counters[w].sleep_seconds;
+            const CacheCounters* counts = &pipeline.cache_counters[w];
+            stats->cache_hits += counts->hits;
+            stats->cache_misses += counts->misses;
+            stats->cache_insertions += counts->insertions;
+            stats->cache_evictions += counts->evictions;
+            stats->cache_entries += counts->entries;
+            stats->cache_capacity += counts->capacity;
+        }
+        stats->stages[STAGE_WRITER] = writer_counters;
+        stats->stages[STAGE_WRITER].name = "writer";
+        stats->stages[STAGE_WRITER].threads = 1;
+    }
+
+    bool input_failed = pipeline.input && input_stream_failed(pipeline.input);
+    close_input_stream(pipeline.input);
+    destroy_cone_partitioning(pipeline.partitioning);
+    destroy_scc_decomposition(pipeline.scc);
+    spsc_ring_destroy(&pipeline.text_ring);
+    for (int w = 0; w < w_count; w++) {
+        spsc_ring_destroy(&pipeline.batch_rings[w]);
+        spsc_ring_destroy(&pipeline.result_rings[w]);
+    }
+    free(pipeline.batch_rings);
+    free(pipeline.result_rings);
+    free(pipeline.worker_counters);
+    free(pipeline.cache_counters);
+    free(pipeline.cross_checks);
+    free(workers);
+    free(worker_args);
+    return input_failed ? 1 : 0;
+}
+
+void print_pipeline_stats(FILE* stream, const PipelineStats* stats) {
+    if (!stream || !stats) return;
+
+    double rate = stats->wall_seconds > 0.0 ? (double)stats->vectors / stats->wall_seconds : 0.0;
+    fprintf(stream, "=== Pipeline Statistics ===\n");
+    fprintf(stream, "Engine: %s\n", engine_name(stats->engine));
+    fprintf(stream, "Vectors: %lld in %.3f s (%.0f vectors/s)", stats->vectors, stats->wall_seconds, rate);
+    if (stats->invalid_lines > 0) fprintf(stream, ", %lld invalid lines skipped", stats->invalid_lines);
+    fprintf(stream, "\n");
+    long long lookups = stats->cache_hits + stats->cache_misses;
+    if (lookups > 0) {
+        fprintf(stream, "Result cache: %lld hits, %lld misses (%.1f%% hit rate), %lld insertions, %lld evictions\n",
+                stats->cache_hits, stats->cache_misses, 100.0 * (double)stats->cache_hits / (double)lookups,
+                stats->cache_insertions, stats->cache_evictions);
+        fprintf(stream, "Result cache entries: %lld of %lld in use\n", stats->cache_entries, stats->cache_capacity);
+    }
+
+    // Waits spin briefly and then sleep (spsc_ring.h); only the spinning part uses a core
+    fprintf(stream, "%-10s | %-7s | %-8s | %-9s | %-9s | %-10s | %-6s\n",
+            "Stage", "Threads", "Items", "Busy (s)", "Wait (s)", "Asleep (s)", "Util");
+    fprintf(stream, "-----------+---------+----------+-----------+-----------+------------+-------\n");
+    for (int s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        const StageCounters* stage = &stats->stages[s];
+        double total = stage->busy_seconds + stage->wait_seconds;
+        double utilisation = total > 0.0 ? 100.0 * stage->busy_seconds / total : 0.0;
+        fprintf(stream, "%-10s | %-7d | %-8lld | %-9.3f | %-9.3f | %-10.3f | %5.1f%%\n",
+                stage->name ? stage->name : "?", stage->threads, stage->items,
+                stage->busy_seconds, stage->wait_seconds, stage->sleep_seconds, utilisation);
+    }
+    fprintf(stream, "\n");
+}
@@ -0,0 +1,114 @@
+#ifndef SIM_PIPELINE_H
+#define SIM_PIPELINE_H
+
+#include "circuit_node.h"
+#include "levelizer.h"
+#include "cross_check.h"
+#include "engine_tuner.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Pipelined batch simulation.
+//
+// Stages run on their own threads and hand batches over bounded lock-free
+// SPSC rings, so reading, parsing, simulating and writing overlap:
+//
+//   source (file reader / generator) -> packer -> N simulation workers -> writer
+//
+// The packer deals batches round-robin to the workers and the writer collects
+// them in the same order, so output lines stay in input order. A full ring
+// blocks its producer (backpressure).
+//
+// Every worker simulates its vectors with the configured engine on a private
+// value array. The partitioned engine evaluates the output-cone partitions
+// one after another, since the workers already run in parallel. Circuits with
+// combinational loops run on the SCC engine (or the iterative one), which
+// start every vector from X like the reference, so responses do not depend on
+// how vectors are dealt to the workers.
+//
+// Vector files hold one vector per line: one character per primary input, in
+// declaration order, using 0, 1 or X. Blank lines and lines starting with '#'
+// or "//" are skipped. The file may be gzip- or zstd-compressed
+// (input_stream.h). Each output line holds the PO values in declaration
+// order.
+
+typedef struct {
+    const char* vector_file;    // Pattern file (possibly compressed), or NULL to generate random vectors
+    long long random_count;     // Vectors to generate when vector_file is NULL
+    uint64_t seed;              // Generator seed
+    FILE* output;               // Response destination
+    int worker_count;           // Simulation threads
+    int batch_size;             // Vectors per batch handed between stages
+    size_t cache_budget;        // Result cache bytes, split across workers (0 disables)
+    double cross_check_rate;    // Fraction of vectors re-checked against the reference (0 disables)
+    const EngineConfig* engine; // Engine and partitions of the workers (NULL: auto)
+} PipelineOptions;
+
+enum {
+    STAGE_SOURCE,
+    STAGE_PACKER,
+    STAGE_WORKERS,
+    STAGE_WRITER,
+    PIPELINE_STAGE_COUNT
+};
+
+// Per-stage utilisation counters (summed over the stage's threads)
+typedef struct {
+    const char* name;
+    int threads;
+    long long items;            // Batches or chunks produced/consumed
+    double busy_seconds;        // Time spent working
+    double wait_seconds;        // Time blocked on an empty input or full output ring
+    double sleep_seconds;       // Part of wait_seconds spent asleep rather than spinning
+} StageCounters;
+
+typedef struct {
+    SimEngine engine;           // Engine the workers ran
+    long long vectors;          // Vectors simulated
+    long long invalid_lines;    // Lines skipped because their length did not match
+    long long cache_hits;       // Result cache, summed over the workers' caches
+    long long cache_misses;
+    long long cache_insertions;
+    long long cache_evictions;
+    long long cache_entries;    // In use at the end, of cache_capacity
+    long long cache_capacity;
+    double wall_seconds;
+    CrossCheckStats cross_check;  // Merged over workers (vectors_seen == 0 when disabled)
+    StageCounters stages[PIPELINE_STAGE_COUNT];
+} PipelineStats;
+
+/**
+ * @brief Parses one line of a vector file.
+ * @param line Start of the line.
+ * @param end One past the last character (excluding the newline).
+ * @param pi_count Expected number of values.
+ * @param values Receives pi_count values.
+ * @return 1 for a vector, 0 for a blank/comment line, -1 if malformed.
+ */
+int parse_vector_line(const char* line, const char* end, int pi_count, SignalValue* values);
+
+/**
+ * @brief Initializes options with defaults (random source, stdout, 1 worker).
+ */
+void init_pipeline_options(PipelineOptions* options);
+
+/**
+ * @brief Runs the full pipeline over a vector source.
+ * @param circuit The circuit (read only; may be shared).
+ * @param levels Levelization of the circuit (must be acyclic for the
+ *        levelized and partitioned engines).
+ * @param options Pipeline configuration.
+ * @param stats Receives counters (may be NULL).
+ * @return 0 on success, 1 on error.
+ */
+int run_simulation_pipeline(const Circuit* circuit, const Levelization* levels,
+                            const PipelineOptions* options, PipelineStats* stats);
+
+/**
+ * @brief Prints throughput and per-stage utilisation.
+ * @param stream Destination stream.
+ * @param stats Counters from run_simulation_pipeline().
+ */
+void print_pipeline_stats(FILE* stream, const PipelineStats* stats);
+
+#endif // SIM_PIPELINE_H
@@ -0,0 +1,320 @@
+#include "sim_stats.h"
+#include "sim_trace.h"
+#include "spsc_ring.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Counter blocks are padded to whole cache lines so no two threads share one
+#define STATS_LINE_BYTES 64
+
+typedef struct StatsBlock StatsBlock;
+struct StatsBlock {
+    SimCounters counters;
+    StatsBlock* prev;
+    StatsBlock* next;
+};
+
+// Blocks of live threads; an exiting thread folds its block into retired
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+static StatsBlock* blocks = NULL;
+static SimCounters retired;
+static int block_count = 0;   // Threads that ever counted, live or exited
+
+static const char* const phase_names[SIM_PHASE_COUNT] = { "parse", "levelize", "engine", "simulate", "write" };
+
+static PhaseTimes phase_times[SIM_PHASE_COUNT];
+static double phase_wall_start[SIM_PHASE_COUNT];
+static double phase_cpu_start[SIM_PHASE_COUNT];
+static long long phase_gate_evals_start[SIM_PHASE_COUNT];
+static HwCounts phase_hw_start[SIM_PHASE_COUNT];
+static bool hw_requested = false;
+static bool hw_enabled = false;
+
+// SimCounters holds only long long fields, so it is summed as an array
+static void add_counters(SimCounters* total, const SimCounters* counters) {
+    long long* sums = (long long*)total;
+    const long long* counts = (const long long*)counters;
+    for (size_t i = 0; i < sizeof(SimCounters) / sizeof(long long); i++) sums[i] += counts[i];
+}
+
+#ifdef SIM_STATS
+__thread SimCounters* sim_stats_local = NULL;
+
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t exit_key;
+static bool exit_key_created = false;
+
+// Thread exit: keep the counts, free the block
+static void retire_block(void* value) {
+    StatsBlock* block = (StatsBlock*)value;
+    pthread_mutex_lock(&blocks_lock);
+    add_counters(&retired, &block->counters);
+    if (block->prev) block->prev->next = block->next;
+    else blocks = block->next;
+    if (block->next) block->next->prev = block->prev;
+    pthread_mutex_unlock(&blocks_lock);
+    sim_stats_local = NULL;
+    free(block);
+}
+
+static void create_exit_key(void) {
+    exit_key_created = (pthread_key_create(&exit_key, retire_block) == 0);
+}
+
+SimCounters* sim_stats_attach_thread(void) {
+    void* memory = NULL;
+    size_t size = (sizeof(StatsBlock) + STATS_LINE_BYTES - 1) / STATS_LINE_BYTES * STATS_LINE_BYTES;
+    if (posix_memalign(&memory, STATS_LINE_BYTES, size) != 0) {
+        fprintf(stderr, "Error: Out of memory allocating statistics counters\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(memory, 0, size);
+    StatsBlock* block = (StatsBlock*)memory;
+
+    pthread_mutex_lock(&blocks_lock);
+    block->next = blocks;
+    if (blocks) blocks->prev = block;
+    blocks = block;
+    block_count++;
+    pthread_mutex_unlock(&blocks_lock);
+
+    // Without the key the block simply stays registered after the thread exits
+    pthread_once(&exit_key_once, create_exit_key);
+    if (exit_key_created) pthread_setspecific(exit_key, block);
+
+    sim_stats_local = &block->counters;
+    return sim_stats_local;
+}
+#endif
+
+static double process_cpu_seconds(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0.0;
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Gate evaluations so far over all threads (phases end after their threads are joined)
+static long long gate_evals_so_far(void) {
+    long long total = 0;
+    pthread_mutex_lock(&blocks_lock);
+    for (int t = 0; t < SIM_STATS_GATE_TYPES; t++) total += retired.gate_evals[t];
+    for (const StatsBlock* block = blocks; block; block = block->next) {
+        for (int t = 0; t < SIM_STATS_GATE_TYPES; t++) total += block->counters.gate_evals[t];
+    }
+    pthread_mutex_unlock(&blocks_lock);
+    return total;
+}
+
+bool sim_stats_enable_hw_counters(void) {
+    hw_requested = true;
+    hw_enabled = open_hw_counters();
+    return hw_enabled;
+}
+
+void sim_stats_phase_begin(SimPhase phase) {
+    if (hw_enabled) read_hw_counters(&phase_hw_start[phase]);
+    phase_gate_evals_start[phase] = gate_evals_so_far();
+    phase_wall_start[phase] = monotonic_seconds();
+    phase_cpu_start[phase] = process_cpu_seconds();
+}
+
+void sim_stats_phase_end(SimPhase phase) {
+    PhaseTimes* times = &phase_times[phase];
+    times->wall_seconds += monotonic_seconds() - phase_wall_start[phase];
+    times->cpu_seconds += process_cpu_seconds() - phase_cpu_start[phase];
+    times->runs++;
+    times->gate_evals += gate_evals_so_far() - phase_gate_evals_start[phase];
+    if (hw_enabled) {
+        HwCounts now;
+        read_hw_counters(&now);
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            if (!now.valid[c] || !phase_hw_start[phase].valid[c]) continue;
+            // Multiplexing estimates can dip slightly; never add a negative delta
+            if (now.value[c] > phase_hw_start[phase].value[c]) {
+                times->hw.value[c] += now.value[c] - phase_hw_start[phase].value[c];
+            }
+            times->hw.valid[c] = true;
+        }
+    }
+    TRACE_END(phase_names[phase], phase_wall_start[phase]);
+}
+
+void collect_sim_stats(SimStatsReport* report) {
+    memset(report, 0, sizeof(*report));
+#ifdef SIM_STATS
+    report->counters_enabled = true;
+#endif
+
+    pthread_mutex_lock(&blocks_lock);
+    report->counters = retired;
+    for (const StatsBlock* block = blocks; block; block = block->next) {
+        add_counters(&report->counters, &block->counters);
+    }
+    report->threads = block_count;
+    pthread_mutex_unlock(&blocks_lock);
+
+    memcpy(report->phases, phase_times, sizeof(phase_times));
+    report->hw_requested = hw_requested;
+    report->hw_enabled = hw_enabled;
+    report->hw_error = hw_counters_error();
+}
+
+// Prints a hardware count, or "-" if the counter is not available
+static void print_hw_value(FILE* stream, const HwCounts* hw, HwCounter counter, int width) {
+    if (hw->valid[counter]) fprintf(stream, " %*llu", width, (unsigned long long)hw->value[counter]);
+    else fprintf(stream, " %*s", width, "-");
+}
+
+static void print_hw_counters(FILE* stream, const SimStatsReport* report) {
+    if (!report->hw_enabled) {
+        fprintf(stream, "Hardware counters unavailable: %s\n", report->hw_error);
+        return;
+    }
+
+    fprintf(stream, "Hardware counters (user space, all threads):\n");
+    fprintf(stream, "%-10s %14s %14s %6s %12s %12s %12s\n",
+            "Phase", "Cycles", "Instructions", "IPC", "LLC misses", "L1D misses", "Br misses");
+    for (int p = 0; p < SIM_PHASE_COUNT; p++) {
+        const PhaseTimes* phase = &report->phases[p];
+        if (phase->runs == 0) continue;
+        const HwCounts* hw = &phase->hw;
+        fprintf(stream, "%-10s", phase_names[p]);
+        print_hw_value(stream, hw, HW_CYCLES, 14);
+        print_hw_value(stream, hw, HW_INSTRUCTIONS, 14);
+        if (hw->valid[HW_CYCLES] && hw->valid[HW_INSTRUCTIONS] && hw->value[HW_CYCLES] > 0) {
+            fprintf(stream, " %6.2f", (double)hw->value[HW_INSTRUCTIONS] / (double)hw->value[HW_CYCLES]);
+        } else {
+            fprintf(stream, " %6s", "-");
+        }
+        print_hw_value(stream, hw, HW_CACHE_MISSES, 12);
+        print_hw_value(stream, hw, HW_L1D_MISSES, 12);
+        print_hw_value(stream, hw, HW_BRANCH_MISSES, 12);
+        fprintf(stream, "\n");
+    }
+
+    if (!report->counters_enabled) {
+        fprintf(stream, "Per gate evaluation figures need the counters (build with STATS=yes).\n");
+        return;
+    }
+    for (int p = 0; p < SIM_PHASE_COUNT; p++) {
+        const PhaseTimes* phase = &report->phases[p];
+        if (phase->runs == 0 || phase->gate_evals == 0) continue;
+        fprintf(stream, "Per gate evaluation (%s):", phase_names[p]);
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            if (!phase->hw.valid[c]) continue;
+            fprintf(stream, " %s %.3f", hw_counter_name((HwCounter)c),
+                    (double)phase->hw.value[c] / (double)phase->gate_evals);
+        }
+        fprintf(stream, "\n");
+    }
+}
+
+static long long total_gate_evals(const SimCounters* counters) {
+    long long total = 0;
+    for (int t = 0; t < SIM_STATS_GATE_TYPES; t++) total += counters->gate_evals[t];
+    return total;
+}
+
+void print_sim_stats(FILE* stream, const SimStatsReport* report) {
+    const SimCounters* c = &report->counters;
+
+    fprintf(stream, "## Statistics\n");
+    fprintf(stream, "%-10s %12s %12s %6s\n", "Phase", "Wall ms", "CPU ms", "Runs");
+    for (int p = 0; p < SIM_PHASE_COUNT; p++) {
+        const PhaseTimes* phase = &report->phases[p];
+        if (phase->runs == 0) continue;
+        fprintf(stream, "%-10s %12.3f %12.3f %6d\n", phase_names[p],
+                phase->wall_seconds * 1e3, phase->cpu_seconds * 1e3, phase->runs);
+    }
+    if (report->hw_requested) print_hw_counters(stream, report);
+
+    if (!report->counters_enabled) {
+        fprintf(stream, "Counters are not compiled in (build with STATS=yes).\n\n");
+        return;
+    }
+
+    fprintf(stream, "Gate evaluations: %lld\n", total_gate_evals(c));
+    for (int t = GATE_AND; t < SIM_STATS_GATE_TYPES; t++) {
+        if (c->gate_evals[t] > 0) {
+            fprintf(stream, "  %-6s %lld\n", gate_type_to_string((GateType)t), c->gate_evals[t]);
+        }
+    }
+    if (c->gate_evals[GATE_UNKNOWN] > 0) fprintf(stream, "  %-6s %lld\n", "other", c->gate_evals[GATE_UNKNOWN]);
+    fprintf(stream, "64-pattern gate evaluations: %lld\n", c->word_evals);
+    fprintf(stream, "Nodes visited: %lld\n", c->nodes_visited);
+    fprintf(stream, "Events scheduled: %lld, processed: %lld\n", c->events_scheduled, c->events_processed);
+    fprintf(stream, "Fixed-point iterations: %lld\n", c->fixed_point_iterations);
+    fprintf(stream, "Batches queued: %lld, simulated: %lld\n", c->batches_queued, c->batches_simulated);
+    fprintf(stream, "Result cache: %lld hits, %lld misses\n", c->sim_cache_hits, c->sim_cache_misses);
+    fprintf(stream, "Netlist cache: %lld hits, %lld misses\n", c->netlist_cache_hits, c->netlist_cache_misses);
+    fprintf(stream, "Bytes read: %lld\n", c->bytes_read);
+    fprintf(stream, "Counting threads: %d\n\n", report->threads);
+}
+
+int write_sim_stats_json(const char* filename, const SimStatsReport* report) {
+    bool to_stdout = (strcmp(filename, "-") == 0);
+    FILE* file = to_stdout ? stdout : fopen(filename, "w");
+    if (!file) {
+        perror("Error opening statistics file");
+        return 1;
+    }
+
+    const SimCounters* c = &report->counters;
+    fprintf(file, "{\n  \"phases\": {");
+    bool first = true;
+    for (int p = 0; p < SIM_PHASE_COUNT; p++) {
+        const PhaseTimes* phase = &report->phases[p];
+        if (phase->runs == 0) continue;
+        fprintf(file, "%s\n    \"%s\": {\"wall_seconds\": %.9f, \"cpu_seconds\": %.9f, \"runs\": %d",
+                first ? "" : ",", phase_names[p], phase->wall_seconds, phase->cpu_seconds, phase->runs);
+        if (report->counters_enabled) fprintf(file, ", \"gate_evals\": %lld", phase->gate_evals);
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            if (phase->hw.valid[c]) {
+                fprintf(file, ", \"%s\": %llu", hw_counter_name((HwCounter)c), (unsigned long long)phase->hw.value[c]);
+            }
+        }
+        fprintf(file, "}");
+        first = false;
+    }
+    fprintf(file, "%s},\n", first ? "" : "\n  ");
+    if (report->hw_requested) {
+        fprintf(file, "  \"hw_counters\": %s,\n", report->hw_enabled ? "true" : "false");
+        // The error text comes from strerror() and fixed hints: no quotes or backslashes
+        if (!report->hw_enabled) fprintf(file, "  \"hw_counters_error\": \"%s\",\n", report->hw_error);
+    }
+
+    fprintf(file, "  \"counters_enabled\": %s", report->counters_enabled ? "true" : "false");
+    if (report->counters_enabled) {
+        fprintf(file, ",\n  \"threads\": %d,\n  \"gate_evals\": {", report->threads);
+        for (int t = GATE_AND; t < SIM_STATS_GATE_TYPES; t++) {
+            fprintf(file, "%s\"%s\": %lld", t == GATE_AND ? "" : ", ", gate_type_to_string((GateType)t), c->gate_evals[t]);
+        }
+        fprintf(file, "},\n");
+        fprintf(file, "  \"gate_evals_total\": %lld,\n", total_gate_evals(c));
+        fprintf(file, "  \"word_evals\": %lld,\n", c->word_evals);
+        fprintf(file, "  \"nodes_visited\": %lld,\n", c->nodes_visited);
+        fprintf(file, "  \"events_scheduled\": %lld,\n", c->events_scheduled);
+        fprintf(file, "  \"events_processed\": %lld,\n", c->events_processed);
+        fprintf(file, "  \"fixed_point_iterations\": %lld,\n", c->fixed_point_iterations);
+        fprintf(file, "  \"batches_queued\": %lld,\n", c->batches_queued);
+        fprintf(file, "  \"batches_simulated\": %lld,\n", c->batches_simulated);
+        fprintf(file, "  \"sim_cache_hits\": %lld,\n", c->sim_cache_hits);
+        fprintf(file, "  \"sim_cache_misses\": %lld,\n", c->sim_cache_misses);
+        fprintf(file, "  \"netlist_cache_hits\": %lld,\n", c->netlist_cache_hits);
+        fprintf(file, "  \"netlist_cache_misses\": %lld,\n", c->netlist_cache_misses);
+        fprintf(file, "  \"bytes_read\": %lld", c->bytes_read);
+    }
+    fprintf(file, "\n}\n");
+
+    int status = ferror(file) ? 1 : 0;
+    if (to_stdout) {
+        fflush(file);
+    } else if (fclose(file) != 0) {
+        status = 1;
+    }
+    if (status) fprintf(stderr, "Error: Could not write statistics to %s\n", filename);
+    return status;
+}
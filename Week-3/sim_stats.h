@@ -0,0 +1,132 @@
+#ifndef SIM_STATS_H
+#define SIM_STATS_H
+
+#include "hw_counters.h"
+#include "verilog_parser.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+// Instrumentation counters for the hot paths, and per-phase timings.
+//
+// Counters are compiled in only when SIM_STATS is defined (make STATS=yes);
+// otherwise SIM_STAT_ADD() counts nothing and the engines run exactly as
+// before. Counting every gate evaluation costs about 12% (c1908, levelized
+// engine, 100k random vectors), so release builds leave them out. Each thread counts into its own
+// cache-line aligned block, created the first time it counts, so threads
+// never write to shared lines. When a thread exits its counts are folded into
+// a retired total and the block is freed; the live blocks and the retired
+// total are summed only when the report is collected.
+//
+// The engines evaluate every node rather than scheduling events, so events
+// are counted as an event-driven engine would see them: each value change
+// (iterative, SCC and levelized engines) schedules one event, and processing
+// it evaluates the node's fanouts. Against nodes_visited, this shows how much
+// evaluation an event-driven engine would skip.
+//
+// Phase timings (wall clock and process CPU time) are always recorded; they
+// are taken once per phase, off the hot paths, and are also spans in the
+// trace when tracing is on (sim_trace.h). Hardware counters (hw_counters.h),
+// once enabled, are read at the same points, so every phase also gets its
+// cycles, instructions and misses, and per gate evaluation with SIM_STATS.
+
+#define SIM_STATS_GATE_TYPES (GATE_BUFF + 1)
+
+typedef struct {
+    long long gate_evals[SIM_STATS_GATE_TYPES]; // Scalar gate evaluations, by GateType
+    long long word_evals;             // 64-pattern gate evaluations (evaluate_gate_bits())
+    long long nodes_visited;          // Nodes evaluated or passed through by an engine
+    long long events_scheduled;       // Node value changes, each an event for the node's fanouts
+    long long events_processed;       // Fanout evaluations those events call for (vs. nodes_visited)
+    long long fixed_point_iterations; // Sweeps of the iterative engine and of cyclic SCCs
+    long long batches_queued;         // Vector batches handed to pipeline workers
+    long long batches_simulated;      // Vector batches simulated by pipeline workers
+    long long sim_cache_hits;         // Result cache (sim_cache.h)
+    long long sim_cache_misses;
+    long long netlist_cache_hits;     // Compiled netlists loaded (netlist_cache.h)
+    long long netlist_cache_misses;
+    long long bytes_read;             // Netlist and vector bytes read (after decompression)
+} SimCounters;
+
+typedef enum {
+    PHASE_PARSE,        // Reading and building the circuit (or loading it compiled)
+    PHASE_LEVELIZE,
+    PHASE_ENGINE,       // Profiling the circuit and choosing (or tuning) the engine
+    PHASE_SIMULATE,
+    PHASE_WRITE,        // Writing a netlist (--write-netlist) or the compiled netlist
+    SIM_PHASE_COUNT
+} SimPhase;
+
+typedef struct {
+    double wall_seconds;
+    double cpu_seconds;   // Process CPU time, so worker threads count too
+    int runs;             // Times the phase was entered
+    long long gate_evals; // Scalar gate evaluations during the phase (SIM_STATS only)
+    HwCounts hw;          // Hardware events during the phase (valid[] false if not counted)
+} PhaseTimes;
+
+typedef struct {
+    bool counters_enabled;  // Built with SIM_STATS
+    int threads;            // Threads that counted anything
+    SimCounters counters;   // Summed over threads
+    PhaseTimes phases[SIM_PHASE_COUNT];
+    bool hw_requested;      // sim_stats_enable_hw_counters() was called
+    bool hw_enabled;        // ... and at least one counter is counting
+    const char* hw_error;   // Why not, if requested but not enabled
+} SimStatsReport;
+
+#ifdef SIM_STATS
+extern __thread SimCounters* sim_stats_local;
+
+/**
+ * @brief Creates and registers the calling thread's counter block (first use only).
+ * @return The block; exits the program if it cannot be allocated.
+ */
+SimCounters* sim_stats_attach_thread(void);
+
+#define SIM_STAT_ADD(field, amount) \
+    ((sim_stats_local ? sim_stats_local : sim_stats_attach_thread())->field += (amount))
+#else
+#define SIM_STAT_ADD(field, amount) ((void)(amount))
+#endif
+
+/**
+ * @brief Opens the hardware counters so phases record them too.
+ *
+ * Call before starting any threads. Failing is not an error: the report
+ * then says why the counters are unavailable.
+ * @return true if hardware counters are counting.
+ */
+bool sim_stats_enable_hw_counters(void);
+
+/**
+ * @brief Starts timing a phase (call from the main thread).
+ */
+void sim_stats_phase_begin(SimPhase phase);
+
+/**
+ * @brief Stops timing a phase started with sim_stats_phase_begin().
+ */
+void sim_stats_phase_end(SimPhase phase);
+
+/**
+ * @brief Sums the counters of all threads that have counted so far.
+ *
+ * Call once the threads being measured have finished (joined), so their
+ * blocks are no longer written.
+ * @param report Receives the merged counters and phase times.
+ */
+void collect_sim_stats(SimStatsReport* report);
+
+/**
+ * @brief Prints a report as a table.
+ */
+void print_sim_stats(FILE* stream, const SimStatsReport* report);
+
+/**
+ * @brief Writes a report as one JSON object.
+ * @param filename Output path, or "-" for stdout.
+ * @return 0 on success, 1 if the file cannot be written.
+ */
+int write_sim_stats_json(const char* filename, const SimStatsReport* report);
+
+#endif // SIM_STATS_H
@@ -0,0 +1,154 @@
+#include "sim_trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_CHUNK_SPANS 1024
+
+typedef struct {
+    const char* name;
+    double begin;
+    double end;
+} TraceSpan;
+
+typedef struct TraceChunk TraceChunk;
+struct TraceChunk {
+    TraceSpan spans[TRACE_CHUNK_SPANS];
+    int count;
+    TraceChunk* next;
+};
+
+// One per recording thread; only its own thread appends to it
+typedef struct TraceThread TraceThread;
+struct TraceThread {
+    int tid;
+    const char* role;
+    int index;
+    TraceChunk* first;
+    TraceChunk* last;
+    long long dropped;       // Spans lost because a chunk could not be allocated
+    TraceThread* next;
+};
+
+bool trace_enabled = false;
+
+static const char* trace_process = NULL;
+static double trace_origin = 0.0;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceThread* threads = NULL;
+static int thread_count = 0;
+static __thread TraceThread* local_thread = NULL;
+
+// Registers the calling thread on its first span (the only locked step)
+static TraceThread* attach_thread(void) {
+    if (local_thread) return local_thread;
+
+    TraceThread* thread = (TraceThread*)calloc(1, sizeof(TraceThread));
+    if (!thread) return NULL;
+    thread->index = -1;
+
+    pthread_mutex_lock(&threads_lock);
+    thread->tid = ++thread_count;
+    thread->next = threads;
+    threads = thread;
+    pthread_mutex_unlock(&threads_lock);
+
+    local_thread = thread;
+    return thread;
+}
+
+void start_trace(const char* process_name) {
+    trace_process = process_name;
+    trace_origin = monotonic_seconds();
+    trace_enabled = true;
+    trace_name_thread("main", -1);
+}
+
+void trace_record(const char* name, double begin) {
+    double end = monotonic_seconds();
+    TraceThread* thread = attach_thread();
+    if (!thread) return;
+
+    TraceChunk* chunk = thread->last;
+    if (!chunk || chunk->count == TRACE_CHUNK_SPANS) {
+        chunk = (TraceChunk*)malloc(sizeof(TraceChunk));
+        if (!chunk) {
+            thread->dropped++;
+            return;
+        }
+        chunk->count = 0;
+        chunk->next = NULL;
+        if (thread->last) thread->last->next = chunk;
+        else thread->first = chunk;
+        thread->last = chunk;
+    }
+
+    TraceSpan* span = &chunk->spans[chunk->count++];
+    span->name = name;
+    span->begin = begin;
+    span->end = end;
+}
+
+void trace_name_thread(const char* role, int index) {
+    if (!trace_enabled) return;
+    TraceThread* thread = attach_thread();
+    if (!thread || thread->role) return;
+    thread->role = role;
+    thread->index = index;
+}
+
+int write_trace(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening trace file");
+        return 1;
+    }
+
+    pthread_mutex_lock(&threads_lock);
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"%s\"}}",
+            trace_process ? trace_process : "simulator");
+
+    long long dropped = 0;
+    for (TraceThread* thread = threads; thread; thread = thread->next) {
+        if (thread->role) {
+            char name[64];
+            if (thread->index >= 0) snprintf(name, sizeof(name), "%s %d", thread->role, thread->index);
+            else snprintf(name, sizeof(name), "%s", thread->role);
+            fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                    thread->tid, name);
+            // Perfetto orders tracks by sort index: main first, then by registration
+            fprintf(file, ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+                    thread->tid, thread->tid);
+        }
+        for (const TraceChunk* chunk = thread->first; chunk; chunk = chunk->next) {
+            for (int i = 0; i < chunk->count; i++) {
+                const TraceSpan* span = &chunk->spans[i];
+                fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                        span->name, thread->tid, (span->begin - trace_origin) * 1e6, (span->end - span->begin) * 1e6);
+            }
+        }
+        dropped += thread->dropped;
+    }
+    fprintf(file, "\n]}\n");
+
+    // The spans are written; free them so a later write starts empty
+    for (TraceThread* thread = threads; thread; thread = thread->next) {
+        TraceChunk* chunk = thread->first;
+        while (chunk) {
+            TraceChunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        thread->first = thread->last = NULL;
+        thread->dropped = 0;
+    }
+    pthread_mutex_unlock(&threads_lock);
+
+    if (dropped > 0) fprintf(stderr, "Warning: %lld trace spans dropped (out of memory)\n", dropped);
+    int status = ferror(file) ? 1 : 0;
+    if (fclose(file) != 0) status = 1;
+    if (status) fprintf(stderr, "Error: Could not write trace to %s\n", filename);
+    return status;
+}
@@ -0,0 +1,61 @@
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include "spsc_ring.h"
+#include <stdbool.h>
+
+// Phase tracing in Chrome trace-event format (chrome://tracing, Perfetto).
+//
+// A span is a begin/end pair on one thread:
+//
+//     double begin = TRACE_BEGIN();
+//     ...
+//     TRACE_END("levelize", begin);
+//
+// Every thread records into its own buffer, registered the first time it
+// records, so recording takes no lock; write_trace() merges the buffers once
+// the threads are done. Spans are taken per phase, parse chunk and vector
+// batch (never per gate or vector), so tracing stays cheap enough for
+// production batch runs. While tracing is off a span costs one branch.
+
+extern bool trace_enabled;
+
+#define TRACE_BEGIN() (trace_enabled ? monotonic_seconds() : 0.0)
+#define TRACE_END(name, begin) \
+    do { if (trace_enabled) trace_record((name), (begin)); } while (0)
+
+/**
+ * @brief Turns tracing on; the calling thread is named "main".
+ *
+ * Call before any other thread starts.
+ * @param process_name Name shown for the process (a string literal).
+ */
+void start_trace(const char* process_name);
+
+/**
+ * @brief Records a span that began at begin and ends now (use TRACE_END()).
+ * @param name Span name; must outlive the trace (a string literal).
+ * @param begin Start time from TRACE_BEGIN().
+ */
+void trace_record(const char* name, double begin);
+
+/**
+ * @brief Names the calling thread in the trace, e.g. ("worker", 2) -> "worker 2".
+ *
+ * A thread keeps its first name, so work run inline on the main thread (or
+ * on a reused pool thread) does not rename it.
+ * @param role Thread role (a string literal).
+ * @param index Number appended to the role, or -1 for none.
+ */
+void trace_name_thread(const char* role, int index);
+
+/**
+ * @brief Writes all recorded spans as trace-event JSON and frees them.
+ *
+ * Call after the traced threads have been joined.
+ * @param filename Output path.
+ * @return 0 on success, 1 if the file cannot be written.
+ */
+int write_trace(const char* filename);
+
+#endif // SIM_TRACE_H
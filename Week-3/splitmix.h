@@ -0,0 +1,20 @@
+#ifndef SPLITMIX_H
+#define SPLITMIX_H
+
+#include <stdint.h>
+
+// splitmix64: small, fast and good enough for stimulus and sampling. Every
+// user seeds its own state, so streams are reproducible across runs.
+
+/**
+ * @brief Advances the generator state and returns the next 64 random bits.
+ * @param state Generator state (any seed, including 0).
+ */
+static inline uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#endif // SPLITMIX_H
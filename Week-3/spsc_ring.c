@@ -0,0 +1,124 @@
+#include "spsc_ring.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Yields before a waiting thread goes to sleep
+#define SPIN_ROUNDS 64
+
+double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+bool spsc_ring_init(SpscRing* ring, size_t min_capacity) {
+    size_t capacity = 2;
+    while (capacity < min_capacity) capacity <<= 1;
+
+    ring->slots = (void**)calloc(capacity, sizeof(void*));
+    if (!ring->slots) return false;
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->sleepers = 0;
+    ring->push_sleep_seconds = 0.0;
+    ring->pop_sleep_seconds = 0.0;
+    if (pthread_mutex_init(&ring->lock, NULL) != 0) {
+        free(ring->slots);
+        ring->slots = NULL;
+        return false;
+    }
+    if (pthread_cond_init(&ring->changed, NULL) != 0) {
+        pthread_mutex_destroy(&ring->lock);
+        free(ring->slots);
+        ring->slots = NULL;
+        return false;
+    }
+    return true;
+}
+
+void spsc_ring_destroy(SpscRing* ring) {
+    if (!ring || !ring->slots) return;
+    free(ring->slots);
+    ring->slots = NULL;
+    pthread_cond_destroy(&ring->changed);
+    pthread_mutex_destroy(&ring->lock);
+}
+
+// Wakes the other side if it sleeps. The fence orders the index store before
+// the sleepers load; the sleeper increments sleepers before re-reading the
+// indices, so one of the two always sees the other.
+static void wake_sleeper(SpscRing* ring) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->sleepers, __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->changed);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static bool can_push(SpscRing* ring) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    return tail - __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) <= ring->mask;
+}
+
+static bool can_pop(SpscRing* ring) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    return head != __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+}
+
+// Sleeps until ready() holds; only the side that needs it ever waits.
+// Returns the seconds spent asleep.
+static double sleep_until(SpscRing* ring, bool (*ready)(SpscRing*)) {
+    double start = monotonic_seconds();
+    pthread_mutex_lock(&ring->lock);
+    __atomic_add_fetch(&ring->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!ready(ring)) pthread_cond_wait(&ring->changed, &ring->lock);
+    __atomic_sub_fetch(&ring->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ring->lock);
+    return monotonic_seconds() - start;
+}
+
+bool spsc_ring_try_push(SpscRing* ring, void* item) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (tail - head > ring->mask) return false;
+
+    ring->slots[tail & ring->mask] = item;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    wake_sleeper(ring);
+    return true;
+}
+
+bool spsc_ring_try_pop(SpscRing* ring, void** item) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+
+    *item = ring->slots[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    wake_sleeper(ring);
+    return true;
+}
+
+double spsc_ring_push(SpscRing* ring, void* item) {
+    if (spsc_ring_try_push(ring, item)) return 0.0;
+
+    double start = monotonic_seconds();
+    for (int round = 1; !spsc_ring_try_push(ring, item); round++) {
+        if (round < SPIN_ROUNDS) sched_yield();
+        else ring->push_sleep_seconds += sleep_until(ring, can_push);
+    }
+    return monotonic_seconds() - start;
+}
+
+double spsc_ring_pop(SpscRing* ring, void** item) {
+    if (spsc_ring_try_pop(ring, item)) return 0.0;
+
+    double start = monotonic_seconds();
+    for (int round = 1; !spsc_ring_try_pop(ring, item); round++) {
+        if (round < SPIN_ROUNDS) sched_yield();
+        else ring->pop_sleep_seconds += sleep_until(ring, can_pop);
+    }
+    return monotonic_seconds() - start;
+}
@@ -0,0 +1,73 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bounded lock-free single-producer/single-consumer ring of pointers.
+//
+// Exactly one thread may push and exactly one other thread may pop. The
+// blocking variants wait while the ring is full (push: backpressure) or empty
+// (pop), and report how long they waited. They spin with sched_yield() for a
+// few rounds, which covers the short gaps of a busy ring, and then sleep on a
+// condition variable, so a stalled stage does not keep a core busy. The other
+// side takes the lock only when someone is asleep.
+
+typedef struct {
+    void** slots;
+    size_t mask;               // capacity - 1 (capacity is a power of two)
+    size_t head;               // Next slot to pop (written by the consumer)
+    char pad[64];              // Keep producer and consumer indices on separate cache lines
+    size_t tail;               // Next slot to push (written by the producer)
+    char pad2[64];
+    int sleepers;              // Threads waiting on changed (0 or 1)
+    double push_sleep_seconds; // Part of the push waits spent asleep (written by the producer)
+    double pop_sleep_seconds;  // Part of the pop waits spent asleep (written by the consumer)
+    pthread_mutex_t lock;      // Guards the sleep on changed
+    pthread_cond_t changed;    // Signalled after a push or pop while someone sleeps
+} SpscRing;
+
+/**
+ * @brief Initializes a ring holding at least min_capacity items.
+ * @return true on success.
+ */
+bool spsc_ring_init(SpscRing* ring, size_t min_capacity);
+
+/**
+ * @brief Frees the ring storage (items still queued are not freed).
+ */
+void spsc_ring_destroy(SpscRing* ring);
+
+/**
+ * @brief Pushes without blocking.
+ * @return false if the ring is full.
+ */
+bool spsc_ring_try_push(SpscRing* ring, void* item);
+
+/**
+ * @brief Pops without blocking.
+ * @return false if the ring is empty.
+ */
+bool spsc_ring_try_pop(SpscRing* ring, void** item);
+
+/**
+ * @brief Pushes, waiting while the ring is full.
+ * @return Seconds spent waiting (the part spent asleep is added to push_sleep_seconds).
+ */
+double spsc_ring_push(SpscRing* ring, void* item);
+
+/**
+ * @brief Pops, waiting while the ring is empty.
+ * @param ring The ring.
+ * @param item Receives the popped item.
+ * @return Seconds spent waiting (the part spent asleep is added to pop_sleep_seconds).
+ */
+double spsc_ring_pop(SpscRing* ring, void** item);
+
+/**
+ * @brief Monotonic clock in seconds.
+ */
+double monotonic_seconds(void);
+
+#endif // SPSC_RING_H
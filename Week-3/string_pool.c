@@ -0,0 +1,215 @@
+#include "string_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_TABLE_SLOTS 256
+#define INITIAL_CHARS (16 * 1024)
+
+StringPool* create_string_pool(void) {
+    StringPool* pool = (StringPool*)calloc(1, sizeof(StringPool));
+    if (!pool) return NULL;
+
+    pool->table = (int*)malloc(INITIAL_TABLE_SLOTS * sizeof(int));
+    pool->chars = (char*)malloc(INITIAL_CHARS);
+    if (!pool->table || !pool->chars) {
+        destroy_string_pool(pool);
+        return NULL;
+    }
+    pool->table_mask = INITIAL_TABLE_SLOTS - 1;
+    pool->chars_capacity = INITIAL_CHARS;
+    memset(pool->table, -1, INITIAL_TABLE_SLOTS * sizeof(int));
+    return pool;
+}
+
+void destroy_string_pool(StringPool* pool) {
+    if (!pool) return;
+    free(pool->chars);
+    free(pool->offsets);
+    free(pool->hashes);
+    free(pool->lengths);
+    free(pool->table);
+    free(pool);
+}
+
+void clear_string_pool(StringPool* pool) {
+    if (!pool) return;
+    pool->chars_used = 0;
+    pool->count = 0;
+    memset(pool->table, -1, (pool->table_mask + 1) * sizeof(int));
+}
+
+uint32_t string_pool_hash(const char* text, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int lookup(const StringPool* pool, const char* text, int length, uint32_t hash, size_t* slot_out) {
+    size_t slot = hash & pool->table_mask;
+    for (;;) {
+        int id = pool->table[slot];
+        if (id < 0) break;
+        if (pool->hashes[id] == hash && pool->lengths[id] == length &&
+            memcmp(pool->chars + pool->offsets[id], text, (size_t)length) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & pool->table_mask;
+    }
+    if (slot_out) *slot_out = slot;
+    return -1;
+}
+
+// Doubles the slot table once it is half full
+static int grow_table(StringPool* pool) {
+    size_t slots = (pool->table_mask + 1) * 2;
+    int* table = (int*)malloc(slots * sizeof(int));
+    if (!table) return 0;
+    memset(table, -1, slots * sizeof(int));
+    for (int id = 0; id < pool->count; id++) {
+        size_t slot = pool->hashes[id] & (slots - 1);
+        while (table[slot] >= 0) slot = (slot + 1) & (slots - 1);
+        table[slot] = id;
+    }
+    free(pool->table);
+    pool->table = table;
+    pool->table_mask = slots - 1;
+    return 1;
+}
+
+static int grow_entries(StringPool* pool) {
+    int capacity = pool->capacity ? pool->capacity * 2 : 256;
+    size_t* offsets = (size_t*)realloc(pool->offsets, (size_t)capacity * sizeof(size_t));
+    if (!offsets) return 0;
+    pool->offsets = offsets;
+    uint32_t* hashes = (uint32_t*)realloc(pool->hashes, (size_t)capacity * sizeof(uint32_t));
+    if (!hashes) return 0;
+    pool->hashes = hashes;
+    int* lengths = (int*)realloc(pool->lengths, (size_t)capacity * sizeof(int));
+    if (!lengths) return 0;
+    pool->lengths = lengths;
+    pool->capacity = capacity;
+    return 1;
+}
+
+// Interns a string whose hash the caller already has
+static int intern_hashed(StringPool* pool, const char* text, int length, uint32_t hash) {
+    size_t slot = 0;
+    int id = lookup(pool, text, length, hash, &slot);
+    if (id >= 0) return id;
+
+    if ((size_t)(pool->count + 1) * 2 > pool->table_mask + 1) {
+        if (!grow_table(pool)) return -1;
+        lookup(pool, text, length, hash, &slot);
+    }
+    if (pool->count == pool->capacity && !grow_entries(pool)) return -1;
+
+    size_t needed = pool->chars_used + (size_t)length + 1;
+    if (needed > pool->chars_capacity) {
+        size_t capacity = pool->chars_capacity * 2;
+        while (capacity < needed) capacity *= 2;
+        char* chars = (char*)realloc(pool->chars, capacity);
+        if (!chars) return -1;
+        pool->chars = chars;
+        pool->chars_capacity = capacity;
+    }
+
+    id = pool->count++;
+    pool->offsets[id] = pool->chars_used;
+    pool->hashes[id] = hash;
+    pool->lengths[id] = length;
+    memcpy(pool->chars + pool->chars_used, text, (size_t)length);
+    pool->chars[pool->chars_used + (size_t)length] = '\0';
+    pool->chars_used = needed;
+    pool->table[slot] = id;
+    return id;
+}
+
+int string_pool_intern(StringPool* pool, const char* text, int length) {
+    if (!pool || !text || length < 0) return -1;
+    return intern_hashed(pool, text, length, string_pool_hash(text, length));
+}
+
+int string_pool_find(const StringPool* pool, const char* text, int length) {
+    if (!pool || !text || length < 0) return -1;
+    return lookup(pool, text, length, string_pool_hash(text, length), NULL);
+}
+
+const char* string_pool_get(const StringPool* pool, int id) {
+    if (!pool || id < 0 || id >= pool->count) return "";
+    return pool->chars + pool->offsets[id];
+}
+
+int string_pool_length(const StringPool* pool, int id) {
+    if (!pool || id < 0 || id >= pool->count) return 0;
+    return pool->lengths[id];
+}
+
+// --- Sharded pool ---
+
+ShardedStringPool* create_sharded_pool(void) {
+    ShardedStringPool* pool = (ShardedStringPool*)calloc(1, sizeof(ShardedStringPool));
+    if (!pool) return NULL;
+    for (int i = 0; i < STRING_POOL_SHARDS; i++) {
+        pool->shards[i].pool = create_string_pool();
+        if (!pool->shards[i].pool) {
+            destroy_sharded_pool(pool);
+            return NULL;
+        }
+        pthread_mutex_init(&pool->shards[i].lock, NULL);
+    }
+    return pool;
+}
+
+void destroy_sharded_pool(ShardedStringPool* pool) {
+    if (!pool) return;
+    for (int i = 0; i < STRING_POOL_SHARDS; i++) {
+        if (!pool->shards[i].pool) continue;
+        destroy_string_pool(pool->shards[i].pool);
+        pthread_mutex_destroy(&pool->shards[i].lock);
+    }
+    free(pool);
+}
+
+int sharded_pool_intern(ShardedStringPool* pool, const char* text, int length) {
+    if (!pool || !text || length < 0) return -1;
+
+    // The top hash bits pick the shard; the shard's table uses the low bits
+    uint32_t hash = string_pool_hash(text, length);
+    int shard_index = (int)(hash >> 26) & (STRING_POOL_SHARDS - 1);
+    StringPoolShard* shard = &pool->shards[shard_index];
+
+    pthread_mutex_lock(&shard->lock);
+    int local_id = intern_hashed(shard->pool, text, length, hash);
+    pthread_mutex_unlock(&shard->lock);
+
+    return local_id < 0 ? -1 : local_id * STRING_POOL_SHARDS + shard_index;
+}
+
+int sharded_pool_count(const ShardedStringPool* pool) {
+    int count = 0;
+    for (int i = 0; i < STRING_POOL_SHARDS; i++) count += pool->shards[i].pool->count;
+    return count;
+}
+
+int sharded_pool_flatten(const ShardedStringPool* pool, StringPool* destination, int shard_base[STRING_POOL_SHARDS]) {
+    int base = 0;
+    for (int i = 0; i < STRING_POOL_SHARDS; i++) {
+        const StringPool* shard = pool->shards[i].pool;
+        shard_base[i] = base;
+        for (int id = 0; id < shard->count; id++) {
+            if (intern_hashed(destination, shard->chars + shard->offsets[id], shard->lengths[id],
+                              shard->hashes[id]) != base + id) {
+                return -1;
+            }
+        }
+        base += shard->count;
+    }
+    return 0;
+}
+
+int sharded_pool_dense_id(const int shard_base[STRING_POOL_SHARDS], int id) {
+    return shard_base[id % STRING_POOL_SHARDS] + id / STRING_POOL_SHARDS;
+}
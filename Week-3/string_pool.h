@@ -0,0 +1,138 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Interned names.
+//
+// Every distinct string is stored once in a growing character arena and gets a
+// dense ID (0, 1, 2, ... in first-seen order). Lookups go through an
+// open-addressing hash table of IDs, so interning a name that is already known
+// costs one hash and one memcmp and allocates nothing.
+
+typedef struct {
+    char* chars;           // NUL-terminated names back to back
+    size_t chars_used;
+    size_t chars_capacity;
+
+    size_t* offsets;       // ID -> offset into chars
+    uint32_t* hashes;      // ID -> hash of the name
+    int* lengths;          // ID -> length of the name
+    int count;
+    int capacity;
+
+    int* table;            // Hash slot -> ID, or -1 when empty
+    size_t table_mask;     // Slot count - 1 (a power of two)
+} StringPool;
+
+/**
+ * @brief Allocates an empty pool.
+ * @return New pool, or NULL on allocation failure.
+ */
+StringPool* create_string_pool(void);
+
+/**
+ * @brief Frees a pool and all its strings.
+ */
+void destroy_string_pool(StringPool* pool);
+
+/**
+ * @brief Forgets every string but keeps the allocated storage.
+ */
+void clear_string_pool(StringPool* pool);
+
+/**
+ * @brief Hash used by the pool (FNV-1a), exposed for callers that pre-hash.
+ */
+uint32_t string_pool_hash(const char* text, int length);
+
+/**
+ * @brief Returns the ID of a string, adding it if it is new.
+ * @param pool The pool.
+ * @param text Characters of the string (need not be NUL-terminated).
+ * @param length Number of characters.
+ * @return The ID, or -1 on allocation failure.
+ */
+int string_pool_intern(StringPool* pool, const char* text, int length);
+
+/**
+ * @brief Looks a string up without adding it.
+ * @return The ID, or -1 if the string is not in the pool.
+ */
+int string_pool_find(const StringPool* pool, const char* text, int length);
+
+/**
+ * @brief Returns the NUL-terminated string for an ID.
+ *
+ * The pointer stays valid until the next string_pool_intern() that adds a string.
+ */
+const char* string_pool_get(const StringPool* pool, int id);
+
+/**
+ * @brief Returns the length of the string for an ID.
+ */
+int string_pool_length(const StringPool* pool, int id);
+
+// --- Sharded pool for concurrent interning ---
+//
+// Names are spread over STRING_POOL_SHARDS independent pools by hash, each with
+// its own lock, so threads interning different names rarely wait for each
+// other. An ID encodes its shard: id = local_id * STRING_POOL_SHARDS + shard.
+// IDs are unique and stable but not dense; sharded_pool_flatten() renumbers
+// them 0..count-1 once interning is finished.
+
+#define STRING_POOL_SHARDS 64
+
+typedef struct {
+    pthread_mutex_t lock;
+    StringPool* pool;
+    char pad[64];              // Keep neighbouring locks off one cache line
+} StringPoolShard;
+
+typedef struct {
+    StringPoolShard shards[STRING_POOL_SHARDS];
+} ShardedStringPool;
+
+/**
+ * @brief Allocates an empty sharded pool.
+ * @return New pool, or NULL on allocation failure.
+ */
+ShardedStringPool* create_sharded_pool(void);
+
+/**
+ * @brief Frees a sharded pool.
+ */
+void destroy_sharded_pool(ShardedStringPool* pool);
+
+/**
+ * @brief Thread-safe string_pool_intern().
+ * @return The (sparse) ID, or -1 on allocation failure.
+ */
+int sharded_pool_intern(ShardedStringPool* pool, const char* text, int length);
+
+/**
+ * @brief Number of distinct strings. Not thread-safe against concurrent interning.
+ */
+int sharded_pool_count(const ShardedStringPool* pool);
+
+/**
+ * @brief Copies every string into a plain pool in dense-ID order.
+ *
+ * Afterwards sharded_pool_dense_id(shard_base, id) is the string's ID in
+ * destination (which must start empty).
+ * Not thread-safe against concurrent interning.
+ * @param pool The sharded pool.
+ * @param destination Empty pool to fill.
+ * @param shard_base Receives STRING_POOL_SHARDS offsets.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int sharded_pool_flatten(const ShardedStringPool* pool, StringPool* destination, int shard_base[STRING_POOL_SHARDS]);
+
+/**
+ * @brief Maps a sharded ID to its dense ID using the offsets from sharded_pool_flatten().
+ */
+int sharded_pool_dense_id(const int shard_base[STRING_POOL_SHARDS], int id);
+
+#endif // STRING_POOL_H
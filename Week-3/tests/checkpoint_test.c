@@ -0,0 +1,179 @@
+// Round-trips simulation checkpoints and deltas (sim_checkpoint.h).
+//
+// Usage: checkpoint_test <netlist> [rounds]
+//
+// Each round simulates a random vector (with some X inputs), checkpoints it,
+// simulates a second vector and captures the delta between the two. Rolling
+// the delta back must give the first state, applying it again the second,
+// and restoring or copying a checkpoint must give back exactly what it
+// captured. Exits with 1 at the first difference.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_parser.h"
+#include "circuit_builder.h"
+#include "circuit_node.h"
+#include "sim_checkpoint.h"
+#include "splitmix.h"
+
+#define DEFAULT_ROUNDS 200
+
+static SignalValue random_value(uint64_t* state) {
+    uint64_t r = next_random(state) % 8;
+    return r == 0 ? LOGIC_X : (r & 1) ? LOGIC_1 : LOGIC_0;
+}
+
+static void simulate_random_vector(Circuit* circuit, SignalValue* inputs, uint64_t* state) {
+    for (int i = 0; i < circuit->pi_count; i++) inputs[i] = random_value(state);
+    reset_simulation(circuit);
+    set_primary_inputs(circuit, inputs);
+    simulate_circuit(circuit);
+}
+
+static void save_values(const Circuit* circuit, SignalValue* values) {
+    for (int i = 0; i < circuit->node_count; i++) values[i] = circuit->nodes[i].value;
+}
+
+// Returns the first node whose value differs from values[], or -1
+static int first_difference(const Circuit* circuit, const SignalValue* values) {
+    for (int i = 0; i < circuit->node_count; i++) {
+        if (circuit->nodes[i].value != values[i]) return i;
+    }
+    return -1;
+}
+
+static bool check_state(const Circuit* circuit, const SignalValue* values, int round, const char* step) {
+    int id = first_difference(circuit, values);
+    if (id < 0) return true;
+    fprintf(stderr, "Error: Round %d, %s: node %s is %c, expected %c\n", round, step,
+            circuit->nodes[id].name, signal_value_to_char(circuit->nodes[id].value),
+            signal_value_to_char(values[id]));
+    return false;
+}
+
+static bool run_round(Circuit* circuit, SignalValue* inputs, SignalValue* first, SignalValue* second,
+                      SignalValue* scratch, SimDelta* delta, uint64_t* state, int round) {
+    simulate_random_vector(circuit, inputs, state);
+    save_values(circuit, first);
+    bool first_stable = circuit->simulation_stable;
+    int first_iterations = circuit->iteration_count;
+    SimCheckpoint* base = create_checkpoint(circuit);
+    if (!base) {
+        fprintf(stderr, "Error: Out of memory creating checkpoint\n");
+        return false;
+    }
+
+    simulate_random_vector(circuit, inputs, state);
+    save_values(circuit, second);
+    int changed = 0;
+    for (int i = 0; i < circuit->node_count; i++) changed += (first[i] != second[i]);
+
+    bool ok = true;
+    int count = capture_delta(delta, base, circuit);
+    if (count != changed) {
+        fprintf(stderr, "Error: Round %d: delta recorded %d nodes, %d changed\n", round, count, changed);
+        ok = false;
+    }
+    for (int i = 1; ok && i < count; i++) {
+        if (delta->node_ids[i - 1] >= delta->node_ids[i]) {
+            fprintf(stderr, "Error: Round %d: delta node IDs are not ascending\n", round);
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        rollback_delta(delta, base, circuit);
+        ok = check_state(circuit, first, round, "rollback_delta");
+    }
+    if (ok && (circuit->simulation_stable != first_stable || circuit->iteration_count != first_iterations)) {
+        fprintf(stderr, "Error: Round %d: rollback_delta did not restore the stability flags\n", round);
+        ok = false;
+    }
+    if (ok) {
+        apply_delta(delta, circuit);
+        ok = check_state(circuit, second, round, "apply_delta");
+    }
+
+    // The second state through a copy of its own checkpoint, then the first
+    // state by copying the base over it
+    SimCheckpoint* copy = ok ? create_checkpoint(circuit) : NULL;
+    if (ok && !copy) {
+        fprintf(stderr, "Error: Out of memory creating checkpoint\n");
+        ok = false;
+    }
+    if (ok) {
+        reset_simulation(circuit);
+        restore_checkpoint(copy, circuit);
+        ok = check_state(circuit, second, round, "restore_checkpoint");
+    }
+    if (ok && !copy_checkpoint(copy, base)) {
+        fprintf(stderr, "Error: Round %d: copy_checkpoint rejected checkpoints of the same size\n", round);
+        ok = false;
+    }
+    if (ok) {
+        restore_checkpoint(copy, circuit);
+        ok = check_state(circuit, first, round, "copy_checkpoint");
+    }
+
+    // Flat value arrays, as used by the value-array engines
+    if (ok) {
+        capture_checkpoint_values(copy, second);
+        for (int i = 0; i < circuit->node_count; i++) scratch[i] = LOGIC_X;
+        restore_checkpoint_values(copy, scratch);
+        for (int i = 0; ok && i < circuit->node_count; i++) {
+            if (scratch[i] != second[i]) {
+                fprintf(stderr, "Error: Round %d: restore_checkpoint_values changed node %s\n",
+                        round, circuit->nodes[i].name);
+                ok = false;
+            }
+        }
+    }
+
+    destroy_checkpoint(copy);
+    destroy_checkpoint(base);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <netlist> [rounds]\n", argv[0]);
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+
+    NetlistSummary summary;
+    Circuit* circuit = (detect_netlist_format(argv[1]) == NETLIST_BENCH)
+        ? build_circuit_from_bench_file(argv[1], false, &summary)
+        : build_circuit_from_file(argv[1], false, &summary);
+    if (!circuit) return 1;
+
+    int n = circuit->node_count > 0 ? circuit->node_count : 1;
+    SignalValue* inputs = (SignalValue*)malloc((size_t)(circuit->pi_count + 1) * sizeof(SignalValue));
+    SignalValue* first = (SignalValue*)malloc((size_t)n * sizeof(SignalValue));
+    SignalValue* second = (SignalValue*)malloc((size_t)n * sizeof(SignalValue));
+    SignalValue* scratch = (SignalValue*)malloc((size_t)n * sizeof(SignalValue));
+    SimDelta* delta = create_delta();
+    int status = 0;
+    if (!inputs || !first || !second || !scratch || !delta) {
+        fprintf(stderr, "Error: Out of memory\n");
+        status = 1;
+    }
+
+    uint64_t state = 0xC0FFEEULL;
+    for (int round = 0; status == 0 && round < rounds; round++) {
+        if (!run_round(circuit, inputs, first, second, scratch, delta, &state, round)) status = 1;
+    }
+    if (status == 0) {
+        printf("Checkpoint round trips: %d rounds on %s (%d nodes) passed\n", rounds, argv[1], circuit->node_count);
+    }
+
+    destroy_delta(delta);
+    free(inputs);
+    free(first);
+    free(second);
+    free(scratch);
+    destroy_circuit(circuit);
+    return status;
+}
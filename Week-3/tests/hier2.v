@@ -0,0 +1,26 @@
+// Two levels of hierarchy: a 3-bit ripple-carry adder of full adders, each
+// built from two half adders (named and positional port connections)
+module half_adder (a, b, s, c);
+input a, b;
+output s, c;
+xor g1 (s, a, b);
+and g2 (c, a, b);
+endmodule
+
+module full_adder (a, b, cin, sum, cout);
+input a, b, cin;
+output sum, cout;
+wire s1, c1, c2;
+half_adder h1 (.a(a), .b(b), .s(s1), .c(c1));
+half_adder h2 (s1, cin, sum, c2);
+or g1 (cout, c1, c2);
+endmodule
+
+module hier2 (a0, a1, a2, b0, b1, b2, cin, s0, s1, s2, cout);
+input a0, a1, a2, b0, b1, b2, cin;
+output s0, s1, s2, cout;
+wire k0, k1;
+full_adder f0 (.a(a0), .b(b0), .cin(cin), .sum(s0), .cout(k0));
+full_adder f1 (.a(a1), .b(b1), .cin(k0), .sum(s1), .cout(k1));
+full_adder f2 (a2, b2, k1, s2, cout);
+endmodule
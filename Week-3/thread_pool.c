@@ -0,0 +1,264 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    ThreadPoolTask task;
+    void* arg;
+} PoolTask;
+
+// Growable ring used as a deque: the owner works at the bottom, thieves take the top
+typedef struct {
+    pthread_mutex_t lock;
+    PoolTask* items;
+    int capacity;
+    int top;          // Index of the oldest task
+    int count;
+} TaskDeque;
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} PoolWorker;
+
+struct ThreadPool {
+    int thread_count;
+    pthread_t* threads;
+    PoolWorker* workers;
+    TaskDeque* deques;
+
+    pthread_mutex_t lock;         // Guards the counters and condition variables below
+    pthread_cond_t work_available;
+    pthread_cond_t all_done;
+    long long queued;             // Tasks sitting in some deque
+    long long outstanding;        // Submitted but not yet finished
+    long long steals;
+    unsigned int next_deque;      // Round-robin target for external submissions
+    bool shutting_down;
+};
+
+// Index of the pool worker running on this thread, or -1
+static __thread int current_worker = -1;
+static __thread ThreadPool* current_pool = NULL;
+
+static bool deque_push_bottom(TaskDeque* deque, PoolTask task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        int capacity = deque->capacity ? deque->capacity * 2 : 64;
+        PoolTask* items = (PoolTask*)malloc(capacity * sizeof(PoolTask));
+        if (!items) {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
+        for (int i = 0; i < deque->count; i++) {
+            items[i] = deque->items[(deque->top + i) % deque->capacity];
+        }
+        free(deque->items);
+        deque->items = items;
+        deque->capacity = capacity;
+        deque->top = 0;
+    }
+    deque->items[(deque->top + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+static bool deque_pop_bottom(TaskDeque* deque, PoolTask* task) {
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        deque->count--;
+        *task = deque->items[(deque->top + deque->count) % deque->capacity];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool deque_steal_top(TaskDeque* deque, PoolTask* task) {
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        *task = deque->items[deque->top];
+        deque->top = (deque->top + 1) % deque->capacity;
+        deque->count--;
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool find_task(ThreadPool* pool, int index, PoolTask* task) {
+    if (deque_pop_bottom(&pool->deques[index], task)) return true;
+
+    for (int offset = 1; offset < pool->thread_count; offset++) {
+        int victim = (index + offset) % pool->thread_count;
+        if (deque_steal_top(&pool->deques[victim], task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->steals++;
+            pthread_mutex_unlock(&pool->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* pool_worker_main(void* arg) {
+    PoolWorker* worker = (PoolWorker*)arg;
+    ThreadPool* pool = worker->pool;
+    current_worker = worker->index;
+    current_pool = pool;
+
+    for (;;) {
+        PoolTask task;
+        if (find_task(pool, worker->index, &task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            task.task(task.arg, worker->index);
+
+            pthread_mutex_lock(&pool->lock);
+            if (--pool->outstanding == 0) pthread_cond_broadcast(&pool->all_done);
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->shutting_down) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        bool stop = (pool->shutting_down && pool->queued == 0);
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+ThreadPool* thread_pool_create(int thread_count) {
+    if (thread_count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (int)cpus : 1;
+    }
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->thread_count = thread_count;
+    pool->threads = (pthread_t*)calloc(thread_count, sizeof(pthread_t));
+    pool->workers = (PoolWorker*)calloc(thread_count, sizeof(PoolWorker));
+    pool->deques = (TaskDeque*)calloc(thread_count, sizeof(TaskDeque));
+    if (!pool->threads || !pool->workers || !pool->deques) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, pool_worker_main, &pool->workers[i]) != 0) {
+            fprintf(stderr, "Warning: Started only %d of %d pool threads\n", i, thread_count);
+            pool->thread_count = i;
+            break;
+        }
+    }
+    if (pool->thread_count == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    thread_pool_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].items);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool);
+}
+
+bool thread_pool_submit(ThreadPool* pool, ThreadPoolTask task, void* arg) {
+    if (!pool || !task) return false;
+
+    PoolTask item = { task, arg };
+    int target;
+    if (current_pool == pool && current_worker >= 0) {
+        target = current_worker;
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        target = (int)(pool->next_deque++ % (unsigned int)pool->thread_count);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    // Count first so waiters never see outstanding == 0 while the task is queued
+    pthread_mutex_lock(&pool->lock);
+    pool->outstanding++;
+    pool->queued++;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!deque_push_bottom(&pool->deques[target], item)) {
+        pthread_mutex_lock(&pool->lock);
+        pool->queued--;
+        if (--pool->outstanding == 0) pthread_cond_broadcast(&pool->all_done);
+        pthread_mutex_unlock(&pool->lock);
+        return false;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+void thread_pool_wait(ThreadPool* pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    while (pool->outstanding > 0) {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int thread_pool_size(const ThreadPool* pool) {
+    return pool ? pool->thread_count : 0;
+}
+
+long long thread_pool_steal_count(ThreadPool* pool) {
+    if (!pool) return 0;
+    pthread_mutex_lock(&pool->lock);
+    long long steals = pool->steals;
+    pthread_mutex_unlock(&pool->lock);
+    return steals;
+}
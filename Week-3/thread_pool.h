@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+
+// Work-stealing thread pool.
+//
+// Each worker owns a deque. Tasks submitted from a worker go to the bottom of
+// its own deque and are taken back LIFO (cache-warm); tasks submitted from
+// outside are dealt round-robin. An idle worker steals from the top of the
+// other deques before going to sleep.
+
+typedef void (*ThreadPoolTask)(void* arg, int worker_index);
+
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief Starts a pool.
+ * @param thread_count Number of workers (<= 0 uses the online CPU count).
+ * @return New pool, or NULL on failure.
+ */
+ThreadPool* thread_pool_create(int thread_count);
+
+/**
+ * @brief Waits for outstanding tasks, stops the workers and frees the pool.
+ */
+void thread_pool_destroy(ThreadPool* pool);
+
+/**
+ * @brief Queues a task. Safe to call from inside a running task.
+ * @return false on allocation failure.
+ */
+bool thread_pool_submit(ThreadPool* pool, ThreadPoolTask task, void* arg);
+
+/**
+ * @brief Blocks until every submitted task (including tasks they submitted) has finished.
+ *
+ * Must not be called from inside a task.
+ */
+void thread_pool_wait(ThreadPool* pool);
+
+/**
+ * @brief Number of worker threads.
+ */
+int thread_pool_size(const ThreadPool* pool);
+
+/**
+ * @brief Number of tasks taken from another worker's deque so far.
+ */
+long long thread_pool_steal_count(ThreadPool* pool);
+
+#endif // THREAD_POOL_H
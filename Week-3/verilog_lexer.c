@@ -0,0 +1,212 @@
+#include "verilog_lexer.h"
+#include "input_stream.h"
+#include "sim_stats.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- Keyword perfect hash ---
+// h = (2 * (first + last) + length) mod 32 is collision-free over the keyword
+// set, so a lookup is one table probe plus one memcmp.
+#define KEYWORD_TABLE_SIZE 32
+
+typedef struct {
+    const char* text;
+    int length;
+    VerilogKeyword keyword;
+} KeywordEntry;
+
+static const KeywordEntry keyword_table[KEYWORD_TABLE_SIZE] = {
+    [10] = { "module", 6, KW_MODULE },
+    [29] = { "endmodule", 9, KW_ENDMODULE },
+    [31] = { "input", 5, KW_INPUT },
+    [12] = { "output", 6, KW_OUTPUT },
+    [28] = { "wire", 4, KW_WIRE },
+    [13] = { "and", 3, KW_AND },
+    [8]  = { "nand", 4, KW_NAND },
+    [4]  = { "or", 2, KW_OR },
+    [3]  = { "nor", 3, KW_NOR },
+    [23] = { "xor", 3, KW_XOR },
+    [24] = { "xnor", 4, KW_XNOR },
+    [7]  = { "not", 3, KW_NOT },
+    [19] = { "buf", 3, KW_BUF },
+    [20] = { "buff", 4, KW_BUFF },
+};
+
+static unsigned keyword_hash(const char* text, int length) {
+    return (2u * ((unsigned char)text[0] + (unsigned char)text[length - 1]) + (unsigned)length) & (KEYWORD_TABLE_SIZE - 1);
+}
+
+VerilogKeyword lookup_keyword(const char* text, int length) {
+    if (length < 2 || length > 9) return KW_NONE;
+    const KeywordEntry* entry = &keyword_table[keyword_hash(text, length)];
+    if (entry->length == length && memcmp(entry->text, text, (size_t)length) == 0) return entry->keyword;
+    return KW_NONE;
+}
+
+GateType keyword_gate_type(VerilogKeyword keyword) {
+    switch (keyword) {
+        case KW_AND:  return GATE_AND;
+        case KW_NAND: return GATE_NAND;
+        case KW_OR:   return GATE_OR;
+        case KW_NOR:  return GATE_NOR;
+        case KW_XOR:  return GATE_XOR;
+        case KW_XNOR: return GATE_XNOR;
+        case KW_NOT:  return GATE_NOT;
+        case KW_BUF:
+        case KW_BUFF: return GATE_BUFF;
+        default:      return GATE_UNKNOWN;
+    }
+}
+
+bool token_equals(const Token* token, const char* text) {
+    size_t length = strlen(text);
+    return (size_t)token->length == length && memcmp(token->text, text, length) == 0;
+}
+
+// --- Input ---
+void lexer_init_buffer(VerilogLexer* lexer, const char* data, size_t size) {
+    memset(lexer, 0, sizeof(*lexer));
+    lexer->data = data;
+    lexer->size = size;
+    lexer->cursor = data;
+    lexer->end = data + size;
+    lexer->line = 1;
+}
+
+int lexer_open(VerilogLexer* lexer, const char* filename) {
+    lexer_init_buffer(lexer, "", 0);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 1;
+
+    // Plain regular files are mapped; compressed files and pipes are decoded into one buffer
+    struct stat info;
+    unsigned char head[4];
+    ssize_t head_length = pread(fd, head, sizeof(head), 0);
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 && head_length > 0 &&
+        detect_compression(head, (size_t)head_length) == COMPRESSION_NONE) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            posix_madvise(mapping, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+            close(fd);
+            lexer_init_buffer(lexer, (const char*)mapping, (size_t)info.st_size);
+            lexer->mapping = mapping;
+            SIM_STAT_ADD(bytes_read, (long long)info.st_size);
+            return 0;
+        }
+    }
+
+    InputStream* stream = open_input_descriptor(fd, filename);
+    if (!stream) return 1;
+    size_t size = 0;
+    char* buffer = read_entire_stream(stream, &size);
+    int saved_errno = errno;
+    close_input_stream(stream);
+    if (!buffer) {
+        errno = saved_errno;
+        return 1;
+    }
+    lexer_init_buffer(lexer, buffer, size);
+    lexer->buffer = buffer;
+    return 0;
+}
+
+void lexer_close(VerilogLexer* lexer) {
+    if (lexer->mapping) munmap(lexer->mapping, lexer->size);
+    free(lexer->buffer);
+    lexer_init_buffer(lexer, "", 0);
+}
+
+// --- Scanning ---
+static bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '$' || c == '.';
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Skips whitespace and comments; returns false at end of input
+static bool skip_trivia(VerilogLexer* lexer) {
+    const char* p = lexer->cursor;
+    const char* end = lexer->end;
+
+    while (p < end) {
+        if (*p == '\n') {
+            lexer->line++;
+            p++;
+        } else if (is_space(*p)) {
+            p++;
+        } else if (*p == '/' && p + 1 < end && p[1] == '/') {
+            const char* newline = memchr(p, '\n', (size_t)(end - p));
+            p = newline ? newline : end;
+        } else if (*p == '/' && p + 1 < end && p[1] == '*') {
+            p += 2;
+            while (p < end && !(*p == '*' && p + 1 < end && p[1] == '/')) {
+                if (*p == '\n') lexer->line++;
+                p++;
+            }
+            p = (p < end) ? p + 2 : end;
+        } else {
+            break;
+        }
+    }
+    lexer->cursor = p;
+    return p < end;
+}
+
+bool lexer_next(VerilogLexer* lexer, Token* token) {
+    token->keyword = KW_NONE;
+    if (!skip_trivia(lexer)) {
+        token->kind = TOKEN_EOF;
+        token->text = lexer->end;
+        token->length = 0;
+        token->line = lexer->line;
+        return false;
+    }
+
+    const char* p = lexer->cursor;
+    const char* end = lexer->end;
+    token->line = lexer->line;
+    token->text = p;
+
+    if (*p == '\\') {
+        // Escaped identifier: everything up to the next whitespace, without the backslash
+        const char* start = ++p;
+        while (p < end && !is_space(*p)) p++;
+        token->kind = TOKEN_IDENTIFIER;
+        token->text = start;
+        token->length = (int)(p - start);
+    } else if (is_identifier_char(*p)) {
+        while (p < end && is_identifier_char(*p)) p++;
+        // A directly attached bit-select ("a[3]") stays part of the name
+        while (p < end && *p == '[') {
+            const char* close = p + 1;
+            while (close < end && *close >= '0' && *close <= '9') close++;
+            if (close == p + 1 || close >= end || *close != ']') break;
+            p = close + 1;
+        }
+        token->kind = TOKEN_IDENTIFIER;
+        token->length = (int)(p - token->text);
+        token->keyword = lookup_keyword(token->text, token->length);
+    } else {
+        switch (*p) {
+            case '(': token->kind = TOKEN_LPAREN; break;
+            case ')': token->kind = TOKEN_RPAREN; break;
+            case ',': token->kind = TOKEN_COMMA; break;
+            case ';': token->kind = TOKEN_SEMICOLON; break;
+            default:  token->kind = TOKEN_OTHER; break;
+        }
+        p++;
+        token->length = 1;
+    }
+
+    lexer->cursor = p;
+    return true;
+}
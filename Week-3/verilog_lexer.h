@@ -0,0 +1,103 @@
+#ifndef VERILOG_LEXER_H
+#define VERILOG_LEXER_H
+
+#include "verilog_parser.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Zero-copy Verilog tokenizer.
+//
+// The file is memory-mapped (or read into one buffer when it is compressed
+// or cannot be mapped, see input_stream.h) and scanned once. Tokens are
+// (pointer, length) views into that buffer, so nothing is copied until the
+// parser stores a name, and line length is unlimited. Keywords are
+// recognised through a perfect hash.
+
+typedef enum {
+    TOKEN_EOF,
+    TOKEN_IDENTIFIER,   // Names and keywords (keyword != KW_NONE)
+    TOKEN_LPAREN,
+    TOKEN_RPAREN,
+    TOKEN_COMMA,
+    TOKEN_SEMICOLON,
+    TOKEN_OTHER         // Any other single character
+} TokenKind;
+
+typedef enum {
+    KW_NONE,
+    KW_MODULE,
+    KW_ENDMODULE,
+    KW_INPUT,
+    KW_OUTPUT,
+    KW_WIRE,
+    KW_AND,
+    KW_NAND,
+    KW_OR,
+    KW_NOR,
+    KW_XOR,
+    KW_XNOR,
+    KW_NOT,
+    KW_BUF,
+    KW_BUFF
+} VerilogKeyword;
+
+typedef struct {
+    TokenKind kind;
+    VerilogKeyword keyword;
+    const char* text;   // Not NUL-terminated
+    int length;
+    int line;
+} Token;
+
+typedef struct {
+    const char* data;
+    size_t size;
+    const char* cursor;
+    const char* end;
+    int line;
+    void* mapping;      // mmap'd region, or NULL
+    char* buffer;       // Heap copy when the file was not mapped
+} VerilogLexer;
+
+/**
+ * @brief Opens a file for tokenizing.
+ * @param lexer Lexer to initialize.
+ * @param filename Path of the Verilog file.
+ * @return 0 on success, 1 if the file cannot be opened or read (errno is set).
+ */
+int lexer_open(VerilogLexer* lexer, const char* filename);
+
+/**
+ * @brief Tokenizes a caller-owned buffer (must outlive the lexer).
+ */
+void lexer_init_buffer(VerilogLexer* lexer, const char* data, size_t size);
+
+/**
+ * @brief Releases the mapping or buffer.
+ */
+void lexer_close(VerilogLexer* lexer);
+
+/**
+ * @brief Reads the next token, skipping whitespace and comments.
+ * @return false at end of input (token->kind is then TOKEN_EOF).
+ */
+bool lexer_next(VerilogLexer* lexer, Token* token);
+
+/**
+ * @brief Perfect-hash keyword lookup.
+ * @return The keyword, or KW_NONE.
+ */
+VerilogKeyword lookup_keyword(const char* text, int length);
+
+/**
+ * @brief Gate primitive of a keyword.
+ * @return The gate type, or GATE_UNKNOWN if the keyword is not a primitive.
+ */
+GateType keyword_gate_type(VerilogKeyword keyword);
+
+/**
+ * @brief Tests whether a token spells a given string.
+ */
+bool token_equals(const Token* token, const char* text);
+
+#endif // VERILOG_LEXER_H
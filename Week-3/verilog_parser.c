@@ -1,390 +1,445 @@
 #include "verilog_parser.h"
+#include "verilog_lexer.h"
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
 
-#define MAX_LINE_LENGTH 1024
-#define MAX_ACCUMULATOR_SIZE (MAX_LINE_LENGTH * 10) // For multi-line declarations
-
-// --- Global Variable Definitions ---
-// Header data
-char module_name[MAX_NAME_LENGTH];
-Signal module_ports[MAX_PORTS];
-int module_port_count = 0;
-Signal input_signals[MAX_SIGNALS];
-int input_count = 0;
-Signal output_signals[MAX_SIGNALS];
-int output_count = 0;
-Signal wire_signals[MAX_SIGNALS];
-int wire_count = 0;
-
-// Gate data
-GateInstance parsed_gates[MAX_GATE_INSTANCES];
-int parsed_gate_count = 0;
-
-// --- Internal State Variables (static to this file) ---
-typedef enum { // Keep ParseState local if only used here
-    PARSING_NONE,
-    PARSING_MODULE_PORTS,
-    PARSING_INPUTS,
-    PARSING_OUTPUTS,
-    PARSING_WIRES
-} ParseState;
-
-static ParseState current_parsing_state = PARSING_NONE;
-static char accumulator[MAX_ACCUMULATOR_SIZE]; // MAX_ACCUMULATOR_SIZE defined as in previous step
-static int accumulator_len = 0;
-
+// State of one parse_verilog_stream() call
+typedef struct {
+    const ParseSink* sink;
+    VerilogLexer lexer;
+    NameView* inputs;          // Input names of the gate being read (actuals of an instance)
+    int input_capacity;
+    NameView* formals;         // Port names of the instance being read
+    int formal_capacity;
+    bool stopped;              // A callback failed or memory ran out
+} Parser;
 
 // --- Static (Private) Helper Functions ---
-// trim_token, trim_whitespace_only, process_accumulated_signals (from previous step)
-
-// (Keep existing static helper functions: trim_token, trim_whitespace_only, process_accumulated_signals)
-// Trim leading/trailing whitespace and trailing commas/semicolons from a token
-static char *trim_token(char *str) {
-    char *start = str;
-    while (isspace((unsigned char)*start)) start++;
-    if (*start == 0) return start;
-    char *end = start + strlen(start) - 1;
-    while (end >= start && (isspace((unsigned char)*end) || *end == ',' || *end == ';')) {
-        end--;
-    }
-    *(end + 1) = 0;
-    return start;
-}
 
-// Trim only leading and trailing whitespace from a string
-static char *trim_whitespace_only(char *str) {
-    char *original_end, *new_end;
-    while (isspace((unsigned char)*str)) str++;
-    if (*str == 0) return str;
-    original_end = str + strlen(str) - 1;
-    new_end = original_end;
-    while (new_end > str && isspace((unsigned char)*new_end)) new_end--;
-    *(new_end + 1) = 0;
-    return str;
+static NameView token_view(const Token* token) {
+    NameView view = { token->text, token->length };
+    return view;
 }
 
-// Processes the content of the accumulator to extract signal names for header declarations
-static void process_accumulated_signals(Signal signals[], int *count, int max_elements) {
-    char *token;
-    // Create a mutable copy of the accumulator for strtok
-    char temp_accumulator[MAX_ACCUMULATOR_SIZE];
-    strncpy(temp_accumulator, accumulator, MAX_ACCUMULATOR_SIZE -1);
-    temp_accumulator[MAX_ACCUMULATOR_SIZE -1] = '\0';
-
-    char *trimmed_list_content = trim_whitespace_only(temp_accumulator);
-
-
-    char *saveptr; // For strtok_r
-    token = strtok_r(trimmed_list_content, ", \t\n", &saveptr);
-    while (token != NULL) {
-        char* clean_token = trim_token(token);
-        if (strlen(clean_token) > 0) {
-            if (*count < max_elements) {
-                 strncpy(signals[*count].name, clean_token, MAX_NAME_LENGTH - 1);
-                 signals[*count].name[MAX_NAME_LENGTH - 1] = '\0';
-                 (*count)++;
-            } else {
-                fprintf(stderr, "Warning: Parser exceeded max signals/ports capacity for current list.\n");
-                break;
-            }
-        }
-        token = strtok_r(NULL, ", \t\n", &saveptr);
+// Consumes tokens up to and including the next ';'
+static void skip_statement(Parser* parser) {
+    Token token;
+    while (lexer_next(&parser->lexer, &token) && token.kind != TOKEN_SEMICOLON) {
     }
-    accumulator[0] = '\0';
-    accumulator_len = 0;
-    current_parsing_state = PARSING_NONE; // Reset state after processing
 }
 
+// Reports a comma-separated name list up to the terminator token (consumed)
+static void read_signal_list(Parser* parser, TokenKind terminator, DeclarationKind kind) {
+    const ParseSink* sink = parser->sink;
+    Token token;
+    while (lexer_next(&parser->lexer, &token) && token.kind != terminator) {
+        if (token.kind != TOKEN_IDENTIFIER || parser->stopped) continue;
+        if (sink->declare && !sink->declare(sink->user, kind, token_view(&token))) parser->stopped = true;
+    }
+    if (token.kind == TOKEN_EOF) {
+        fprintf(stderr, "Warning: EOF reached while still reading a declaration list. Incomplete declaration.\n");
+    }
+}
 
-// New helper to convert gate type string to enum (case-insensitive for keywords)
-static GateType string_to_gate_type(const char* str) {
-    // For robust comparison, convert str to lower case or use strcasecmp if available/portable
-    // Assuming Verilog keywords are lowercase as in "nand" example:
-    if (strcmp(str, "and") == 0) return GATE_AND;
-    if (strcmp(str, "nand") == 0) return GATE_NAND;
-    if (strcmp(str, "or") == 0) return GATE_OR;
-    if (strcmp(str, "nor") == 0) return GATE_NOR;
-    if (strcmp(str, "xor") == 0) return GATE_XOR;
-    if (strcmp(str, "xnor") == 0) return GATE_XNOR;
-    if (strcmp(str, "not") == 0) return GATE_NOT;
-    if (strcmp(str, "buff") == 0 || strcmp(str, "buf") == 0) return GATE_BUFF; // Allow "buff" and "buf"
-    return GATE_UNKNOWN;
+static bool append_view(NameView** views, int* capacity, int count, NameView view) {
+    if (count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        NameView* grown = (NameView*)realloc(*views, (size_t)new_capacity * sizeof(NameView));
+        if (!grown) return false;
+        *views = grown;
+        *capacity = new_capacity;
+    }
+    (*views)[count] = view;
+    return true;
 }
 
-// New helper to check if a token is a gate type
-static int is_gate_type_keyword(const char* str) {
-    return string_to_gate_type(str) != GATE_UNKNOWN;
+static bool append_input(Parser* parser, int count, const Token* token) {
+    return append_view(&parser->inputs, &parser->input_capacity, count, token_view(token));
 }
 
-// New helper to parse a gate instantiation line
-static void parse_gate_instantiation_line(const char* line_content, const char* gate_keyword) {
-    if (parsed_gate_count >= MAX_GATE_INSTANCES) {
-        fprintf(stderr, "Warning: Maximum gate instances limit reached (%d).\n", MAX_GATE_INSTANCES);
+// Parses "<instance> ( out, in1, in2, ... ) ;" after a gate keyword
+static void parse_gate_instantiation(Parser* parser, const Token* keyword) {
+    const ParseSink* sink = parser->sink;
+    Token token;
+
+    // 1. Instance name
+    lexer_next(&parser->lexer, &token);
+    if (token.kind != TOKEN_IDENTIFIER) {
+        fprintf(stderr, "Error: Missing instance name for gate type %.*s on line %d\n",
+                keyword->length, keyword->text, keyword->line);
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
         return;
     }
-    GateInstance* current_gate = &parsed_gates[parsed_gate_count];
-    current_gate->type = string_to_gate_type(gate_keyword);
-    current_gate->input_signal_count = 0;
-    current_gate->instance_number = -1; // Default if not found or invalid
-    current_gate->base_name[0] = '\0';
-
-    const char* ptr = line_content + strlen(gate_keyword); // Move past gate keyword
-
-    // 1. Extract Instance Name
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++; // Skip spaces
-    if (!*ptr || *ptr == '(') {
-        fprintf(stderr, "Error: Missing instance name for gate type %s on line: %s\n", gate_keyword, line_content);
+    NameView instance = token_view(&token);
+
+    // 2. Port list: output first, then inputs
+    lexer_next(&parser->lexer, &token);
+    if (token.kind != TOKEN_LPAREN) {
+        fprintf(stderr, "Error: Missing '(' for port list of gate instance %.*s on line %d\n",
+                instance.length, instance.text, token.line);
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
         return;
     }
-    const char* instance_name_start = ptr;
-    while (*ptr && !isspace((unsigned char)*ptr) && *ptr != '(') ptr++; // Read until space or '('
-    size_t name_len = ptr - instance_name_start;
-    if (name_len == 0) {
-         fprintf(stderr, "Error: Empty instance name for gate type %s on line: %s\n", gate_keyword, line_content);
+
+    NameView output = { NULL, 0 };
+    int input_count = 0;
+    while (lexer_next(&parser->lexer, &token) && token.kind != TOKEN_RPAREN && token.kind != TOKEN_SEMICOLON) {
+        if (token.kind != TOKEN_IDENTIFIER) continue;
+        if (!output.text) {
+            output = token_view(&token);
+        } else if (append_input(parser, input_count, &token)) {
+            input_count++;
+        } else {
+            fprintf(stderr, "Error: Out of memory reading gate instance %.*s\n", instance.length, instance.text);
+            parser->stopped = true;
+            return;
+        }
+    }
+    if (token.kind != TOKEN_RPAREN) {
+        fprintf(stderr, "Error: Missing ')' for port list of gate instance %.*s on line %d\n",
+                instance.length, instance.text, token.line);
         return;
     }
-    if (name_len >= MAX_GATE_INSTANCE_NAME_LEN) name_len = MAX_GATE_INSTANCE_NAME_LEN - 1;
-    strncpy(current_gate->instance_name, instance_name_start, name_len);
-    current_gate->instance_name[name_len] = '\0';
-
-    // Parse instance_name into base_name and instance_number
-    char* last_underscore = strrchr(current_gate->instance_name, '_');
-    if (last_underscore) {
-        size_t base_name_len = last_underscore - current_gate->instance_name;
-        if (base_name_len < MAX_GATE_BASE_NAME_LEN) {
-            strncpy(current_gate->base_name, current_gate->instance_name, base_name_len);
-            current_gate->base_name[base_name_len] = '\0';
-        } else {
-            strncpy(current_gate->base_name, current_gate->instance_name, MAX_GATE_BASE_NAME_LEN - 1);
-            current_gate->base_name[MAX_GATE_BASE_NAME_LEN - 1] = '\0';
-            // fprintf(stderr, "Warning: Gate base name truncated: %s\n", current_gate->instance_name);
+    if (!output.text) {
+        fprintf(stderr, "Error: Empty port list for gate instance %.*s\n", instance.length, instance.text);
+        skip_statement(parser);
+        return;
+    }
+    skip_statement(parser);
+
+    if (sink->gate && !sink->gate(sink->user, keyword_gate_type(keyword->keyword), instance, output,
+                                  parser->inputs, input_count)) {
+        parser->stopped = true;
+    }
+}
+
+// Parses "<instance> ( .port(net), ... ) ;" or "<instance> ( net, ... ) ;" after
+// a module name. Anything else (assign, reg, parameters) is skipped.
+static void parse_module_instance(Parser* parser, const Token* module) {
+    const ParseSink* sink = parser->sink;
+    Token token;
+
+    lexer_next(&parser->lexer, &token);
+    if (token.kind != TOKEN_IDENTIFIER) {
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
+        return;
+    }
+    NameView instance = token_view(&token);
+    lexer_next(&parser->lexer, &token);
+    if (token.kind != TOKEN_LPAREN) {
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
+        return;
+    }
+
+    // The lexer keeps '.' in identifiers, so a named connection starts with a ".port" token
+    int count = 0;
+    int named = -1;     // Unknown until the first connection
+    const char* error = NULL;
+    while (!error && lexer_next(&parser->lexer, &token) && token.kind != TOKEN_RPAREN && token.kind != TOKEN_SEMICOLON) {
+        if (token.kind == TOKEN_COMMA) continue;
+        if (token.kind != TOKEN_IDENTIFIER) {
+            error = "Unsupported connection";
+            break;
         }
-        
-        char* num_part = last_underscore + 1;
-        if (strlen(num_part) > 0) {
-            int is_all_digits = 1;
-            for (size_t i = 0; i < strlen(num_part); ++i) {
-                if (!isdigit((unsigned char)num_part[i])) {
-                    is_all_digits = 0;
-                    break;
-                }
+
+        NameView formal = { NULL, 0 };
+        NameView actual = token_view(&token);
+        bool is_named = (token.text[0] == '.');
+        if (named >= 0 && is_named != (named == 1)) {
+            error = "Mixed named and positional connections";
+            break;
+        }
+        named = is_named ? 1 : 0;
+
+        if (is_named) {
+            formal.text = token.text + 1;
+            formal.length = token.length - 1;
+            actual.text = NULL;
+            actual.length = 0;
+            lexer_next(&parser->lexer, &token);
+            if (token.kind != TOKEN_LPAREN) {
+                error = "Missing '(' after port name";
+                break;
+            }
+            lexer_next(&parser->lexer, &token);
+            if (token.kind == TOKEN_IDENTIFIER) {
+                actual = token_view(&token);
+                lexer_next(&parser->lexer, &token);
             }
-            if (is_all_digits) {
-                current_gate->instance_number = atoi(num_part);
-            } else {
-                 // Not a number, so treat full name as base, no instance number effectively
-                strncpy(current_gate->base_name, current_gate->instance_name, MAX_GATE_BASE_NAME_LEN - 1);
-                current_gate->base_name[MAX_GATE_BASE_NAME_LEN-1] = '\0';
-                current_gate->instance_number = -1; // Or some other indicator for "not a numeric suffix"
+            if (token.kind != TOKEN_RPAREN) {
+                error = "Unsupported connection";
+                break;
             }
         }
-    } else { // No underscore
-        strncpy(current_gate->base_name, current_gate->instance_name, MAX_GATE_BASE_NAME_LEN - 1);
-        current_gate->base_name[MAX_GATE_BASE_NAME_LEN-1] = '\0';
-        current_gate->instance_number = 0; // Default if no underscore, or could be -1
+
+        if (!append_view(&parser->formals, &parser->formal_capacity, count, formal) ||
+            !append_view(&parser->inputs, &parser->input_capacity, count, actual)) {
+            fprintf(stderr, "Error: Out of memory reading instance %.*s\n", instance.length, instance.text);
+            parser->stopped = true;
+            return;
+        }
+        count++;
     }
+    if (error || token.kind != TOKEN_RPAREN) {
+        fprintf(stderr, "Error: %s in port list of instance %.*s on line %d\n",
+                error ? error : "Missing ')'", instance.length, instance.text, token.line);
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
+        return;
+    }
+    skip_statement(parser);
 
+    if (sink->instance && !sink->instance(sink->user, token_view(module), instance,
+                                          named == 1 ? parser->formals : NULL, parser->inputs, count)) {
+        parser->stopped = true;
+    }
+}
 
-    // 2. Extract Port List
-    while (*ptr && isspace((unsigned char)*ptr)) ptr++; // Skip spaces before '('
-    if (*ptr != '(') {
-        fprintf(stderr, "Error: Missing '(' for port list of gate instance %s on line: %s\n", current_gate->instance_name, line_content);
+// Parses "module <name> ( ports ) ;"
+static void parse_module_header(Parser* parser) {
+    const ParseSink* sink = parser->sink;
+    Token token;
+    lexer_next(&parser->lexer, &token);
+    if (token.kind != TOKEN_IDENTIFIER) {
+        fprintf(stderr, "Error: Module name missing.\n");
+        if (token.kind != TOKEN_SEMICOLON) skip_statement(parser);
         return;
     }
-    ptr++; // Skip '('
-    
-    const char* port_list_content_start = ptr;
-    const char* port_list_content_end = strrchr(port_list_content_start, ')'); // Find last ')'
-    if (!port_list_content_end) {
-        fprintf(stderr, "Error: Missing ')' for port list of gate instance %s on line: %s\n", current_gate->instance_name, line_content);
+    if (sink->module && !sink->module(sink->user, token_view(&token))) {
+        parser->stopped = true;
         return;
     }
 
-    char port_list_buffer[MAX_LINE_LENGTH]; // Assuming MAX_LINE_LENGTH is sufficient for the port list part
-    size_t port_list_len = port_list_content_end - port_list_content_start;
-    if (port_list_len >= MAX_LINE_LENGTH) port_list_len = MAX_LINE_LENGTH - 1;
-    strncpy(port_list_buffer, port_list_content_start, port_list_len);
-    port_list_buffer[port_list_len] = '\0';
+    lexer_next(&parser->lexer, &token);
+    if (token.kind == TOKEN_LPAREN) {
+        read_signal_list(parser, TOKEN_RPAREN, DECLARE_PORT);
+        skip_statement(parser);
+    } else if (token.kind != TOKEN_SEMICOLON) {
+        skip_statement(parser);
+    }
+}
 
-    // Tokenize port_list_buffer
-    char *port_saveptr;
-    char *port_token = strtok_r(port_list_buffer, ", \t\n", &port_saveptr);
+// --- ParseContext sink: interns names and stores the compact tables ---
 
-    // First token is the output signal
-    if (!port_token) {
-        fprintf(stderr, "Error: Empty port list for gate instance %s\n", current_gate->instance_name);
-        return;
-    }
-    char* clean_port_token = trim_token(port_token); // Use existing trim_token
-    strncpy(current_gate->output_signal, clean_port_token, MAX_NAME_LENGTH - 1);
-    current_gate->output_signal[MAX_NAME_LENGTH - 1] = '\0';
-
-    // Subsequent tokens are input signals
-    port_token = strtok_r(NULL, ", \t\n", &port_saveptr);
-    while(port_token) {
-        if (current_gate->input_signal_count >= MAX_GATE_INPUTS) {
-            fprintf(stderr, "Warning: Max gate inputs (%d) reached for instance %s.\n", MAX_GATE_INPUTS, current_gate->instance_name);
-            break;
-        }
-        clean_port_token = trim_token(port_token);
-        if (strlen(clean_port_token) > 0) {
-            strncpy(current_gate->input_signals[current_gate->input_signal_count].name, clean_port_token, MAX_NAME_LENGTH - 1);
-            current_gate->input_signals[current_gate->input_signal_count].name[MAX_NAME_LENGTH - 1] = '\0';
-            current_gate->input_signal_count++;
-        }
-        port_token = strtok_r(NULL, ", \t\n", &port_saveptr);
+typedef struct {
+    ParseContext* ctx;
+    const char* filename;
+} ContextSink;
+
+static bool context_out_of_memory(const ContextSink* target) {
+    fprintf(stderr, "Error: Out of memory while parsing %s\n", target->filename);
+    return false;
+}
+
+static int intern_view(ParseContext* ctx, NameView name) {
+    return string_pool_intern(ctx->names, name.text, name.length);
+}
+
+static bool context_module(void* user, NameView name) {
+    ContextSink* target = (ContextSink*)user;
+    if (target->ctx->module_name >= 0) target->ctx->hierarchical = true;
+    target->ctx->module_name = intern_view(target->ctx, name);
+    return target->ctx->module_name >= 0 || context_out_of_memory(target);
+}
+
+static bool context_declare(void* user, DeclarationKind kind, NameView name) {
+    ContextSink* target = (ContextSink*)user;
+    ParseContext* ctx = target->ctx;
+    NameList* list = (kind == DECLARE_PORT) ? &ctx->module_ports :
+                     (kind == DECLARE_INPUT) ? &ctx->inputs :
+                     (kind == DECLARE_OUTPUT) ? &ctx->outputs : &ctx->wires;
+    return append_parsed_name(list, intern_view(ctx, name)) || context_out_of_memory(target);
+}
+
+static bool context_gate(void* user, GateType type, NameView instance, NameView output,
+                         const NameView* inputs, int input_count) {
+    ContextSink* target = (ContextSink*)user;
+    ParseContext* ctx = target->ctx;
+
+    GateInstance gate;
+    gate.type = type;
+    gate.instance_name = intern_view(ctx, instance);
+    gate.instance_number = instance_number_from_name(instance.text, instance.length);
+    gate.output_signal = intern_view(ctx, output);
+    gate.first_input = ctx->gate_inputs.count;
+    gate.input_count = input_count;
+    if (gate.instance_name < 0 || gate.output_signal < 0) return context_out_of_memory(target);
+
+    for (int i = 0; i < input_count; i++) {
+        if (!append_parsed_name(&ctx->gate_inputs, intern_view(ctx, inputs[i]))) return context_out_of_memory(target);
     }
-    parsed_gate_count++;
+    return append_parsed_gate(ctx, &gate) || context_out_of_memory(target);
+}
+
+static bool context_instance(void* user, NameView module, NameView instance,
+                             const NameView* formals, const NameView* actuals, int count) {
+    (void)module; (void)instance; (void)formals; (void)actuals; (void)count;
+    ((ContextSink*)user)->ctx->hierarchical = true;
+    return true;
 }
 
 
 // --- Public Function Implementations ---
 
-void reset_parsed_data(void) {
-    module_name[0] = '\0';
-    module_port_count = 0;
-    input_count = 0;
-    output_count = 0;
-    wire_count = 0;
-    parsed_gate_count = 0; // Reset gate count
-
-    current_parsing_state = PARSING_NONE;
-    accumulator[0] = '\0';
-    accumulator_len = 0;
+ParseContext* create_parse_context(void) {
+    ParseContext* ctx = (ParseContext*)calloc(1, sizeof(ParseContext));
+    if (ctx) ctx->names = create_string_pool();
+    if (!ctx || !ctx->names) {
+        fprintf(stderr, "Error: Memory allocation failed for parse context\n");
+        free(ctx);
+        return NULL;
+    }
+    reset_parsed_data(ctx);
+    return ctx;
 }
 
-// Renamed from parse_verilog_header_declarations
-int parse_verilog_module(const char *filename) {
-    FILE *file;
-    char line_buffer[MAX_LINE_LENGTH]; // MAX_LINE_LENGTH defined as in previous step
-    char *remaining_line_part = NULL;
+void destroy_parse_context(ParseContext* ctx) {
+    if (!ctx) return;
+    destroy_string_pool(ctx->names);
+    free(ctx->module_ports.ids);
+    free(ctx->inputs.ids);
+    free(ctx->outputs.ids);
+    free(ctx->wires.ids);
+    free(ctx->gates);
+    free(ctx->gate_inputs.ids);
+    free(ctx);
+}
 
-    reset_parsed_data();
+// Storage is kept so a context can be reused for the next file
+void reset_parsed_data(ParseContext* ctx) {
+    clear_string_pool(ctx->names);
+    ctx->module_name = -1;
+    ctx->module_ports.count = 0;
+    ctx->inputs.count = 0;
+    ctx->outputs.count = 0;
+    ctx->wires.count = 0;
+    ctx->gate_count = 0; // Reset gate count
+    ctx->gate_inputs.count = 0;
+    ctx->hierarchical = false;
+}
 
-    file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening Verilog file");
-        return 1;
-    }
-    accumulator[0] = '\0';
+// Statement loop shared by the file and buffer entry points
+static void run_parser(Parser* parser, size_t* header_end) {
+    Token token;
 
-    while (1) {
-        char *current_line_ptr;
-        if (remaining_line_part && *remaining_line_part != '\0') {
-            current_line_ptr = remaining_line_part;
-            remaining_line_part = NULL;
-        } else {
-            if (!fgets(line_buffer, sizeof(line_buffer), file)) {
-                if (current_parsing_state != PARSING_NONE && accumulator_len > 0) {
-                     fprintf(stderr, "Warning: EOF reached while still accumulating list for %d. Incomplete declaration.\n", current_parsing_state);
+    // Each statement starts with a keyword; anything else is skipped to its ';'
+    while (!parser->stopped && lexer_next(&parser->lexer, &token)) {
+        switch (token.keyword) {
+            case KW_MODULE:
+                parse_module_header(parser);
+                break;
+            case KW_INPUT:
+                read_signal_list(parser, TOKEN_SEMICOLON, DECLARE_INPUT);
+                break;
+            case KW_OUTPUT:
+                read_signal_list(parser, TOKEN_SEMICOLON, DECLARE_OUTPUT);
+                break;
+            case KW_WIRE:
+                read_signal_list(parser, TOKEN_SEMICOLON, DECLARE_WIRE);
+                break;
+            case KW_ENDMODULE:
+                break; // No ';' follows endmodule
+            case KW_NONE:
+                if (token.kind == TOKEN_IDENTIFIER) {
+                    parse_module_instance(parser, &token);
+                } else if (token.kind != TOKEN_SEMICOLON) {
+                    skip_statement(parser);
                 }
                 break;
-            }
-            current_line_ptr = line_buffer;
+            default: // Gate primitive
+                if (header_end) {
+                    *header_end = (size_t)(token.text - parser->lexer.data);
+                    return;
+                }
+                parse_gate_instantiation(parser, &token);
+                break;
         }
+    }
+    if (header_end) *header_end = parser->lexer.size;
+}
 
-        char *segment_to_process = trim_whitespace_only(current_line_ptr);
+int parse_verilog_stream(const char *filename, const ParseSink* sink) {
+    Parser parser = { sink, { 0 }, NULL, 0, NULL, 0, false };
 
-        if (current_parsing_state != PARSING_NONE) {
-            // (Logic for accumulating multi-line header declarations - unchanged from previous)
-            if (accumulator_len > 0 && accumulator_len < MAX_ACCUMULATOR_SIZE -1 && strlen(segment_to_process) > 0) {
-                accumulator[accumulator_len++] = ' '; 
-                accumulator[accumulator_len] = '\0';
-            }
-            strncat(accumulator, segment_to_process, MAX_ACCUMULATOR_SIZE - accumulator_len - 1);
-            accumulator_len = strlen(accumulator);
-            accumulator[MAX_ACCUMULATOR_SIZE - 1] = '\0';
-
-            char *terminator_found = NULL;
-            if (current_parsing_state == PARSING_MODULE_PORTS) terminator_found = strchr(accumulator, ')');
-            else if (current_parsing_state == PARSING_INPUTS || current_parsing_state == PARSING_OUTPUTS || current_parsing_state == PARSING_WIRES) {
-                terminator_found = strchr(accumulator, ';');
-            }
-            if (terminator_found) {
-                remaining_line_part = terminator_found + 1;
-                *terminator_found = '\0';
-                if (current_parsing_state == PARSING_MODULE_PORTS) process_accumulated_signals(module_ports, &module_port_count, MAX_PORTS);
-                else if (current_parsing_state == PARSING_INPUTS) process_accumulated_signals(input_signals, &input_count, MAX_SIGNALS);
-                else if (current_parsing_state == PARSING_OUTPUTS) process_accumulated_signals(output_signals, &output_count, MAX_SIGNALS);
-                else if (current_parsing_state == PARSING_WIRES) process_accumulated_signals(wire_signals, &wire_count, MAX_SIGNALS);
-            }
-            continue;
-        }
-        
-        // If current_parsing_state == PARSING_NONE
-        if (strncmp(segment_to_process, "//", 2) == 0 || strlen(segment_to_process) == 0) {
-            remaining_line_part = NULL;
-            continue;
-        }
-        
-        char temp_segment_for_strtok[MAX_LINE_LENGTH];
-        strncpy(temp_segment_for_strtok, segment_to_process, MAX_LINE_LENGTH -1);
-        temp_segment_for_strtok[MAX_LINE_LENGTH-1] = '\0';
+    if (lexer_open(&parser.lexer, filename) != 0) {
+        perror("Error opening Verilog file");
+        return 1;
+    }
+    run_parser(&parser, NULL);
 
-        char *first_token = strtok(temp_segment_for_strtok, " \t("); // Delimiters
+    lexer_close(&parser.lexer);
+    free(parser.inputs);
+    free(parser.formals);
+    return parser.stopped ? 1 : 0;
+}
 
-        if (first_token == NULL) {
-            remaining_line_part = NULL;
-            continue;
-        }
-        
-        accumulator[0] = '\0'; accumulator_len = 0; // Reset for any new list that might start
-
-        if (strcmp(first_token, "module") == 0) {
-            // (Module parsing logic - unchanged)
-            char *module_name_token = strtok(NULL, " \t(");
-            if (module_name_token) { strncpy(module_name, module_name_token, MAX_NAME_LENGTH - 1); module_name[MAX_NAME_LENGTH - 1] = '\0'; }
-            else { fprintf(stderr, "Error: Module name missing.\n"); remaining_line_part = NULL; continue; }
-            char *ports_content_start = strchr(segment_to_process, '(');
-            if (ports_content_start) {
-                ports_content_start++;
-                strncpy(accumulator, ports_content_start, MAX_ACCUMULATOR_SIZE -1); accumulator[MAX_ACCUMULATOR_SIZE-1] = '\0'; accumulator_len = strlen(accumulator);
-                char *ports_end = strchr(accumulator, ')');
-                if (ports_end) { remaining_line_part = ports_end + 1; *ports_end = '\0'; process_accumulated_signals(module_ports, &module_port_count, MAX_PORTS); }
-                else { current_parsing_state = PARSING_MODULE_PORTS; remaining_line_part = NULL; }
-            } else { current_parsing_state = PARSING_MODULE_PORTS; remaining_line_part = NULL;}
-
-        } else if (strcmp(first_token, "input") == 0 || strcmp(first_token, "output") == 0 || strcmp(first_token, "wire") == 0) {
-            // (Input/output/wire parsing logic - unchanged)
-            char *list_content_start = segment_to_process + strlen(first_token); list_content_start = trim_whitespace_only(list_content_start);
-            strncpy(accumulator, list_content_start, MAX_ACCUMULATOR_SIZE -1); accumulator[MAX_ACCUMULATOR_SIZE-1] = '\0'; accumulator_len = strlen(accumulator);
-            char *list_end = strchr(accumulator, ';');
-            if (list_end) {
-                remaining_line_part = list_end + 1; *list_end = '\0';
-                if (strcmp(first_token, "input") == 0) process_accumulated_signals(input_signals, &input_count, MAX_SIGNALS);
-                else if (strcmp(first_token, "output") == 0) process_accumulated_signals(output_signals, &output_count, MAX_SIGNALS);
-                else if (strcmp(first_token, "wire") == 0) process_accumulated_signals(wire_signals, &wire_count, MAX_SIGNALS);
-            } else {
-                if (strcmp(first_token, "input") == 0) current_parsing_state = PARSING_INPUTS;
-                else if (strcmp(first_token, "output") == 0) current_parsing_state = PARSING_OUTPUTS;
-                else if (strcmp(first_token, "wire") == 0) current_parsing_state = PARSING_WIRES;
-                remaining_line_part = NULL;
-            }
-        } else if (is_gate_type_keyword(first_token)) {
-            // *** NEW: Handle Gate Instantiation ***
-            // The entire gate instantiation is assumed to be on one line as per example.
-            // We pass the original 'segment_to_process' because first_token came from a copy.
-            parse_gate_instantiation_line(segment_to_process, first_token);
-            remaining_line_part = NULL; // Assume gate line is fully consumed.
-        } else if (strcmp(first_token, "endmodule") == 0) {
-            // End of module, parsing for this module can stop.
-            remaining_line_part = NULL; // Consume
-            // Could optionally break from the while(1) loop here if desired.
-        }
-        else {
-            // Unrecognized line when not in an accumulation state.
-             if(strlen(trim_whitespace_only(first_token)) > 0) {
-                 //fprintf(stderr, "Info: Skipping unrecognized line/token: %s\n", segment_to_process);
-             }
-            remaining_line_part = NULL;
-        }
+int parse_verilog_buffer(const char* data, size_t size, int first_line, const ParseSink* sink, size_t* header_end) {
+    Parser parser = { sink, { 0 }, NULL, 0, NULL, 0, false };
+
+    lexer_init_buffer(&parser.lexer, data, size);
+    parser.lexer.line = first_line;
+    run_parser(&parser, header_end);
+
+    free(parser.inputs);
+    free(parser.formals);
+    return parser.stopped ? 1 : 0;
+}
+
+// Renamed from parse_verilog_header_declarations
+int parse_verilog_module(ParseContext* ctx, const char *filename) {
+    ContextSink target = { ctx, filename };
+    ParseSink sink = { &target, context_module, context_declare, context_gate, context_instance };
+
+    reset_parsed_data(ctx);
+    return parse_verilog_stream(filename, &sink);
+}
+
+bool append_parsed_name(NameList* list, int id) {
+    if (id < 0) return false;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        int* ids = (int*)realloc(list->ids, (size_t)capacity * sizeof(int));
+        if (!ids) return false;
+        list->ids = ids;
+        list->capacity = capacity;
     }
+    list->ids[list->count++] = id;
+    return true;
+}
+
+bool append_parsed_gate(ParseContext* ctx, const GateInstance* gate) {
+    if (ctx->gate_count == ctx->gate_capacity) {
+        int capacity = ctx->gate_capacity ? ctx->gate_capacity * 2 : 256;
+        GateInstance* gates = (GateInstance*)realloc(ctx->gates, (size_t)capacity * sizeof(GateInstance));
+        if (!gates) return false;
+        ctx->gates = gates;
+        ctx->gate_capacity = capacity;
+    }
+    ctx->gates[ctx->gate_count++] = *gate;
+    return true;
+}
+
+int instance_number_from_name(const char* name, int length) {
+    int underscore = length - 1;
+    while (underscore >= 0 && name[underscore] != '_') underscore--;
+    if (underscore < 0) return 0;
+    if (underscore == length - 1) return -1;
+
+    int number = 0;
+    for (int i = underscore + 1; i < length; i++) {
+        if (!isdigit((unsigned char)name[i])) return -1;
+        number = number * 10 + (name[i] - '0');
+    }
+    return number;
+}
+
+const char* parsed_name(const ParseContext* ctx, int id) {
+    return string_pool_get(ctx->names, id);
+}
 
-    fclose(file);
-    return 0;
+const int* parsed_gate_inputs(const ParseContext* ctx, const GateInstance* gate) {
+    return gate->input_count > 0 ? ctx->gate_inputs.ids + gate->first_input : NULL;
 }
 
 const char* gate_type_to_string(GateType type) {
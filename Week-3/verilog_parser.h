@@ -1,26 +1,18 @@
 #ifndef VERILOG_PARSER_H
 #define VERILOG_PARSER_H
 
+#include "string_pool.h"
+#include <stdbool.h>
+#include <stddef.h>
+
 // --- General Defines ---
 #define MAX_NAME_LENGTH 64
 
-// --- Header Declaration Defines ---
-#define MAX_PORTS 200
-#define MAX_SIGNALS 500 // Applies to inputs, outputs, or wires lists
-
 // --- Gate Declaration Defines ---
-#define MAX_GATE_INSTANCE_NAME_LEN MAX_NAME_LENGTH
-#define MAX_GATE_BASE_NAME_LEN MAX_NAME_LENGTH
-#define MAX_GATE_INPUTS 16      // Max inputs a single gate can have (adjust as needed)
-#define MAX_GATE_INSTANCES 2000 // Max number of gate instances in the module (adjust for larger circuits)
+#define MAX_GATE_INPUTS 16      // Gate inputs gathered on the stack; wider gates use a heap buffer
 
 // --- Data Structures ---
 
-// Structure to hold a signal/port name (reused)
-typedef struct {
-    char name[MAX_NAME_LENGTH];
-} Signal;
-
 // Enumeration for gate types
 typedef enum {
     GATE_UNKNOWN,
@@ -34,52 +26,165 @@ typedef enum {
     GATE_BUFF // Buffer
 } GateType;
 
-// Structure to hold a gate instantiation
+// Structure to hold a gate instantiation. Names are string pool IDs; the
+// inputs are input_count consecutive entries of ParseContext.gate_inputs.
 typedef struct {
     GateType type;
-    char instance_name[MAX_GATE_INSTANCE_NAME_LEN]; // e.g., "NAND2_1"
-    char base_name[MAX_GATE_BASE_NAME_LEN];         // e.g., "NAND2"
-    int instance_number;                            // e.g., 1
-    char output_signal[MAX_NAME_LENGTH];            // The result signal
-    Signal input_signals[MAX_GATE_INPUTS];          // Input signals
-    int input_signal_count;
+    int instance_name;                              // e.g., "NAND2_1"
+    int instance_number;                            // e.g., 1 (-1 if the suffix is not numeric)
+    int output_signal;                              // The result signal
+    int first_input;                                // Offset into ParseContext.gate_inputs
+    int input_count;
 } GateInstance;
 
+// Growable list of string pool IDs
+typedef struct {
+    int* ids;
+    int count;
+    int capacity;
+} NameList;
 
-// --- Extern Declarations for Parsed Header Data ---
-extern char module_name[MAX_NAME_LENGTH];
-extern Signal module_ports[MAX_PORTS];
-extern int module_port_count;
 
-extern Signal input_signals[MAX_SIGNALS];
-extern int input_count;
+// --- Streaming Interface ---
 
-extern Signal output_signals[MAX_SIGNALS];
-extern int output_count;
+// A name as it appears in the source: a view into the parser's input buffer,
+// valid only for the duration of the callback that receives it.
+typedef struct {
+    const char* text;
+    int length;
+} NameView;
+
+typedef enum {
+    DECLARE_PORT,     // Module header port list
+    DECLARE_INPUT,
+    DECLARE_OUTPUT,
+    DECLARE_WIRE
+} DeclarationKind;
+
+// Callbacks invoked in source order as statements are recognized. Any callback
+// may be NULL. Returning false stops the parse (the callback reports why).
+// module is called once per module header, so a hierarchical file reports each
+// module's declarations, gates and instances after its own header. In
+// instance, formals is NULL for positional connections, and an unconnected
+// port (".a()") has an actual with NULL text.
+typedef struct {
+    void* user;
+    bool (*module)(void* user, NameView name);
+    bool (*declare)(void* user, DeclarationKind kind, NameView name);
+    bool (*gate)(void* user, GateType type, NameView instance, NameView output,
+                 const NameView* inputs, int input_count);
+    bool (*instance)(void* user, NameView module, NameView instance,
+                     const NameView* formals, const NameView* actuals, int count);
+} ParseSink;
 
-extern Signal wire_signals[MAX_SIGNALS];
-extern int wire_count;
 
-// --- Extern Declarations for Parsed Gate Data ---
-extern GateInstance parsed_gates[MAX_GATE_INSTANCES];
-extern int parsed_gate_count;
+// --- Parse Context ---
+
+// Everything one parse produces. Each context is owned by its caller, so
+// separate contexts can parse different files concurrently. Every name is
+// interned once in names; all storage grows with the netlist.
+typedef struct {
+    StringPool* names;
+
+    // Parsed header data
+    int module_name;               // Pool ID, or -1 before a module header is seen
+    NameList module_ports;
+    NameList inputs;
+    NameList outputs;
+    NameList wires;
+
+    // Parsed gate data
+    GateInstance* gates;
+    int gate_count;
+    int gate_capacity;
+    NameList gate_inputs;          // Input IDs of all gates, back to back
+
+    bool hierarchical;             // Several modules or module instances (not stored)
+} ParseContext;
 
 
 // --- Public Function Prototypes ---
 
+/**
+ * @brief Allocates an empty parse context.
+ * @return New context, or NULL on allocation failure.
+ */
+ParseContext* create_parse_context(void);
+
+/**
+ * @brief Frees a parse context.
+ * @param ctx The context (may be NULL).
+ */
+void destroy_parse_context(ParseContext* ctx);
+
 /**
  * @brief Parses the specified gate-level Verilog file, including header and gate instantiations.
  *
- * Populates global data structures for module info, signals, and gate instances.
+ * Populates the context with module info, signals, and gate instances. The file
+ * is tokenized in place (see verilog_lexer.h), so statements may span lines and
+ * lines may be of any length. The tables describe one flat module: a file with
+ * several modules or module instances only sets ctx->hierarchical (see
+ * hierarchy.h).
+ * @param ctx The context to fill (previous contents are discarded).
+ * @param filename The path to the Verilog file.
+ * @return 0 on success, 1 if the file cannot be opened or read or memory runs out.
+ */
+int parse_verilog_module(ParseContext* ctx, const char *filename);
+
+/**
+ * @brief Parses a Verilog file, handing each statement to a sink instead of storing it.
  * @param filename The path to the Verilog file.
- * @return 0 on success, 1 if file cannot be opened.
+ * @param sink Receives the module name, declarations and gates in source order.
+ * @return 0 on success, 1 if the file cannot be read or a callback stopped the parse.
+ */
+int parse_verilog_stream(const char *filename, const ParseSink* sink);
+
+/**
+ * @brief Parses Verilog text held in memory (same statements as parse_verilog_stream()).
+ * @param data Text to parse (need not be NUL-terminated).
+ * @param size Length of the text.
+ * @param first_line Line number of the first character, for messages.
+ * @param sink Receives the statements.
+ * @param header_end If non-NULL, stop before the first gate instantiation and
+ *                   store its offset (size if there is none).
+ * @return 0 on success, 1 if a callback stopped the parse.
+ */
+int parse_verilog_buffer(const char* data, size_t size, int first_line, const ParseSink* sink, size_t* header_end);
+
+/**
+ * @brief Resets a context's parsed data to its initial empty state.
+ * @param ctx The context.
+ */
+void reset_parsed_data(ParseContext* ctx);
+
+/**
+ * @brief Returns the string for a name ID of the context ("" for -1).
+ */
+const char* parsed_name(const ParseContext* ctx, int id);
+
+/**
+ * @brief Returns the input name IDs of a parsed gate (gate->input_count entries).
+ */
+const int* parsed_gate_inputs(const ParseContext* ctx, const GateInstance* gate);
+
+/**
+ * @brief Appends a name ID to a list.
+ * @return false if the ID is negative or memory runs out.
+ */
+bool append_parsed_name(NameList* list, int id);
+
+/**
+ * @brief Appends a gate whose names are already interned and whose inputs are
+ *        already in ctx->gate_inputs.
+ * @return false if memory runs out.
  */
-int parse_verilog_module(const char *filename); // Renamed for clarity
+bool append_parsed_gate(ParseContext* ctx, const GateInstance* gate);
 
 /**
- * @brief Resets all global parsed data structures to their initial empty state.
+ * @brief Numeric suffix of an instance name ("NAND2_1" -> 1).
+ * @return The number, 0 if the name has no '_', or -1 if the suffix is not numeric.
  */
-void reset_parsed_data(void);
+int instance_number_from_name(const char* name, int length);
 
 /**
  * @brief Converts a GateType enum to its string representation.